@@ -1,5 +1,6 @@
 #pragma once
 #include "geometry.h"
+#include "../boolean/polygon_set.h"
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
 #include <CGAL/Polygon_2.h>
 #include <CGAL/Polygon_with_holes_2.h>
@@ -84,19 +85,21 @@ static void applyOffset(Geometry& geo, FT k) {
             Polygon_with_holes_2 expanded_frame = CGAL::minkowski_sum_2(framed_pwh, tool);
 
             // Resulting holes are the inset boundaries
-            General_polygon_set_2 gps;
+            boolean::PolygonBatch insets;
             for (auto hit = expanded_frame.holes_begin(); hit != expanded_frame.holes_end(); ++hit) {
                 Polygon_2 b = *hit;
                 assert(b.is_simple() && "Inset boundary must be simple");
                 b.reverse_orientation(); // CCW
-                gps.join(General_polygon_set_2(b));
+                insets.add(b);
             }
+            General_polygon_set_2 gps = insets.to_set();
 
             // Subtract expanded holes
+            boolean::PolygonBatch expanded_holes;
             for (const auto& h : holes) {
-                Polygon_with_holes_2 expanded_hole = CGAL::minkowski_sum_2(h, tool);
-                gps.difference(General_polygon_set_2(expanded_hole));
+                expanded_holes.add(CGAL::minkowski_sum_2(h, tool));
             }
+            expanded_holes.cut_from(gps);
             
             if (!gps.is_empty()) {
                 gps.polygons_with_holes(std::back_inserter(results));
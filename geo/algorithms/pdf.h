@@ -5,7 +5,11 @@
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include <ostream>
 #include "geometry.h"
+#include "camera.h"
+#include "raster.h"
 
 namespace jotcad {
 namespace geo {
@@ -17,31 +21,77 @@ struct PDFConfig {
     double page_height = 0.0;
 };
 
+/**
+ * PDFPaths: One component's outlines, placed and converted to doubles, so
+ * the writer keeps no exact geometry and can format components on workers.
+ */
+struct PDFPaths {
+    std::vector<std::vector<std::array<double, 2>>> loops;  // Closed face loops
+    std::vector<std::array<double, 4>> segments;
+    double min[2] = {0, 0}, max[2] = {0, 0};
+    bool empty = true;
+
+    static PDFPaths from(const Geometry& geo, const Matrix& tf = Matrix::identity()) {
+        PDFPaths out;
+        if (geo.vertices.empty()) return out;
+        ViewTransform view = ViewTransform::from(tf);
+        const double* m = view.m;
+        std::vector<std::array<double, 2>> xy(geo.vertices.size());
+        for (std::size_t i = 0; i < geo.vertices.size(); ++i) {
+            const Vertex& v = geo.vertices[i];
+            double x = CGAL::to_double(v.x), y = CGAL::to_double(v.y), z = CGAL::to_double(v.z);
+            xy[i] = {m[0] * x + m[1] * y + m[2] * z + m[3], m[4] * x + m[5] * y + m[6] * z + m[7]};
+            for (int k = 0; k < 2; ++k) {
+                if (i == 0 || xy[i][k] < out.min[k]) out.min[k] = xy[i][k];
+                if (i == 0 || xy[i][k] > out.max[k]) out.max[k] = xy[i][k];
+            }
+        }
+        out.empty = false;
+        for (const auto& face : geo.faces) {
+            for (const auto& loop : face.loops) {
+                if (loop.empty()) continue;
+                out.loops.emplace_back();
+                for (int idx : loop) out.loops.back().push_back(xy[idx]);
+            }
+        }
+        for (const auto& seg : geo.segments) {
+            out.segments.push_back({xy[seg[0]][0], xy[seg[0]][1], xy[seg[1]][0], xy[seg[1]][1]});
+        }
+        return out;
+    }
+};
+
 class PDFWriter {
 public:
     PDFWriter(const PDFConfig& config = {}) : config_(config) {}
 
     void add_geometry(const Geometry& geo) {
-        if (geo.vertices.empty()) return;
-        
-        for (const auto& v : geo.vertices) {
-            if (!has_bounds_) {
-                min_ = max_ = v;
-                has_bounds_ = true;
-            } else {
-                if (v.x < min_.x) min_.x = v.x;
-                if (v.y < min_.y) min_.y = v.y;
-                if (v.z < min_.z) min_.z = v.z;
-                if (v.x > max_.x) max_.x = v.x;
-                if (v.y > max_.y) max_.y = v.y;
-                if (v.z > max_.z) max_.z = v.z;
-            }
+        add_paths(PDFPaths::from(geo));
+    }
+
+    void add_paths(PDFPaths paths) {
+        if (paths.empty) return;
+        for (int k = 0; k < 2; ++k) {
+            min_[k] = has_bounds_ ? std::min(min_[k], paths.min[k]) : paths.min[k];
+            max_[k] = has_bounds_ ? std::max(max_[k], paths.max[k]) : paths.max[k];
         }
-        geos_.push_back(geo);
+        has_bounds_ = true;
+        paths_.push_back(std::move(paths));
     }
 
     std::vector<unsigned char> write() {
-        if (geos_.empty() && config_.page_width <= 0) return {};
+        std::ostringstream out;
+        if (!write(out)) return {};
+        std::string result = out.str();
+        return std::vector<unsigned char>(result.begin(), result.end());
+    }
+
+    /**
+     * write: Writes the document to out. Each component's content is
+     * formatted on a worker and the pieces are written in order.
+     */
+    bool write(std::ostream& out) {
+        if (paths_.empty() && config_.page_width <= 0) return false;
 
         double w_pt, h_pt;
         scale_ = config_.scale;
@@ -49,8 +99,8 @@ public:
         bool auto_size = (config_.page_width <= 0 || config_.page_height <= 0);
 
         if (auto_size) {
-            double width_mm = CGAL::to_double(max_.x - min_.x);
-            double height_mm = CGAL::to_double(max_.y - min_.y);
+            double width_mm = max_[0] - min_[0];
+            double height_mm = max_[1] - min_[1];
             w_pt = (width_mm + 2 * config_.trim) * scale_;
             h_pt = (height_mm + 2 * config_.trim) * scale_;
         } else {
@@ -58,82 +108,62 @@ public:
             h_pt = config_.page_height * scale_;
         }
 
-        std::stringstream ss;
-        ss << "%PDF-1.4\n";
-        ss << "1 0 obj << /Type /Catalog /Pages 2 0 R >> endobj\n";
-        ss << "2 0 obj << /Type /Pages /Kids [3 0 R] /Count 1 >> endobj\n";
-        ss << "3 0 obj << /Type /Page /Parent 2 0 R /MediaBox [0 0 " << w_pt << " " << h_pt << "] /Contents 4 0 R >> endobj\n";
-        
-        std::stringstream stream;
-        stream << "q\n";
-        stream << "0.072 w\n"; // CRITICAL: 0.072pt is the required hairline for most laser cutters. DO NOT CHANGE.
-
-        for (const auto& geo : geos_) {
-            for (const auto& face : geo.faces) {
-                for (const auto& loop : face.loops) {
-                    if (loop.empty()) continue;
-                    
-                    auto get_pt = [&](int idx) {
-                        const auto& v = geo.vertices[idx];
-                        double sx, sy;
-                        if (auto_size) {
-                            sx = CGAL::to_double(v.x - min_.x) * scale_ + (config_.trim * scale_);
-                            sy = CGAL::to_double(v.y - min_.y) * scale_ + (config_.trim * scale_);
-                        } else {
-                            // Map world (0,0) to top-left (0, h_pt)
-                            // PDF Y is bottom-up.
-                            sx = CGAL::to_double(v.x) * scale_;
-                            sy = h_pt - (CGAL::to_double(v.y) * scale_);
-                        }
-                        return std::make_pair(sx, sy);
-                    };
-
-                    auto start = get_pt(loop[0]);
+        auto get_pt = [&](double x, double y) {
+            if (auto_size) {
+                return std::make_pair((x - min_[0]) * scale_ + (config_.trim * scale_),
+                                      (y - min_[1]) * scale_ + (config_.trim * scale_));
+            }
+            // Map world (0,0) to top-left (0, h_pt)
+            // PDF Y is bottom-up.
+            return std::make_pair(x * scale_, h_pt - (y * scale_));
+        };
+
+        std::vector<std::string> pieces(paths_.size());
+        Raster::parallel_bands((int)paths_.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                std::ostringstream stream;
+                for (const auto& loop : paths_[i].loops) {
+                    auto start = get_pt(loop[0][0], loop[0][1]);
                     stream << start.first << " " << start.second << " m\n";
-                    for (size_t i = 1; i < loop.size(); ++i) {
-                        auto p = get_pt(loop[i]);
+                    for (size_t j = 1; j < loop.size(); ++j) {
+                        auto p = get_pt(loop[j][0], loop[j][1]);
                         stream << p.first << " " << p.second << " l\n";
                     }
                     stream << "h S\n";
                 }
+                for (const auto& seg : paths_[i].segments) {
+                    auto p1 = get_pt(seg[0], seg[1]);
+                    auto p2 = get_pt(seg[2], seg[3]);
+                    stream << p1.first << " " << p1.second << " m " << p2.first << " " << p2.second << " l S\n";
+                }
+                pieces[i] = stream.str();
             }
-            
-            for (const auto& seg : geo.segments) {
-                const auto& v1 = geo.vertices[seg[0]];
-                const auto& v2 = geo.vertices[seg[1]];
-                
-                auto get_v_scaled = [&](const Vertex& v) {
-                    double sx, sy;
-                    if (auto_size) {
-                        sx = CGAL::to_double(v.x - min_.x) * scale_ + (config_.trim * scale_);
-                        sy = CGAL::to_double(v.y - min_.y) * scale_ + (config_.trim * scale_);
-                    } else {
-                        sx = CGAL::to_double(v.x) * scale_;
-                        sy = h_pt - (CGAL::to_double(v.y) * scale_);
-                    }
-                    return std::make_pair(sx, sy);
-                };
-                
-                auto p1 = get_v_scaled(v1);
-                auto p2 = get_v_scaled(v2);
-                stream << p1.first << " " << p1.second << " m " << p2.first << " " << p2.second << " l S\n";
-            }
+        }, 16);
+
+        const std::string open = "q\n0.072 w\n"; // CRITICAL: 0.072pt is the required hairline for most laser cutters. DO NOT CHANGE.
+        const std::string close = "Q\n";
+        std::size_t length = open.size() + close.size();
+        for (const auto& piece : pieces) length += piece.size();
+
+        out << "%PDF-1.4\n";
+        out << "1 0 obj << /Type /Catalog /Pages 2 0 R >> endobj\n";
+        out << "2 0 obj << /Type /Pages /Kids [3 0 R] /Count 1 >> endobj\n";
+        out << "3 0 obj << /Type /Page /Parent 2 0 R /MediaBox [0 0 " << w_pt << " " << h_pt << "] /Contents 4 0 R >> endobj\n";
+        out << "4 0 obj << /Length " << length << " >> stream\n" << open;
+        for (auto& piece : pieces) {
+            out << piece;
+            std::string().swap(piece);
         }
-        stream << "Q\n";
-        
-        std::string content = stream.str();
-        ss << "4 0 obj << /Length " << content.length() << " >> stream\n" << content << "endstream\nendobj\n";
-        ss << "xref\n0 5\n0000000000 65535 f \n";
-        ss << "trailer << /Size 5 /Root 1 0 R >>\nstartxref\n%%EOF";
-
-        std::string result = ss.str();
-        return std::vector<unsigned char>(result.begin(), result.end());
+        out << close << "endstream\nendobj\n";
+        out << "xref\n0 5\n0000000000 65535 f \n";
+        out << "trailer << /Size 5 /Root 1 0 R >>\nstartxref\n%%EOF";
+        return true;
     }
 
 private:
     PDFConfig config_;
-    std::vector<Geometry> geos_;
-    Vertex min_, max_; // Corrected type: Vertex
+    std::vector<PDFPaths> paths_;
+    double min_[2] = {0, 0}, max_[2] = {0, 0};
     bool has_bounds_ = false;
     double scale_ = 1.0;
 };
@@ -0,0 +1,201 @@
+#pragma once
+#include <zlib.h>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * PngRows: Decodes a PNG one row at a time as 8-bit RGB, inflating its
+ * IDAT chunks as rows are asked for, so a caller holds a window of rows
+ * rather than the whole image and sizes are not bound by stb's int limits.
+ * Pixels match stbi_load with 3 components: gray is replicated, alpha is
+ * dropped and 16-bit samples keep their high byte. Interlaced images are
+ * not streamed; ok() is false for them and for anything that is not a PNG.
+ */
+class PngRows {
+public:
+    int width = 0, height = 0;
+
+    PngRows(const uint8_t* data, size_t size) : data_(data), size_(size) {
+        static const uint8_t kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+        if (size < 33 || std::memcmp(data, kSignature, 8) != 0 || std::memcmp(data + 12, "IHDR", 4) != 0) return;
+        const uint8_t* h = data + 16;
+        uint32_t w = be32(h), ht = be32(h + 4);
+        depth_ = h[8];
+        color_ = h[9];
+        if (w == 0 || ht == 0 || w > INT_MAX || ht > INT_MAX) return;
+        if (h[10] != 0 || h[11] != 0 || h[12] != 0) return;  // Compression, filter, interlace
+        switch (color_) {
+            case 0: channels_ = 1; if (depth_ != 1 && depth_ != 2 && depth_ != 4 && depth_ != 8 && depth_ != 16) return; break;
+            case 3: channels_ = 1; if (depth_ != 1 && depth_ != 2 && depth_ != 4 && depth_ != 8) return; break;
+            case 2: channels_ = 3; break;
+            case 4: channels_ = 2; break;
+            case 6: channels_ = 4; break;
+            default: return;
+        }
+        if (channels_ > 1 && depth_ != 8 && depth_ != 16) return;
+        int bits = channels_ * depth_;
+        row_bytes_ = ((size_t)w * bits + 7) / 8;
+        if (row_bytes_ + 1 > UINT_MAX) return;
+        unit_ = bits >= 8 ? bits / 8 : 1;
+
+        for (size_t at = 8; at + 12 <= size; ) {
+            size_t len = be32(data + at);
+            if (len > size - at - 12) return;
+            const uint8_t* type = data + at + 4;
+            if (std::memcmp(type, "PLTE", 4) == 0) palette_.assign(data + at + 8, data + at + 8 + len);
+            if (std::memcmp(type, "IDAT", 4) == 0) break;
+            at += 12 + len;
+        }
+        if (color_ == 3 && palette_.size() < 3) return;
+
+        width = (int)w;
+        height = (int)ht;
+        ok_ = true;
+        rewind();
+    }
+
+    ~PngRows() { if (inflating_) inflateEnd(&z_); }
+    PngRows(const PngRows&) = delete;
+    PngRows& operator=(const PngRows&) = delete;
+
+    bool ok() const { return ok_; }
+
+    // The row the next read() decodes.
+    int row() const { return row_; }
+
+    // Restarts decoding at row 0.
+    void rewind() {
+        if (!ok_) throw std::runtime_error("PngRows: not a streamable PNG");
+        if (inflating_) inflateEnd(&z_);
+        z_ = z_stream{};
+        if (inflateInit(&z_) != Z_OK) throw std::runtime_error("PngRows: inflateInit failed");
+        inflating_ = true;
+        chunk_ = 8;
+        row_ = 0;
+        cur_.assign(row_bytes_ + 1, 0);
+        prev_.assign(row_bytes_ + 1, 0);
+    }
+
+    // Decodes the next row into width * 3 bytes of RGB.
+    void read(unsigned char* rgb) {
+        if (row_ >= height) throw std::runtime_error("PngRows: read past the last row");
+        std::swap(cur_, prev_);
+        z_.next_out = cur_.data();
+        z_.avail_out = (uInt)(row_bytes_ + 1);
+        while (z_.avail_out > 0) {
+            if (z_.avail_in == 0) next_idat();
+            int r = inflate(&z_, Z_NO_FLUSH);
+            if (r == Z_STREAM_END && z_.avail_out > 0) throw std::runtime_error("PngRows: image data ends early");
+            if (r != Z_OK && r != Z_STREAM_END) throw std::runtime_error("PngRows: corrupt image data");
+        }
+        unfilter();
+        expand(rgb);
+        ++row_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    bool ok_ = false;
+    int depth_ = 0, color_ = 0, channels_ = 0;
+    size_t row_bytes_ = 0, unit_ = 1;
+    std::vector<uint8_t> palette_;
+
+    z_stream z_{};
+    bool inflating_ = false;
+    size_t chunk_ = 8;
+    int row_ = 0;
+    std::vector<uint8_t> cur_, prev_;  // Filter byte then the row
+
+    static uint32_t be32(const uint8_t* p) {
+        return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+
+    void next_idat() {
+        while (chunk_ + 12 <= size_) {
+            size_t len = be32(data_ + chunk_);
+            if (len > size_ - chunk_ - 12) break;
+            const uint8_t* type = data_ + chunk_ + 4;
+            size_t body = chunk_ + 8;
+            chunk_ += 12 + len;
+            if (std::memcmp(type, "IDAT", 4) == 0) {
+                z_.next_in = const_cast<Bytef*>(data_ + body);
+                z_.avail_in = (uInt)len;
+                if (len > 0) return;
+            } else if (std::memcmp(type, "IEND", 4) == 0) {
+                break;
+            }
+        }
+        throw std::runtime_error("PngRows: image data ends early");
+    }
+
+    void unfilter() {
+        uint8_t* r = cur_.data() + 1;
+        const uint8_t* p = prev_.data() + 1;
+        const size_t n = row_bytes_, u = unit_;
+        switch (cur_[0]) {
+            case 0: break;
+            case 1: for (size_t i = u; i < n; ++i) r[i] += r[i - u]; break;
+            case 2: for (size_t i = 0; i < n; ++i) r[i] += p[i]; break;
+            case 3:
+                for (size_t i = 0; i < n; ++i) r[i] += (uint8_t)(((i >= u ? r[i - u] : 0) + p[i]) / 2);
+                break;
+            case 4:
+                for (size_t i = 0; i < n; ++i) {
+                    int a = i >= u ? r[i - u] : 0, b = p[i], c = i >= u ? p[i - u] : 0;
+                    int q = a + b - c, pa = std::abs(q - a), pb = std::abs(q - b), pc = std::abs(q - c);
+                    r[i] += (uint8_t)(pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+                }
+                break;
+            default: throw std::runtime_error("PngRows: bad filter type");
+        }
+    }
+
+    void expand(unsigned char* rgb) const {
+        const uint8_t* r = cur_.data() + 1;
+        if (depth_ < 8) {
+            const int mask = (1 << depth_) - 1;
+            for (int x = 0; x < width; ++x) {
+                size_t bit = (size_t)x * depth_;
+                int v = (r[bit / 8] >> (8 - depth_ - (int)(bit % 8))) & mask;
+                put(rgb + (size_t)x * 3, v, color_ == 0 ? v * 255 / mask : v);
+            }
+            return;
+        }
+        const int step = depth_ / 8;
+        for (int x = 0; x < width; ++x) {
+            const uint8_t* s = r + (size_t)x * channels_ * step;
+            unsigned char* o = rgb + (size_t)x * 3;
+            if (channels_ >= 3) {
+                o[0] = s[0];
+                o[1] = s[step];
+                o[2] = s[2 * step];
+            } else {
+                put(o, s[0], s[0]);
+            }
+        }
+    }
+
+    // A gray or palette sample: idx indexes the palette, gray is its level.
+    void put(unsigned char* o, int idx, int gray) const {
+        if (color_ != 3) {
+            o[0] = o[1] = o[2] = (unsigned char)gray;
+            return;
+        }
+        if ((size_t)idx * 3 + 2 >= palette_.size()) throw std::runtime_error("PngRows: palette index out of range");
+        o[0] = palette_[idx * 3];
+        o[1] = palette_[idx * 3 + 1];
+        o[2] = palette_[idx * 3 + 2];
+    }
+};
+
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,244 @@
+#pragma once
+#include "raster.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * ColorQuantizer: k-means in HSV space for jot/trace.
+ *
+ * Pixels are reduced to a weighted histogram of their distinct colors
+ * (binned coarser when an image has too many), seeded with k-means++ and refined
+ * by Lloyd iterations that use Hamerly bounds to skip most distance
+ * evaluations. Iteration stops early once no sample changes cluster.
+ * Results depend only on the seed, never on the thread count.
+ */
+struct ColorQuantizer {
+    using HSV = Raster::HSV;
+
+    static constexpr std::size_t kMaxSamples = 1 << 16;
+    // The distinct-color table holds 2 * kMaxSamples slots.
+    static constexpr int kTableBits = 17;
+    static constexpr int kChunk = 4096;
+    static constexpr uint32_t kEmpty = 0xffffffffu;
+
+    struct Result {
+        std::vector<HSV> centers;
+        std::vector<int> labels;  // Center index per pixel
+        int iterations = 0;
+        std::size_t samples = 0;
+    };
+
+    // Squared distance with hue wrapping and weighted four times.
+    static double distance_sq(const HSV& a, const HSV& b) {
+        double dh = std::min(std::abs(a.h - b.h), 1.0 - std::abs(a.h - b.h));
+        double ds = a.s - b.s, dv = a.v - b.v;
+        return dh*dh * 4.0 + ds*ds + dv*dv;
+    }
+
+    static double distance(const HSV& a, const HSV& b) { return std::sqrt(distance_sq(a, b)); }
+
+    static Result kmeans(const unsigned char* rgb, int count, int k, uint32_t seed = 42, int max_iterations = 10) {
+        Result result;
+        if (count <= 0 || k <= 0) return result;
+
+        // 1. Weighted samples: the distinct colors in order of first
+        // appearance, found with a small open-addressing table. An image with
+        // more than kMaxSamples of them is binned instead into 5-bit RGB cells
+        // at their mean color, averaged in RGB so that reds either side of
+        // the hue wrap do not average to cyan.
+        std::vector<int> pixel_sample(count);
+        std::vector<HSV> samples;
+        std::vector<double> weights;
+        bool exact = true;
+        {
+            const uint32_t capacity = 1u << kTableBits;
+            static_assert((std::size_t(1) << kTableBits) == kMaxSamples * 2, "table holds twice kMaxSamples");
+            std::vector<uint32_t> slot_key(capacity, kEmpty);
+            std::vector<int> slot_sample(capacity);
+            std::vector<uint32_t> keys;
+            for (int i = 0; i < count && exact; ++i) {
+                uint32_t key = (uint32_t)rgb[i * 3] << 16 | (uint32_t)rgb[i * 3 + 1] << 8 | rgb[i * 3 + 2];
+                // Fibonacci hashing: the product's high bits are the well mixed ones.
+                uint32_t slot = (key * 2654435761u) >> (32 - kTableBits);
+                while (slot_key[slot] != key && slot_key[slot] != kEmpty) slot = (slot + 1) & (capacity - 1);
+                if (slot_key[slot] == kEmpty) {
+                    if (keys.size() == kMaxSamples) exact = false;
+                    slot_key[slot] = key;
+                    slot_sample[slot] = (int)keys.size();
+                    keys.push_back(key);
+                    weights.push_back(0);
+                }
+                if (exact) {
+                    pixel_sample[i] = slot_sample[slot];
+                    weights[slot_sample[slot]] += 1;
+                }
+            }
+            if (exact) {
+                samples.resize(keys.size());
+                for (std::size_t i = 0; i < keys.size(); ++i) {
+                    samples[i] = Raster::rgb_to_hsv(keys[i] >> 16, (keys[i] >> 8) & 0xff, keys[i] & 0xff);
+                }
+            }
+        }
+        if (!exact) {
+            std::vector<int> cell_sample(1 << 15, -1);
+            std::vector<uint64_t> sums;
+            weights.clear();
+            for (int i = 0; i < count; ++i) {
+                const unsigned char* p = &rgb[i * 3];
+                int& s = cell_sample[(p[0] >> 3) << 10 | (p[1] >> 3) << 5 | p[2] >> 3];
+                if (s < 0) {
+                    s = (int)weights.size();
+                    sums.insert(sums.end(), {0, 0, 0});
+                    weights.push_back(0);
+                }
+                sums[s * 3] += p[0]; sums[s * 3 + 1] += p[1]; sums[s * 3 + 2] += p[2];
+                weights[s] += 1;
+                pixel_sample[i] = s;
+            }
+            samples.resize(weights.size());
+            for (std::size_t s = 0; s < samples.size(); ++s) {
+                double scale = 1.0 / (255.0 * weights[s]);
+                samples[s] = Raster::rgb_to_hsv_unit(sums[s * 3] * scale, sums[s * 3 + 1] * scale, sums[s * 3 + 2] * scale);
+            }
+        }
+        const int n = (int)samples.size();
+        result.samples = samples.size();
+
+        // 2. k-means++ seeding.
+        std::mt19937 rng(seed);
+        std::vector<HSV> centers;
+        centers.reserve(k);
+        auto pick = [&](const std::vector<double>& mass) {
+            double total = 0;
+            for (double m : mass) total += m;
+            if (!(total > 0)) return -1;
+            double target = std::uniform_real_distribution<double>(0.0, total)(rng);
+            for (int i = 0; i < n; ++i) {
+                target -= mass[i];
+                if (target < 0) return i;
+            }
+            for (int i = n - 1; i >= 0; --i) if (mass[i] > 0) return i;
+            return -1;
+        };
+        centers.push_back(samples[std::max(0, pick(weights))]);
+        std::vector<double> nearest_sq(n);
+        for (int i = 0; i < n; ++i) nearest_sq[i] = distance_sq(samples[i], centers[0]);
+        std::vector<double> mass(n);
+        while ((int)centers.size() < k) {
+            for (int i = 0; i < n; ++i) mass[i] = weights[i] * nearest_sq[i];
+            int chosen = pick(mass);
+            // Fewer distinct colors than centers: the rest stay empty.
+            centers.push_back(samples[chosen < 0 ? 0 : chosen]);
+            for (int i = 0; i < n; ++i) nearest_sq[i] = std::min(nearest_sq[i], distance_sq(samples[i], centers.back()));
+        }
+
+        // 3. Lloyd iterations with Hamerly bounds: upper[i] bounds the distance
+        // to the assigned center, lower[i] the distance to any other one.
+        std::vector<int> assign(n);
+        std::vector<double> upper(n), lower(n);
+        auto full_scan = [&](int i) {
+            int best = 0;
+            double d1 = 1e18, d2 = 1e18;
+            for (int j = 0; j < k; ++j) {
+                double d = distance(samples[i], centers[j]);
+                if (d < d1) { d2 = d1; d1 = d; best = j; }
+                else if (d < d2) { d2 = d; }
+            }
+            upper[i] = d1;
+            lower[i] = d2;
+            return best;
+        };
+        Raster::parallel_bands(n, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) assign[i] = full_scan(i);
+        }, kChunk);
+
+        // Weighted means summed per fixed chunk, then across chunks in
+        // order, so rounding does not depend on the worker count.
+        auto update_centers = [&]() {
+            int chunks = (n + kChunk - 1) / kChunk;
+            std::vector<double> partial((std::size_t)chunks * k * 4, 0.0);
+            Raster::parallel_bands(chunks, [&](int c0, int c1) {
+                for (int c = c0; c < c1; ++c) {
+                    double* sums = &partial[(std::size_t)c * k * 4];
+                    for (int i = c * kChunk; i < std::min(n, (c + 1) * kChunk); ++i) {
+                        double* s = &sums[assign[i] * 4];
+                        s[0] += samples[i].h * weights[i]; s[1] += samples[i].s * weights[i];
+                        s[2] += samples[i].v * weights[i]; s[3] += weights[i];
+                    }
+                }
+            }, 1);
+            std::vector<double> moved(k, 0.0);
+            for (int j = 0; j < k; ++j) {
+                double h = 0, s = 0, v = 0, w = 0;
+                for (int c = 0; c < chunks; ++c) {
+                    const double* p = &partial[((std::size_t)c * k + j) * 4];
+                    h += p[0]; s += p[1]; v += p[2]; w += p[3];
+                }
+                if (w > 0) {
+                    HSV next = {h / w, s / w, v / w};
+                    moved[j] = distance(centers[j], next);
+                    centers[j] = next;
+                }
+            }
+            return moved;
+        };
+
+        for (int iter = 0; iter < max_iterations; ++iter) {
+            std::vector<double> moved = update_centers();
+            result.iterations = iter + 1;
+            double max_move = 0, second_move = 0;
+            int max_index = -1;
+            for (int j = 0; j < k; ++j) {
+                if (moved[j] > max_move) { second_move = max_move; max_move = moved[j]; max_index = j; }
+                else if (moved[j] > second_move) { second_move = moved[j]; }
+            }
+            if (max_move == 0 || iter + 1 == max_iterations) break;
+
+            std::vector<double> half_gap(k, 1e18);
+            for (int a = 0; a < k; ++a) {
+                for (int b = a + 1; b < k; ++b) {
+                    double d = 0.5 * distance(centers[a], centers[b]);
+                    half_gap[a] = std::min(half_gap[a], d);
+                    half_gap[b] = std::min(half_gap[b], d);
+                }
+            }
+
+            std::atomic<int> changes{0};
+            Raster::parallel_bands(n, [&](int begin, int end) {
+                int local = 0;
+                for (int i = begin; i < end; ++i) {
+                    int a = assign[i];
+                    upper[i] += moved[a];
+                    lower[i] -= (a == max_index) ? second_move : max_move;
+                    double bound = std::max(half_gap[a], lower[i]);
+                    if (upper[i] <= bound) continue;
+                    upper[i] = distance(samples[i], centers[a]);
+                    if (upper[i] <= bound) continue;
+                    int best = full_scan(i);
+                    if (best != a) {
+                        assign[i] = best;
+                        ++local;
+                    }
+                }
+                changes += local;
+            }, kChunk);
+            if (changes == 0) break;
+        }
+
+        result.centers = std::move(centers);
+        result.labels.resize(count);
+        for (int i = 0; i < count; ++i) result.labels[i] = assign[pixel_sample[i]];
+        return result;
+    }
+};
+
+} // namespace geo
+} // namespace jotcad
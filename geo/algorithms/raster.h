@@ -0,0 +1,264 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * Raster: Label-image processing shared by jot/relief and jot/trace.
+ *
+ * Per-pixel stages split the image into row bands processed on worker
+ * threads; connected components use a banded union-find. Every stage gives
+ * the same result as a serial scan, so output CIDs do not depend on the
+ * thread count.
+ */
+struct Raster {
+    struct HSV { double h, s, v; };
+
+    // Worker threads for banded stages; 0 selects the hardware concurrency.
+    static inline int threads = 0;
+
+    /**
+     * parallel_bands: Calls fn(begin, end) over contiguous bands of [0, n).
+     * Every band runs to completion; the first exception thrown by any band
+     * is rethrown once all workers have joined. Calls made from inside a
+     * band run serially, so nested stages do not multiply the threads.
+     */
+    template <typename F>
+    static void parallel_bands(int n, F&& fn, int min_band = 64) {
+        int workers = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        workers = std::max(1, std::min(workers, n / std::max(1, min_band)));
+        if (workers <= 1 || in_band) {
+            fn(0, n);
+            return;
+        }
+        std::mutex failed_mutex;
+        std::exception_ptr failed;
+        auto band = [&](int w) {
+            in_band = true;
+            try {
+                fn((int)((long long)n * w / workers), (int)((long long)n * (w + 1) / workers));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failed_mutex);
+                if (!failed) failed = std::current_exception();
+            }
+            in_band = false;
+        };
+        std::vector<std::thread> pool;
+        for (int w = 1; w < workers; ++w) pool.emplace_back(band, w);
+        band(0);
+        for (auto& t : pool) t.join();
+        if (failed) std::rethrow_exception(failed);
+    }
+
+    // Whether this thread is running a band of parallel_bands.
+    static inline thread_local bool in_band = false;
+
+    // Luma (Rec. 601) in [0, 1] of packed RGB pixels.
+    static std::vector<double> intensity(const unsigned char* rgb, int count) {
+        std::vector<double> out(count);
+        parallel_bands(count, [&](int begin, int end) {
+            // Branch-free so the compiler can vectorize the loop.
+            for (int i = begin; i < end; ++i) {
+                double r = rgb[i * 3] / 255.0;
+                double g = rgb[i * 3 + 1] / 255.0;
+                double b = rgb[i * 3 + 2] / 255.0;
+                out[i] = 0.299 * r + 0.587 * g + 0.114 * b;
+            }
+        }, 4096);
+        return out;
+    }
+
+    static HSV rgb_to_hsv(unsigned char r, unsigned char g, unsigned char b) {
+        return rgb_to_hsv_unit(r / 255.0, g / 255.0, b / 255.0);
+    }
+
+    // As rgb_to_hsv, for components in [0, 1] such as mean colors.
+    static HSV rgb_to_hsv_unit(double rd, double gd, double bd) {
+        double max_v = std::max({rd, gd, bd}), min_v = std::min({rd, gd, bd});
+        double h, s, v = max_v, d = max_v - min_v;
+        s = (max_v == 0) ? 0 : d / max_v;
+        if (max_v == min_v) h = 0;
+        else {
+            if (max_v == rd) h = (gd - bd) / d + (gd < bd ? 6 : 0);
+            else if (max_v == gd) h = (bd - rd) / d + 2;
+            else h = (rd - gd) / d + 4;
+            h /= 6.0;
+        }
+        return { h, s, v };
+    }
+
+    static std::vector<HSV> hsv(const unsigned char* rgb, int count) {
+        std::vector<HSV> out(count);
+        parallel_bands(count, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) out[i] = rgb_to_hsv(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+        }, 4096);
+        return out;
+    }
+
+    /**
+     * mode_filter: 3x3 despeckle. An interior pixel takes the label held by
+     * at least five of its nine neighbors (including itself), if any; such a
+     * label is a strict majority, so a majority vote finds it without a
+     * histogram. Border pixels are kept.
+     */
+    static std::vector<int> mode_filter(const std::vector<int>& labels, int W, int H) {
+        std::vector<int> out = labels;
+        if (W < 3 || H < 3) return out;
+        parallel_bands(H - 2, [&](int begin, int end) {
+            for (int y = begin + 1; y < end + 1; ++y) {
+                const int* rows[3] = {&labels[(y - 1) * W], &labels[y * W], &labels[(y + 1) * W]};
+                for (int x = 1; x < W - 1; ++x) {
+                    int candidate = 0, votes = 0;
+                    for (int r = 0; r < 3; ++r) {
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            int v = rows[r][x + dx];
+                            if (votes == 0) { candidate = v; votes = 1; }
+                            else if (v == candidate) ++votes;
+                            else --votes;
+                        }
+                    }
+                    int count = 0;
+                    for (int r = 0; r < 3; ++r) {
+                        count += (rows[r][x - 1] == candidate) + (rows[r][x] == candidate) + (rows[r][x + 1] == candidate);
+                    }
+                    if (count >= 5) out[y * W + x] = candidate;
+                }
+            }
+        });
+        return out;
+    }
+
+    /**
+     * label_components: 4-connected components of equal labels, numbered in
+     * the raster order of their first pixel. Returns the component count;
+     * comp_labels, when given, receives each component's label.
+     */
+    static int label_components(const std::vector<int>& labels, int W, int H, std::vector<int>& comp_ids,
+                                std::vector<int>* comp_labels = nullptr) {
+        const int N = W * H;
+        // Union-find keeping the smallest pixel index as the root, so each
+        // root is its component's first pixel in raster order.
+        std::vector<int> parent(N);
+        auto find = [&](int i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        };
+        auto unite = [&](int a, int b) {
+            a = find(a);
+            b = find(b);
+            if (a < b) parent[b] = a;
+            else if (b < a) parent[a] = b;
+        };
+
+        // Bands only link pixels inside themselves, so they run concurrently.
+        std::vector<char> band_start(H, 0);
+        parallel_bands(H, [&](int y0, int y1) {
+            band_start[y0] = 1;
+            for (int y = y0; y < y1; ++y) {
+                for (int x = 0; x < W; ++x) {
+                    int i = y * W + x;
+                    parent[i] = i;
+                    if (x > 0 && labels[i - 1] == labels[i]) unite(i, i - 1);
+                    if (y > y0 && labels[i - W] == labels[i]) unite(i, i - W);
+                }
+            }
+        }, 16);
+        for (int y0 = 1; y0 < H; ++y0) {
+            if (!band_start[y0]) continue;
+            for (int x = 0; x < W; ++x) {
+                int i = y0 * W + x;
+                if (labels[i - W] == labels[i]) unite(i, i - W);
+            }
+        }
+
+        comp_ids.assign(N, -1);
+        if (comp_labels) comp_labels->clear();
+        int count = 0;
+        for (int i = 0; i < N; ++i) {
+            int root = find(i);
+            if (root == i) {
+                comp_ids[i] = count++;
+                if (comp_labels) comp_labels->push_back(labels[i]);
+            } else {
+                comp_ids[i] = comp_ids[root];
+            }
+        }
+        return count;
+    }
+
+    /**
+     * merge_small_regions: Relabels components smaller than min_area pixels
+     * to the neighboring label nearest by distance(label, neighbor), ties to
+     * the smaller label, visiting components in raster order so that each
+     * sees the merges before it. Repeats until stable or max_passes. For a
+     * window cut from a larger image, open_edges flags the window sides that
+     * are cut (kLeft | kRight | kTop | kBottom); components touching them
+     * may continue outside and are left alone.
+     */
+    enum Edge { kLeft = 1, kRight = 2, kTop = 4, kBottom = 8 };
+
+    template <typename Distance>
+    static void merge_small_regions(std::vector<int>& labels, int W, int H, double min_area, Distance distance,
+                                    int max_passes = 5, int open_edges = 0) {
+        const int N = W * H;
+        std::vector<int> comp_ids, offsets, pixels(N), neighbors;
+        for (int pass = 0; pass < max_passes; ++pass) {
+            int count = label_components(labels, W, H, comp_ids);
+
+            // Pixels grouped by component, in raster order.
+            offsets.assign(count + 1, 0);
+            for (int i = 0; i < N; ++i) offsets[comp_ids[i] + 1]++;
+            for (int c = 0; c < count; ++c) offsets[c + 1] += offsets[c];
+            std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+            for (int i = 0; i < N; ++i) pixels[cursor[comp_ids[i]]++] = i;
+
+            bool changed = false;
+            for (int c = 0; c < count; ++c) {
+                int begin = offsets[c], end = offsets[c + 1];
+                if ((std::size_t)(end - begin) >= (std::size_t)min_area) continue;
+                int target = labels[pixels[begin]];
+
+                neighbors.clear();
+                bool cut = false;
+                for (int k = begin; k < end; ++k) {
+                    int idx = pixels[k];
+                    int cx = idx % W, cy = idx / W;
+                    cut |= ((open_edges & kLeft) && cx == 0) || ((open_edges & kRight) && cx == W - 1) ||
+                           ((open_edges & kTop) && cy == 0) || ((open_edges & kBottom) && cy == H - 1);
+                    if (cx > 0 && labels[idx - 1] != target) neighbors.push_back(labels[idx - 1]);
+                    if (cx < W - 1 && labels[idx + 1] != target) neighbors.push_back(labels[idx + 1]);
+                    if (cy > 0 && labels[idx - W] != target) neighbors.push_back(labels[idx - W]);
+                    if (cy < H - 1 && labels[idx + W] != target) neighbors.push_back(labels[idx + W]);
+                }
+                if (cut || neighbors.empty()) continue;
+                std::sort(neighbors.begin(), neighbors.end());
+                neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+                int best = -1;
+                double best_distance = 0;
+                for (int n : neighbors) {
+                    double d = distance(target, n);
+                    if (best == -1 || d < best_distance) {
+                        best_distance = d;
+                        best = n;
+                    }
+                }
+                for (int k = begin; k < end; ++k) labels[pixels[k]] = best;
+                changed = true;
+            }
+            if (!changed) break;
+        }
+    }
+};
+
+} // namespace geo
+} // namespace jotcad
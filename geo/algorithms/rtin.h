@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * Rtin: Right-triangulated irregular network over a square grid of
+ * (2^k + 1)^2 heights, for continuous jot/relief surfaces.
+ *
+ * The grid is the root of a binary tree of right triangles, each split at
+ * the midpoint of its hypotenuse. Every grid point records the largest
+ * error, against linear interpolation along the hypotenuse, of the
+ * triangles that would split there or below, so mesh(max_error) descends
+ * only where the surface needs it and the triangle count follows the
+ * terrain rather than the pixel count. Split points are shared by both
+ * triangles on a hypotenuse, so the mesh has no T-junctions.
+ */
+struct Rtin {
+    struct Mesh {
+        std::vector<std::array<int, 2>> vertices;  // Grid coordinates (x, y)
+        std::vector<std::array<int, 3>> triangles;
+    };
+
+    int size;  // Grid points per side, 2^k + 1
+    std::vector<float> heights;
+    std::vector<float> errors;
+
+    // The smallest 2^k + 1 covering a w x h raster.
+    static int grid_size(int w, int h) {
+        int tile = 2;
+        while (tile + 1 < std::max(w, h)) tile *= 2;
+        return tile + 1;
+    }
+
+    Rtin(std::vector<float> grid, int size) : size(size), heights(std::move(grid)), errors((size_t)size * size, 0.0f) {
+        // The deepest triangles have legs of length sqrt(2); compute a level
+        // at a time from there up, so each reads finished child errors.
+        const int tile = size - 1;
+        int depth = 0;
+        for (int t = tile; t > 1; t /= 2) depth += 2;
+        depth -= 1;
+        for (int level = depth; level >= 0; --level) {
+            update(0, 0, tile, tile, tile, 0, 0, level, level < depth);
+            update(tile, tile, 0, 0, 0, tile, 0, level, level < depth);
+        }
+    }
+
+    Mesh mesh(double max_error) const {
+        Mesh out;
+        std::vector<int> index((size_t)size * size, -1);
+        auto vertex = [&](int x, int y) {
+            int& id = index[(size_t)y * size + x];
+            if (id < 0) {
+                id = (int)out.vertices.size();
+                out.vertices.push_back({x, y});
+            }
+            return id;
+        };
+        const int tile = size - 1;
+        struct Triangle { int ax, ay, bx, by, cx, cy; };
+        std::vector<Triangle> stack = {{tile, tile, 0, 0, 0, tile}, {0, 0, tile, tile, tile, 0}};
+        while (!stack.empty()) {
+            Triangle t = stack.back();
+            stack.pop_back();
+            int mx = (t.ax + t.bx) / 2, my = (t.ay + t.by) / 2;
+            if (std::abs(t.ax - t.cx) + std::abs(t.ay - t.cy) > 1 && errors[(size_t)my * size + mx] > max_error) {
+                stack.push_back({t.bx, t.by, t.cx, t.cy, mx, my});
+                stack.push_back({t.cx, t.cy, t.ax, t.ay, mx, my});
+            } else {
+                out.triangles.push_back({vertex(t.ax, t.ay), vertex(t.bx, t.by), vertex(t.cx, t.cy)});
+            }
+        }
+        return out;
+    }
+
+private:
+    // Errors of the triangles at target depth below (a, b, c), whose
+    // hypotenuse is a-b and right angle c.
+    void update(int ax, int ay, int bx, int by, int cx, int cy, int level, int target, bool has_children) {
+        int mx = (ax + bx) / 2, my = (ay + by) / 2;
+        if (level < target) {
+            update(cx, cy, ax, ay, mx, my, level + 1, target, has_children);
+            update(bx, by, cx, cy, mx, my, level + 1, target, has_children);
+            return;
+        }
+        size_t middle = (size_t)my * size + mx;
+        float interpolated = (heights[(size_t)ay * size + ax] + heights[(size_t)by * size + bx]) / 2;
+        float error = std::abs(interpolated - heights[middle]);
+        if (has_children) {
+            error = std::max({error, errors[(size_t)((ay + cy) / 2) * size + (ax + cx) / 2],
+                                     errors[(size_t)((by + cy) / 2) * size + (bx + cx) / 2]});
+        }
+        errors[middle] = std::max(errors[middle], error);
+    }
+};
+
+} // namespace geo
+} // namespace jotcad
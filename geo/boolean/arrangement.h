@@ -0,0 +1,208 @@
+#pragma once
+
+#include <CGAL/Surface_mesh.h>
+#include <CGAL/Polygon_mesh_processing/autorefinement.h>
+#include <CGAL/Polygon_mesh_processing/polygon_soup_to_polygon_mesh.h>
+#include <CGAL/Polygon_mesh_processing/orient_polygon_soup.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
+#include <CGAL/Polygon_mesh_processing/bbox.h>
+#include <CGAL/Side_of_triangle_mesh.h>
+#include <CGAL/AABB_tree.h>
+#include <CGAL/AABB_traits.h>
+#include <CGAL/AABB_face_graph_triangle_primitive.h>
+#include <vector>
+#include <array>
+#include <map>
+#include <memory>
+#include "kernel.h"
+#include "../fix/repair.h"
+#include "classifier.h"
+
+namespace jotcad {
+namespace geo {
+namespace boolean {
+
+/**
+ * Arrangement: N-ary mesh booleans computed in a single pass.
+ *
+ * Instead of folding N inputs through N-1 corefinements, every input triangle
+ * is put into one soup and refined once (autorefinement), so that all
+ * intersections between all inputs are resolved together. Each refined
+ * triangle is then classified by the winding of the other inputs at its
+ * centroid, and the union, intersection or difference is extracted directly.
+ *
+ * Inputs must be closed; callers fall back to the pairwise path otherwise.
+ */
+struct Arrangement {
+    typedef CGAL::Surface_mesh<EK::Point_3> Mesh;
+    typedef std::array<std::size_t, 3> Triangle;
+
+    enum class Op { Union, Intersection, Difference };
+
+    // Records which input mesh each refined triangle came from.
+    struct OriginVisitor {
+        const std::vector<std::size_t>* input_owner;
+        std::vector<std::size_t>* output_owner;
+
+        void number_of_output_triangles(std::size_t nbt) { output_owner->resize(nbt); }
+        void verbatim_triangle_copy(std::size_t tgt, std::size_t src) { (*output_owner)[tgt] = (*input_owner)[src]; }
+        void new_subtriangle(std::size_t tgt, std::size_t src) { (*output_owner)[tgt] = (*input_owner)[src]; }
+        void delete_triangle(std::size_t /*src*/) {}
+    };
+
+    // How an input relates to the centroid of a refined triangle.
+    enum class Side { Outside, Inside, Coincident, Opposed };
+
+    struct Classifier {
+        typedef CGAL::AABB_face_graph_triangle_primitive<Mesh> Primitive;
+        typedef CGAL::AABB_traits<EK, Primitive> Traits;
+        typedef CGAL::AABB_tree<Traits> Tree;
+
+        const Mesh& mesh;
+        CGAL::Bbox_3 bounds;
+        Tree tree;
+        PointClassifier inside;
+
+        explicit Classifier(const Mesh& m)
+            : mesh(m), bounds(CGAL::Polygon_mesh_processing::bbox(m)), tree(faces(m).first, faces(m).second, m), inside(m) {}
+
+        Side classify(const EK::Point_3& c, const EK::Vector_3& normal) const {
+            // Most refined triangles lie far from most inputs; skip the
+            // point-in-mesh query when the centroid is outside the bounds.
+            if (!CGAL::do_overlap(c.bbox(), bounds)) return Side::Outside;
+            CGAL::Bounded_side side = inside(c);
+            if (side == CGAL::ON_BOUNDED_SIDE) return Side::Inside;
+            if (side == CGAL::ON_UNBOUNDED_SIDE) return Side::Outside;
+            // The centroid lies on this input's surface: compare facing.
+            auto f = tree.any_intersected_primitive(c);
+            if (!f) return Side::Outside;
+            auto h = mesh.halfedge(*f);
+            EK::Vector_3 n = CGAL::normal(mesh.point(mesh.source(h)), mesh.point(mesh.target(h)), mesh.point(mesh.target(mesh.next(h))));
+            return CGAL::scalar_product(n, normal) > 0 ? Side::Coincident : Side::Opposed;
+        }
+    };
+
+    /**
+     * keep: Decides whether a refined triangle owned by input i survives the
+     * operation, and whether it must be flipped. Coincident surfaces are kept
+     * once (by the lowest input index); opposed surfaces are internal contacts.
+     */
+    static bool keep(Op op, std::size_t i, const std::vector<Side>& sides, bool& flip) {
+        flip = false;
+        switch (op) {
+            case Op::Union:
+                for (std::size_t j = 0; j < sides.size(); ++j) {
+                    if (j == i) continue;
+                    if (sides[j] == Side::Inside || sides[j] == Side::Opposed) return false;
+                    if (sides[j] == Side::Coincident && j < i) return false;
+                }
+                return true;
+            case Op::Intersection:
+                for (std::size_t j = 0; j < sides.size(); ++j) {
+                    if (j == i) continue;
+                    if (sides[j] == Side::Outside || sides[j] == Side::Opposed) return false;
+                    if (sides[j] == Side::Coincident && j < i) return false;
+                }
+                return true;
+            case Op::Difference:
+                if (i == 0) {
+                    for (std::size_t j = 1; j < sides.size(); ++j) {
+                        if (sides[j] == Side::Inside || sides[j] == Side::Coincident) return false;
+                    }
+                    return true;
+                }
+                if (sides[0] != Side::Inside) return false;
+                for (std::size_t j = 1; j < sides.size(); ++j) {
+                    if (j == i) continue;
+                    if (sides[j] == Side::Inside || sides[j] == Side::Opposed) return false;
+                    if (sides[j] == Side::Coincident && j < i) return false;
+                }
+                flip = true;
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * compute: Applies op across all inputs. For Difference the first input is
+     * the subject and the remainder are tools. Returns false (leaving out
+     * untouched) if any input is not closed.
+     */
+    static bool compute(const std::vector<Mesh>& inputs, Op op, Mesh& out) {
+        for (const auto& m : inputs) if (!CGAL::is_closed(m)) return false;
+        if (inputs.empty()) { out.clear(); return true; }
+        if (inputs.size() == 1) { out = inputs[0]; return true; }
+
+        // 1. Gather every input triangle into one soup.
+        std::vector<EK::Point_3> points;
+        std::vector<Triangle> triangles;
+        std::vector<std::size_t> input_owner;
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            const Mesh& m = inputs[i];
+            std::map<Mesh::Vertex_index, std::size_t> v_map;
+            for (auto v : m.vertices()) { v_map[v] = points.size(); points.push_back(m.point(v)); }
+            for (auto f : m.faces()) {
+                std::vector<std::size_t> loop;
+                for (auto v : m.vertices_around_face(m.halfedge(f))) loop.push_back(v_map[v]);
+                for (std::size_t k = 1; k + 1 < loop.size(); ++k) {
+                    triangles.push_back({loop[0], loop[k], loop[k + 1]});
+                    input_owner.push_back(i);
+                }
+            }
+        }
+
+        // 2. Refine all intersections in one pass.
+        std::vector<std::size_t> output_owner;
+        OriginVisitor visitor{&input_owner, &output_owner};
+        CGAL::Polygon_mesh_processing::autorefine_triangle_soup(points, triangles, CGAL::parameters::visitor(visitor));
+
+        // 3. Classify each refined triangle against the other inputs.
+        std::vector<std::unique_ptr<Classifier>> classifiers;
+        for (const auto& m : inputs) classifiers.push_back(std::make_unique<Classifier>(m));
+
+        std::vector<std::vector<std::size_t>> kept;
+        std::vector<Side> sides(inputs.size());
+        for (std::size_t t = 0; t < triangles.size(); ++t) {
+            const Triangle& tri = triangles[t];
+            const EK::Point_3& p0 = points[tri[0]];
+            const EK::Point_3& p1 = points[tri[1]];
+            const EK::Point_3& p2 = points[tri[2]];
+            if (CGAL::collinear(p0, p1, p2)) continue;
+            std::size_t owner = output_owner[t];
+            EK::Point_3 c = CGAL::centroid(p0, p1, p2);
+            EK::Vector_3 n = CGAL::normal(p0, p1, p2);
+            for (std::size_t j = 0; j < inputs.size(); ++j) {
+                sides[j] = (j == owner) ? Side::Coincident : classifiers[j]->classify(c, n);
+            }
+            bool flip = false;
+            if (!keep(op, owner, sides, flip)) continue;
+            if (flip) kept.push_back({tri[0], tri[2], tri[1]});
+            else kept.push_back({tri[0], tri[1], tri[2]});
+        }
+
+        // 4. Rebuild a mesh from the surviving triangles.
+        std::vector<std::size_t> remap(points.size(), (std::size_t)-1);
+        std::vector<EK::Point_3> used_points;
+        for (auto& face : kept) {
+            for (auto& idx : face) {
+                if (remap[idx] == (std::size_t)-1) { remap[idx] = used_points.size(); used_points.push_back(points[idx]); }
+                idx = remap[idx];
+            }
+        }
+        if (!CGAL::Polygon_mesh_processing::is_polygon_soup_a_polygon_mesh(kept)) {
+            CGAL::Polygon_mesh_processing::orient_polygon_soup(used_points, kept);
+        }
+        out.clear();
+        CGAL::Polygon_mesh_processing::polygon_soup_to_polygon_mesh(used_points, kept, out);
+        // Orienting the soup may choose the inward facing for a component.
+        if (CGAL::is_closed(out) && !CGAL::Polygon_mesh_processing::is_outward_oriented(out)) {
+            CGAL::Polygon_mesh_processing::reverse_face_orientations(out);
+        }
+        fix::make_geometry_unambiguous(out);
+        return true;
+    }
+};
+
+} // namespace boolean
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,446 @@
+#pragma once
+
+#include <CGAL/Surface_mesh.h>
+#include <CGAL/Side_of_triangle_mesh.h>
+#include <vector>
+#include <array>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include "kernel.h"
+#include "../algorithms/raster.h"
+
+namespace jotcad {
+namespace geo {
+namespace boolean {
+
+/**
+ * TriangleBVH: A flattened bounding volume hierarchy over a triangle soup.
+ *
+ * Nodes are stored depth first in one array, with float bounds rounded
+ * outward so they always contain their triangles. Triangles are kept in leaf
+ * order as structure-of-arrays (vertex a and edges b-a, c-a) in double
+ * precision, so a leaf's triangles are read from contiguous memory. Every
+ * triangle remembers the face it came from.
+ */
+struct TriangleBVH {
+    static constexpr uint32_t kLeafSize = 4;
+
+    struct Node {
+        float lo[3], hi[3];
+        uint32_t start;  // First triangle for a leaf; right child for an interior node.
+        uint32_t count;  // Number of triangles; 0 for an interior node.
+    };
+
+    struct Hit { double t; uint32_t face; };
+
+    enum class RayResult { Miss, Hit, Edge, Parallel };
+
+    std::vector<Node> nodes;
+    std::vector<double> ax, ay, az, e1x, e1y, e1z, e2x, e2y, e2z;
+    std::vector<uint32_t> faces;
+    double scale = 1.0;
+
+    template <typename Mesh>
+    static TriangleBVH from_mesh(const Mesh& mesh) {
+        std::vector<std::array<double, 9>> tris;
+        std::vector<uint32_t> ids;
+        for (auto f : mesh.faces()) {
+            std::vector<std::array<double, 3>> loop;
+            for (auto v : mesh.vertices_around_face(mesh.halfedge(f))) {
+                const auto& p = mesh.point(v);
+                loop.push_back({CGAL::to_double(p.x()), CGAL::to_double(p.y()), CGAL::to_double(p.z())});
+            }
+            for (std::size_t k = 1; k + 1 < loop.size(); ++k) {
+                tris.push_back({loop[0][0], loop[0][1], loop[0][2], loop[k][0], loop[k][1], loop[k][2], loop[k + 1][0], loop[k + 1][1], loop[k + 1][2]});
+                ids.push_back((uint32_t)f.idx());
+            }
+        }
+        TriangleBVH bvh;
+        bvh.build(tris, ids);
+        return bvh;
+    }
+
+    void build(const std::vector<std::array<double, 9>>& tris, const std::vector<uint32_t>& ids) {
+        nodes.clear();
+        if (tris.empty()) return;
+        std::vector<uint32_t> order(tris.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::vector<std::array<double, 3>> centroids(tris.size());
+        for (std::size_t i = 0; i < tris.size(); ++i) {
+            for (int a = 0; a < 3; ++a) centroids[i][a] = (tris[i][a] + tris[i][3 + a] + tris[i][6 + a]) / 3.0;
+        }
+        nodes.reserve(2 * tris.size() / kLeafSize + 1);
+        build_node(tris, centroids, order, 0, (uint32_t)order.size());
+
+        for (auto* v : {&ax, &ay, &az, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z}) { v->clear(); v->reserve(order.size()); }
+        faces.clear();
+        for (uint32_t i : order) {
+            const auto& t = tris[i];
+            ax.push_back(t[0]); ay.push_back(t[1]); az.push_back(t[2]);
+            e1x.push_back(t[3] - t[0]); e1y.push_back(t[4] - t[1]); e1z.push_back(t[5] - t[2]);
+            e2x.push_back(t[6] - t[0]); e2y.push_back(t[7] - t[1]); e2z.push_back(t[8] - t[2]);
+            faces.push_back(ids[i]);
+        }
+        const Node& root = nodes[0];
+        scale = std::max({1.0, (double)root.hi[0] - root.lo[0], (double)root.hi[1] - root.lo[1], (double)root.hi[2] - root.lo[2]});
+    }
+
+    bool empty() const { return nodes.empty(); }
+
+    /**
+     * near_surface: True if some triangle may lie within eps of p. Uses the
+     * triangle's plane distance, a lower bound on its true distance, so it
+     * never misses a nearby triangle.
+     */
+    bool near_surface(const double p[3], double eps) const {
+        bool found = false;
+        traverse([&](const Node& n) { return box_contains(n, p, eps); }, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                double bx = ax[i] + e1x[i], by = ay[i] + e1y[i], bz = az[i] + e1z[i];
+                double cx = ax[i] + e2x[i], cy = ay[i] + e2y[i], cz = az[i] + e2z[i];
+                if (p[0] < std::min({ax[i], bx, cx}) - eps || p[0] > std::max({ax[i], bx, cx}) + eps) continue;
+                if (p[1] < std::min({ay[i], by, cy}) - eps || p[1] > std::max({ay[i], by, cy}) + eps) continue;
+                if (p[2] < std::min({az[i], bz, cz}) - eps || p[2] > std::max({az[i], bz, cz}) + eps) continue;
+                double nx = e1y[i] * e2z[i] - e1z[i] * e2y[i];
+                double ny = e1z[i] * e2x[i] - e1x[i] * e2z[i];
+                double nz = e1x[i] * e2y[i] - e1y[i] * e2x[i];
+                double dist = nx * (p[0] - ax[i]) + ny * (p[1] - ay[i]) + nz * (p[2] - az[i]);
+                if (std::abs(dist) <= eps * std::sqrt(nx * nx + ny * ny + nz * nz)) { found = true; return false; }
+            }
+            return true;
+        });
+        return found;
+    }
+
+    /**
+     * near_faces: The faces of triangles that may lie within eps of p, by the
+     * same test as near_surface.
+     */
+    std::vector<uint32_t> near_faces(const double p[3], double eps) const {
+        std::vector<uint32_t> out;
+        traverse([&](const Node& n) { return box_contains(n, p, eps); }, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                double bx = ax[i] + e1x[i], by = ay[i] + e1y[i], bz = az[i] + e1z[i];
+                double cx = ax[i] + e2x[i], cy = ay[i] + e2y[i], cz = az[i] + e2z[i];
+                if (p[0] < std::min({ax[i], bx, cx}) - eps || p[0] > std::max({ax[i], bx, cx}) + eps) continue;
+                if (p[1] < std::min({ay[i], by, cy}) - eps || p[1] > std::max({ay[i], by, cy}) + eps) continue;
+                if (p[2] < std::min({az[i], bz, cz}) - eps || p[2] > std::max({az[i], bz, cz}) + eps) continue;
+                double nx = e1y[i] * e2z[i] - e1z[i] * e2y[i];
+                double ny = e1z[i] * e2x[i] - e1x[i] * e2z[i];
+                double nz = e1x[i] * e2y[i] - e1y[i] * e2x[i];
+                double dist = nx * (p[0] - ax[i]) + ny * (p[1] - ay[i]) + nz * (p[2] - az[i]);
+                if (std::abs(dist) <= eps * std::sqrt(nx * nx + ny * ny + nz * nz)) out.push_back(faces[i]);
+            }
+            return true;
+        });
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    /**
+     * intersect: Moller-Trumbore test of the ray o + t*d against triangle i.
+     * Hits within tol (in barycentric terms) of an edge are reported as Edge,
+     * and rays (nearly) parallel to the triangle as Parallel, since a double
+     * evaluation cannot decide them.
+     */
+    RayResult intersect(uint32_t i, const double o[3], const double d[3], double& t) const {
+        const double tol = 1e-9;
+        double px = d[1] * e2z[i] - d[2] * e2y[i];
+        double py = d[2] * e2x[i] - d[0] * e2z[i];
+        double pz = d[0] * e2y[i] - d[1] * e2x[i];
+        double det = e1x[i] * px + e1y[i] * py + e1z[i] * pz;
+        double e1_len = std::sqrt(e1x[i] * e1x[i] + e1y[i] * e1y[i] + e1z[i] * e1z[i]);
+        double p_len = std::sqrt(px * px + py * py + pz * pz);
+        if (std::abs(det) <= tol * e1_len * p_len) return RayResult::Parallel;
+        double inv = 1.0 / det;
+        double sx = o[0] - ax[i], sy = o[1] - ay[i], sz = o[2] - az[i];
+        double u = (sx * px + sy * py + sz * pz) * inv;
+        if (u < -tol || u > 1.0 + tol) return RayResult::Miss;
+        double qx = sy * e1z[i] - sz * e1y[i];
+        double qy = sz * e1x[i] - sx * e1z[i];
+        double qz = sx * e1y[i] - sy * e1x[i];
+        double v = (d[0] * qx + d[1] * qy + d[2] * qz) * inv;
+        if (v < -tol || u + v > 1.0 + tol) return RayResult::Miss;
+        t = (e2x[i] * qx + e2y[i] * qy + e2z[i] * qz) * inv;
+        if (u < tol || v < tol || u + v > 1.0 - tol) return RayResult::Edge;
+        return RayResult::Hit;
+    }
+
+    /**
+     * coplanar_entry: For a ray lying in the plane of triangle i, the
+     * parameter at which it enters the triangle, if it crosses it at all.
+     */
+    bool coplanar_entry(uint32_t i, const double o[3], const double d[3], double& t) const {
+        double n[3] = {e1y[i] * e2z[i] - e1z[i] * e2y[i], e1z[i] * e2x[i] - e1x[i] * e2z[i], e1x[i] * e2y[i] - e1y[i] * e2x[i]};
+        double n_len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (n_len == 0.0) return false;
+        double dist = n[0] * (o[0] - ax[i]) + n[1] * (o[1] - ay[i]) + n[2] * (o[2] - az[i]);
+        if (std::abs(dist) > 1e-9 * scale * n_len) return false;
+
+        // Clip the ray against the inward half-plane of each edge.
+        double a[3] = {ax[i], ay[i], az[i]};
+        double b[3] = {ax[i] + e1x[i], ay[i] + e1y[i], az[i] + e1z[i]};
+        double c[3] = {ax[i] + e2x[i], ay[i] + e2y[i], az[i] + e2z[i]};
+        const double* corners[3] = {a, b, c};
+        double lo = -std::numeric_limits<double>::infinity(), hi = std::numeric_limits<double>::infinity();
+        for (int k = 0; k < 3; ++k) {
+            const double* p = corners[k];
+            const double* q = corners[(k + 1) % 3];
+            const double* r = corners[(k + 2) % 3];
+            double e[3] = {q[0] - p[0], q[1] - p[1], q[2] - p[2]};
+            double m[3] = {n[1] * e[2] - n[2] * e[1], n[2] * e[0] - n[0] * e[2], n[0] * e[1] - n[1] * e[0]};
+            if (m[0] * (r[0] - p[0]) + m[1] * (r[1] - p[1]) + m[2] * (r[2] - p[2]) < 0) for (double& x : m) x = -x;
+            double base = m[0] * (o[0] - p[0]) + m[1] * (o[1] - p[1]) + m[2] * (o[2] - p[2]);
+            double rate = m[0] * d[0] + m[1] * d[1] + m[2] * d[2];
+            if (rate == 0.0) {
+                if (base < 0) return false;
+            } else if (rate > 0) {
+                lo = std::max(lo, -base / rate);
+            } else {
+                hi = std::min(hi, -base / rate);
+            }
+        }
+        if (lo > hi) return false;
+        t = lo;
+        return true;
+    }
+
+    /**
+     * first_hit: The nearest hit with t > t_min, counting edge hits.
+     */
+    std::optional<Hit> first_hit(const double o[3], const double d[3], double t_min = 0.0) const {
+        std::optional<Hit> best;
+        double inv[3] = {1.0 / d[0], 1.0 / d[1], 1.0 / d[2]};
+        traverse([&](const Node& n) { return ray_box(n, o, inv, t_min, best ? best->t : std::numeric_limits<double>::infinity()); }, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                double t;
+                RayResult r = intersect(i, o, d, t);
+                if ((r == RayResult::Hit || r == RayResult::Edge) && t > t_min && (!best || t < best->t)) best = Hit{t, faces[i]};
+            }
+            return true;
+        });
+        return best;
+    }
+
+    /**
+     * any_hit: True if the ray hits any triangle at t > t_min. A ray running
+     * within a triangle's plane hits it where it enters the triangle.
+     */
+    bool any_hit(const double o[3], const double d[3], double t_min = 0.0) const {
+        bool found = false;
+        double inv[3] = {1.0 / d[0], 1.0 / d[1], 1.0 / d[2]};
+        traverse([&](const Node& n) { return ray_box(n, o, inv, t_min, std::numeric_limits<double>::infinity()); }, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                double t;
+                RayResult r = intersect(i, o, d, t);
+                if (r == RayResult::Parallel && !coplanar_entry(i, o, d, t)) continue;
+                if (r != RayResult::Miss && t > t_min) { found = true; return false; }
+            }
+            return true;
+        });
+        return found;
+    }
+
+    /**
+     * crossings: Number of triangles crossed by the ray from o, or nothing if
+     * some crossing is too close to an edge or too grazing to count reliably.
+     */
+    std::optional<std::size_t> crossings(const double o[3], const double d[3]) const {
+        std::size_t count_hits = 0;
+        bool ambiguous = false;
+        double inv[3] = {1.0 / d[0], 1.0 / d[1], 1.0 / d[2]};
+        traverse([&](const Node& n) { return ray_box(n, o, inv, 0.0, std::numeric_limits<double>::infinity()); }, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                double t;
+                RayResult r = intersect(i, o, d, t);
+                if (r == RayResult::Miss) continue;
+                if (r == RayResult::Hit) { if (t > 0.0) ++count_hits; continue; }
+                if (r == RayResult::Edge && t <= 0.0) continue;
+                ambiguous = true;
+                return false;
+            }
+            return true;
+        });
+        if (ambiguous) return std::nullopt;
+        return count_hits;
+    }
+
+  private:
+    static float round_down(double v) { float f = (float)v; return (double)f > v ? std::nextafter(f, -std::numeric_limits<float>::infinity()) : f; }
+    static float round_up(double v) { float f = (float)v; return (double)f < v ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f; }
+
+    uint32_t build_node(const std::vector<std::array<double, 9>>& tris, const std::vector<std::array<double, 3>>& centroids, std::vector<uint32_t>& order, uint32_t begin, uint32_t end) {
+        uint32_t index = (uint32_t)nodes.size();
+        nodes.push_back({});
+        double lo[3], hi[3], clo[3], chi[3];
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = clo[a] = std::numeric_limits<double>::infinity();
+            hi[a] = chi[a] = -std::numeric_limits<double>::infinity();
+        }
+        for (uint32_t k = begin; k < end; ++k) {
+            const auto& t = tris[order[k]];
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = std::min({lo[a], t[a], t[3 + a], t[6 + a]});
+                hi[a] = std::max({hi[a], t[a], t[3 + a], t[6 + a]});
+                clo[a] = std::min(clo[a], centroids[order[k]][a]);
+                chi[a] = std::max(chi[a], centroids[order[k]][a]);
+            }
+        }
+        for (int a = 0; a < 3; ++a) { nodes[index].lo[a] = round_down(lo[a]); nodes[index].hi[a] = round_up(hi[a]); }
+
+        if (end - begin <= kLeafSize) {
+            nodes[index].start = begin;
+            nodes[index].count = end - begin;
+            return index;
+        }
+        int axis = 0;
+        for (int a = 1; a < 3; ++a) if (chi[a] - clo[a] > chi[axis] - clo[axis]) axis = a;
+        uint32_t mid = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+        build_node(tris, centroids, order, begin, mid);
+        uint32_t right = build_node(tris, centroids, order, mid, end);
+        nodes[index].start = right;
+        nodes[index].count = 0;
+        return index;
+    }
+
+    template <typename BoxTest, typename LeafVisit>
+    void traverse(BoxTest box_test, LeafVisit leaf_visit) const {
+        if (nodes.empty()) return;
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& n = nodes[stack[--top]];
+            if (!box_test(n)) continue;
+            if (n.count > 0) {
+                if (!leaf_visit(n.start, n.count)) return;
+                continue;
+            }
+            uint32_t left = (uint32_t)(&n - nodes.data()) + 1;
+            stack[top++] = n.start;
+            stack[top++] = left;
+        }
+    }
+
+    static bool box_contains(const Node& n, const double p[3], double eps) {
+        for (int a = 0; a < 3; ++a) if (p[a] < n.lo[a] - eps || p[a] > n.hi[a] + eps) return false;
+        return true;
+    }
+
+    static bool ray_box(const Node& n, const double o[3], const double inv[3], double t_min, double t_max) {
+        for (int a = 0; a < 3; ++a) {
+            double t0 = (n.lo[a] - o[a]) * inv[a];
+            double t1 = (n.hi[a] - o[a]) * inv[a];
+            if (t0 > t1) std::swap(t0, t1);
+            t_min = std::max(t_min, t0);
+            t_max = std::min(t_max, t1);
+            if (t_min > t_max) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * PointClassifier: Batched point-in-solid tests against an exact mesh.
+ *
+ * Points are first classified in double precision by ray parity over a
+ * TriangleBVH. Points within a small tolerance of the surface, and rays that
+ * graze an edge, fall back to the exact predicates (Side_of_triangle_mesh for
+ * closed meshes), so the answer always matches the exact path. For an open
+ * mesh the only sides are ON_BOUNDARY (on the surface) and
+ * ON_UNBOUNDED_SIDE, decided exactly against the faces the BVH finds near
+ * the point.
+ *
+ * classify() runs the double-precision tests over bands of points on
+ * worker threads and then resolves the remaining points exactly on the
+ * calling thread. The exact predicate for a closed mesh is built on first
+ * use and the fallback count is updated by every query, so a classifier
+ * must not be shared between threads; give each thread its own.
+ */
+struct PointClassifier {
+    typedef CGAL::Surface_mesh<EK::Point_3> Mesh;
+
+    explicit PointClassifier(const Mesh& mesh) : mesh_(mesh), closed_(CGAL::is_closed(mesh)), bvh_(TriangleBVH::from_mesh(mesh)) {
+        eps_ = 1e-9 * bvh_.scale;
+    }
+
+    bool is_closed() const { return closed_; }
+
+    // Number of points so far that needed the exact predicates.
+    std::size_t exact_fallbacks() const { return fallbacks_; }
+
+    CGAL::Bounded_side operator()(const EK::Point_3& point) const {
+        double p[3] = {CGAL::to_double(point.x()), CGAL::to_double(point.y()), CGAL::to_double(point.z())};
+        auto side = approximate(p);
+        return side ? *side : exact(point, p);
+    }
+
+    std::vector<CGAL::Bounded_side> classify(const std::vector<EK::Point_3>& points) const {
+        // Lazy exact coordinates are not safe to touch from several threads,
+        // so they are rounded here and the workers only read doubles.
+        std::vector<double> coords(points.size() * 3);
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            coords[i * 3] = CGAL::to_double(points[i].x());
+            coords[i * 3 + 1] = CGAL::to_double(points[i].y());
+            coords[i * 3 + 2] = CGAL::to_double(points[i].z());
+        }
+        std::vector<std::optional<CGAL::Bounded_side>> fast(points.size());
+        Raster::parallel_bands((int)points.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) fast[i] = approximate(&coords[(std::size_t)i * 3]);
+        }, 256);
+        std::vector<CGAL::Bounded_side> sides(points.size());
+        for (std::size_t i = 0; i < points.size(); ++i) sides[i] = fast[i] ? *fast[i] : exact(points[i], &coords[i * 3]);
+        return sides;
+    }
+
+  private:
+    // The side decided in double precision, or nothing if it needs the exact
+    // predicates. Reads only the BVH, so it may run on several threads.
+    std::optional<CGAL::Bounded_side> approximate(const double p[3]) const {
+        if (bvh_.empty()) return CGAL::ON_UNBOUNDED_SIDE;
+        const TriangleBVH::Node& root = bvh_.nodes[0];
+        for (int a = 0; a < 3; ++a) if (p[a] < root.lo[a] - eps_ || p[a] > root.hi[a] + eps_) return CGAL::ON_UNBOUNDED_SIDE;
+        if (bvh_.near_surface(p, eps_)) return std::nullopt;
+        if (!closed_) return CGAL::ON_UNBOUNDED_SIDE;
+        // A fixed skew direction avoids systematic alignment with axis-aligned edges.
+        static const double d[3] = {0.5773502691896258, 0.6180339887498949, 0.5345224838248488};
+        auto count = bvh_.crossings(p, d);
+        if (!count) return std::nullopt;
+        return (*count % 2) ? CGAL::ON_BOUNDED_SIDE : CGAL::ON_UNBOUNDED_SIDE;
+    }
+
+    CGAL::Bounded_side exact(const EK::Point_3& point, const double p[3]) const {
+        ++fallbacks_;
+        if (closed_) {
+            if (!side_) side_ = std::make_unique<CGAL::Side_of_triangle_mesh<Mesh, EK>>(mesh_);
+            return (*side_)(point);
+        }
+        for (uint32_t f : bvh_.near_faces(p, eps_)) {
+            std::vector<EK::Point_3> loop;
+            for (auto v : mesh_.vertices_around_face(mesh_.halfedge(Mesh::Face_index(f)))) loop.push_back(mesh_.point(v));
+            for (std::size_t k = 1; k + 1 < loop.size(); ++k) {
+                if (CGAL::collinear(loop[0], loop[k], loop[k + 1])) continue;
+                if (EK::Triangle_3(loop[0], loop[k], loop[k + 1]).has_on(point)) return CGAL::ON_BOUNDARY;
+            }
+        }
+        return CGAL::ON_UNBOUNDED_SIDE;
+    }
+
+    const Mesh& mesh_;
+    bool closed_;
+    TriangleBVH bvh_;
+    double eps_;
+    mutable std::unique_ptr<CGAL::Side_of_triangle_mesh<Mesh, EK>> side_;
+    mutable std::size_t fallbacks_ = 0;
+};
+
+} // namespace boolean
+} // namespace geo
+} // namespace jotcad
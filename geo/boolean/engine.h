@@ -19,8 +19,13 @@
 #include <set>
 #include <cassert>
 #include <iterator>
+#include <optional>
 #include "kernel.h"
 #include "../fix/repair.h"
+#include "arrangement.h"
+#include "classifier.h"
+#include "polygon_set.h"
+#include "../core/derived.h"
 #include "../data/geometry.h"
 #include "../data/shape.h"
 #include "../math/matrix.h"
@@ -34,12 +39,24 @@ typedef CGAL::Surface_mesh<EK::Point_3> ExactMesh;
 typedef ExactMesh Surface_mesh; // Alias for compatibility
 typedef CGAL::Surface_mesh<IK::Point_3> InexactMesh;
 typedef InexactMesh InexactSurfaceMesh; // Alias for compatibility
-typedef CGAL::Gps_segment_traits_2<EK> Gps_traits_2;
-typedef CGAL::General_polygon_set_2<Gps_traits_2> General_polygon_set_2;
-typedef CGAL::Polygon_2<EK> Polygon_2;
-typedef CGAL::Polygon_with_holes_2<EK> Polygon_with_holes_2;
 
 struct Engine {
+    /**
+     * Mode: How N-ary mesh booleans are evaluated.
+     * Pairwise folds each tool into the target with its own corefinement;
+     * Arrangement refines all inputs together and extracts the result once;
+     * Incremental cuts by all closed tools in one corefinement, reusing cached
+     * unions of overlapping tools, so moving one tool only re-joins the tools
+     * it overlaps.
+     */
+    enum class Mode { Pairwise, Arrangement, Incremental };
+
+    static Mode mode_from_string(const std::string& name) {
+        if (name == "arrangement") return Mode::Arrangement;
+        if (name == "incremental") return Mode::Incremental;
+        return Mode::Pairwise;
+    }
+
     /**
      * cut_mesh_by_mesh: 3D Volume-Volume subtraction OR Surface-Volume subtraction.
      */
@@ -56,17 +73,21 @@ struct Engine {
         if (CGAL::is_closed(tool)) {
             ExactMesh tool_copy = tool; // split needs non-const splitter
             CGAL::Polygon_mesh_processing::split(target, tool_copy);
-            CGAL::Side_of_triangle_mesh<ExactMesh, EK> inside_check(tool_copy);
-            std::vector<ExactMesh::Face_index> to_remove;
+            PointClassifier inside_check(tool_copy);
+            std::vector<ExactMesh::Face_index> candidates;
+            std::vector<EK::Point_3> centroids;
             for (auto f : target.faces()) {
                 auto h = target.halfedge(f);
                 auto p0 = target.point(target.source(h));
                 auto p1 = target.point(target.target(h));
                 auto p2 = target.point(target.target(target.next(h)));
-                auto mid = CGAL::centroid(p0, p1, p2);
-                if (inside_check(mid) != CGAL::ON_UNBOUNDED_SIDE) {
-                    to_remove.push_back(f);
-                }
+                candidates.push_back(f);
+                centroids.push_back(CGAL::centroid(p0, p1, p2));
+            }
+            std::vector<CGAL::Bounded_side> sides = inside_check.classify(centroids);
+            std::vector<ExactMesh::Face_index> to_remove;
+            for (std::size_t i = 0; i < candidates.size(); ++i) {
+                if (sides[i] != CGAL::ON_UNBOUNDED_SIDE) to_remove.push_back(candidates[i]);
             }
             for (auto f : to_remove) {
                 CGAL::Euler::remove_face(target.halfedge(f), target);
@@ -88,6 +109,28 @@ struct Engine {
         return success;
     }
 
+    /**
+     * join_meshes: 3D Volume union of a target with many tools.
+     * Open meshes are skipped and reported as failures, matching
+     * join_mesh_by_mesh; in Arrangement mode they take the pairwise path.
+     */
+    static bool join_meshes(ExactMesh& target, std::vector<ExactMesh>& tools, Mode mode = Mode::Pairwise) {
+        bool success = true;
+        if (mode == Mode::Arrangement && CGAL::is_closed(target)) {
+            std::vector<ExactMesh> inputs = {target};
+            std::vector<ExactMesh> open;
+            for (auto& tool : tools) {
+                if (CGAL::is_closed(tool)) inputs.push_back(std::move(tool));
+                else open.push_back(std::move(tool));
+            }
+            success = Arrangement::compute(inputs, Arrangement::Op::Union, target);
+            for (auto& tool : open) success = join_mesh_by_mesh(target, tool) && success;
+            return success;
+        }
+        for (auto& tool : tools) success = join_mesh_by_mesh(target, tool) && success;
+        return success;
+    }
+
     /**
      * clip_mesh_by_mesh: 3D Volume-Volume intersection OR Surface-Volume intersection.
      */
@@ -122,18 +165,14 @@ struct Engine {
 
     static void cut_points_by_mesh(std::vector<EK::Point_3>& points, const ExactMesh& tool) {
         if (points.empty()) return;
-        bool is_closed = CGAL::is_closed(tool);
-        typedef CGAL::AABB_face_graph_triangle_primitive<ExactMesh> Primitive;
-        typedef CGAL::AABB_traits<EK, Primitive> Traits;
-        typedef CGAL::AABB_tree<Traits> Tree;
-        Tree tree(faces(tool).first, faces(tool).second, tool);
-        std::unique_ptr<CGAL::Side_of_triangle_mesh<ExactMesh, EK>> inside_check;
-        if (is_closed) inside_check = std::make_unique<CGAL::Side_of_triangle_mesh<ExactMesh, EK>>(tool);
-
-        points.erase(std::remove_if(points.begin(), points.end(), [&](const EK::Point_3& p) {
-            if (is_closed) return inside_check->operator()(p) != CGAL::ON_UNBOUNDED_SIDE;
-            return tree.do_intersect(p);
-        }), points.end());
+        // Closed tools classify by volume; open tools only by lying on the surface.
+        PointClassifier inside_check(tool);
+        std::vector<CGAL::Bounded_side> sides = inside_check.classify(points);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (sides[i] == CGAL::ON_UNBOUNDED_SIDE) points[kept++] = points[i];
+        }
+        points.resize(kept);
     }
 
     static void cut_points_by_plane(std::vector<EK::Point_3>& points, const EK::Plane_3& plane) {
@@ -158,18 +197,14 @@ struct Engine {
 
     static void clip_points_by_mesh(std::vector<EK::Point_3>& points, const ExactMesh& tool) {
         if (points.empty()) return;
-        bool is_closed = CGAL::is_closed(tool);
-        typedef CGAL::AABB_face_graph_triangle_primitive<ExactMesh> Primitive;
-        typedef CGAL::AABB_traits<EK, Primitive> Traits;
-        typedef CGAL::AABB_tree<Traits> Tree;
-        Tree tree(faces(tool).first, faces(tool).second, tool);
-        std::unique_ptr<CGAL::Side_of_triangle_mesh<ExactMesh, EK>> inside_check;
-        if (is_closed) inside_check = std::make_unique<CGAL::Side_of_triangle_mesh<ExactMesh, EK>>(tool);
-
-        points.erase(std::remove_if(points.begin(), points.end(), [&](const EK::Point_3& p) {
-            if (is_closed) return inside_check->operator()(p) == CGAL::ON_UNBOUNDED_SIDE;
-            return !tree.do_intersect(p);
-        }), points.end());
+        // Closed tools classify by volume; open tools only by lying on the surface.
+        PointClassifier inside_check(tool);
+        std::vector<CGAL::Bounded_side> sides = inside_check.classify(points);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (sides[i] != CGAL::ON_UNBOUNDED_SIDE) points[kept++] = points[i];
+        }
+        points.resize(kept);
     }
 
     static void clip_points_by_plane(std::vector<EK::Point_3>& points, const EK::Plane_3& plane) {
@@ -205,8 +240,7 @@ struct Engine {
         typedef CGAL::AABB_traits<EK, Primitive> Traits;
         typedef CGAL::AABB_tree<Traits> Tree;
         Tree tree(faces(tool).first, faces(tool).second, tool);
-        std::unique_ptr<CGAL::Side_of_triangle_mesh<ExactMesh, EK>> inside_check;
-        if (is_closed) inside_check = std::make_unique<CGAL::Side_of_triangle_mesh<ExactMesh, EK>>(tool);
+        PointClassifier inside_check(tool);
 
         std::vector<std::pair<EK::Point_3, EK::Point_3>> result;
         for (const auto& seg : segments) {
@@ -225,7 +259,7 @@ struct Engine {
             for (size_t i = 0; i < split_pts.size() - 1; ++i) {
                 if (split_pts[i] == split_pts[i+1]) continue;
                 EK::Point_3 mid = CGAL::midpoint(split_pts[i], split_pts[i+1]);
-                bool is_inside = is_closed ? (inside_check->operator()(mid) != CGAL::ON_UNBOUNDED_SIDE) : tree.do_intersect(mid);
+                bool is_inside = is_closed ? (inside_check(mid) != CGAL::ON_UNBOUNDED_SIDE) : tree.do_intersect(mid);
                 if (!is_inside) result.push_back({split_pts[i], split_pts[i+1]});
             }
         }
@@ -289,8 +323,7 @@ struct Engine {
         typedef CGAL::AABB_traits<EK, Primitive> Traits;
         typedef CGAL::AABB_tree<Traits> Tree;
         Tree tree(faces(tool).first, faces(tool).second, tool);
-        std::unique_ptr<CGAL::Side_of_triangle_mesh<ExactMesh, EK>> inside_check;
-        if (is_closed) inside_check = std::make_unique<CGAL::Side_of_triangle_mesh<ExactMesh, EK>>(tool);
+        PointClassifier inside_check(tool);
 
         std::vector<std::pair<EK::Point_3, EK::Point_3>> result;
         for (const auto& seg : segments) {
@@ -309,7 +342,7 @@ struct Engine {
             for (size_t i = 0; i < split_pts.size() - 1; ++i) {
                 if (split_pts[i] == split_pts[i+1]) continue;
                 EK::Point_3 mid = CGAL::midpoint(split_pts[i], split_pts[i+1]);
-                bool is_inside = is_closed ? (inside_check->operator()(mid) != CGAL::ON_UNBOUNDED_SIDE) : tree.do_intersect(mid);
+                bool is_inside = is_closed ? (inside_check(mid) != CGAL::ON_UNBOUNDED_SIDE) : tree.do_intersect(mid);
                 if (is_inside) result.push_back({split_pts[i], split_pts[i+1]});
             }
         }
@@ -516,21 +549,28 @@ struct Engine {
 
     static void transform_mesh(ExactMesh& mesh, const Matrix& tf) { for (auto v : mesh.vertices()) mesh.point(v) = tf.transform(mesh.point(v)); }
 
-    static void add_geometry_to_gps(const Geometry& geo, const Matrix& tf, General_polygon_set_2& gps) {
+    /**
+     * add_geometry_to_batch: Projects each face of geo through tf into the
+     * batch; faces with a non-simple boundary are skipped.
+     */
+    static void add_geometry_to_batch(const Geometry& geo, const Matrix& tf, PolygonBatch& batch) {
         Geometry t = geo; t.apply_tf(tf);
         for (const auto& face : t.faces) {
             if (face.loops.empty()) continue;
             Polygon_2 boundary; for (int idx : face.loops[0]) boundary.push_back(EK::Point_2(t.vertices[idx].x, t.vertices[idx].y));
             try {
-                if (boundary.is_empty() || !boundary.is_simple()) continue;
-                if (boundary.is_clockwise_oriented()) boundary.reverse_orientation();
                 std::vector<Polygon_2> holes;
-                for (size_t i = 1; i < face.loops.size(); ++i) { Polygon_2 h; for (int idx : face.loops[i]) h.push_back(EK::Point_2(t.vertices[idx].x, t.vertices[idx].y)); if (h.is_simple()) { if (h.is_counterclockwise_oriented()) h.reverse_orientation(); holes.push_back(h); } }
-                gps.join(Polygon_with_holes_2(boundary, holes.begin(), holes.end()));
+                for (size_t i = 1; i < face.loops.size(); ++i) { Polygon_2 h; for (int idx : face.loops[i]) h.push_back(EK::Point_2(t.vertices[idx].x, t.vertices[idx].y)); holes.push_back(h); }
+                batch.add(boundary, holes);
             } catch (...) {}
         }
     }
 
+    static void add_geometry_to_gps(const Geometry& geo, const Matrix& tf, General_polygon_set_2& gps) {
+        PolygonBatch batch; add_geometry_to_batch(geo, tf, batch);
+        batch.join_into(gps);
+    }
+
     static Geometry gps_to_geometry(const General_polygon_set_2& gps) {
         Geometry g;
         std::vector<Polygon_with_holes_2> pwhs; gps.polygons_with_holes(std::back_inserter(pwhs));
@@ -544,21 +584,105 @@ struct Engine {
         return g;
     }
 
-    struct ToolNode { Geometry geo; Matrix world_tf; std::string type; bool is_gap = false; };
+    struct ToolNode { Geometry geo; Matrix world_tf; std::string type; bool is_gap = false; std::optional<fs::CID> cid; };
 
     static void collect_tool_geometry(fs::VFSNode* vfs, const Shape& s, const Matrix& /*ignored_parent_tf*/, std::vector<ToolNode>& tool_nodes) {
         if (s.is_ghost() || s.is_mark() || s.is_mask()) return;
         Matrix current_tf = s.tf;
         std::string type = s.tags.value("type", "");
         bool is_gap = s.is_gap();
-        if (s.geometry.has_value()) tool_nodes.push_back({vfs->read<Geometry>(s.geometry.value()), current_tf, type, is_gap});
+        if (s.geometry.has_value()) tool_nodes.push_back({vfs->read<Geometry>(s.geometry.value()), current_tf, type, is_gap, s.geometry.value()});
         else if (type == "plane") tool_nodes.push_back({Geometry(), current_tf, type, is_gap});
         for (const auto& child : s.components) collect_tool_geometry(vfs, child, current_tf /* unused */, tool_nodes);
     }
 
+    // --- Incremental Cut ---
+
+    /**
+     * IncrementalTool: A closed tool placed relative to the subject. The key
+     * identifies it by geometry CID and placement, so an unchanged tool keeps
+     * its key across edits.
+     */
+    struct IncrementalTool { std::string key; ExactMesh mesh; CGAL::Bbox_3 bbox; };
+
+    static IncrementalTool make_incremental_tool(const Geometry& geo, const fs::CID& cid, const Matrix& rel_tf) {
+        IncrementalTool tool;
+        tool.key = nlohmann::json{{"g", cid.value}, {"tf", rel_tf.to_vec()}}.dump();
+        tool.mesh = geometry_to_mesh(geo);
+        transform_mesh(tool.mesh, rel_tf);
+        bool first = true;
+        for (auto v : tool.mesh.vertices()) {
+            CGAL::Bbox_3 b = tool.mesh.point(v).bbox();
+            tool.bbox = first ? b : tool.bbox + b;
+            first = false;
+        }
+        return tool;
+    }
+
+    // The cached union of a cluster of overlapping tools.
+    static fs::Selector incremental_union_key(std::vector<std::string> tool_keys) {
+        std::sort(tool_keys.begin(), tool_keys.end());
+        return Derived::key("cut_union", {{"tools", tool_keys}});
+    }
+
+    /**
+     * incremental_cut: Subtracts closed tools from target in one
+     * corefinement, reusing cached unions of the tools around unchanged ones.
+     *
+     * Tools whose bounds overlap, directly or through others, form a cluster.
+     * Clusters are disjoint, so their unions are appended into one cutter
+     * without further booleans. The union of each cluster of two or more
+     * tools is cached by its tool keys alone, so moving one tool only joins
+     * the tools of the clusters it leaves and enters. Clusters are ordered
+     * by their first key and always continue from the stored union, so the
+     * result is the same whichever unions happen to be cached.
+     */
+    static bool incremental_cut(fs::VFSNode* vfs, ExactMesh& target, std::vector<IncrementalTool>& tools) {
+        std::sort(tools.begin(), tools.end(), [](const IncrementalTool& a, const IncrementalTool& b) { return a.key < b.key; });
+        std::vector<std::size_t> parent(tools.size());
+        for (std::size_t i = 0; i < parent.size(); ++i) parent[i] = i;
+        auto find = [&](std::size_t i) {
+            while (parent[i] != i) i = parent[i] = parent[parent[i]];
+            return i;
+        };
+        for (std::size_t i = 0; i < tools.size(); ++i) {
+            for (std::size_t j = i + 1; j < tools.size(); ++j) {
+                if (!CGAL::do_overlap(tools[i].bbox, tools[j].bbox)) continue;
+                std::size_t a = find(i), b = find(j);
+                if (a != b) parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+        // Roots are each cluster's first tool, so clusters follow key order.
+        std::map<std::size_t, std::vector<std::size_t>> clusters;
+        for (std::size_t i = 0; i < tools.size(); ++i) clusters[find(i)].push_back(i);
+
+        ExactMesh cutter;
+        for (const auto& [root, members] : clusters) {
+            if (members.size() == 1) {
+                cutter.join(tools[root].mesh);
+                continue;
+            }
+            std::vector<std::string> keys;
+            for (std::size_t i : members) keys.push_back(tools[i].key);
+            fs::Selector key = incremental_union_key(keys);
+            Geometry joined;
+            if (auto hit = Derived::lookup(vfs, key)) {
+                joined = vfs->read<Geometry>(*hit);
+            } else {
+                ExactMesh part = tools[members[0]].mesh;
+                for (std::size_t k = 1; k < members.size(); ++k) join_mesh_by_mesh(part, tools[members[k]].mesh);
+                joined = mesh_to_geometry(part);
+                Derived::store(vfs, key, vfs->materialize<Geometry>(joined));
+            }
+            cutter.join(geometry_to_mesh(joined));
+        }
+        if (cutter.is_empty()) return true;
+        return cut_mesh_by_mesh(target, cutter);
+    }
+
     // --- Recursive Boolean Orchestrators ---
 
-    static void recursive_subtract(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const std::vector<ToolNode>& tool_nodes, bool open, bool stamp = false) {
+    static void recursive_subtract(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const std::vector<ToolNode>& tool_nodes, bool open, bool stamp = false, Mode mode = Mode::Pairwise) {
         if (!s.is_solid() && !s.is_gap()) return;
         Matrix subject_world_tf = parent_tf * s.tf;
         Matrix subject_world_inv = subject_world_tf.inverse();
@@ -578,17 +702,26 @@ struct Engine {
                     Matrix rehydrate_tf = project_tf.inverse();
                     General_polygon_set_2 subject_set; add_geometry_to_gps(target_geo, project_tf, subject_set);
                     bool used_pwh_path = false;
+                    PolygonBatch tool_batch;
                     for (const auto& tool : tool_nodes) {
                         Geometry local_tool_geo = tool.geo; Matrix tool_rel_tf = subject_world_inv * tool.world_tf; local_tool_geo.apply_tf(tool_rel_tf);
-                        if (local_tool_geo.is_coplanar_with(target_plane)) { General_polygon_set_2 tool_set; add_geometry_to_gps(local_tool_geo, project_tf, tool_set); cut_gps_by_gps(subject_set, tool_set); used_pwh_path = true; }
+                        if (local_tool_geo.is_coplanar_with(target_plane)) { add_geometry_to_batch(local_tool_geo, project_tf, tool_batch); used_pwh_path = true; }
                         else if (tool.type == "closed" || tool.type == "open" || tool.type == "surface") { used_pwh_path = false; break; }
                     }
-                    if (used_pwh_path) { target_geo = gps_to_geometry(subject_set); target_geo.apply_tf(rehydrate_tf); }
+                    if (used_pwh_path) { tool_batch.cut_from(subject_set); target_geo = gps_to_geometry(subject_set); target_geo.apply_tf(rehydrate_tf); }
                     else is_target_flat = false;
                 }
                 if (!is_target_flat || (original_is_flat && stamp)) {
                     ExactMesh target_mesh = geometry_to_mesh(target_geo);
+                    std::vector<IncrementalTool> incremental_tools;
+                    bool incremental = mode == Mode::Incremental && !original_is_flat && !tool_nodes.empty();
                     for (const auto& tool : tool_nodes) {
+                        if (!incremental) break;
+                        if (tool.type != "closed" || !tool.cid.has_value()) { incremental = false; break; }
+                        incremental_tools.push_back(make_incremental_tool(tool.geo, tool.cid.value(), subject_world_inv * tool.world_tf));
+                    }
+                    if (incremental) incremental_cut(vfs, target_mesh, incremental_tools);
+                    else for (const auto& tool : tool_nodes) {
                         if (tool.type == "plane") cut_mesh_by_plane(target_mesh, (subject_world_inv * tool.world_tf).transform(EK::Plane_3(0,0,1,0)));
                         else if (tool.type == "closed" || tool.type == "open" || tool.type == "surface") { 
                             ExactMesh tool_mesh = geometry_to_mesh(tool.geo); 
@@ -628,10 +761,10 @@ struct Engine {
             }
             s.geometry = vfs->materialize<Geometry>(target_geo);
         }
-        for (auto& child : s.components) recursive_subtract(vfs, child, subject_world_tf, tool_nodes, open, stamp);
+        for (auto& child : s.components) recursive_subtract(vfs, child, subject_world_tf, tool_nodes, open, stamp, mode);
     }
 
-    static void recursive_union(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const std::vector<ToolNode>& tool_nodes) {
+    static void recursive_union(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const std::vector<ToolNode>& tool_nodes, Mode mode = Mode::Pairwise) {
         if (!s.is_solid() && !s.is_gap()) return;
         Matrix subject_world_tf = parent_tf * s.tf;
         Matrix subject_world_inv = subject_world_tf.inverse();
@@ -653,22 +786,28 @@ struct Engine {
                     Matrix rehydrate_tf = project_tf.inverse();
                     General_polygon_set_2 subject_set; add_geometry_to_gps(target_geo, project_tf, subject_set);
                     bool used_pwh_path = true;
+                    PolygonBatch tool_batch;
                     for (const auto& tool : regular_tools) {
                         Geometry local_tool_geo = tool.geo; Matrix tool_rel_tf = subject_world_inv * tool.world_tf; local_tool_geo.apply_tf(tool_rel_tf);
-                        if (local_tool_geo.is_coplanar_with(target_plane)) { General_polygon_set_2 tool_set; add_geometry_to_gps(local_tool_geo, project_tf, tool_set); join_gps_by_gps(subject_set, tool_set); }
+                        if (local_tool_geo.is_coplanar_with(target_plane)) add_geometry_to_batch(local_tool_geo, project_tf, tool_batch);
                         else { used_pwh_path = false; break; }
                     }
                     if (used_pwh_path) {
+                        tool_batch.join_into(subject_set);
+                        PolygonBatch gap_batch;
                         for (const auto& gap : gap_tools) {
                             Geometry local_gap_geo = gap.geo; Matrix gap_rel_tf = subject_world_inv * gap.world_tf; local_gap_geo.apply_tf(gap_rel_tf);
-                            if (local_gap_geo.is_coplanar_with(target_plane)) { General_polygon_set_2 gap_set; add_geometry_to_gps(local_gap_geo, project_tf, gap_set); cut_gps_by_gps(subject_set, gap_set); }
+                            if (local_gap_geo.is_coplanar_with(target_plane)) add_geometry_to_batch(local_gap_geo, project_tf, gap_batch);
                         }
+                        gap_batch.cut_from(subject_set);
                         target_geo = gps_to_geometry(subject_set); target_geo.apply_tf(rehydrate_tf);
                     } else is_target_flat = false;
                 }
                 if (!is_target_flat) {
                     ExactMesh target_mesh = geometry_to_mesh(target_geo);
-                    for (const auto& tool : regular_tools) if (tool.type == "closed" || tool.type == "open" || tool.type == "surface") { ExactMesh tool_mesh = geometry_to_mesh(tool.geo); transform_mesh(tool_mesh, subject_world_inv * tool.world_tf); join_mesh_by_mesh(target_mesh, tool_mesh); }
+                    std::vector<ExactMesh> tool_meshes;
+                    for (const auto& tool : regular_tools) if (tool.type == "closed" || tool.type == "open" || tool.type == "surface") { ExactMesh tool_mesh = geometry_to_mesh(tool.geo); transform_mesh(tool_mesh, subject_world_inv * tool.world_tf); tool_meshes.push_back(std::move(tool_mesh)); }
+                    join_meshes(target_mesh, tool_meshes, mode);
                     for (const auto& gap : gap_tools) if (gap.type == "closed" || gap.type == "open" || gap.type == "surface") { ExactMesh gap_mesh = geometry_to_mesh(gap.geo); transform_mesh(gap_mesh, subject_world_inv * gap.world_tf); cut_mesh_by_mesh(target_mesh, gap_mesh); }
                     target_geo = mesh_to_geometry(target_mesh);
                 }
@@ -696,7 +835,7 @@ struct Engine {
             }
             s.geometry = vfs->materialize<Geometry>(target_geo);
         }
-        for (auto& child : s.components) recursive_union(vfs, child, subject_world_tf, tool_nodes);
+        for (auto& child : s.components) recursive_union(vfs, child, subject_world_tf, tool_nodes, mode);
     }
 
     static void recursive_intersect(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const std::vector<ToolNode>& tool_nodes) {
@@ -727,10 +866,12 @@ struct Engine {
                         else { used_pwh_path = false; break; }
                     }
                     if (used_pwh_path) {
+                        PolygonBatch gap_batch;
                         for (const auto& gap : gap_tools) {
                             Geometry local_gap_geo = gap.geo; Matrix gap_rel_tf = subject_world_inv * gap.world_tf; local_gap_geo.apply_tf(gap_rel_tf);
-                            if (local_gap_geo.is_coplanar_with(target_plane)) { General_polygon_set_2 gap_set; add_geometry_to_gps(local_gap_geo, project_tf, gap_set); cut_gps_by_gps(subject_set, gap_set); }
+                            if (local_gap_geo.is_coplanar_with(target_plane)) add_geometry_to_batch(local_gap_geo, project_tf, gap_batch);
                         }
+                        gap_batch.cut_from(subject_set);
                         target_geo = gps_to_geometry(subject_set); target_geo.apply_tf(rehydrate_tf);
                     } else is_target_flat = false;
                 }
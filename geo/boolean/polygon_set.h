@@ -0,0 +1,107 @@
+#pragma once
+
+#include <CGAL/Polygon_2.h>
+#include <CGAL/Polygon_with_holes_2.h>
+#include <CGAL/General_polygon_set_2.h>
+#include <CGAL/Gps_segment_traits_2.h>
+#include <vector>
+#include "kernel.h"
+
+namespace jotcad {
+namespace geo {
+namespace boolean {
+
+typedef CGAL::Gps_segment_traits_2<EK> Gps_traits_2;
+typedef CGAL::General_polygon_set_2<Gps_traits_2> General_polygon_set_2;
+typedef CGAL::Polygon_2<EK> Polygon_2;
+typedef CGAL::Polygon_with_holes_2<EK> Polygon_with_holes_2;
+
+/**
+ * PolygonBatch: Polygons gathered for one aggregated 2D boolean.
+ *
+ * Joining polygons into a General_polygon_set_2 one at a time re-sweeps the
+ * accumulated arrangement on every call, which is quadratic in the number of
+ * polygons. A batch is inserted with General_polygon_set_2's range join, which
+ * builds a single arrangement and classifies its faces once.
+ */
+struct PolygonBatch {
+    std::vector<Polygon_2> polygons;
+    std::vector<Polygon_with_holes_2> pwhs;
+
+    /**
+     * is_valid_boundary: Simplicity check, with triangles settled by a single
+     * orientation test instead of a sweep.
+     */
+    static bool is_valid_boundary(const Polygon_2& p) {
+        if (p.size() < 3) return false;
+        if (p.size() == 3) return !CGAL::collinear(p[0], p[1], p[2]);
+        return p.is_simple();
+    }
+
+    // Adds a boundary as counterclockwise. Returns false if it is not simple.
+    bool add(Polygon_2 boundary) {
+        if (!is_valid_boundary(boundary)) return false;
+        if (boundary.is_clockwise_oriented()) boundary.reverse_orientation();
+        polygons.push_back(std::move(boundary));
+        return true;
+    }
+
+    // Adds a boundary with holes, normalizing orientations and dropping invalid holes.
+    bool add(Polygon_2 boundary, std::vector<Polygon_2> holes) {
+        if (holes.empty()) return add(std::move(boundary));
+        if (!is_valid_boundary(boundary)) return false;
+        if (boundary.is_clockwise_oriented()) boundary.reverse_orientation();
+        std::vector<Polygon_2> valid_holes;
+        for (auto& h : holes) {
+            if (!is_valid_boundary(h)) continue;
+            if (h.is_counterclockwise_oriented()) h.reverse_orientation();
+            valid_holes.push_back(std::move(h));
+        }
+        pwhs.emplace_back(boundary, valid_holes.begin(), valid_holes.end());
+        return true;
+    }
+
+    // Adds an already valid polygon with holes.
+    void add(const Polygon_with_holes_2& pwh) { pwhs.push_back(pwh); }
+
+    bool empty() const { return polygons.empty() && pwhs.empty(); }
+    std::size_t size() const { return polygons.size() + pwhs.size(); }
+
+    /**
+     * to_set: The union of the batch. The aggregated join throws on a
+     * degenerate polygon; the batch then falls back to joining polygon by
+     * polygon, so only the offending polygons are lost.
+     */
+    General_polygon_set_2 to_set() const {
+        General_polygon_set_2 gps;
+        if (empty()) return gps;
+        try {
+            gps.join(polygons.begin(), polygons.end(), pwhs.begin(), pwhs.end());
+        } catch (...) {
+            gps = General_polygon_set_2();
+            for (const auto& p : polygons) {
+                try { gps.join(p); } catch (...) {}
+            }
+            for (const auto& pwh : pwhs) {
+                try { gps.join(pwh); } catch (...) {}
+            }
+        }
+        return gps;
+    }
+
+    void join_into(General_polygon_set_2& gps) const {
+        if (empty()) return;
+        if (gps.is_empty()) { gps = to_set(); return; }
+        gps.join(to_set());
+    }
+
+    // Subtracts the union of the batch from gps with one difference.
+    void cut_from(General_polygon_set_2& gps) const {
+        if (empty()) return;
+        gps.difference(to_set());
+    }
+};
+
+} // namespace boolean
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,51 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <json.hpp>
+#include "../../fs/cpp/vfs_node.h"
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * Derived: Node-local cache entries for artifacts computed from
+ * content-addressed inputs.
+ *
+ * An entry lives at the selector `jot/derived/<kind>` with the identifying
+ * parameters, and holds the CID of the materialized artifact. A miss only
+ * means the artifact must be recomputed, so lookups never throw.
+ */
+struct Derived {
+    using json = nlohmann::json;
+
+    static fs::Selector key(const std::string& kind, const json& params) {
+        return fs::Selector("jot/derived/" + kind, params, "$out");
+    }
+
+    static std::optional<json> lookup_json(fs::VFSNode* vfs, const fs::Selector& key) {
+        if (!vfs) return std::nullopt;
+        try {
+            if (!vfs->has_local(vfs->get_cid(key))) return std::nullopt;
+            return vfs->read<json>(key);
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+
+    static std::optional<fs::CID> lookup(fs::VFSNode* vfs, const fs::Selector& key) {
+        auto entry = lookup_json(vfs, key);
+        if (!entry || !entry->contains("cid") || !entry->at("cid").is_string()) return std::nullopt;
+        return fs::CID::from_json(entry->at("cid"));
+    }
+
+    static void store_json(fs::VFSNode* vfs, const fs::Selector& key, const json& entry) {
+        if (vfs) vfs->write(key, entry);
+    }
+
+    static void store(fs::VFSNode* vfs, const fs::Selector& key, const fs::CID& cid) {
+        store_json(vfs, key, json{{"cid", cid.value}});
+    }
+};
+
+} // namespace geo
+} // namespace jotcad
@@ -10,6 +10,9 @@
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <array>
+#include <chrono>
 #include "kernel.h"
 
 namespace jotcad {
@@ -79,116 +82,217 @@ bool is_geometry_solid(const CGAL::Surface_mesh<typename K::Point_3>& mesh) {
            CGAL::is_triangle_mesh(mesh);
 }
 
+/**
+ * RepairTimings: Accumulated cost of make_geometry_unambiguous, split by
+ * stage, so benchmarks can report the post-pass apart from the boolean that
+ * precedes it. Collected only inside a RepairTimingScope.
+ */
+struct RepairTimings {
+    double precheck = 0;     // Combinatorial manifoldness pre-check.
+    double manifold = 0;     // Phase 1: duplicating and splitting non-manifold vertices.
+    double collisions = 0;   // Phase 2: hashed coordinate collision scan and splitting.
+    double triangulate = 0;  // Re-triangulating after a change.
+    std::size_t calls = 0;
+    std::size_t clean = 0;   // Calls that needed no repair.
+};
+
+// The timings collected on this thread, if any.
+inline RepairTimings*& repair_timings_sink() {
+    thread_local RepairTimings* sink = nullptr;
+    return sink;
+}
+
+/**
+ * RepairTimingScope: Accumulates the repairs made on this thread into the
+ * caller's timings for the scope's lifetime. Scopes nest; the innermost
+ * receives the timings.
+ */
+class RepairTimingScope {
+public:
+    explicit RepairTimingScope(RepairTimings& timings) : previous_(repair_timings_sink()) { repair_timings_sink() = &timings; }
+    ~RepairTimingScope() { repair_timings_sink() = previous_; }
+    RepairTimingScope(const RepairTimingScope&) = delete;
+    RepairTimingScope& operator=(const RepairTimingScope&) = delete;
+
+private:
+    RepairTimings* previous_;
+};
+
+/**
+ * is_combinatorially_manifold: True if every vertex has a single umbrella,
+ * i.e. walking around it from its halfedge reaches all of its incoming
+ * halfedges. Linear in the number of halfedges.
+ */
+template <typename Surface_mesh>
+bool is_combinatorially_manifold(const Surface_mesh& mesh) {
+    std::vector<std::size_t> incoming(mesh.number_of_vertices() + mesh.number_of_removed_vertices(), 0);
+    for (auto h : mesh.halfedges()) ++incoming[mesh.target(h).idx()];
+    for (auto v : mesh.vertices()) {
+        auto h = mesh.halfedge(v);
+        if (h == Surface_mesh::null_halfedge()) continue;
+        std::size_t around = 0;
+        auto start = h;
+        do {
+            ++around;
+            h = mesh.next_around_target(h);
+        } while (h != start);
+        if (around != incoming[v.idx()]) return false;
+    }
+    return true;
+}
+
+/**
+ * CoordinateKey: A hash key for an exact point. Each coordinate is reduced to
+ * the tightest double interval around its exact value, forcing the exact
+ * value only when the approximation is not already a single double, so equal
+ * points always produce equal keys.
+ */
+struct CoordinateKey {
+    std::array<double, 6> bounds;
+    bool operator==(const CoordinateKey& other) const { return bounds == other.bounds; }
+};
+
+struct CoordinateKeyHash {
+    std::size_t operator()(const CoordinateKey& key) const {
+        std::size_t h = 0;
+        for (double b : key.bounds) h ^= std::hash<double>()(b) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+template <typename FT>
+std::pair<double, double> tight_interval(const FT& x) {
+    std::pair<double, double> i = CGAL::to_interval(x);
+    if (i.first == i.second) return i;
+    return CGAL::to_interval(CGAL::exact(x));
+}
+
+template <typename Point_3>
+CoordinateKey coordinate_key(const Point_3& p) {
+    auto x = tight_interval(p.x()), y = tight_interval(p.y()), z = tight_interval(p.z());
+    return {{x.first, x.second, y.first, y.second, z.first, z.second}};
+}
+
+/**
+ * split_vertex_umbrella: Separates the umbrella around v by splitting each
+ * outgoing edge delta away from v and cutting the corners off its faces.
+ */
+template <typename K>
+void split_vertex_umbrella(CGAL::Surface_mesh<typename K::Point_3>& mesh, typename CGAL::Surface_mesh<typename K::Point_3>::Vertex_index v, typename K::FT delta) {
+    typedef CGAL::Surface_mesh<typename K::Point_3> Surface_mesh;
+    typedef typename Surface_mesh::Halfedge_index Halfedge_index;
+    typedef typename K::Point_3 Point_3;
+    typedef typename K::Vector_3 Vector_3;
+
+    std::vector<Halfedge_index> outgoing;
+    Halfedge_index h = mesh.halfedge(v);
+    if (h == Surface_mesh::null_halfedge()) return;
+    Halfedge_index start = h;
+    do {
+        outgoing.push_back(h);
+        h = mesh.next_around_target(h);
+    } while (h != start);
+
+    double local_delta = CGAL::to_double(delta);
+    Vector_3 umbrella_sum(0, 0, 0);
+    std::vector<Halfedge_index> splits;
+    for (auto eh : outgoing) {
+        Point_3 p_s = mesh.point(mesh.source(eh)), p_t = mesh.point(mesh.target(eh));
+        Vector_3 vec = p_s - p_t;
+        double dist = std::sqrt(CGAL::to_double(vec.squared_length()));
+        if (dist < 1e-12) continue;
+        auto new_h = CGAL::Euler::split_edge(eh, mesh);
+        double scale = local_delta / dist;
+        Vector_3 offset(typename K::FT(CGAL::to_double(vec.x()) * scale),
+                        typename K::FT(CGAL::to_double(vec.y()) * scale),
+                        typename K::FT(CGAL::to_double(vec.z()) * scale));
+        mesh.point(mesh.target(new_h)) = p_t + offset;
+        umbrella_sum += offset;
+        splits.push_back(new_h);
+    }
+    for (size_t i = 0; i < splits.size(); ++i) {
+        auto h1 = splits[i], h2 = splits[(i + 1) % splits.size()];
+        if (h1 != h2 && mesh.face(h1) != Surface_mesh::null_face() && mesh.face(h1) == mesh.face(h2))
+            CGAL::Euler::split_face(h1, h2, mesh);
+    }
+    if (!splits.empty()) {
+        mesh.point(v) += (umbrella_sum / typename K::FT(splits.size())) / 2.0;
+    }
+}
+
 /**
  * make_geometry_unambiguous:
  * Resolves both actual and latent non-manifold singularities.
+ * A mesh that passes the manifoldness pre-check and has no coordinate
+ * collisions is returned untouched.
  */
 template <typename K = EK>
 bool make_geometry_unambiguous(CGAL::Surface_mesh<typename K::Point_3>& mesh, typename K::FT delta = 0.0001) {
     typedef CGAL::Surface_mesh<typename K::Point_3> Surface_mesh;
     typedef typename Surface_mesh::Vertex_index Vertex_index;
-    typedef typename Surface_mesh::Halfedge_index Halfedge_index;
-    typedef typename K::Point_3 Point_3;
-    typedef typename K::Vector_3 Vector_3;
+    typedef std::chrono::high_resolution_clock Clock;
 
+    RepairTimings unobserved;
+    RepairTimings& timings = repair_timings_sink() ? *repair_timings_sink() : unobserved;
+    ++timings.calls;
     bool changed = false;
 
     // Phase 1: Handle Combinatorial Non-Manifoldness (Already merged indices)
-    std::vector<std::vector<Vertex_index>> vertex_groups;
-    CGAL::Polygon_mesh_processing::duplicate_non_manifold_vertices(
-        mesh,
-        CGAL::parameters::output_iterator(std::back_inserter(vertex_groups))
-    );
+    auto t0 = Clock::now();
+    bool manifold = is_combinatorially_manifold(mesh);
+    auto t1 = Clock::now();
+    timings.precheck += std::chrono::duration<double>(t1 - t0).count();
 
-    if (!vertex_groups.empty()) {
-        changed = true;
-        for (auto& group : vertex_groups) {
-            for (Vertex_index v : group) {
-                std::vector<Halfedge_index> outgoing;
-                Halfedge_index h = mesh.halfedge(v);
-                if (h == Surface_mesh::null_halfedge()) continue;
-                Halfedge_index start = h;
-                do {
-                    outgoing.push_back(h);
-                    h = mesh.next_around_target(h);
-                } while (h != start);
-
-                double local_delta = CGAL::to_double(delta);
-                Vector_3 umbrella_sum(0, 0, 0);
-                std::vector<Halfedge_index> splits;
-                for (auto eh : outgoing) {
-                    Point_3 p_s = mesh.point(mesh.source(eh)), p_t = mesh.point(mesh.target(eh));
-                    Vector_3 vec = p_s - p_t; 
-                    double dist = std::sqrt(CGAL::to_double(vec.squared_length()));
-                    if (dist < 1e-12) continue;
-                    auto new_h = CGAL::Euler::split_edge(eh, mesh);
-                    double scale = local_delta / dist;
-                    Vector_3 offset(typename K::FT(CGAL::to_double(vec.x()) * scale),
-                                    typename K::FT(CGAL::to_double(vec.y()) * scale),
-                                    typename K::FT(CGAL::to_double(vec.z()) * scale));
-                    mesh.point(mesh.target(new_h)) = p_t + offset;
-                    umbrella_sum += offset;
-                    splits.push_back(new_h);
-                }
-                for (size_t i = 0; i < splits.size(); ++i) {
-                    auto h1 = splits[i], h2 = splits[(i + 1) % splits.size()];
-                    if (h1 != h2 && mesh.face(h1) != Surface_mesh::null_face() && mesh.face(h1) == mesh.face(h2)) 
-                        CGAL::Euler::split_face(h1, h2, mesh);
-                }
-                if (!splits.empty()) {
-                    mesh.point(v) += (umbrella_sum / typename K::FT(splits.size())) / 2.0;
-                }
+    if (!manifold) {
+        std::vector<std::vector<Vertex_index>> vertex_groups;
+        CGAL::Polygon_mesh_processing::duplicate_non_manifold_vertices(
+            mesh,
+            CGAL::parameters::output_iterator(std::back_inserter(vertex_groups))
+        );
+        if (!vertex_groups.empty()) {
+            changed = true;
+            for (auto& group : vertex_groups) {
+                for (Vertex_index v : group) split_vertex_umbrella<K>(mesh, v, delta);
             }
         }
+        timings.manifold += std::chrono::duration<double>(Clock::now() - t1).count();
     }
 
     // Phase 2: Handle Latent Non-Manifoldness (Coordinate collisions)
-    std::map<Point_3, std::vector<Vertex_index>> coord_map;
-    for (auto v : mesh.vertices()) coord_map[mesh.point(v)].push_back(v);
+    auto t2 = Clock::now();
+    std::unordered_map<CoordinateKey, std::vector<Vertex_index>, CoordinateKeyHash> coord_index;
+    coord_index.reserve(mesh.number_of_vertices());
+    for (auto v : mesh.vertices()) coord_index[coordinate_key(mesh.point(v))].push_back(v);
 
-    for (auto const& [pt, vs] : coord_map) {
-        if (vs.size() > 1) {
-            changed = true;
-            for (auto v : vs) {
-                std::vector<Halfedge_index> outgoing;
-                Halfedge_index h = mesh.halfedge(v);
-                if (h == Surface_mesh::null_halfedge()) continue;
-                Halfedge_index start = h;
-                do {
-                    outgoing.push_back(h);
-                    h = mesh.next_around_target(h);
-                } while (h != start);
-
-                double local_delta = CGAL::to_double(delta);
-                Vector_3 umbrella_sum(0, 0, 0);
-                std::vector<Halfedge_index> splits;
-                for (auto eh : outgoing) {
-                    Point_3 p_s = mesh.point(mesh.source(eh)), p_t = mesh.point(mesh.target(eh));
-                    Vector_3 vec = p_s - p_t;
-                    double dist = std::sqrt(CGAL::to_double(vec.squared_length()));
-                    if (dist < 1e-12) continue;
-                    auto new_h = CGAL::Euler::split_edge(eh, mesh);
-                    double scale = local_delta / dist;
-                    Vector_3 offset(typename K::FT(CGAL::to_double(vec.x()) * scale),
-                                    typename K::FT(CGAL::to_double(vec.y()) * scale),
-                                    typename K::FT(CGAL::to_double(vec.z()) * scale));
-                    mesh.point(mesh.target(new_h)) = p_t + offset;
-                    umbrella_sum += offset;
-                    splits.push_back(new_h);
-                }
-                for (size_t i = 0; i < splits.size(); ++i) {
-                    auto h1 = splits[i], h2 = splits[(i + 1) % splits.size()];
-                    if (h1 != h2 && mesh.face(h1) != Surface_mesh::null_face() && mesh.face(h1) == mesh.face(h2)) 
-                        CGAL::Euler::split_face(h1, h2, mesh);
-                }
-                if (!splits.empty()) {
-                    mesh.point(v) += (umbrella_sum / typename K::FT(splits.size())) / 2.0;
-                }
+    std::vector<std::vector<Vertex_index>> collisions;
+    for (auto const& [key, vs] : coord_index) {
+        if (vs.size() < 2) continue;
+        // Distinct exact values may share a key; only equal points collide.
+        std::vector<bool> grouped(vs.size(), false);
+        for (std::size_t i = 0; i < vs.size(); ++i) {
+            if (grouped[i]) continue;
+            std::vector<Vertex_index> group = {vs[i]};
+            for (std::size_t j = i + 1; j < vs.size(); ++j) {
+                if (!grouped[j] && mesh.point(vs[i]) == mesh.point(vs[j])) { group.push_back(vs[j]); grouped[j] = true; }
             }
+            if (group.size() > 1) collisions.push_back(std::move(group));
         }
     }
+    // Repair in coordinate order so the result does not depend on hashing.
+    std::sort(collisions.begin(), collisions.end(), [&](const auto& a, const auto& b) { return mesh.point(a[0]) < mesh.point(b[0]); });
+    for (const auto& group : collisions) {
+        changed = true;
+        for (auto v : group) split_vertex_umbrella<K>(mesh, v, delta);
+    }
+    auto t3 = Clock::now();
+    timings.collisions += std::chrono::duration<double>(t3 - t2).count();
 
-    if (changed) CGAL::Polygon_mesh_processing::triangulate_faces(mesh);
+    if (changed) {
+        CGAL::Polygon_mesh_processing::triangulate_faces(mesh);
+        timings.triangulate += std::chrono::duration<double>(Clock::now() - t3).count();
+    } else {
+        ++timings.clean;
+    }
     return changed;
 }
 
@@ -52,9 +52,67 @@ void test_point_to_surface_collision() {
     std::cout << "  ✅ Resolved: Apex and Centroid separated." << std::endl;
 }
 
+void test_clean_mesh_skips_repair() {
+    std::cout << "[Test 6] Clean tetrahedron passes the pre-check untouched..." << std::endl;
+    Mesh mesh;
+    auto a = mesh.add_vertex(EK::Point_3(0, 0, 0));
+    auto b = mesh.add_vertex(EK::Point_3(10, 0, 0));
+    auto c = mesh.add_vertex(EK::Point_3(0, 10, 0));
+    auto d = mesh.add_vertex(EK::Point_3(0, 0, 10));
+    mesh.add_face(a, c, b);
+    mesh.add_face(a, b, d);
+    mesh.add_face(b, c, d);
+    mesh.add_face(c, a, d);
+
+    assert(is_combinatorially_manifold(mesh));
+    RepairTimings timings;
+    {
+        RepairTimingScope scope(timings);
+        assert(!make_geometry_unambiguous(mesh, 0.1));
+    }
+    assert(timings.calls == 1 && timings.clean == 1);
+    assert(!make_geometry_unambiguous(mesh, 0.1));
+    assert(timings.calls == 1);
+    assert(mesh.number_of_vertices() == 4 && mesh.number_of_faces() == 4);
+    std::cout << "  ✅ No repair performed." << std::endl;
+}
+
+void test_inexact_coordinate_collision() {
+    std::cout << "[Test 7] Collision at a coordinate with no double representation..." << std::endl;
+    Mesh mesh;
+    EK::FT third = EK::FT(1) / EK::FT(3);
+    // The same point reached by two different constructions.
+    EK::Point_3 p(third, third, 10);
+    EK::Point_3 q(EK::FT(2) / EK::FT(6), EK::FT(1) - EK::FT(2) / EK::FT(3), 10);
+    assert(p == q);
+    assert(coordinate_key(p) == coordinate_key(q));
+
+    auto v0 = mesh.add_vertex(p);
+    auto v1 = mesh.add_vertex(EK::Point_3(-5, -5, 10));
+    auto v2 = mesh.add_vertex(EK::Point_3(5, -5, 10));
+    auto v3 = mesh.add_vertex(EK::Point_3(0, 5, 10));
+    mesh.add_face(v1, v2, v0);
+    mesh.add_face(v2, v3, v0);
+    mesh.add_face(v3, v1, v0);
+    auto w0 = mesh.add_vertex(q);
+    auto w1 = mesh.add_vertex(EK::Point_3(-2, 0, 15));
+    auto w2 = mesh.add_vertex(EK::Point_3(2, -2, 15));
+    auto w3 = mesh.add_vertex(EK::Point_3(2, 2, 15));
+    mesh.add_face(w0, w1, w2);
+    mesh.add_face(w0, w2, w3);
+    mesh.add_face(w0, w3, w1);
+
+    assert(!is_geometry_unambiguous(mesh));
+    assert(make_geometry_unambiguous(mesh, 0.1));
+    assert(is_geometry_unambiguous(mesh));
+    std::cout << "  ✅ Hashed index found and resolved the collision." << std::endl;
+}
+
 int main() {
     try {
         test_point_to_surface_collision();
+        test_clean_mesh_skips_repair();
+        test_inexact_coordinate_collision();
         std::cout << "\nALL AMBIGUITY RESOLUTION TESTS PASSED." << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Test failed: " << e.what() << std::endl;
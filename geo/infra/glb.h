@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <json.hpp>
+#include "rasterizer.h"
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * GLBWriter: Packs a collected render scene into binary glTF 2.0.
+ *
+ * Each distinct (render buffer, material) pair becomes one mesh that every
+ * placement of it instances through its node matrix. Vertex and index data
+ * are laid out in node order, and each node records in `extras.byteEnd` how
+ * much of the binary chunk it needs, so a viewport can draw components as
+ * the stream arrives. Normals are omitted; glTF viewers derive flat normals.
+ * With quantization, positions are normalized int16 (KHR_mesh_quantization)
+ * and the node matrix carries the dequantization.
+ */
+class GLBWriter {
+    using json = nlohmann::json;
+
+    bool quantize;
+    json gltf;
+    std::vector<uint8_t> bin;
+    std::map<std::tuple<int, int, int, int, std::string>, int> materials;
+    std::map<std::pair<const RenderBuffer*, int>, std::pair<int, std::array<double, 16>>> meshes;
+
+    static constexpr int kFloat = 5126, kShort = 5122, kUnsignedShort = 5123, kUnsignedInt = 5125;
+    static constexpr int kArrayBuffer = 34962, kElementArrayBuffer = 34963;
+
+    void align() { while (bin.size() % 4) bin.push_back(0); }
+
+    template <typename T>
+    void put(const T& value) {
+        std::size_t offset = bin.size();
+        bin.resize(offset + sizeof(T));
+        std::memcpy(bin.data() + offset, &value, sizeof(T));
+    }
+
+    int add_view(std::size_t offset, int stride, int target) {
+        json view = {{"buffer", 0}, {"byteOffset", offset}, {"byteLength", bin.size() - offset}, {"target", target}};
+        if (stride) view["byteStride"] = stride;
+        gltf["bufferViews"].push_back(view);
+        align();
+        return (int)gltf["bufferViews"].size() - 1;
+    }
+
+    int add_accessor(json accessor) {
+        gltf["accessors"].push_back(std::move(accessor));
+        return (int)gltf["accessors"].size() - 1;
+    }
+
+    static double to_linear(unsigned char c) {
+        double s = c / 255.0;
+        return s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+    }
+
+    int material_for(const ColorRGBA& color, const std::string& name) {
+        auto key = std::make_tuple((int)color.r, (int)color.g, (int)color.b, (int)color.a, name);
+        auto it = materials.find(key);
+        if (it != materials.end()) return it->second;
+        json material = {
+            {"pbrMetallicRoughness", {
+                {"baseColorFactor", {to_linear(color.r), to_linear(color.g), to_linear(color.b), color.a / 255.0}},
+                {"metallicFactor", 0.0},
+                {"roughnessFactor", 1.0}
+            }},
+            {"doubleSided", true}
+        };
+        if (color.a < 255) material["alphaMode"] = "BLEND";
+        if (!name.empty()) material["extras"] = {{"material", name}};
+        gltf["materials"].push_back(material);
+        int index = (int)gltf["materials"].size() - 1;
+        materials[key] = index;
+        return index;
+    }
+
+    // Writes one mesh; returns its index and the matrix mapping stored positions to local ones.
+    std::pair<int, std::array<double, 16>> mesh_for(const RenderBuffer& buffer, int material, bool textured) {
+        std::size_t count = buffer.vertex_count();
+        std::array<float, 3> lo = {0, 0, 0}, hi = {0, 0, 0};
+        for (std::size_t i = 0; i < count; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                float v = buffer.positions[i * 3 + k];
+                if (i == 0 || v < lo[k]) lo[k] = v;
+                if (i == 0 || v > hi[k]) hi[k] = v;
+            }
+        }
+        std::array<double, 16> dequant = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        double center[3], half[3];
+        for (int k = 0; k < 3; ++k) {
+            center[k] = (lo[k] + (double)hi[k]) / 2;
+            half[k] = hi[k] > lo[k] ? (hi[k] - (double)lo[k]) / 2 : 1.0;
+            if (quantize) {
+                dequant[k * 5] = half[k];
+                dequant[12 + k] = center[k];
+            }
+        }
+
+        int position_bytes = quantize ? 8 : 12;
+        int stride = position_bytes + (textured ? 8 : 0);
+        std::array<int, 3> qlo = {32767, 32767, 32767}, qhi = {-32767, -32767, -32767};
+        std::size_t vertex_offset = bin.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                float v = buffer.positions[i * 3 + k];
+                if (quantize) {
+                    int16_t q = (int16_t)std::lround(std::clamp((v - center[k]) / half[k], -1.0, 1.0) * 32767.0);
+                    qlo[k] = std::min(qlo[k], (int)q);
+                    qhi[k] = std::max(qhi[k], (int)q);
+                    put(q);
+                } else {
+                    put(v);
+                }
+            }
+            if (quantize) put((int16_t)0);
+            if (textured) { put(buffer.uvs[i * 2]); put(buffer.uvs[i * 2 + 1]); }
+        }
+        int vertex_view = add_view(vertex_offset, stride, kArrayBuffer);
+
+        json position = {{"bufferView", vertex_view}, {"byteOffset", 0}, {"count", count}, {"type", "VEC3"}};
+        if (quantize) {
+            position["componentType"] = kShort;
+            position["normalized"] = true;
+            position["min"] = qlo;
+            position["max"] = qhi;
+        } else {
+            position["componentType"] = kFloat;
+            position["min"] = {lo[0], lo[1], lo[2]};
+            position["max"] = {hi[0], hi[1], hi[2]};
+        }
+        json attributes = {{"POSITION", add_accessor(position)}};
+        if (textured) {
+            attributes["TEXCOORD_0"] = add_accessor({{"bufferView", vertex_view}, {"byteOffset", position_bytes},
+                                                     {"componentType", kFloat}, {"count", count}, {"type", "VEC2"}});
+        }
+
+        bool wide = count > 65535;
+        auto add_indices = [&](const std::vector<uint32_t>& indices) {
+            std::size_t offset = bin.size();
+            for (uint32_t i : indices) {
+                if (wide) put(i);
+                else put((uint16_t)i);
+            }
+            int view = add_view(offset, 0, kElementArrayBuffer);
+            return add_accessor({{"bufferView", view}, {"componentType", wide ? kUnsignedInt : kUnsignedShort},
+                                 {"count", indices.size()}, {"type", "SCALAR"}});
+        };
+
+        json primitives = json::array();
+        if (!buffer.triangles.empty()) {
+            primitives.push_back({{"attributes", attributes}, {"indices", add_indices(buffer.triangles)}, {"material", material}, {"mode", 4}});
+        }
+        if (!buffer.segments.empty()) {
+            primitives.push_back({{"attributes", attributes}, {"indices", add_indices(buffer.segments)}, {"material", material}, {"mode", 1}});
+        }
+        gltf["meshes"].push_back({{"primitives", primitives}});
+        return {(int)gltf["meshes"].size() - 1, dequant};
+    }
+
+public:
+    explicit GLBWriter(bool quantize = false) : quantize(quantize) {
+        gltf = {
+            {"asset", {{"version", "2.0"}, {"generator", "JotCAD"}}},
+            {"scene", 0},
+            // JotCAD is Z-up; glTF is Y-up.
+            {"scenes", json::array({json{{"nodes", json::array({0})}}})},
+            {"nodes", json::array({json{{"name", "jot"}, {"rotation", {-std::sqrt(0.5), 0.0, 0.0, std::sqrt(0.5)}}, {"children", json::array()}}})},
+            {"meshes", json::array()}, {"materials", json::array()},
+            {"accessors", json::array()}, {"bufferViews", json::array()}
+        };
+        if (quantize) {
+            gltf["extensionsUsed"] = json::array({"KHR_mesh_quantization"});
+            gltf["extensionsRequired"] = json::array({"KHR_mesh_quantization"});
+        }
+    }
+
+    void add_scene(const Rasterizer::Scene& scene) {
+        for (const auto& item : scene.items) {
+            const RenderBuffer& buffer = *item.buffer;
+            if (buffer.triangles.empty() && buffer.segments.empty()) continue;
+            int material = material_for(item.color, item.material);
+            auto key = std::make_pair(item.buffer, material);
+            auto it = meshes.find(key);
+            if (it == meshes.end()) it = meshes.emplace(key, mesh_for(buffer, material, !item.material.empty())).first;
+
+            // Column-major placement * dequantization.
+            const double* m = item.placement.m;
+            const std::array<double, 16>& q = it->second.second;
+            std::array<double, 16> matrix;
+            for (int c = 0; c < 4; ++c) {
+                for (int r = 0; r < 4; ++r) {
+                    double sum = 0;
+                    for (int k = 0; k < 4; ++k) {
+                        double a = r < 3 ? m[r * 4 + k] : (k == 3 ? 1.0 : 0.0);
+                        sum += a * q[c * 4 + k];
+                    }
+                    matrix[c * 4 + r] = sum;
+                }
+            }
+            gltf["nodes"].push_back({{"mesh", it->second.first}, {"matrix", matrix}, {"extras", {{"byteEnd", bin.size()}}}});
+            gltf["nodes"][0]["children"].push_back((int)gltf["nodes"].size() - 1);
+        }
+    }
+
+    std::vector<uint8_t> write_binary() {
+        json doc = gltf;
+        if (doc["meshes"].empty()) {
+            for (const char* key : {"meshes", "materials", "accessors", "bufferViews"}) doc.erase(key);
+        } else {
+            doc["buffers"] = json::array({json{{"byteLength", bin.size()}}});
+        }
+        std::string text = doc.dump();
+        while (text.size() % 4) text.push_back(' ');
+
+        std::vector<uint8_t> out;
+        auto put_u32 = [&](uint32_t v) { out.insert(out.end(), (uint8_t*)&v, (uint8_t*)&v + 4); };
+        uint32_t total = 12 + 8 + (uint32_t)text.size() + (bin.empty() ? 0 : 8 + (uint32_t)bin.size());
+        put_u32(0x46546C67); // "glTF"
+        put_u32(2);
+        put_u32(total);
+        put_u32((uint32_t)text.size());
+        put_u32(0x4E4F534A); // "JSON"
+        out.insert(out.end(), text.begin(), text.end());
+        if (!bin.empty()) {
+            put_u32((uint32_t)bin.size());
+            put_u32(0x004E4942); // "BIN"
+            out.insert(out.end(), bin.begin(), bin.end());
+        }
+        return out;
+    }
+};
+
+} // namespace geo
+} // namespace jotcad
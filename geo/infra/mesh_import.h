@@ -0,0 +1,273 @@
+#pragma once
+#include <array>
+#include <charconv>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "geometry.h"
+#include "../algorithms/raster.h"
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * MappedFile: A read-only view of a whole file, memory mapped where the
+ * platform allows and read into memory otherwise.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat st;
+            if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+                void* map = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map != MAP_FAILED) {
+                    map_ = map;
+                    size_ = (size_t)st.st_size;
+                    data_ = static_cast<const uint8_t*>(map);
+                }
+            }
+            ::close(fd);
+        }
+        if (data_) return;
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return;
+        fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+        open_ = true;
+    }
+    ~MappedFile() {
+        if (map_) ::munmap(map_, size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return map_ != nullptr || open_; }
+    const uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    void* map_ = nullptr;
+    const uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool open_ = false;
+    std::vector<uint8_t> fallback_;
+};
+
+/**
+ * ImportMesh: Triangles over double vertices, as parsed from a mesh file.
+ *
+ * Importers fill this on worker threads; exact FT vertices are only made by
+ * to_geometry, on the calling thread, so callers that only need doubles
+ * never pay for them.
+ */
+struct ImportMesh {
+    std::vector<double> xyz;  // x, y, z per vertex
+    std::vector<std::array<int, 3>> triangles;
+
+    std::size_t vertex_count() const { return xyz.size() / 3; }
+
+    void to_geometry(Geometry& out) const {
+        out.vertices.clear();
+        out.triangles.clear();
+        out.faces.clear();
+        out.vertices.reserve(vertex_count());
+        for (std::size_t i = 0; i < vertex_count(); ++i) {
+            out.vertices.push_back({FT(xyz[i * 3]), FT(xyz[i * 3 + 1]), FT(xyz[i * 3 + 2])});
+        }
+        out.triangles = triangles;
+    }
+};
+
+/**
+ * MeshImport: Chunking, number parsing and vertex welding shared by the STL
+ * and OBJ readers.
+ */
+struct MeshImport {
+    // Text is parsed in chunks of about this many bytes.
+    static constexpr std::size_t kChunkBytes = 1u << 20;
+
+    static bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Splits [data, data + size) into chunks of about chunk_bytes that end
+    // after a newline.
+    static std::vector<std::pair<std::size_t, std::size_t>> line_chunks(const char* data, std::size_t size,
+                                                                         std::size_t chunk_bytes = kChunkBytes) {
+        std::vector<std::pair<std::size_t, std::size_t>> chunks;
+        std::size_t begin = 0;
+        while (begin < size) {
+            std::size_t end = std::min(size, begin + std::max<std::size_t>(1, chunk_bytes));
+            while (end < size && data[end - 1] != '\n') ++end;
+            chunks.push_back({begin, end});
+            begin = end;
+        }
+        return chunks;
+    }
+
+    // Splits [data, data + size) into chunks of about chunk_bytes, each but
+    // the first starting at a whitespace-delimited word, ignoring case, so
+    // that the record it opens is never cut whatever the line layout.
+    static std::vector<std::pair<std::size_t, std::size_t>> word_chunks(const char* data, std::size_t size, const char* word,
+                                                                         std::size_t chunk_bytes = kChunkBytes) {
+        std::vector<std::pair<std::size_t, std::size_t>> chunks;
+        std::size_t begin = 0;
+        while (begin < size) {
+            std::size_t end = std::min(size, begin + std::max<std::size_t>(1, chunk_bytes));
+            for (; end < size; ++end) {
+                const char* p = data + end;
+                if (is_space(data[end - 1]) && !is_space(*p) && keyword(p, data + size, word)) break;
+            }
+            chunks.push_back({begin, end});
+            begin = end;
+        }
+        return chunks;
+    }
+
+    // Calls fn(line, line_end) for each line of [p, end), without newlines.
+    template <typename F>
+    static void for_lines(const char* p, const char* end, F&& fn) {
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            const char* line_end = eol ? eol : end;
+            if (line_end > p && line_end[-1] == '\r') --line_end;
+            fn(p, line_end);
+            if (!eol) break;
+            p = eol + 1;
+        }
+    }
+
+    static const char* skip_space(const char* p, const char* end) {
+        while (p < end && is_space(*p)) ++p;
+        return p;
+    }
+
+    // Whether the next word is keyword, ignoring case; advances past it.
+    static bool keyword(const char*& p, const char* end, const char* word) {
+        const char* q = skip_space(p, end);
+        for (; *word; ++word, ++q) {
+            if (q >= end || (char)std::tolower((unsigned char)*q) != *word) return false;
+        }
+        if (q < end && !is_space(*q)) return false;
+        p = q;
+        return true;
+    }
+
+    // Parses the next number into out and advances p past it.
+    template <typename T>
+    static bool parse_number(const char*& p, const char* end, T& out) {
+        p = skip_space(p, end);
+        if (p < end && *p == '+') ++p;
+        if (p >= end) return false;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto result = std::from_chars(p, end, out);
+        if (result.ec != std::errc()) return false;
+        p = result.ptr;
+        return true;
+#else
+        char buffer[64];
+        std::size_t n = 0;
+        while (p + n < end && n < sizeof(buffer) - 1 && !is_space(p[n])) {
+            buffer[n] = p[n];
+            ++n;
+        }
+        buffer[n] = '\0';
+        char* stop = nullptr;
+        double value = std::strtod(buffer, &stop);
+        if (stop == buffer) return false;
+        out = (T)value;
+        p += stop - buffer;
+        return true;
+#endif
+    }
+
+    /**
+     * VertexTable: Welds float vertices with identical coordinates through
+     * an open-addressing table; ids follow first occurrence.
+     */
+    class VertexTable {
+    public:
+        explicit VertexTable(std::size_t expected) {
+            std::size_t capacity = 16;
+            while (capacity < expected * 2) capacity *= 2;
+            slots_.assign(capacity, -1);
+            mask_ = capacity - 1;
+        }
+
+        static uint64_t hash(const std::array<float, 3>& p) {
+            uint64_t h = 0x9e3779b97f4a7c15ull;
+            for (float f : p) {
+                if (f == 0.0f) f = 0.0f;  // Weld -0 with 0
+                uint32_t bits;
+                std::memcpy(&bits, &f, 4);
+                h = (h ^ bits) * 0xff51afd7ed558ccdull;
+                h ^= h >> 29;
+            }
+            return h;
+        }
+
+        // The id of p, given its hash, adding it to mesh if it is new.
+        int insert(const std::array<float, 3>& p, uint64_t h, ImportMesh& mesh) {
+            std::array<float, 3> key = p;
+            for (float& f : key) if (f == 0.0f) f = 0.0f;
+            for (std::size_t i = h & mask_;; i = (i + 1) & mask_) {
+                int id = slots_[i];
+                if (id < 0) {
+                    id = (int)keys_.size();
+                    slots_[i] = id;
+                    keys_.push_back(key);
+                    mesh.xyz.insert(mesh.xyz.end(), {(double)p[0], (double)p[1], (double)p[2]});
+                    if (keys_.size() * 2 > slots_.size()) grow();
+                    return id;
+                }
+                if (keys_[id] == key) return id;
+            }
+        }
+
+        // Welds corners (three per triangle) into mesh, hashing across workers.
+        static void weld(const std::vector<std::array<float, 3>>& corners, ImportMesh& mesh) {
+            std::vector<uint64_t> hashes(corners.size());
+            Raster::parallel_bands((int)corners.size(), [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) hashes[i] = hash(corners[i]);
+            }, 4096);
+            VertexTable table(corners.size() / 4);
+            mesh.triangles.resize(corners.size() / 3);
+            for (std::size_t i = 0; i < corners.size(); ++i) {
+                mesh.triangles[i / 3][i % 3] = table.insert(corners[i], hashes[i], mesh);
+            }
+        }
+
+    private:
+        std::vector<int> slots_;
+        std::vector<std::array<float, 3>> keys_;
+        std::size_t mask_ = 0;
+
+        void grow() {
+            std::vector<int> slots(slots_.size() * 2, -1);
+            std::size_t mask = slots.size() - 1;
+            for (std::size_t id = 0; id < keys_.size(); ++id) {
+                std::size_t i = hash(keys_[id]) & mask;
+                while (slots[i] >= 0) i = (i + 1) & mask;
+                slots[i] = (int)id;
+            }
+            slots_.swap(slots);
+            mask_ = mask;
+        }
+    };
+};
+
+} // namespace geo
+} // namespace jotcad
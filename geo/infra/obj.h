@@ -6,6 +6,7 @@
 #include <map>
 #include <cmath>
 #include "geometry.h"
+#include "mesh_import.h"
 
 namespace jotcad {
 namespace geo {
@@ -50,61 +51,97 @@ public:
     }
 };
 
+/**
+ * OBJReader: OBJ import of `v` and `f` lines. The text is parsed across
+ * Raster::threads in line-aligned chunks; relative (negative) face indices
+ * are resolved once each chunk's first vertex is known, and faces with more
+ * than three corners are split as fans.
+ */
 class OBJReader {
 public:
-    static bool read_text(const std::string& text, Geometry& out_geo) {
-        std::istringstream stream(text);
-        std::string line;
-        
-        out_geo.vertices.clear();
-        out_geo.triangles.clear();
-        out_geo.faces.clear();
-        
-        while (std::getline(stream, line)) {
-            // Trim leading/trailing whitespace
-            size_t start = line.find_first_not_of(" \t\r\n");
-            if (start == std::string::npos) continue;
-            line = line.substr(start);
-            
-            if (line.rfind("v ", 0) == 0) {
-                std::stringstream ss(line.substr(2));
-                double x, y, z;
-                if (ss >> x >> y >> z) {
-                    Vertex v;
-                    v.x = (FT)x;
-                    v.y = (FT)y;
-                    v.z = (FT)z;
-                    out_geo.vertices.push_back(v);
-                }
-            } else if (line.rfind("f ", 0) == 0) {
-                std::stringstream ss(line.substr(2));
-                std::string part;
-                std::vector<int> indices;
-                while (ss >> part) {
-                    size_t slash = part.find('/');
-                    std::string idx_str = (slash == std::string::npos) ? part : part.substr(0, slash);
-                    if (!idx_str.empty()) {
-                        try {
-                            int idx = std::stoi(idx_str);
-                            if (idx > 0) {
-                                indices.push_back(idx - 1);
-                            } else if (idx < 0) {
-                                indices.push_back((int)out_geo.vertices.size() + idx);
+    static bool read_text(const char* data, std::size_t size, ImportMesh& out,
+                          std::size_t chunk_bytes = MeshImport::kChunkBytes) {
+        out = ImportMesh();
+        struct Chunk {
+            std::vector<double> xyz;
+            std::vector<int> corners;
+            std::vector<uint32_t> face_sizes;
+            std::vector<std::size_t> relative;  // Corners counted from the chunk's first vertex
+        };
+        auto ranges = MeshImport::line_chunks(data, size, chunk_bytes);
+        std::vector<Chunk> chunks(ranges.size());
+        Raster::parallel_bands((int)ranges.size(), [&](int begin, int end) {
+            for (int c = begin; c < end; ++c) {
+                Chunk& chunk = chunks[c];
+                MeshImport::for_lines(data + ranges[c].first, data + ranges[c].second, [&](const char* p, const char* line_end) {
+                    p = MeshImport::skip_space(p, line_end);
+                    if (line_end - p < 2 || p[1] != ' ') return;
+                    if (p[0] == 'v') {
+                        ++p;
+                        double x, y, z;
+                        if (MeshImport::parse_number(p, line_end, x) && MeshImport::parse_number(p, line_end, y) &&
+                            MeshImport::parse_number(p, line_end, z)) {
+                            chunk.xyz.insert(chunk.xyz.end(), {x, y, z});
+                        }
+                    } else if (p[0] == 'f') {
+                        ++p;
+                        uint32_t count = 0;
+                        int local = (int)(chunk.xyz.size() / 3);
+                        while ((p = MeshImport::skip_space(p, line_end)) < line_end) {
+                            // The vertex index precedes any /texture/normal indices.
+                            const char* word_end = p;
+                            while (word_end < line_end && *word_end != ' ' && *word_end != '\t') ++word_end;
+                            int idx = 0;
+                            const char* q = p + (*p == '+' ? 1 : 0);
+                            if (std::from_chars(q, word_end, idx).ec == std::errc()) {
+                                if (idx > 0) {
+                                    chunk.corners.push_back(idx - 1);
+                                    ++count;
+                                } else if (idx < 0) {
+                                    chunk.relative.push_back(chunk.corners.size());
+                                    chunk.corners.push_back(local + idx);
+                                    ++count;
+                                }
                             }
-                        } catch (...) {}
-                    }
-                }
-                if (indices.size() == 3) {
-                    out_geo.triangles.push_back({indices[0], indices[1], indices[2]});
-                } else if (indices.size() > 3) {
-                    // Triangulate convex face as a fan
-                    for (size_t i = 1; i < indices.size() - 1; ++i) {
-                        out_geo.triangles.push_back({indices[0], (int)indices[i], (int)indices[i+1]});
+                            p = word_end;
+                        }
+                        if (count >= 3) chunk.face_sizes.push_back(count);
+                        else chunk.corners.resize(chunk.corners.size() - count);
+                        while (!chunk.relative.empty() && chunk.relative.back() >= chunk.corners.size()) chunk.relative.pop_back();
                     }
-                }
+                });
+            }
+        }, 1);
+
+        std::vector<std::size_t> base(chunks.size() + 1, 0);
+        for (std::size_t c = 0; c < chunks.size(); ++c) base[c + 1] = base[c] + chunks[c].xyz.size() / 3;
+        out.xyz.reserve(base.back() * 3);
+        for (Chunk& chunk : chunks) {
+            std::size_t c = &chunk - chunks.data();
+            for (std::size_t k : chunk.relative) chunk.corners[k] += (int)base[c];
+            out.xyz.insert(out.xyz.end(), chunk.xyz.begin(), chunk.xyz.end());
+            std::vector<double>().swap(chunk.xyz);
+            std::size_t at = 0;
+            for (uint32_t n : chunk.face_sizes) {
+                const int* f = &chunk.corners[at];
+                for (uint32_t i = 1; i + 1 < n; ++i) out.triangles.push_back({f[0], f[i], f[i + 1]});
+                at += n;
             }
         }
-        return !out_geo.vertices.empty();
+        return out.vertex_count() > 0;
+    }
+
+    static bool read_text(const std::string& text, Geometry& out_geo) {
+        ImportMesh mesh;
+        bool ok = read_text(text.data(), text.size(), mesh);
+        mesh.to_geometry(out_geo);
+        return ok;
+    }
+
+    static bool read_file(const std::string& path, ImportMesh& out) {
+        MappedFile file(path);
+        if (!file.ok()) return false;
+        return read_text((const char*)file.data(), file.size(), out);
     }
 };
 
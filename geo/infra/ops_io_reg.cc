@@ -1,7 +1,9 @@
 #include "stl_op.h"
 #include "obj_op.h"
 #include "pdf_op.h"
+#include "glb_op.h"
 #include "png_op.h"
+#include "views_op.h"
 #include "relief_op.h"
 #include "outline_op.h"
 #include "asset_ops.h"
@@ -12,7 +14,9 @@ void register_io_ops(fs::VFSNode* vfs) {
     stl_init(vfs);
     obj_init(vfs);
     pdf_init(vfs);
+    glb_init(vfs);
     png_init(vfs);
+    views_init(vfs);
     relief_init(vfs);
     outline_init(vfs);
     assets_init(vfs);
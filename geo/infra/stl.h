@@ -7,26 +7,54 @@
 #include <algorithm>
 #include <cctype>
 #include <map>
+#include <ostream>
 #include "geometry.h"
 #include "triangulation.h"
+#include "render_buffer.h"
+#include "camera.h"
+#include "../algorithms/raster.h"
+#include "mesh_import.h"
 
 namespace jotcad {
 namespace geo {
 
+/**
+ * STLWriter: Binary STL encoded facet by facet into its output bytes.
+ *
+ * In memory the bytes are the finished file once finish() patches the
+ * facet count. Given a stream, facets are written in kChunkBytes chunks as
+ * they are added and the count is patched on finish(), so the stream must
+ * be seekable.
+ */
 class STLWriter {
-    struct Triangle {
-        float normal[3];
-        float v1[3];
-        float v2[3];
-        float v3[3];
-        uint16_t attr_byte_count;
+public:
+    static constexpr std::size_t kFacetBytes = 50;
+    static constexpr std::size_t kChunkBytes = 4u << 20;
+
+    /**
+     * Placement: A render buffer and its placement, converted to doubles on
+     * the calling thread so workers never touch the exact matrix.
+     */
+    struct Placement {
+        const RenderBuffer* buffer = nullptr;
+        ViewTransform view;
+        bool reflect = false;
+
+        static Placement at(const Matrix& tf, const RenderBuffer* buffer = nullptr) {
+            Placement p;
+            p.buffer = buffer;
+            p.view = ViewTransform::from(tf);
+            p.reflect = tf.is_reflection();
+            return p;
+        }
     };
 
-    std::vector<Triangle> triangles;
+    STLWriter() { begin(); }
+    explicit STLWriter(std::ostream& out) : out_(&out), start_(out.tellp()) { begin(); }
+
+    uint32_t triangle_count() const { return count_; }
 
-public:
     void add_triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3) {
-        Triangle t;
         EK::Point_3 p1(v1.x, v1.y, v1.z);
         EK::Point_3 p2(v2.x, v2.y, v2.z);
         EK::Point_3 p3(v3.x, v3.y, v3.z);
@@ -39,29 +67,22 @@ public:
         double ny = CGAL::to_double(n_vec.y());
         double nz = CGAL::to_double(n_vec.z());
         double len = std::sqrt(nx*nx + ny*ny + nz*nz);
-        
+
+        float normal[3] = {0, 0, 0};
         if (len > 1e-12) {
-            t.normal[0] = (float)(nx / len);
-            t.normal[1] = (float)(ny / len);
-            t.normal[2] = (float)(nz / len);
-        } else {
-            t.normal[0] = 0; t.normal[1] = 0; t.normal[2] = 0;
+            normal[0] = (float)(nx / len);
+            normal[1] = (float)(ny / len);
+            normal[2] = (float)(nz / len);
         }
-        
-        t.v1[0] = (float)CGAL::to_double(v1.x);
-        t.v1[1] = (float)CGAL::to_double(v1.y);
-        t.v1[2] = (float)CGAL::to_double(v1.z);
-        
-        t.v2[0] = (float)CGAL::to_double(v2.x);
-        t.v2[1] = (float)CGAL::to_double(v2.y);
-        t.v2[2] = (float)CGAL::to_double(v2.z);
-        
-        t.v3[0] = (float)CGAL::to_double(v3.x);
-        t.v3[1] = (float)CGAL::to_double(v3.y);
-        t.v3[2] = (float)CGAL::to_double(v3.z);
-        
-        t.attr_byte_count = 0;
-        triangles.push_back(t);
+        float a[3] = {(float)CGAL::to_double(v1.x), (float)CGAL::to_double(v1.y), (float)CGAL::to_double(v1.z)};
+        float b[3] = {(float)CGAL::to_double(v2.x), (float)CGAL::to_double(v2.y), (float)CGAL::to_double(v2.z)};
+        float c[3] = {(float)CGAL::to_double(v3.x), (float)CGAL::to_double(v3.y), (float)CGAL::to_double(v3.z)};
+
+        std::size_t offset = bytes_.size();
+        bytes_.resize(offset + kFacetBytes);
+        put_facet(bytes_.data() + offset, normal, a, b, c);
+        ++count_;
+        flush(false);
     }
 
     void add_geometry(const Geometry& geo) {
@@ -72,172 +93,257 @@ public:
                          geo.vertices[t_indices[2]]);
         }
         
-        // 2. Process complex faces (triangulate)
+        // 2. Process complex faces (triangulate), projecting the vertices once
+        if (geo.faces.empty()) return;
+        std::vector<Vec3> pts;
+        pts.reserve(geo.vertices.size());
+        for (const auto& v : geo.vertices) {
+            pts.push_back(Vec3{CGAL::to_double(v.x), CGAL::to_double(v.y), CGAL::to_double(v.z)});
+        }
         for (const auto& f : geo.faces) {
-            std::vector<Vec3> pts;
-            for (const auto& v : geo.vertices) {
-                pts.push_back(Vec3{CGAL::to_double(v.x), CGAL::to_double(v.y), CGAL::to_double(v.z)});
-            }
-            
             Triangulation::triangulate_face(f, pts, [&](int i0, int i1, int i2) {
                 add_triangle(geo.vertices[i0], geo.vertices[i1], geo.vertices[i2]);
             });
         }
     }
 
+    /**
+     * add_buffer: Appends a cached render buffer placed by tf, so faces are
+     * not re-triangulated per export.
+     */
+    void add_buffer(const RenderBuffer& buffer, const Matrix& tf) {
+        add_buffers({Placement::at(tf, &buffer)});
+    }
+
+    /**
+     * add_buffers: Appends placed buffers in order. Each vertex is placed
+     * once, then facets are encoded straight into the output; both passes
+     * run across Raster::threads and give the same bytes as a serial run.
+     * Facets whose placed corners have no normal are skipped, as
+     * add_triangle skips collinear ones.
+     */
+    void add_buffers(const std::vector<Placement>& batch) {
+        std::vector<std::size_t> vertex_base(batch.size() + 1, 0), facet_base(batch.size() + 1, 0);
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            vertex_base[i + 1] = vertex_base[i] + batch[i].buffer->vertex_count();
+            facet_base[i + 1] = facet_base[i] + batch[i].buffer->triangle_count();
+        }
+        if (facet_base.back() == 0) return;
+
+        // Visits [begin, end) of the concatenated items as (item, local index).
+        auto visit = [&](const std::vector<std::size_t>& base, int begin, int end, auto&& fn) {
+            std::size_t item = std::upper_bound(base.begin(), base.end(), (std::size_t)begin) - base.begin() - 1;
+            for (std::size_t k = begin; k < (std::size_t)end; ++k) {
+                while (k >= base[item + 1]) ++item;
+                fn(item, k - base[item], k);
+            }
+        };
+
+        std::vector<float> placed(vertex_base.back() * 3);
+        Raster::parallel_bands((int)vertex_base.back(), [&](int begin, int end) {
+            visit(vertex_base, begin, end, [&](std::size_t item, std::size_t i, std::size_t k) {
+                const double* m = batch[item].view.m;
+                const float* p = &batch[item].buffer->positions[i * 3];
+                double x = p[0], y = p[1], z = p[2];
+                placed[k * 3] = (float)(m[0] * x + m[1] * y + m[2] * z + m[3]);
+                placed[k * 3 + 1] = (float)(m[4] * x + m[5] * y + m[6] * z + m[7]);
+                placed[k * 3 + 2] = (float)(m[8] * x + m[9] * y + m[10] * z + m[11]);
+            });
+        }, 4096);
+
+        // The placed corners of facet i of an item, wound for its placement.
+        auto corners = [&](std::size_t item, std::size_t i, const float*& a, const float*& b, const float*& c) {
+            const uint32_t* t = &batch[item].buffer->triangles[i * 3];
+            bool reflect = batch[item].reflect;
+            a = &placed[(vertex_base[item] + t[0]) * 3];
+            b = &placed[(vertex_base[item] + t[reflect ? 2 : 1]) * 3];
+            c = &placed[(vertex_base[item] + t[reflect ? 1 : 2]) * 3];
+        };
+
+        std::vector<float> normals(facet_base.back() * 3);
+        std::vector<uint8_t> kept(facet_base.back());
+        Raster::parallel_bands((int)facet_base.back(), [&](int begin, int end) {
+            visit(facet_base, begin, end, [&](std::size_t item, std::size_t i, std::size_t k) {
+                const float *a, *b, *c;
+                corners(item, i, a, b, c);
+                Vec3 va{a[0], a[1], a[2]}, vb{b[0], b[1], b[2]}, vc{c[0], c[1], c[2]};
+                Vec3 n = (vb - va).cross(vc - va);
+                double len = n.length();
+                kept[k] = len > 0;
+                if (!kept[k]) return;
+                normals[k * 3] = (float)(n.x / len);
+                normals[k * 3 + 1] = (float)(n.y / len);
+                normals[k * 3 + 2] = (float)(n.z / len);
+            });
+        }, 4096);
+
+        // Each kept facet's position in the output.
+        std::vector<uint32_t> slot(facet_base.back());
+        uint32_t written = 0;
+        for (std::size_t k = 0; k < slot.size(); ++k) {
+            slot[k] = written;
+            written += kept[k];
+        }
+        if (written == 0) return;
+
+        std::size_t offset = bytes_.size();
+        bytes_.resize(offset + (std::size_t)written * kFacetBytes);
+        Raster::parallel_bands((int)facet_base.back(), [&](int begin, int end) {
+            visit(facet_base, begin, end, [&](std::size_t item, std::size_t i, std::size_t k) {
+                if (!kept[k]) return;
+                const float *a, *b, *c;
+                corners(item, i, a, b, c);
+                put_facet(bytes_.data() + offset + (std::size_t)slot[k] * kFacetBytes, &normals[k * 3], a, b, c);
+            });
+        }, 4096);
+        count_ += written;
+        flush(false);
+    }
+
+    // The finished file so far, for in-memory writers.
     std::vector<uint8_t> write_binary() const {
-        std::vector<uint8_t> buffer;
-        buffer.resize(80 + 4 + triangles.size() * 50);
-        
-        // 80 byte header
+        std::vector<uint8_t> buffer = bytes_;
+        if (!out_) std::memcpy(buffer.data() + 80, &count_, 4);
+        return buffer;
+    }
+
+    /**
+     * finish: Patches the facet count. In memory this returns the file;
+     * streaming, it writes the remaining facets and returns nothing.
+     */
+    std::vector<uint8_t> finish() {
+        if (!out_) {
+            std::memcpy(bytes_.data() + 80, &count_, 4);
+            return std::move(bytes_);
+        }
+        bool header_written = flushed_;
+        if (!header_written) std::memcpy(bytes_.data() + 80, &count_, 4);
+        flush(true);
+        if (header_written) {
+            std::streampos end = out_->tellp();
+            out_->seekp(start_ + std::streamoff(80));
+            out_->write((const char*)&count_, 4);
+            out_->seekp(end);
+        }
+        return {};
+    }
+
+private:
+    std::ostream* out_ = nullptr;
+    std::streampos start_ = 0;
+    std::vector<uint8_t> bytes_;  // Header until first flushed, then unwritten facets
+    uint32_t count_ = 0;
+    bool flushed_ = false;  // The header has been written to out_
+
+    void begin() {
+        // 80 byte header, then the 4 byte triangle count
         std::string header = "JotCAD Binary STL Export";
         header.resize(80, ' ');
-        std::memcpy(buffer.data(), header.data(), 80);
-        
-        // 4 byte triangle count
-        uint32_t count = (uint32_t)triangles.size();
-        std::memcpy(buffer.data() + 80, &count, 4);
-        
-        // Triangles
-        for (size_t i = 0; i < triangles.size(); ++i) {
-            std::memcpy(buffer.data() + 84 + i * 50, &triangles[i], 50);
-        }
-        
-        return buffer;
+        bytes_.assign(header.begin(), header.end());
+        bytes_.resize(84, 0);
+    }
+
+    static void put_facet(uint8_t* dst, const float normal[3], const float a[3], const float b[3], const float c[3]) {
+        std::memcpy(dst, normal, 12);
+        std::memcpy(dst + 12, a, 12);
+        std::memcpy(dst + 24, b, 12);
+        std::memcpy(dst + 36, c, 12);
+        dst[48] = dst[49] = 0;
+    }
+
+    void flush(bool force) {
+        if (!out_ || bytes_.empty() || (!force && bytes_.size() < kChunkBytes)) return;
+        out_->write((const char*)bytes_.data(), (std::streamsize)bytes_.size());
+        bytes_.clear();
+        flushed_ = true;
     }
 };
 
+/**
+ * STLReader: Binary and ASCII STL import. Facets are decoded across
+ * Raster::threads and corners with identical coordinates are welded into
+ * shared vertices in first-seen order. ASCII is read as whitespace-separated
+ * words in chunks that start at a `vertex`, so any line layout parses.
+ */
 class STLReader {
 public:
-    static bool read_ascii(const std::string& text, Geometry& out_geo) {
-        std::istringstream stream(text);
-        std::string token;
-        
-        out_geo.vertices.clear();
-        out_geo.triangles.clear();
-        out_geo.faces.clear();
-        
-        // Map to deduplicate vertices and reuse indices
-        struct ComparePoint {
-            bool operator()(const std::array<float, 3>& a, const std::array<float, 3>& b) const {
-                if (std::abs(a[0] - b[0]) > 1e-5f) return a[0] < b[0];
-                if (std::abs(a[1] - b[1]) > 1e-5f) return a[1] < b[1];
-                return a[2] < b[2];
-            }
-        };
-        std::map<std::array<float, 3>, int, ComparePoint> vertex_map;
-        
-        auto get_or_add_vertex = [&](float x, float y, float z) -> int {
-            std::array<float, 3> pt = {x, y, z};
-            auto it = vertex_map.find(pt);
-            if (it != vertex_map.end()) {
-                return it->second;
-            }
-            int idx = (int)out_geo.vertices.size();
-            Vertex v;
-            v.x = (FT)x;
-            v.y = (FT)y;
-            v.z = (FT)z;
-            out_geo.vertices.push_back(v);
-            vertex_map[pt] = idx;
-            return idx;
+    static bool read_ascii(const char* data, std::size_t size, ImportMesh& out,
+                           std::size_t chunk_bytes = MeshImport::kChunkBytes) {
+        out = ImportMesh();
+        struct Chunk {
+            std::vector<std::array<float, 3>> vertices;
+            std::vector<std::size_t> ends;  // Vertex count at each endfacet
+            bool ok = true;
         };
-        
-        std::vector<int> current_face_verts;
-        current_face_verts.reserve(3);
-        
-        while (stream >> token) {
-            for (char& c : token) c = (char)std::tolower(c);
-            
-            if (token == "vertex") {
-                float x, y, z;
-                if (!(stream >> x >> y >> z)) return false;
-                current_face_verts.push_back(get_or_add_vertex(x, y, z));
-            } else if (token == "endfacet") {
-                if (current_face_verts.size() == 3) {
-                    out_geo.triangles.push_back({current_face_verts[0], current_face_verts[1], current_face_verts[2]});
+        auto ranges = MeshImport::word_chunks(data, size, "vertex", chunk_bytes);
+        std::vector<Chunk> chunks(ranges.size());
+        Raster::parallel_bands((int)ranges.size(), [&](int begin, int end) {
+            for (int c = begin; c < end; ++c) {
+                Chunk& chunk = chunks[c];
+                const char* p = data + ranges[c].first;
+                const char* chunk_end = data + ranges[c].second;
+                while ((p = MeshImport::skip_space(p, chunk_end)) < chunk_end) {
+                    if (MeshImport::keyword(p, chunk_end, "vertex")) {
+                        std::array<float, 3> v;
+                        if (!MeshImport::parse_number(p, chunk_end, v[0]) || !MeshImport::parse_number(p, chunk_end, v[1]) ||
+                            !MeshImport::parse_number(p, chunk_end, v[2])) {
+                            chunk.ok = false;
+                            break;
+                        }
+                        chunk.vertices.push_back(v);
+                    } else if (MeshImport::keyword(p, chunk_end, "endfacet")) {
+                        chunk.ends.push_back(chunk.vertices.size());
+                    } else {
+                        while (p < chunk_end && !MeshImport::is_space(*p)) ++p;
+                    }
                 }
-                current_face_verts.clear();
             }
+        }, 1);
+
+        // Facets may straddle chunks; only those with three vertices are kept.
+        std::vector<std::array<float, 3>> corners, pending;
+        for (const Chunk& chunk : chunks) {
+            if (!chunk.ok) return false;
+            std::size_t from = 0;
+            for (std::size_t to : chunk.ends) {
+                pending.insert(pending.end(), chunk.vertices.begin() + from, chunk.vertices.begin() + to);
+                if (pending.size() == 3) corners.insert(corners.end(), pending.begin(), pending.end());
+                pending.clear();
+                from = to;
+            }
+            pending.insert(pending.end(), chunk.vertices.begin() + from, chunk.vertices.end());
         }
-        return !out_geo.triangles.empty();
+        MeshImport::VertexTable::weld(corners, out);
+        return !out.triangles.empty();
     }
 
-    static bool read_binary(const std::vector<uint8_t>& buffer, Geometry& out_geo) {
-        if (buffer.size() < 84) return false;
+    static bool read_binary(const uint8_t* data, std::size_t size, ImportMesh& out) {
+        out = ImportMesh();
+        if (size < 84) return false;
         
         uint32_t count = 0;
-        std::memcpy(&count, buffer.data() + 80, 4);
-        
-        if (buffer.size() < 84 + count * 50) return false;
-        
-        out_geo.vertices.clear();
-        out_geo.triangles.clear();
-        out_geo.faces.clear();
-        out_geo.vertices.reserve(count * 3);
-        out_geo.triangles.reserve(count);
+        std::memcpy(&count, data + 80, 4);
         
-        // Map to deduplicate vertices and reuse indices
-        struct ComparePoint {
-            bool operator()(const std::array<float, 3>& a, const std::array<float, 3>& b) const {
-                if (std::abs(a[0] - b[0]) > 1e-5f) return a[0] < b[0];
-                if (std::abs(a[1] - b[1]) > 1e-5f) return a[1] < b[1];
-                return a[2] < b[2];
-            }
-        };
-        std::map<std::array<float, 3>, int, ComparePoint> vertex_map;
+        if (size < 84 + (std::size_t)count * 50) return false;
         
-        auto get_or_add_vertex = [&](float x, float y, float z) -> int {
-            std::array<float, 3> pt = {x, y, z};
-            auto it = vertex_map.find(pt);
-            if (it != vertex_map.end()) {
-                return it->second;
+        std::vector<std::array<float, 3>> corners((std::size_t)count * 3);
+        Raster::parallel_bands((int)count, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const uint8_t* facet = data + 84 + (std::size_t)i * 50;
+                std::memcpy(corners[(std::size_t)i * 3].data(), facet + 12, 12);
+                std::memcpy(corners[(std::size_t)i * 3 + 1].data(), facet + 24, 12);
+                std::memcpy(corners[(std::size_t)i * 3 + 2].data(), facet + 36, 12);
             }
-            int idx = (int)out_geo.vertices.size();
-            Vertex v;
-            v.x = (FT)x;
-            v.y = (FT)y;
-            v.z = (FT)z;
-            out_geo.vertices.push_back(v);
-            vertex_map[pt] = idx;
-            return idx;
-        };
-        
-        for (uint32_t i = 0; i < count; ++i) {
-            size_t offset = 84 + i * 50;
-            float normal[3];
-            float v1[3], v2[3], v3[3];
-            
-            std::memcpy(normal, buffer.data() + offset, 12);
-            std::memcpy(v1, buffer.data() + offset + 12, 12);
-            std::memcpy(v2, buffer.data() + offset + 24, 12);
-            std::memcpy(v3, buffer.data() + offset + 36, 12);
-            
-            int idx1 = get_or_add_vertex(v1[0], v1[1], v1[2]);
-            int idx2 = get_or_add_vertex(v2[0], v2[1], v2[2]);
-            int idx3 = get_or_add_vertex(v3[0], v3[1], v3[2]);
-            
-            out_geo.triangles.push_back({idx1, idx2, idx3});
-        }
-        
+        }, 4096);
+        MeshImport::VertexTable::weld(corners, out);
         return true;
     }
 
-    static bool read_file(const std::string& path, Geometry& out_geo) {
-        std::ifstream file(path, std::ios::binary);
-        if (!file.is_open()) return false;
-        
-        file.seekg(0, std::ios::end);
-        size_t size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        
-        std::vector<uint8_t> buffer(size);
-        file.read((char*)buffer.data(), size);
-        
-        // Auto-detect format
+    // Detects ASCII or binary STL, falling back to ASCII if binary fails.
+    static bool read(const uint8_t* data, std::size_t size, ImportMesh& out) {
         bool is_ascii = false;
         if (size >= 5) {
-            std::string header(buffer.begin(), buffer.begin() + std::min(size, (size_t)80));
+            std::string header((const char*)data, std::min(size, (std::size_t)80));
             size_t start = header.find_first_not_of(" \t\r\n");
             if (start != std::string::npos && start + 5 <= header.size()) {
                 std::string prefix = header.substr(start, 5);
@@ -245,8 +351,8 @@ public:
                 if (prefix == "solid") {
                     if (size >= 84) {
                         uint32_t count = 0;
-                        std::memcpy(&count, buffer.data() + 80, 4);
-                        if (size != 84 + count * 50) {
+                        std::memcpy(&count, data + 80, 4);
+                        if (size != 84 + (std::size_t)count * 50) {
                             is_ascii = true;
                         }
                     } else {
@@ -256,16 +362,35 @@ public:
             }
         }
         
-        if (is_ascii) {
-            std::string text(buffer.begin(), buffer.end());
-            return read_ascii(text, out_geo);
-        } else {
-            if (read_binary(buffer, out_geo)) {
-                return true;
-            }
-            std::string text(buffer.begin(), buffer.end());
-            return read_ascii(text, out_geo);
-        }
+        if (!is_ascii && read_binary(data, size, out)) return true;
+        return read_ascii((const char*)data, size, out);
+    }
+
+    static bool read_ascii(const std::string& text, Geometry& out_geo) {
+        ImportMesh mesh;
+        bool ok = read_ascii(text.data(), text.size(), mesh);
+        mesh.to_geometry(out_geo);
+        return ok;
+    }
+
+    static bool read_binary(const std::vector<uint8_t>& buffer, Geometry& out_geo) {
+        ImportMesh mesh;
+        if (!read_binary(buffer.data(), buffer.size(), mesh)) return false;
+        mesh.to_geometry(out_geo);
+        return true;
+    }
+
+    static bool read_file(const std::string& path, ImportMesh& out) {
+        MappedFile file(path);
+        if (!file.ok()) return false;
+        return read(file.data(), file.size(), out);
+    }
+
+    static bool read_file(const std::string& path, Geometry& out_geo) {
+        ImportMesh mesh;
+        if (!read_file(path, mesh)) return false;
+        mesh.to_geometry(out_geo);
+        return true;
     }
 };
 
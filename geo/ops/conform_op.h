@@ -2,6 +2,8 @@
 #include "protocols.h"
 #include "processor.h"
 #include "boolean/engine.h"
+#include "boolean/classifier.h"
+#include <memory>
 #include <CGAL/AABB_tree.h>
 #include <CGAL/AABB_traits.h>
 #include <CGAL/AABB_face_graph_triangle_primitive.h>
@@ -21,7 +23,7 @@ struct ConformOp : P {
     typedef CGAL::AABB_traits<IK, Primitive> Traits;
     typedef CGAL::AABB_tree<Traits> Tree;
 
-    static void project_recursive(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const Tree& tree, const Mesh& target_mesh, const IK::Vector_3& dir, double offset) {
+    static void project_recursive(fs::VFSNode* vfs, Shape& s, const Matrix& parent_tf, const Tree* tree, const boolean::TriangleBVH* bvh, const Mesh& target_mesh, const IK::Vector_3& dir, double offset) {
         Matrix current_tf = parent_tf * s.tf;
         CGAL::Cartesian_converter<EK, IK> ek_to_ik;
         CGAL::Cartesian_converter<IK, EK> ik_to_ek;
@@ -39,29 +41,18 @@ struct ConformOp : P {
 
                 if (dir == IK::Vector_3(0,0,0)) {
                     // Closest point mode
-                    auto cp = tree.closest_point_and_primitive(p_world);
+                    auto cp = tree->closest_point_and_primitive(p_world);
                     p_new = cp.first;
                     normal = CGAL::Polygon_mesh_processing::compute_face_normal(cp.second, target_mesh);
                     hit = true;
                 } else {
                     // Raycast mode
-                    IK::Ray_3 ray(p_world, dir);
-                    std::vector<typename Tree::Intersection_and_primitive_id<IK::Ray_3>::Type> intersections;
-                    tree.all_intersections(ray, std::back_inserter(intersections));
-                    
-                    if (!intersections.empty()) {
-                        double min_dist = -1;
-                        for (const auto& inter : intersections) {
-                            if (const IK::Point_3* pi = std::get_if<IK::Point_3>(&inter.first)) {
-                                double d = CGAL::to_double(CGAL::squared_distance(p_world, *pi));
-                                if (min_dist < 0 || d < min_dist) {
-                                    min_dist = d;
-                                    p_new = *pi;
-                                    normal = CGAL::Polygon_mesh_processing::compute_face_normal(inter.second, target_mesh);
-                                    hit = true;
-                                }
-                            }
-                        }
+                    double origin[3] = {p_world.x(), p_world.y(), p_world.z()};
+                    double ray_dir[3] = {dir.x(), dir.y(), dir.z()};
+                    if (auto first = bvh->first_hit(origin, ray_dir, -std::numeric_limits<double>::min())) {
+                        p_new = p_world + dir * first->t;
+                        normal = CGAL::Polygon_mesh_processing::compute_face_normal(Mesh::Face_index(first->face), target_mesh);
+                        hit = true;
                     }
                 }
 
@@ -81,7 +72,7 @@ struct ConformOp : P {
         }
 
         for (auto& child : s.components) {
-            project_recursive(vfs, child, current_tf, tree, target_mesh, dir, offset);
+            project_recursive(vfs, child, current_tf, tree, bvh, target_mesh, dir, offset);
         }
     }
 
@@ -104,16 +95,22 @@ struct ConformOp : P {
             target_mesh.point(v) = ek_to_ik(target.tf.transform(p_ek));
         }
         
-        Tree tree(faces(target_mesh).first, faces(target_mesh).second, target_mesh);
-        tree.build();
-
         IK::Vector_3 dir(0,0,0);
         if (direction.size() >= 3 && (direction[0] != 0 || direction[1] != 0 || direction[2] != 0)) {
             dir = IK::Vector_3(direction[0], direction[1], direction[2]);
         }
 
+        // Closest point mode queries the AABB tree; raycast mode the BVH.
+        std::unique_ptr<Tree> tree;
+        std::unique_ptr<boolean::TriangleBVH> bvh;
+        if (dir == IK::Vector_3(0,0,0)) {
+            tree = std::make_unique<Tree>(faces(target_mesh).first, faces(target_mesh).second, target_mesh);
+        } else {
+            bvh = std::make_unique<boolean::TriangleBVH>(boolean::TriangleBVH::from_mesh(target_mesh));
+        }
+
         Shape out = in;
-        project_recursive(vfs, out, Matrix::identity(), tree, target_mesh, dir, offset);
+        project_recursive(vfs, out, Matrix::identity(), tree.get(), bvh.get(), target_mesh, dir, offset);
         
         vfs->write(fulfilling.with_output("$out"), out);
     }
@@ -11,7 +11,7 @@ template <typename P = JotVfsProtocol>
 struct CutOp : P {
     static constexpr const char* path = "jot/cut";
 
-    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::vector<Shape>& tools, bool open = false) {
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::vector<Shape>& tools, bool open = false, const std::string& engine = "pairwise") {
         Shape result = in;
         if (tools.empty()) {
             vfs->write(fulfilling.with_output("$out"), result);
@@ -23,7 +23,7 @@ struct CutOp : P {
             boolean::Engine::collect_tool_geometry(vfs, tool, Matrix::identity(), tool_nodes);
         }
 
-        boolean::Engine::recursive_subtract(vfs, result, Matrix::identity(), tool_nodes, open);
+        boolean::Engine::recursive_subtract(vfs, result, Matrix::identity(), tool_nodes, open, false, boolean::Engine::mode_from_string(engine));
         
         for (const auto& tool : tools) {
             result.components.push_back(Shape::make_ghost(tool));
@@ -32,7 +32,7 @@ struct CutOp : P {
         vfs->write(fulfilling.with_output("$out"), result);
     }
 
-    static std::vector<std::string> argument_keys() { return {"$in", "tools", "open"}; }
+    static std::vector<std::string> argument_keys() { return {"$in", "tools", "open", "engine"}; }
     static typename P::json schema() {
         return { 
             {"path", "jot/cut"}, 
@@ -45,7 +45,8 @@ struct CutOp : P {
             }},
             {"arguments", nlohmann::json::array({ 
                 {{"name", "tools"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}, {"description", "A shape, list of shapes, or sequence to subtract."}}, 
-                {{"name", "open"}, {"type", "jot:boolean"}, {"default", false}, {"description", "If true, leaves the cut boundaries open."}} 
+                {{"name", "open"}, {"type", "jot:boolean"}, {"default", false}, {"description", "If true, leaves the cut boundaries open."}},
+                {{"name", "engine"}, {"type", "jot:string"}, {"default", "pairwise"}, {"enum", {"pairwise", "incremental"}}, {"description", "How the cut is evaluated. 'incremental' subtracts all closed tools in one pass and caches the unions of overlapping tools, so moving one closed tool only re-joins the tools it overlaps."}}
             })}, 
             {"outputs", {{"$out", {{"type", "jot:shape"}, {"description", "The resulting cut shape."}}}}},
             {"examples", {"Box(10).cut(Orb(3)) -> $out", "Box(10).cut([Orb(2), Cylinder(1)]) -> $out"}}
@@ -54,7 +55,7 @@ struct CutOp : P {
 };
 
 static void cut_init(fs::VFSNode* vfs) {
-    Processor::register_op<CutOp<>, Shape, std::vector<Shape>, bool>(vfs, "jot/cut");
+    Processor::register_op<CutOp<>, Shape, std::vector<Shape>, bool, std::string>(vfs, "jot/cut");
 }
 
 } // namespace geo
@@ -139,17 +139,16 @@ struct FacesOp : P {
 
             Matrix project_tf = Matrix::lookAt(patch_plane.point(), patch_plane.orthogonal_vector());
             Matrix rehydrate_tf = project_tf.inverse();
-            General_polygon_set_2 gps;
+            boolean::PolygonBatch batch;
             for (auto pf : patch) {
                 Polygon_2 poly;
                 for (auto v : mesh.vertices_around_face(mesh.halfedge(pf))) {
                     auto lp = project_tf.transform(mesh.point(v));
                     poly.push_back(EK::Point_2(lp.x(), lp.y()));
                 }
-                if (poly.is_empty() || !poly.is_simple()) continue;
-                if (poly.is_clockwise_oriented()) poly.reverse_orientation();
-                gps.join(Polygon_with_holes_2(poly));
+                batch.add(poly);
             }
+            General_polygon_set_2 gps = batch.to_set();
 
             std::vector<Polygon_with_holes_2> merged_pwhs;
             gps.polygons_with_holes(std::back_inserter(merged_pwhs));
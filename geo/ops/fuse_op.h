@@ -27,7 +27,7 @@ struct FuseHelper {
         }
     }
 
-    static void execute_fuse_nodes(fs::VFSNode* vfs, const fs::Selector& fulfilling, const std::vector<GeometryNode>& all_nodes) {
+    static void execute_fuse_nodes(fs::VFSNode* vfs, const fs::Selector& fulfilling, const std::vector<GeometryNode>& all_nodes, boolean::Engine::Mode mode = boolean::Engine::Mode::Pairwise) {
         if (all_nodes.empty()) {
             vfs->write(fulfilling.with_output("$out"), Shape());
             return;
@@ -35,7 +35,7 @@ struct FuseHelper {
 
         // 2. Group components by type (Closed Solids vs Coplanar Surfaces)
         boolean::Surface_mesh combined_solids;
-        std::vector<std::pair<EK::Plane_3, boolean::General_polygon_set_2>> plane_groups;
+        std::vector<std::pair<EK::Plane_3, boolean::PolygonBatch>> plane_batches;
 
         std::vector<GeometryNode> regular_nodes, gap_nodes;
         for (const auto& node : all_nodes) {
@@ -44,6 +44,7 @@ struct FuseHelper {
         }
 
         // Process Regular Nodes
+        std::vector<boolean::Surface_mesh> solid_meshes;
         for (const auto& node : regular_nodes) {
             if (node.geo.vertices.empty()) continue;
 
@@ -51,26 +52,21 @@ struct FuseHelper {
                 // A. Watertight 3D Solids
                 boolean::Surface_mesh mesh = boolean::Engine::geometry_to_mesh(node.geo);
                 boolean::Engine::transform_mesh(mesh, node.tf);
-                
-                if (combined_solids.number_of_vertices() == 0) {
-                    combined_solids = mesh;
-                } else {
-                    boolean::Engine::join_mesh_by_mesh(combined_solids, mesh);
-                }
+                solid_meshes.push_back(std::move(mesh));
             } else if (node.type == "surface") {
                 // B. 2D Planar Surfaces
                 // World plane is defined robustly by transforming local Z=0 plane using node.tf
                 EK::Plane_3 world_plane = node.tf.transform(EK::Plane_3(0, 0, 1, 0));
 
                 bool found_group = false;
-                for (auto& [existing_plane, gps] : plane_groups) {
+                for (auto& [existing_plane, batch] : plane_batches) {
                     // Check if they represent the same 3D plane
                     if (std::abs(CGAL::to_double(CGAL::squared_distance(existing_plane, world_plane.point()))) < 1e-6) {
                         Vector_3 n1 = existing_plane.orthogonal_vector();
                         Vector_3 n2 = world_plane.orthogonal_vector();
                         if (CGAL::cross_product(n1, n2).squared_length() < 1e-6) {
                             Matrix project_tf = Matrix::lookAt(existing_plane.point(), existing_plane.orthogonal_vector());
-                            boolean::Engine::add_geometry_to_gps(node.geo, project_tf * node.tf, gps);
+                            boolean::Engine::add_geometry_to_batch(node.geo, project_tf * node.tf, batch);
                             found_group = true;
                             break;
                         }
@@ -79,13 +75,23 @@ struct FuseHelper {
 
                 if (!found_group) {
                     Matrix project_tf = Matrix::lookAt(world_plane.point(), world_plane.orthogonal_vector());
-                    boolean::General_polygon_set_2 gps;
-                    boolean::Engine::add_geometry_to_gps(node.geo, project_tf * node.tf, gps);
-                    plane_groups.push_back({world_plane, gps});
+                    plane_batches.push_back({world_plane, boolean::PolygonBatch()});
+                    boolean::Engine::add_geometry_to_batch(node.geo, project_tf * node.tf, plane_batches.back().second);
                 }
             }
         }
 
+        // Union each coplanar group in one sweep
+        std::vector<std::pair<EK::Plane_3, boolean::General_polygon_set_2>> plane_groups;
+        for (const auto& [world_plane, batch] : plane_batches) plane_groups.push_back({world_plane, batch.to_set()});
+
+        // Union all solids at once so the arrangement engine sees every input
+        if (!solid_meshes.empty()) {
+            combined_solids = std::move(solid_meshes[0]);
+            std::vector<boolean::Surface_mesh> rest(std::make_move_iterator(solid_meshes.begin() + 1), std::make_move_iterator(solid_meshes.end()));
+            boolean::Engine::join_meshes(combined_solids, rest, mode);
+        }
+
         // Process Gap Nodes
         for (const auto& gap : gap_nodes) {
             if (gap.geo.vertices.empty()) continue;
@@ -163,22 +169,23 @@ template <typename P = JotVfsProtocol>
 struct FuseOp : P {
     static constexpr const char* path = "jot/fuse";
 
-    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::vector<Shape>& tools) {
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::vector<Shape>& tools, const std::string& engine = "pairwise") {
         std::vector<FuseHelper::GeometryNode> all_nodes;
         FuseHelper::collect_geometries(vfs, in, all_nodes);
         for (const auto& tool : tools) {
             FuseHelper::collect_geometries(vfs, tool, all_nodes);
         }
-        FuseHelper::execute_fuse_nodes(vfs, fulfilling, all_nodes);
+        FuseHelper::execute_fuse_nodes(vfs, fulfilling, all_nodes, boolean::Engine::mode_from_string(engine));
     }
 
-    static std::vector<std::string> argument_keys() { return {"$in", "tools"}; }
+    static std::vector<std::string> argument_keys() { return {"$in", "tools", "engine"}; }
     static typename P::json schema() {
         return { 
             {"path", "jot/fuse"}, 
             {"inputs", {{"$in", {{"type", "jot:shape"}, {"description", "The shape to fuse."}}}}},
             {"arguments", nlohmann::json::array({ 
-                {{"name", "tools"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}}
+                {{"name", "tools"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}},
+                {{"name", "engine"}, {"type", "jot:string"}, {"default", "pairwise"}, {"enum", {"pairwise", "arrangement"}}}
             })}, 
             {"outputs", {{"$out", {{"type", "jot:shape"}}}}} 
         };
@@ -189,15 +196,15 @@ template <typename P = JotVfsProtocol>
 struct FusePrimitiveOp : P {
     static constexpr const char* path = "jot/Fuse";
 
-    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const std::vector<Shape>& shapes) {
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const std::vector<Shape>& shapes, const std::string& engine = "pairwise") {
         std::vector<FuseHelper::GeometryNode> all_nodes;
         for (const auto& shape : shapes) {
             FuseHelper::collect_geometries(vfs, shape, all_nodes);
         }
-        FuseHelper::execute_fuse_nodes(vfs, fulfilling, all_nodes);
+        FuseHelper::execute_fuse_nodes(vfs, fulfilling, all_nodes, boolean::Engine::mode_from_string(engine));
     }
 
-    static std::vector<std::string> argument_keys() { return {"shapes"}; }
+    static std::vector<std::string> argument_keys() { return {"shapes", "engine"}; }
     static typename P::json schema() {
         return { 
             {"path", "jot/Fuse"},
@@ -207,7 +214,8 @@ struct FusePrimitiveOp : P {
             {"synonyms", {"Union", "Combine"}},
             {"inputs", nlohmann::json::object()}, 
             {"arguments", nlohmann::json::array({ 
-                {{"name", "shapes"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}, {"description", "The list of shapes to fuse."}}
+                {{"name", "shapes"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}, {"description", "The list of shapes to fuse."}},
+                {{"name", "engine"}, {"type", "jot:string"}, {"default", "pairwise"}, {"enum", {"pairwise", "arrangement"}}, {"description", "Boolean engine: 'pairwise' or 'arrangement' (single-pass N-ary union)."}}
             })}, 
             {"outputs", {{"$out", {{"type", "jot:shape"}}}}} 
         };
@@ -215,8 +223,8 @@ struct FusePrimitiveOp : P {
 };
 
 static void fuse_init(fs::VFSNode* vfs) {
-    Processor::register_op<FuseOp<>, Shape, std::vector<Shape>>(vfs, "jot/fuse");
-    Processor::register_op<FusePrimitiveOp<>, std::vector<Shape>>(vfs, "jot/Fuse");
+    Processor::register_op<FuseOp<>, Shape, std::vector<Shape>, std::string>(vfs, "jot/fuse");
+    Processor::register_op<FusePrimitiveOp<>, std::vector<Shape>, std::string>(vfs, "jot/Fuse");
 }
 
 } // namespace geo
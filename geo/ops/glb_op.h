@@ -0,0 +1,45 @@
+#pragma once
+#include "protocols.h"
+#include "processor.h"
+#include "glb.h"
+
+namespace jotcad {
+namespace geo {
+
+template <typename P = JotVfsProtocol>
+struct GlbOp : P {
+    static constexpr const char* path = "jot/glb";
+
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::string& glb_path, bool quantize = false) {
+        Rasterizer::Scene scene = Rasterizer::collect_scene(vfs, in, false);
+        GLBWriter writer(quantize);
+        writer.add_scene(scene);
+
+        // Output: GLB bytes in the primary '$out' port
+        vfs->write(fulfilling.with_output("$out"), writer.write_binary());
+    }
+
+    static std::vector<std::string> argument_keys() { return {"$in", "path", "quantize"}; }
+
+    static typename P::json schema() {
+        return {
+            {"path", "jot/glb"},
+            {"description", "Generates a binary glTF scene from the input shape for progressive display, instancing shared geometry and resolving color, opacity and material tags as the renderer does."},
+            {"inputs", {{"$in", {{"type", "jot:shape"}}}}},
+            {"arguments", json::array({
+                {{"name", "path"}, {"type", "jot:string"}, {"default", "export.glb"}},
+                {{"name", "quantize"}, {"type", "jot:boolean"}, {"default", false}}
+            })},
+            {"outputs", {
+                {"$out", {{"type", "file"}, {"mimeType", "model/gltf-binary"}, {"description", "The generated GLB blob."}}}
+            }}
+        };
+    }
+};
+
+static void glb_init(fs::VFSNode* vfs) {
+    Processor::register_op<GlbOp<>, Shape, std::string, bool>(vfs, "jot/glb");
+}
+
+} // namespace geo
+} // namespace jotcad
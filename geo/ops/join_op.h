@@ -11,7 +11,7 @@ template <typename P = JotVfsProtocol>
 struct JoinOp : P {
     static constexpr const char* path = "jot/join";
 
-    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::vector<Shape>& tools) {
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::vector<Shape>& tools, const std::string& engine = "pairwise") {
         Shape out = in;
         if (tools.empty()) {
             vfs->write(fulfilling.with_output("$out"), out);
@@ -23,17 +23,18 @@ struct JoinOp : P {
             boolean::Engine::collect_tool_geometry(vfs, tool, Matrix::identity(), tool_nodes);
         }
 
-        boolean::Engine::recursive_union(vfs, out, Matrix::identity(), tool_nodes);
+        boolean::Engine::recursive_union(vfs, out, Matrix::identity(), tool_nodes, boolean::Engine::mode_from_string(engine));
         vfs->write(fulfilling.with_output("$out"), out);
     }
 
-    static std::vector<std::string> argument_keys() { return {"$in", "tools"}; }
+    static std::vector<std::string> argument_keys() { return {"$in", "tools", "engine"}; }
     static typename P::json schema() {
         return { 
             {"path", "jot/join"}, 
             {"inputs", {{"$in", {{"type", "jot:shape"}, {"description", "The shape to join to."}}}}},
             {"arguments", json::array({ 
-                {{"name", "tools"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}}
+                {{"name", "tools"}, {"type", "jot:shapes"}, {"default", nlohmann::json::array()}},
+                {{"name", "engine"}, {"type", "jot:string"}, {"default", "pairwise"}, {"enum", {"pairwise", "arrangement"}}, {"description", "Boolean engine: 'pairwise' (one corefinement per tool) or 'arrangement' (all solids refined in a single pass)."}}
             })}, 
             {"outputs", {{"$out", {{"type", "jot:shape"}}}}} 
         };
@@ -41,7 +42,7 @@ struct JoinOp : P {
 };
 
 static void join_init(fs::VFSNode* vfs) {
-    Processor::register_op<JoinOp<>, Shape, std::vector<Shape>>(vfs, "jot/join");
+    Processor::register_op<JoinOp<>, Shape, std::vector<Shape>, std::string>(vfs, "jot/join");
 }
 
 } // namespace geo
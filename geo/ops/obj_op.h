@@ -63,12 +63,12 @@ struct ObjImportOp : P {
     static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const fs::Selector& file) {
         fs::VFSResult file_res = vfs->read<fs::VFSResult>(file);
         
-        std::string obj_text(file_res.data.begin(), file_res.data.end());
-        
-        Geometry geo;
-        if (!OBJReader::read_text(obj_text, geo)) {
+        ImportMesh mesh;
+        if (!OBJReader::read_text((const char*)file_res.data.data(), file_res.data.size(), mesh)) {
             throw std::runtime_error("Failed to parse OBJ file");
         }
+        Geometry geo;
+        mesh.to_geometry(geo);
 
         Shape out = P::make_shape(vfs, geo, {{"type", "closed"}});
         vfs->write(fulfilling.with_output("$out"), out);
@@ -14,9 +14,8 @@ struct PdfOp : P {
     static void walk(fs::VFSNode* vfs, const Shape& shape, PDFWriter& writer) {
         if (shape.geometry.has_value()) {
             try {
-                Geometry geo = vfs->read<Geometry>(shape.geometry.value());
-                geo.apply_tf(shape.tf);
-                writer.add_geometry(geo);
+                // Placed in doubles; the writer keeps only the outlines.
+                writer.add_paths(PDFPaths::from(vfs->read<Geometry>(shape.geometry.value()), shape.tf));
             } catch (const std::exception& e) {
                 std::cerr << "[PdfOp::walk] Error reading geometry: " << e.what() << std::endl;
             }
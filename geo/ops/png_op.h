@@ -2,6 +2,7 @@
 #include "protocols.h"
 #include "processor.h"
 #include "render/png_op.h"
+#include "render/image_encoder.h"
 
 namespace jotcad {
 namespace geo {
@@ -20,11 +21,15 @@ struct PngOp : P {
     static typename P::json schema() {
         return {
             {"path", "jot/png"},
-            {"description", "Generates a PNG thumbnail for the input shape and returns it via the '$out' port."},
+            {"description", "Generates a PNG thumbnail for the input shape and returns it via the '$out' port. Selector parameters ax, ay, width and height set the view; format ('png' or 'qoi') and level (zlib 0-9, default: built-in writer) set the encoding. layers (default false) composites assemblies from cached per-component layers for fast re-rendering after edits. lod (default false) draws dense meshes from decimated levels sized to the frame; the first such render builds the level."},
             {"inputs", {{"$in", {{"type", "jot:shape"}}}}},
             {"arguments", nlohmann::json::array()},
             {"outputs", {
-                {"$out", {{"type", "file"}, {"mimeType", "image/png"}, {"description", "The generated PNG thumbnail."}}}
+                {"$out", {{"type", "file"},
+                          {"mimeType", ImageEncoder::mime_type(ImageEncoder::Format::Png)},
+                          {"mimeTypes", {{"png", ImageEncoder::mime_type(ImageEncoder::Format::Png)},
+                                         {"qoi", ImageEncoder::mime_type(ImageEncoder::Format::Qoi)}}},
+                          {"description", "The generated thumbnail, in the mimeTypes entry for the selected format."}}}
             }}
         };
     }
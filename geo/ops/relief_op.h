@@ -2,8 +2,12 @@
 #include "protocols.h"
 #include "processor.h"
 #include "../../fs/cpp/vendor/stb_image.h"
+#include "../core/derived.h"
 #include "../render/contour_utils.h"
 #include "../render/triangulation.h"
+#include "../algorithms/png_rows.h"
+#include "../algorithms/raster.h"
+#include "../algorithms/rtin.h"
 #include <CGAL/mark_domain_in_triangulation.h>
 #include <vector>
 #include <array>
@@ -13,15 +17,398 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <climits>
+#include <optional>
+#include <utility>
 
 namespace jotcad {
 namespace geo {
 
+/**
+ * ReliefMesh: The triangles of a relief in physical units, with vertices
+ * welded at 1e-6. Pixel positions map onto a width x breadth footprint
+ * centered on the origin, levels onto base..base + height, and the bottom
+ * sits at z = 0.
+ */
+struct ReliefMesh {
+    struct VertexKey {
+        double x, y, z;
+        bool operator<(const VertexKey& o) const {
+            if (x != o.x) return x < o.x;
+            if (y != o.y) return y < o.y;
+            return z < o.z;
+        }
+    };
+
+    double width, breadth, height, base;
+    int W, H, levels;
+    double z_base = 0.0; // The bottom is always at Z=0 for standard primitives
+
+    std::map<VertexKey, int> vertex_map;
+    std::vector<Vertex> vertices;
+    std::vector<std::array<int, 3>> triangles;
+    std::set<std::pair<std::pair<long long, long long>, std::pair<long long, long long>>> built_walls;
+
+    // Levels that walls are split at, ascending from -1 for the bottom.
+    std::vector<int> existing_levels;
+    std::vector<int> level_to_idx;
+
+    ReliefMesh(double width, double breadth, double height, double base, int W, int H, int levels)
+        : width(width), breadth(breadth), height(height), base(base), W(W), H(H), levels(levels) {}
+
+    int add_vertex(double px, double py, double pz) {
+        double sx = std::round(px * 1000000.0) / 1000000.0;
+        double sy = std::round(py * 1000000.0) / 1000000.0;
+        double sz = std::round(pz * 1000000.0) / 1000000.0;
+        VertexKey key{sx, sy, sz};
+        auto it = vertex_map.find(key);
+        if (it != vertex_map.end()) return it->second;
+        int idx = vertices.size();
+        vertices.push_back(Vertex{FT(sx), FT(sy), FT(sz)});
+        vertex_map[key] = idx;
+        return idx;
+    }
+
+    double to_phys_x(double px_pixel) const { return -width / 2.0 + ((px_pixel + 0.5) / W) * width; }
+    double to_phys_y(double py_pixel) const { return -breadth / 2.0 + ((py_pixel - 0.5) / H) * breadth; }
+    double get_z(int L) const { return base + height * (double)L / (levels - 1); }
+
+    void set_levels(const std::set<int>& unique_levels) {
+        existing_levels.assign(unique_levels.begin(), unique_levels.end());
+        level_to_idx.assign(levels + 1, -1);
+        for (int i = 0; i < (int)existing_levels.size(); ++i) {
+            level_to_idx[existing_levels[i] + 1] = i;
+        }
+    }
+
+    // A horizontal face at z bounded by face_polys, facing down for the bottom.
+    void add_cap(const std::vector<Polygon>& face_polys, double z, bool downward) {
+        // Add vertices to unique_vertices and record their indices
+        std::vector<std::vector<int>> face_loops_indices;
+        for (const auto& poly : face_polys) {
+            std::vector<int> loop_indices;
+            for (auto it = poly.vertices_begin(); it != poly.vertices_end(); ++it) {
+                double px = to_phys_x(CGAL::to_double(it->x()));
+                double py = to_phys_y(CGAL::to_double(it->y()));
+                loop_indices.push_back(add_vertex(px, py, z));
+            }
+            face_loops_indices.push_back(std::move(loop_indices));
+        }
+
+        // Triangulate directly using the 2D polygon coordinates
+        CDT cdt;
+        std::map<CDT::Vertex_handle, int> v_map;
+        for (size_t l = 0; l < face_polys.size(); ++l) {
+            const auto& poly = face_polys[l];
+            const auto& indices = face_loops_indices[l];
+            std::vector<CDT::Vertex_handle> vh;
+            for (size_t idx = 0; idx < poly.size(); ++idx) {
+                vh.push_back(cdt.insert(poly[idx]));
+                v_map[vh.back()] = indices[idx];
+            }
+            if (vh.size() >= 2) {
+                for (size_t idx = 0; idx < vh.size(); ++idx) {
+                    cdt.insert_constraint(vh[idx], vh[(idx + 1) % vh.size()]);
+                }
+            }
+        }
+        CGAL::mark_domain_in_triangulation(cdt);
+        for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
+            if (!fit->info().in_domain) continue;
+            if (downward) {
+                triangles.push_back({v_map[fit->vertex(0)], v_map[fit->vertex(2)], v_map[fit->vertex(1)]});
+            } else {
+                triangles.push_back({v_map[fit->vertex(0)], v_map[fit->vertex(1)], v_map[fit->vertex(2)]});
+            }
+        }
+    }
+
+    // Wall between lattice points p1 and p2, with the region at level on
+    // its right and neighbor_level (-1 for outside) on its left. Each
+    // segment is built once, split at every existing level in between.
+    void add_wall(const ContourUtils::LatticePoint& p1, const ContourUtils::LatticePoint& p2, int level, int neighbor_level) {
+        double px1 = to_phys_x(p1.x / ContourUtils::kLatticeScale);
+        double py1 = to_phys_y(p1.y / ContourUtils::kLatticeScale);
+        double px2 = to_phys_x(p2.x / ContourUtils::kLatticeScale);
+        double py2 = to_phys_y(p2.y / ContourUtils::kLatticeScale);
+
+        auto to_key_point = [](double x, double y) {
+            return std::make_pair(
+                (long long)std::round(x * 1000000),
+                (long long)std::round(y * 1000000)
+            );
+        };
+        auto k1 = to_key_point(px1, py1);
+        auto k2 = to_key_point(px2, py2);
+        auto key = std::make_pair(std::min(k1, k2), std::max(k1, k2));
+        if (built_walls.count(key)) return;
+        built_walls.insert(key);
+
+        int idx_start = level_to_idx[level + 1];
+        int idx_end = level_to_idx[neighbor_level + 1];
+        if (idx_start == -1 || idx_end == -1) return;
+
+        int i_min = std::min(idx_start, idx_end);
+        int i_max = std::max(idx_start, idx_end);
+
+        for (int idx = i_min; idx < i_max; ++idx) {
+            int l1 = existing_levels[idx];
+            int l2 = existing_levels[idx + 1];
+
+            double h1 = (l1 == -1) ? z_base : get_z(l1);
+            double h2 = (l2 == -1) ? z_base : get_z(l2);
+
+            if (std::abs(h1 - h2) < 1e-9) continue;
+
+            double hz1 = std::min(h1, h2);
+            double hz2 = std::max(h1, h2);
+
+            int b1 = add_vertex(px1, py1, hz1);
+            int b2 = add_vertex(px2, py2, hz1);
+            int a1 = add_vertex(px1, py1, hz2);
+            int a2 = add_vertex(px2, py2, hz2);
+
+            // If the region's level is HIGHER than the current wall level
+            // segment (idx), the wall is an exterior face of the region.
+            bool point_right = level > l1;
+
+            if (point_right) {
+                triangles.push_back({b1, b2, a1});
+                triangles.push_back({a1, b2, a2});
+            } else {
+                triangles.push_back({b1, a1, b2});
+                triangles.push_back({a1, a2, b2});
+            }
+        }
+    }
+
+    /**
+     * add_walls: Vertical walls along every boundary between labels of a
+     * padded label image, or of a window of one at padded offset (ox, oy),
+     * as marching_triangles traces them. level_of maps a label to its level;
+     * the border label is never a wall's own side.
+     */
+    template <typename LevelOf>
+    void add_walls(const std::vector<int>& padded, int p_w, int p_h, int ox, int oy, int border, LevelOf level_of) {
+        for (int y = 0; y < p_h - 1; ++y) {
+            for (int x = 0; x < p_w - 1; ++x) {
+                int v0_lbl = padded[y*p_w+x];
+                int v1_lbl = padded[y*p_w+(x+1)];
+                int v2_lbl = padded[(y+1)*p_w+(x+1)];
+                int v3_lbl = padded[(y+1)*p_w+x];
+
+                int cell_colors[4];
+                int num_colors = 0;
+                auto add_unique_color = [&](int lbl) {
+                    if (lbl == border) return;
+                    for (int j = 0; j < num_colors; ++j) {
+                        if (cell_colors[j] == lbl) return;
+                    }
+                    cell_colors[num_colors++] = lbl;
+                };
+                add_unique_color(v0_lbl);
+                add_unique_color(v1_lbl);
+                add_unique_color(v2_lbl);
+                add_unique_color(v3_lbl);
+
+                int64_t fx = 2 * (int64_t)(x + ox - 1), fy = 2 * (int64_t)(H - (y + oy - 1));
+                for (int color_idx = 0; color_idx < num_colors; ++color_idx) {
+                    int c = cell_colors[color_idx];
+                    ContourUtils::cell_segments(fx, fy, v0_lbl, v1_lbl, v2_lbl, v3_lbl, c,
+                        [&](const ContourUtils::LatticePoint& a, const ContourUtils::LatticePoint& b, int neighbor) {
+                            add_wall(a, b, level_of(c), level_of(neighbor));
+                        });
+                }
+            }
+        }
+    }
+
+    Geometry geometry() {
+        Geometry geo;
+        geo.vertices = std::move(vertices);
+        geo.triangles = std::move(triangles);
+        return geo;
+    }
+};
+
+/**
+ * ReliefBlocks: Level labels of a tiled relief, one tile-sized block at a
+ * time. A block is quantized, despeckled and merged within a window reaching
+ * margin() pixels past it, leaving components cut by the window edge
+ * unmerged, and keeps only its own pixels. Every pixel's level comes from
+ * exactly one block, so neighboring tiles agree along their shared edges.
+ * Blocks are cached as Derived "relief_levels" entries of 16-bit labels.
+ */
+struct ReliefBlocks {
+    // Image pixels. PNGs are decoded a window of rows at a time, moving
+    // forward through the image, so memory follows the window rather than
+    // the image; other formats are decoded whole on first use.
+    struct Source {
+        const std::vector<uint8_t>& bytes;
+        PngRows png;
+        unsigned char* data = nullptr;
+        std::vector<unsigned char> window;
+        int first = 0;  // Image row of window[0]
+        int W = 0, H = 0;
+
+        explicit Source(const std::vector<uint8_t>& bytes) : bytes(bytes), png(bytes.data(), bytes.size()) {
+            int channels;
+            if (png.ok()) {
+                W = png.width;
+                H = png.height;
+            } else if (bytes.size() > INT_MAX || !stbi_info_from_memory(bytes.data(), (int)bytes.size(), &W, &H, &channels)) {
+                throw std::runtime_error("Relief: stbi_info failed");
+            }
+        }
+        ~Source() { if (data) stbi_image_free(data); }
+
+        // RGB rows y0 .. y1 - 1, valid until the next call.
+        const unsigned char* rows(int y0, int y1) {
+            const size_t stride = (size_t)W * 3;
+            if (!png.ok()) {
+                if (!data) {
+                    int channels;
+                    data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &W, &H, &channels, 3);
+                    if (!data) throw std::runtime_error("Relief: stbi_load failed");
+                }
+                return data + (size_t)y0 * stride;
+            }
+            int last = first + (int)(window.size() / stride);
+            if (y0 >= first && y0 <= last) {
+                window.erase(window.begin(), window.begin() + (size_t)(y0 - first) * stride);
+            } else {
+                window.clear();
+                if (png.row() > y0) png.rewind();
+                std::vector<unsigned char> skip(stride);
+                while (png.row() < y0) png.read(skip.data());
+            }
+            first = y0;
+            for (size_t have = window.size() / stride; (int)have < y1 - y0; ++have) {
+                window.resize((have + 1) * stride);
+                png.read(window.data() + have * stride);
+            }
+            return window.data();
+        }
+    };
+
+    static int margin(double minArea) { return (int)std::ceil(std::max(0.0, minArea)) + 2; }
+
+    // Image rows the labels of block row by are computed from.
+    static std::pair<int, int> window_rows(int H, double minArea, int tile, int by) {
+        const int M = margin(minArea);
+        return {std::max(0, by * tile - M), std::min(H, std::min(H, (by + 1) * tile) + M)};
+    }
+
+    static fs::Selector key(const nlohmann::json& image, int tile, int bx, int by, int levels, double minArea) {
+        return Derived::key("relief_levels", {{"image", image}, {"tile", tile}, {"x", bx}, {"y", by},
+                                              {"levels", levels}, {"minArea", minArea}});
+    }
+
+    // rgb holds the rows of window_rows(H, minArea, tile, by).
+    static std::vector<int> compute(const unsigned char* rgb, int W, int H, int levels, double minArea, int tile, int bx, int by) {
+        const int M = margin(minArea);
+        int cx0 = bx * tile, cx1 = std::min(W, cx0 + tile);
+        int cy0 = by * tile, cy1 = std::min(H, cy0 + tile);
+        int wx0 = std::max(0, cx0 - M), wx1 = std::min(W, cx1 + M);
+        auto [wy0, wy1] = window_rows(H, minArea, tile, by);
+        int ww = wx1 - wx0, wh = wy1 - wy0;
+
+        // Blocks are computed on fetch_all's workers, so luma is taken here
+        // serially rather than through Raster::intensity.
+        std::vector<int> labels((size_t)ww * wh);
+        for (int y = 0; y < wh; ++y) {
+            const unsigned char* row = rgb + ((size_t)y * W + wx0) * 3;
+            for (int x = 0; x < ww; ++x) {
+                double luma = 0.299 * (row[x * 3] / 255.0) + 0.587 * (row[x * 3 + 1] / 255.0) + 0.114 * (row[x * 3 + 2] / 255.0);
+                labels[(size_t)y * ww + x] = std::clamp((int)(luma * (levels - 1) + 0.5), 0, levels - 1);
+            }
+        }
+        std::vector<int> clean_labels = Raster::mode_filter(labels, ww, wh);
+        int open_edges = (wx0 > 0 ? Raster::kLeft : 0) | (wx1 < W ? Raster::kRight : 0) |
+                         (wy0 > 0 ? Raster::kTop : 0) | (wy1 < H ? Raster::kBottom : 0);
+        Raster::merge_small_regions(clean_labels, ww, wh, minArea, [](int a, int b) { return (double)std::abs(a - b); }, 5, open_edges);
+
+        std::vector<int> core((size_t)(cx1 - cx0) * (cy1 - cy0));
+        for (int y = cy0; y < cy1; ++y) {
+            for (int x = cx0; x < cx1; ++x) {
+                core[(size_t)(y - cy0) * (cx1 - cx0) + (x - cx0)] = clean_labels[(size_t)(y - wy0) * ww + (x - wx0)];
+            }
+        }
+        return core;
+    }
+
+    static size_t count(int W, int H, int tile, int bx, int by) {
+        return (size_t)(std::min(W, (bx + 1) * tile) - bx * tile) * (std::min(H, (by + 1) * tile) - by * tile);
+    }
+
+    static std::optional<std::vector<int>> lookup(fs::VFSNode* vfs, const nlohmann::json& image, int W, int H,
+                                                  int levels, double minArea, int tile, int bx, int by) {
+        const size_t n = count(W, H, tile, bx, by);
+        if (auto entry = Derived::lookup(vfs, key(image, tile, bx, by, levels, minArea))) {
+            try {
+                std::vector<uint8_t> bytes = vfs->read<std::vector<uint8_t>>(*entry);
+                if (bytes.size() == n * 2) {
+                    std::vector<int> labels(n);
+                    for (size_t i = 0; i < n; ++i) labels[i] = bytes[2 * i] | bytes[2 * i + 1] << 8;
+                    return labels;
+                }
+            } catch (...) {
+                // Missing or unreadable artifact: recompute.
+            }
+        }
+        return std::nullopt;
+    }
+
+    static void store(fs::VFSNode* vfs, const nlohmann::json& image, int levels, double minArea, int tile, int bx, int by,
+                      const std::vector<int>& labels) {
+        std::vector<uint8_t> bytes(labels.size() * 2);
+        for (size_t i = 0; i < labels.size(); ++i) {
+            bytes[2 * i] = (uint8_t)(labels[i] & 0xff);
+            bytes[2 * i + 1] = (uint8_t)(labels[i] >> 8);
+        }
+        Derived::store(vfs, key(image, tile, bx, by, levels, minArea), vfs->materialize<std::vector<uint8_t>>(bytes));
+    }
+
+    static std::vector<int> fetch(fs::VFSNode* vfs, Source& source, const nlohmann::json& image,
+                                  int levels, double minArea, int tile, int bx, int by) {
+        if (auto labels = lookup(vfs, image, source.W, source.H, levels, minArea, tile, bx, by)) return *labels;
+        auto [wy0, wy1] = window_rows(source.H, minArea, tile, by);
+        std::vector<int> labels = compute(source.rows(wy0, wy1), source.W, source.H, levels, minArea, tile, bx, by);
+        store(vfs, image, levels, minArea, tile, bx, by, labels);
+        return labels;
+    }
+
+    /**
+     * Labels every block that is not cached yet. Each row of blocks decodes
+     * its window of image rows once and labels its blocks concurrently.
+     */
+    static void fetch_all(fs::VFSNode* vfs, Source& source, const nlohmann::json& image, int levels, double minArea, int tile) {
+        const int nx = (source.W + tile - 1) / tile, ny = (source.H + tile - 1) / tile;
+        for (int by = 0; by < ny; ++by) {
+            std::vector<char> cached(nx);
+            Raster::parallel_bands(nx, [&](int begin, int end) {
+                for (int bx = begin; bx < end; ++bx) {
+                    cached[bx] = lookup(vfs, image, source.W, source.H, levels, minArea, tile, bx, by).has_value();
+                }
+            }, 1);
+            if (std::all_of(cached.begin(), cached.end(), [](char c) { return c; })) continue;
+            auto [wy0, wy1] = window_rows(source.H, minArea, tile, by);
+            const unsigned char* rgb = source.rows(wy0, wy1);
+            Raster::parallel_bands(nx, [&](int begin, int end) {
+                for (int bx = begin; bx < end; ++bx) {
+                    if (cached[bx]) continue;
+                    store(vfs, image, levels, minArea, tile, bx, by, compute(rgb, source.W, source.H, levels, minArea, tile, bx, by));
+                }
+            }, 1);
+        }
+    }
+};
+
 template <typename P = JotVfsProtocol>
 struct ReliefOp : P {
     static constexpr const char* path = "jot/relief";
 
-    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const nlohmann::json& image_identity, double width, double breadth, double height, double base, int levels, double minArea, double smooth, bool close = true) {
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const nlohmann::json& image_identity, double width, double breadth, double height, double base, int levels, double minArea, double smooth, bool close = true, int tile = 0, double maxError = 0.0) {
         try {
             std::cout << "[Relief] Loading image bytes..." << std::endl;
             fs::Selector img_sel = image_identity.get<fs::Selector>();
@@ -29,21 +416,21 @@ struct ReliefOp : P {
             std::vector<uint8_t> img_bytes = vfs->read<std::vector<uint8_t>>(img_sel);
             if (img_bytes.empty()) throw std::runtime_error("Relief: Image data empty");
 
+            if (maxError > 0) {
+                execute_heightfield(vfs, fulfilling, img_bytes, width, breadth, height, base, maxError, close);
+                return;
+            }
+            if (tile > 0) {
+                execute_tiled(vfs, fulfilling, image_identity, img_bytes, width, breadth, height, base, levels, minArea, smooth, close, tile);
+                return;
+            }
+
             int W, H, channels;
             unsigned char* data = stbi_load_from_memory(img_bytes.data(), (int)img_bytes.size(), &W, &H, &channels, 3);
             if (!data) throw std::runtime_error("Relief: stbi_load failed");
 
             std::cout << "[Relief] Processing image of size " << W << "x" << H << "..." << std::endl;
-            std::vector<double> intensity_data(W * H);
-            for (int y = 0; y < H; ++y) {
-                for (int x = 0; x < W; ++x) {
-                    int idx = (x + y * W) * 3;
-                    double r = data[idx] / 255.0;
-                    double g = data[idx+1] / 255.0;
-                    double b = data[idx+2] / 255.0;
-                    intensity_data[y * W + x] = 0.299 * r + 0.587 * g + 0.114 * b;
-                }
-            }
+            std::vector<double> intensity_data = Raster::intensity(data, W * H);
 
             // 1. Uniform Quantization
             std::vector<int> labels(W * H);
@@ -51,142 +438,18 @@ struct ReliefOp : P {
                 labels[i] = std::clamp((int)(intensity_data[i] * (levels - 1) + 0.5), 0, levels - 1);
             }
 
-            // 2. Median Filter Despeckle (3x3)
-            std::vector<int> clean_labels = labels;
-            for (int y = 1; y < H - 1; ++y) {
-                for (int x = 1; x < W - 1; ++x) {
-                    std::map<int, int> neighbors;
-                    for (int dy = -1; dy <= 1; ++dy) {
-                        for (int dx = -1; dx <= 1; ++dx) neighbors[labels[(y+dy)*W + (x+dx)]]++;
-                    }
-                    int best = labels[y*W+x], max_c = 0;
-                    for (auto const& [id, count] : neighbors) if (count > max_c) { max_c = count; best = id; }
-                    if (max_c >= 5) clean_labels[y*W + x] = best;
-                }
-            }
+            // 2. Mode Filter Despeckle (3x3)
+            std::vector<int> clean_labels = Raster::mode_filter(labels, W, H);
 
-            // 3. BFS-based Component Merging
-            bool changed = true;
-            int passes = 0;
-            while (changed && passes < 5) {
-                changed = false;
-                passes++;
-                std::vector<bool> visited(W * H, false);
-                for (int y = 0; y < H; ++y) {
-                    for (int x = 0; x < W; ++x) {
-                        int start_idx = y * W + x;
-                        if (visited[start_idx]) continue;
-
-                        int target_label = clean_labels[start_idx];
-                        std::vector<int> component;
-                        std::vector<int> queue;
-                        queue.push_back(start_idx);
-                        visited[start_idx] = true;
-
-                        size_t q_head = 0;
-                        while (q_head < queue.size()) {
-                            int idx = queue[q_head++];
-                            component.push_back(idx);
-
-                            int cx = idx % W;
-                            int cy = idx / W;
-
-                            int dx[4] = {-1, 1, 0, 0};
-                            int dy[4] = {0, 0, -1, 1};
-                            for (int dir = 0; dir < 4; ++dir) {
-                                int nx = cx + dx[dir];
-                                int ny = cy + dy[dir];
-                                if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
-                                    int nidx = ny * W + nx;
-                                    if (clean_labels[nidx] == target_label && !visited[nidx]) {
-                                        visited[nidx] = true;
-                                        queue.push_back(nidx);
-                                    }
-                                }
-                            }
-                        }
-
-                        if (component.size() < (size_t)minArea) {
-                            std::set<int> neighbor_labels;
-                            for (int idx : component) {
-                                int cx = idx % W;
-                                int cy = idx / W;
-                                int dx[4] = {-1, 1, 0, 0};
-                                int dy[4] = {0, 0, -1, 1};
-                                for (int dir = 0; dir < 4; ++dir) {
-                                    int nx = cx + dx[dir];
-                                    int ny = cy + dy[dir];
-                                    if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
-                                        int nidx = ny * W + nx;
-                                        if (clean_labels[nidx] != target_label) {
-                                            neighbor_labels.insert(clean_labels[nidx]);
-                                        }
-                                    }
-                                }
-                            }
-
-                            if (!neighbor_labels.empty()) {
-                                int best_neighbor = -1;
-                                int min_dist = 999999;
-                                for (int n_lbl : neighbor_labels) {
-                                    int d = std::abs(target_label - n_lbl);
-                                    if (d < min_dist) {
-                                        min_dist = d;
-                                        best_neighbor = n_lbl;
-                                    }
-                                }
-
-                                if (best_neighbor != -1) {
-                                    for (int idx : component) {
-                                        clean_labels[idx] = best_neighbor;
-                                    }
-                                    changed = true;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            // 3. Merge small components into the nearest neighboring level
+            Raster::merge_small_regions(clean_labels, W, H, minArea, [](int a, int b) { return (double)std::abs(a - b); });
 
             stbi_image_free(data);
 
             // 4. Connected Component Partitioning & Boundary Injection
-            std::vector<int> comp_ids(W * H, -1);
-            int comp_count = 0;
+            std::vector<int> comp_ids;
             std::vector<int> comp_levels;
-            for (int y = 0; y < H; ++y) {
-                for (int x = 0; x < W; ++x) {
-                    int idx = y * W + x;
-                    if (comp_ids[idx] != -1) continue;
-
-                    int lvl = clean_labels[idx];
-                    int comp_id = comp_count++;
-                    comp_levels.push_back(lvl);
-
-                    std::vector<int> queue;
-                    queue.push_back(idx);
-                    comp_ids[idx] = comp_id;
-                    size_t q_head = 0;
-                    while (q_head < queue.size()) {
-                        int curr = queue[q_head++];
-                        int cx = curr % W;
-                        int cy = curr / W;
-                        int dx[4] = {-1, 1, 0, 0};
-                        int dy[4] = {0, 0, -1, 1};
-                        for (int dir = 0; dir < 4; ++dir) {
-                            int nx = cx + dx[dir];
-                            int ny = cy + dy[dir];
-                            if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
-                                int nidx = ny * W + nx;
-                                if (clean_labels[nidx] == lvl && comp_ids[nidx] == -1) {
-                                    comp_ids[nidx] = comp_id;
-                                    queue.push_back(nidx);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            int comp_count = Raster::label_components(clean_labels, W, H, comp_ids, &comp_levels);
 
             int border_comp_id = comp_count++;
             comp_levels.push_back(-1);
@@ -202,356 +465,341 @@ struct ReliefOp : P {
             // 5. Trace segments and weld loops for each component
             std::vector<int> targets(comp_count);
             for (int i = 0; i < comp_count; ++i) targets[i] = i;
-            auto comp_segments = ContourUtils::generate_marching_triangles_segments(padded, p_w, p_h, H, targets);
-
-            std::vector<std::vector<Polygon>> comp_loops(comp_count);
-            for (int i = 0; i < comp_count; ++i) {
-                comp_loops[i] = ContourUtils::weld_segments(comp_segments[i], smooth, 0.1, false);
-            }
+            std::vector<std::vector<Polygon>> comp_loops = ContourUtils::trace_components(padded, p_w, p_h, H, targets, smooth, 0.1, false);
 
             // 6. Geometry generation setup
-            struct VertexKey {
-                double x, y, z;
-                bool operator<(const VertexKey& o) const {
-                    if (x != o.x) return x < o.x;
-                    if (y != o.y) return y < o.y;
-                    return z < o.z;
-                }
-            };
-            std::map<VertexKey, int> vertex_map;
-            std::vector<Vertex> unique_vertices;
-            std::vector<Vec3> pts_double;
-            std::vector<std::array<int, 3>> triangles;
-
-            auto add_vertex = [&](double px, double py, double pz) {
-                double sx = std::round(px * 1000000.0) / 1000000.0;
-                double sy = std::round(py * 1000000.0) / 1000000.0;
-                double sz = std::round(pz * 1000000.0) / 1000000.0;
-                VertexKey key{sx, sy, sz};
-                auto it = vertex_map.find(key);
-                if (it != vertex_map.end()) return it->second;
-                int idx = unique_vertices.size();
-                unique_vertices.push_back(Vertex{FT(sx), FT(sy), FT(sz)});
-                pts_double.push_back(Vec3{sx, sy, sz});
-                vertex_map[key] = idx;
-                return idx;
-            };
-
-            auto to_phys_x = [&](double px_pixel) { return -width / 2.0 + ((px_pixel + 0.5) / W) * width; };
-            auto to_phys_y = [&](double py_pixel) { return -breadth / 2.0 + ((py_pixel - 0.5) / H) * breadth; };
-            auto get_z = [&](int L) { return base + height * (double)L / (levels - 1); };
-
-            double z_base = 0.0; // The bottom is always at Z=0 for standard primitives
+            ReliefMesh mesh(width, breadth, height, base, W, H, levels);
 
             // A. Top Horizontal Faces (for each component except border)
             for (int i = 0; i < comp_count - 1; ++i) {
                 const auto& polys = comp_loops[i];
                 if (polys.empty()) continue;
+                mesh.add_cap(face_polygons(polys), mesh.get_z(comp_levels[i]), false);
+            }
 
-                int c = comp_levels[i];
-                double z = get_z(c);
+            // B. Single Bottom Cap (for the border component)
+            if (close) {
+                const auto& polys = comp_loops[border_comp_id];
+                if (!polys.empty()) mesh.add_cap(face_polygons(polys), mesh.z_base, true);
+            }
 
-                // Find the outer boundary (longest loop)
-                size_t longest_idx = 0;
-                size_t max_size = 0;
-                for (size_t j = 0; j < polys.size(); ++j) {
-                    if (polys[j].size() > max_size) {
-                        max_size = polys[j].size();
-                        longest_idx = j;
-                    }
-                }
+            // C. Vertical Walls
+            std::set<int> unique_levels(clean_labels.begin(), clean_labels.end());
+            unique_levels.insert(-1);
+            mesh.set_levels(unique_levels);
+            mesh.add_walls(padded, p_w, p_h, 0, 0, border_comp_id, [&](int c) { return comp_levels[c]; });
 
-                std::vector<Polygon> face_polys;
-                Polygon outer = polys[longest_idx];
-                if (outer.is_clockwise_oriented()) outer.reverse_orientation();
-                face_polys.push_back(outer);
+            vfs->write(fulfilling.with_output("$out"), P::make_shape(vfs, mesh.geometry(), {}));
+        } catch (const std::exception& e) {
+            std::cerr << "[ReliefOp] Error: " << e.what() << std::endl;
+            throw;
+        }
+    }
 
-                for (size_t j = 0; j < polys.size(); ++j) {
-                    if (j != longest_idx) {
-                        Polygon hole = polys[j];
-                        if (hole.is_counterclockwise_oriented()) hole.reverse_orientation();
-                        face_polys.push_back(hole);
-                    }
-                }
+    // A component's outer loop counterclockwise, then its holes clockwise.
+    static std::vector<Polygon> face_polygons(const std::vector<Polygon>& polys) {
+        // The outer boundary encloses the component's holes
+        size_t outer_idx = ContourUtils::outer_loop(polys);
+
+        std::vector<Polygon> face_polys;
+        Polygon outer = polys[outer_idx];
+        if (outer.is_clockwise_oriented()) outer.reverse_orientation();
+        face_polys.push_back(outer);
+
+        for (size_t j = 0; j < polys.size(); ++j) {
+            if (j != outer_idx) {
+                Polygon hole = polys[j];
+                if (hole.is_counterclockwise_oriented()) hole.reverse_orientation();
+                face_polys.push_back(hole);
+            }
+        }
+        return face_polys;
+    }
 
-                // Add vertices to unique_vertices and record their indices
-                std::vector<std::vector<int>> face_loops_indices;
-                for (const auto& poly : face_polys) {
-                    std::vector<int> loop_indices;
-                    for (auto it = poly.vertices_begin(); it != poly.vertices_end(); ++it) {
-                        double px = to_phys_x(CGAL::to_double(it->x()));
-                        double py = to_phys_y(CGAL::to_double(it->y()));
-                        loop_indices.push_back(add_vertex(px, py, z));
-                    }
-                    face_loops_indices.push_back(std::move(loop_indices));
+    /**
+     * Heightfield relief: intensities become one continuous surface at
+     * base + height * intensity, resampled bilinearly onto an Rtin grid over
+     * the pixel centers and meshed to within maxError, instead of terraced
+     * levels. Closing adds walls down the boundary and a flat bottom.
+     */
+    static void execute_heightfield(fs::VFSNode* vfs, const fs::Selector& fulfilling, const std::vector<uint8_t>& img_bytes,
+                                    double width, double breadth, double height, double base, double maxError, bool close) {
+        int W, H, channels;
+        unsigned char* data = stbi_load_from_memory(img_bytes.data(), (int)img_bytes.size(), &W, &H, &channels, 3);
+        if (!data) throw std::runtime_error("Relief: stbi_load failed");
+        std::vector<double> intensity_data = Raster::intensity(data, W * H);
+        stbi_image_free(data);
+
+        const int n = Rtin::grid_size(W, H), tile = n - 1;
+        std::vector<float> grid((size_t)n * n);
+        Raster::parallel_bands(n, [&](int begin, int end) {
+            for (int j = begin; j < end; ++j) {
+                double v = (double)j * (H - 1) / tile;
+                int y0 = std::min((int)v, H - 1), y1 = std::min(y0 + 1, H - 1);
+                double fy = v - y0;
+                for (int i = 0; i < n; ++i) {
+                    double u = (double)i * (W - 1) / tile;
+                    int x0 = std::min((int)u, W - 1), x1 = std::min(x0 + 1, W - 1);
+                    double fx = u - x0;
+                    double top = intensity_data[(size_t)y0 * W + x0] * (1 - fx) + intensity_data[(size_t)y0 * W + x1] * fx;
+                    double bottom = intensity_data[(size_t)y1 * W + x0] * (1 - fx) + intensity_data[(size_t)y1 * W + x1] * fx;
+                    grid[(size_t)j * n + i] = (float)(base + height * (top * (1 - fy) + bottom * fy));
                 }
+            }
+        });
+        std::vector<double>().swap(intensity_data);
+
+        Rtin rtin(std::move(grid), n);
+        Rtin::Mesh surface = rtin.mesh(maxError);
+        std::cout << "[Relief] Heightfield of " << W << "x" << H << " on a " << n << "x" << n << " grid: "
+                  << surface.triangles.size() << " triangles" << std::endl;
+
+        // Grid point (i, j) is pixel (i - 0.5, n - 0.5 - j) of a tile x tile
+        // mesh raster, so the grid spans the footprint with row 0 at the back.
+        ReliefMesh mesh(width, breadth, height, base, tile, tile, 2);
+        auto add_grid_vertex = [&](int i, int j, double z) {
+            return mesh.add_vertex(mesh.to_phys_x(i - 0.5), mesh.to_phys_y(n - 0.5 - j), z);
+        };
+        std::vector<int> top_ids(surface.vertices.size());
+        for (size_t v = 0; v < surface.vertices.size(); ++v) {
+            auto [i, j] = surface.vertices[v];
+            top_ids[v] = add_grid_vertex(i, j, rtin.heights[(size_t)j * n + i]);
+        }
+        for (const auto& t : surface.triangles) {
+            const auto& a = surface.vertices[t[0]];
+            const auto& b = surface.vertices[t[1]];
+            const auto& c = surface.vertices[t[2]];
+            // Grid rows run down the image, so counterclockwise on the grid faces down.
+            long long turn = (long long)(b[0] - a[0]) * (c[1] - a[1]) - (long long)(b[1] - a[1]) * (c[0] - a[0]);
+            if (turn > 0) mesh.triangles.push_back({top_ids[t[0]], top_ids[t[2]], top_ids[t[1]]});
+            else mesh.triangles.push_back({top_ids[t[0]], top_ids[t[1]], top_ids[t[2]]});
+        }
 
-                // Triangulate directly using the 2D polygon coordinates
-                CDT cdt;
-                std::map<CDT::Vertex_handle, int> v_map;
-                for (size_t l = 0; l < face_polys.size(); ++l) {
-                    const auto& poly = face_polys[l];
-                    const auto& indices = face_loops_indices[l];
-                    std::vector<CDT::Vertex_handle> vh;
-                    for (size_t idx = 0; idx < poly.size(); ++idx) {
-                        vh.push_back(cdt.insert(poly[idx]));
-                        v_map[vh.back()] = indices[idx];
-                    }
-                    if (vh.size() >= 2) {
-                        for (size_t idx = 0; idx < vh.size(); ++idx) {
-                            cdt.insert_constraint(vh[idx], vh[(idx + 1) % vh.size()]);
-                        }
-                    }
-                }
-                CGAL::mark_domain_in_triangulation(cdt);
-                for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                    if (fit->info().in_domain) {
-                        triangles.push_back({v_map[fit->vertex(0)], v_map[fit->vertex(1)], v_map[fit->vertex(2)]});
-                    }
-                }
+        if (close) {
+            // Boundary vertices counterclockwise from the front left corner.
+            auto perimeter = [&](int i, int j) -> long long {
+                if (j == tile) return i;
+                if (i == tile) return (long long)tile + (tile - j);
+                if (j == 0) return 2LL * tile + (tile - i);
+                return 3LL * tile + j;
+            };
+            std::vector<std::pair<long long, int>> boundary;
+            for (size_t v = 0; v < surface.vertices.size(); ++v) {
+                auto [i, j] = surface.vertices[v];
+                if (i == 0 || j == 0 || i == tile || j == tile) boundary.push_back({perimeter(i, j), (int)v});
             }
+            std::sort(boundary.begin(), boundary.end());
+
+            Polygon outline;
+            for (size_t k = 0; k < boundary.size(); ++k) {
+                const auto& p = surface.vertices[boundary[k].second];
+                const auto& q = surface.vertices[boundary[(k + 1) % boundary.size()].second];
+                int p_top = top_ids[boundary[k].second], q_top = top_ids[boundary[(k + 1) % boundary.size()].second];
+                int p_bottom = add_grid_vertex(p[0], p[1], mesh.z_base), q_bottom = add_grid_vertex(q[0], q[1], mesh.z_base);
+                if (q_top != q_bottom) mesh.triangles.push_back({p_bottom, q_bottom, q_top});
+                if (p_top != p_bottom) mesh.triangles.push_back({p_bottom, q_top, p_top});
+                outline.push_back(EK::Point_2(FT(p[0] - 0.5), FT(n - 0.5 - p[1])));
+            }
+            mesh.add_cap({outline}, mesh.z_base, true);
+        }
 
-            // B. Single Bottom Cap (for the border component)
-            if (close) {
-                const auto& polys = comp_loops[border_comp_id];
-                if (!polys.empty()) {
-                    // Find the outer boundary (longest loop)
-                    size_t longest_idx = 0;
-                    size_t max_size = 0;
-                    for (size_t j = 0; j < polys.size(); ++j) {
-                        if (polys[j].size() > max_size) {
-                            max_size = polys[j].size();
-                            longest_idx = j;
-                        }
-                    }
+        vfs->write(fulfilling.with_output("$out"), P::make_shape(vfs, mesh.geometry(), {}));
+    }
 
-                    std::vector<Polygon> face_polys;
-                    Polygon outer = polys[longest_idx];
-                    if (outer.is_clockwise_oriented()) outer.reverse_orientation();
-                    face_polys.push_back(outer);
+    /**
+     * Tiled relief: the image is split into tile x tile pixel blocks and
+     * each becomes a jot/reliefTile component, so tiles are meshed, cached
+     * and distributed independently and only a block's labels and a tile's
+     * mesh are held at once. Level blocks are labeled here first so that the
+     * tiles need not decode the image again.
+     */
+    static void execute_tiled(fs::VFSNode* vfs, const fs::Selector& fulfilling, const nlohmann::json& image_identity,
+                              const std::vector<uint8_t>& img_bytes, double width, double breadth, double height, double base,
+                              int levels, double minArea, double smooth, bool close, int tile) {
+        ReliefBlocks::Source source(img_bytes);
+        const int W = source.W, H = source.H;
+        int nx = (W + tile - 1) / tile, ny = (H + tile - 1) / tile;
+        std::cout << "[Relief] Tiling image of size " << W << "x" << H << " into " << nx << "x" << ny << " tiles..." << std::endl;
+
+        ReliefBlocks::fetch_all(vfs, source, image_identity, levels, minArea, tile);
+
+        // Tiles only read cached blocks, so they are meshed concurrently.
+        std::vector<Shape> tiles((size_t)nx * ny);
+        Raster::parallel_bands(nx * ny, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                fs::Selector tile_sel = fs::Selector("jot/reliefTile", {
+                    {"$in", image_identity}, {"width", width}, {"breadth", breadth}, {"height", height}, {"base", base},
+                    {"levels", levels}, {"minArea", minArea}, {"smooth", smooth}, {"close", close},
+                    {"tile", tile}, {"x", i % nx}, {"y", i / nx}}).with_output("$out");
+                tiles[i] = vfs->read<Shape>(tile_sel);
+            }
+        }, 1);
+        vfs->write(fulfilling.with_output("$out"), Shape::group(tiles));
+    }
 
-                    for (size_t j = 0; j < polys.size(); ++j) {
-                        if (j != longest_idx) {
-                            Polygon hole = polys[j];
-                            if (hole.is_counterclockwise_oriented()) hole.reverse_orientation();
-                            face_polys.push_back(hole);
-                        }
-                    }
+    static std::vector<std::string> argument_keys() { return {"$in", "width", "breadth", "height", "base", "levels", "minArea", "smooth", "close", "tile", "maxError"}; }
 
-                    // Add vertices to unique_vertices and record their indices
-                    std::vector<std::vector<int>> face_loops_indices;
-                    for (const auto& poly : face_polys) {
-                        std::vector<int> loop_indices;
-                        for (auto it = poly.vertices_begin(); it != poly.vertices_end(); ++it) {
-                            double px = to_phys_x(CGAL::to_double(it->x()));
-                            double py = to_phys_y(CGAL::to_double(it->y()));
-                            loop_indices.push_back(add_vertex(px, py, z_base));
-                        }
-                        face_loops_indices.push_back(std::move(loop_indices));
-                    }
+    static typename P::json schema() {
+        return {
+            {"path", "jot/relief"},
+            {"inputs", {
+                {"$in", {{"type", "jot:image"}}}
+            }},
+            {"arguments", nlohmann::json::array({
+                {{"name", "width"}, {"type", "jot:number"}, {"default", 10.0}},
+                {{"name", "breadth"}, {"type", "jot:number"}, {"default", 10.0}},
+                {{"name", "height"}, {"type", "jot:number"}, {"default", 2.0}},
+                {{"name", "base"}, {"type", "jot:number"}, {"default", 1.0}},
+                {{"name", "levels"}, {"type", "jot:number"}, {"default", 16}},
+                {{"name", "minArea"}, {"type", "jot:number"}, {"default", 25.0}},
+                {{"name", "smooth"}, {"type", "jot:number"}, {"default", 0.0}},
+                {{"name", "close"}, {"type", "jot:boolean"}, {"default", true}},
+                {{"name", "tile"}, {"type", "jot:number"}, {"default", 0}, {"description", "Tile size in pixels; 0 meshes the image as one piece."}},
+                {{"name", "maxError"}, {"type", "jot:number"}, {"default", 0.0}, {"description", "Builds a continuous surface to within this height error instead of terraced levels; 0 keeps the levels."}}
+            })},
+            {"outputs", {{"$out", {{"type", "jot:shape"}}}}}
+        };
+    }
+};
 
-                    // Triangulate directly using the 2D polygon coordinates
-                    CDT cdt;
-                    std::map<CDT::Vertex_handle, int> v_map;
-                    for (size_t l = 0; l < face_polys.size(); ++l) {
-                        const auto& poly = face_polys[l];
-                        const auto& indices = face_loops_indices[l];
-                        std::vector<CDT::Vertex_handle> vh;
-                        for (size_t idx = 0; idx < poly.size(); ++idx) {
-                            vh.push_back(cdt.insert(poly[idx]));
-                            v_map[vh.back()] = indices[idx];
-                        }
-                        if (vh.size() >= 2) {
-                            for (size_t idx = 0; idx < vh.size(); ++idx) {
-                                cdt.insert_constraint(vh[idx], vh[(idx + 1) % vh.size()]);
+/**
+ * ReliefTileOp: One tile of a tiled jot/relief. The tile owns the marching
+ * cells between its pixels and those of the tiles before it, so every
+ * boundary segment and wall is built by exactly one tile. Loops crossing the
+ * tile edge are closed along it, with those points pinned through smoothing,
+ * and walls are split at every level, so tiles meet vertex for vertex.
+ */
+template <typename P = JotVfsProtocol>
+struct ReliefTileOp : P {
+    static constexpr const char* path = "jot/reliefTile";
+
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const nlohmann::json& image_identity, double width, double breadth, double height, double base, int levels, double minArea, double smooth, bool close, int tile, int tx, int ty) {
+        try {
+            using LatticePoint = ContourUtils::LatticePoint;
+            using LatticeSegment = ContourUtils::LatticeSegment;
+
+            fs::Selector img_sel = image_identity.get<fs::Selector>();
+            if (img_sel.output.empty()) img_sel = img_sel.with_output("$out");
+            std::vector<uint8_t> img_bytes = vfs->read<std::vector<uint8_t>>(img_sel);
+            if (img_bytes.empty()) throw std::runtime_error("Relief: Image data empty");
+
+            ReliefBlocks::Source source(img_bytes);
+            const int W = source.W, H = source.H;
+            if (tile <= 0) throw std::runtime_error("Relief: tile must be positive");
+            int nx = (W + tile - 1) / tile, ny = (H + tile - 1) / tile;
+            if (tx < 0 || tx >= nx || ty < 0 || ty >= ny) throw std::runtime_error("Relief: tile out of range");
+
+            // 1. Levels of pixel columns x0 - 1 .. x1 - 1 and rows y0 - 1 .. y1 - 1,
+            // reaching one further past the image's last column and row, with
+            // -1 outside the image. Each pixel is read from its own block.
+            int x0 = tx * tile, x1 = std::min(W, x0 + tile);
+            int y0 = ty * tile, y1 = std::min(H, y0 + tile);
+            int g_w = (x1 == W ? W : x1 - 1) - x0 + 2;
+            int g_h = (y1 == H ? H : y1 - 1) - y0 + 2;
+            std::vector<int> grid((size_t)g_w * g_h, -1);
+            {
+                for (int by = std::max(0, ty - 1); by <= ty; ++by) {
+                    for (int bx = std::max(0, tx - 1); bx <= tx; ++bx) {
+                        std::vector<int> block = ReliefBlocks::fetch(vfs, source, image_identity, levels, minArea, tile, bx, by);
+                        int bx0 = bx * tile, bx1 = std::min(W, bx0 + tile);
+                        int by0 = by * tile, by1 = std::min(H, by0 + tile);
+                        for (int py = std::max(by0, y0 - 1); py < std::min(by1, y0 - 1 + g_h); ++py) {
+                            for (int px = std::max(bx0, x0 - 1); px < std::min(bx1, x0 - 1 + g_w); ++px) {
+                                grid[(size_t)(py - y0 + 1) * g_w + (px - x0 + 1)] = block[(size_t)(py - by0) * (bx1 - bx0) + (px - bx0)];
                             }
                         }
                     }
-                    CGAL::mark_domain_in_triangulation(cdt);
-                    for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                        if (fit->info().in_domain) {
-                            triangles.push_back({v_map[fit->vertex(0)], v_map[fit->vertex(2)], v_map[fit->vertex(1)]}); // Oriented downwards
-                        }
-                    }
                 }
             }
 
-            // C. Vertical Walls
-            std::set<std::pair<std::pair<long long, long long>, std::pair<long long, long long>>> built_walls;
+            // 2. Marching segments of each level, closed along the tile edge:
+            // each half of an edge between two outline pixels belongs to the
+            // pixel at its end.
+            std::vector<char> present(levels, 0);
+            for (int lbl : grid) if (lbl >= 0) present[lbl] = 1;
+            std::vector<int> targets, target_of(levels, -1);
+            for (int l = 0; l < levels; ++l) {
+                if (!present[l]) continue;
+                target_of[l] = (int)targets.size();
+                targets.push_back(l);
+            }
 
-            auto to_key_point = [](double x, double y) {
-                return std::make_pair(
-                    (long long)std::round(x * 1000000),
-                    (long long)std::round(y * 1000000)
-                );
+            auto point = [&](int gx, int gy) {
+                return LatticePoint{2 * (int64_t)(gx + x0 - 1), 2 * (int64_t)(H - (gy + y0 - 1))};
+            };
+            const LatticePoint corner0 = point(0, 0), corner1 = point(g_w - 1, g_h - 1);
+            auto close_outline = [&](const std::vector<int>& labels, std::vector<std::vector<LatticeSegment>>& segments,
+                                     const std::vector<int>& index) {
+                auto half_edges = [&](int ax, int ay, int bx, int by) {
+                    int a = labels[(size_t)ay * g_w + ax], b = labels[(size_t)by * g_w + bx];
+                    LatticePoint pa = point(ax, ay), pb = point(bx, by);
+                    LatticePoint mid{(pa.x + pb.x) / 2, (pa.y + pb.y) / 2};
+                    if (a >= 0) segments[index[a]].push_back({pa, mid});
+                    if (b >= 0) segments[index[b]].push_back({mid, pb});
+                };
+                for (int gx = 0; gx < g_w - 1; ++gx) {
+                    half_edges(gx, 0, gx + 1, 0);
+                    half_edges(gx, g_h - 1, gx + 1, g_h - 1);
+                }
+                for (int gy = 0; gy < g_h - 1; ++gy) {
+                    half_edges(0, gy, 0, gy + 1);
+                    half_edges(g_w - 1, gy, g_w - 1, gy + 1);
+                }
+            };
+            auto pinned = [&](const LatticePoint& p) {
+                return p.x == corner0.x || p.x == corner1.x || p.y == corner0.y || p.y == corner1.y;
+            };
+            auto weld = [&](std::vector<std::vector<LatticeSegment>>& segments) {
+                std::vector<std::vector<ContourUtils::LatticeLoop>> loops(segments.size());
+                Raster::parallel_bands((int)segments.size(), [&](int begin, int end) {
+                    for (int i = begin; i < end; ++i) {
+                        loops[i] = ContourUtils::weld_lattice(segments[i], ContourUtils::kLatticeScale, smooth, 0.0, false, pinned);
+                    }
+                }, 16);
+                std::vector<std::vector<Polygon>> polys(segments.size());
+                for (size_t i = 0; i < segments.size(); ++i) polys[i] = ContourUtils::lattice_polygons(loops[i], ContourUtils::kLatticeScale);
+                return polys;
             };
 
-            std::set<int> unique_levels(clean_labels.begin(), clean_labels.end());
-            unique_levels.insert(-1);
-            std::vector<int> existing_levels(unique_levels.begin(), unique_levels.end());
-            int k = existing_levels.size();
+            std::vector<std::vector<LatticeSegment>> segments = ContourUtils::marching_triangles(grid, g_w, g_h, H, targets, x0, y0);
+            close_outline(grid, segments, target_of);
+            std::vector<std::vector<Polygon>> level_loops = weld(segments);
 
-            std::vector<int> level_to_idx(levels + 1, -1);
-            for (int i = 0; i < k; ++i) {
-                level_to_idx[existing_levels[i] + 1] = i;
+            // 3. Level tops, the bottom over the tile's part of the image, and walls.
+            ReliefMesh mesh(width, breadth, height, base, W, H, levels);
+            for (size_t t = 0; t < targets.size(); ++t) {
+                if (!level_loops[t].empty()) mesh.add_cap(level_loops[t], mesh.get_z(targets[t]), false);
             }
 
-            for (int y = 0; y < p_h - 1; ++y) {
-                for (int x = 0; x < p_w - 1; ++x) {
-                    int v0_lbl = padded[y*p_w+x];
-                    int v1_lbl = padded[y*p_w+(x+1)];
-                    int v2_lbl = padded[(y+1)*p_w+(x+1)];
-                    int v3_lbl = padded[(y+1)*p_w+x];
-
-                    int cell_colors[4];
-                    int num_colors = 0;
-                    auto add_unique_color = [&](int lbl) {
-                        if (lbl == border_comp_id) return;
-                        for (int j = 0; j < num_colors; ++j) {
-                            if (cell_colors[j] == lbl) return;
-                        }
-                        cell_colors[num_colors++] = lbl;
-                    };
-                    add_unique_color(v0_lbl);
-                    add_unique_color(v1_lbl);
-                    add_unique_color(v2_lbl);
-                    add_unique_color(v3_lbl);
-
-                    for (int color_idx = 0; color_idx < num_colors; ++color_idx) {
-                         int c = cell_colors[color_idx];
-
-                         FT fx(x-1), fy(H - (y-1)), h = FT(1)/2;
-                         EK::Point_2 e0(fx+h, fy);
-                         EK::Point_2 e1(fx+1, fy-h);
-                         EK::Point_2 e2(fx+h, fy-1);
-                         EK::Point_2 e3(fx, fy-h);
-                         EK::Point_2 d0(fx+h, fy-h);
-
-                        auto add_wall = [&](EK::Point_2 p1, EK::Point_2 p2, int neighbor_label, bool normal_right) {
-                            double px1 = to_phys_x(CGAL::to_double(p1.x()));
-                            double py1 = to_phys_y(CGAL::to_double(p1.y()));
-                            double px2 = to_phys_x(CGAL::to_double(p2.x()));
-                            double py2 = to_phys_y(CGAL::to_double(p2.y()));
-
-                            auto k1 = to_key_point(px1, py1);
-                            auto k2 = to_key_point(px2, py2);
-                            auto key = std::make_pair(std::min(k1, k2), std::max(k1, k2));
-                            if (built_walls.count(key)) return;
-                            built_walls.insert(key);
-
-                            int idx_start = level_to_idx[comp_levels[c] + 1];
-                            int idx_end = level_to_idx[comp_levels[neighbor_label] + 1];
-                            if (idx_start == -1 || idx_end == -1) return;
-
-                            int i_min = std::min(idx_start, idx_end);
-                            int i_max = std::max(idx_start, idx_end);
-
-                            for (int idx = i_min; idx < i_max; ++idx) {
-                                int l1 = existing_levels[idx];
-                                int l2 = existing_levels[idx + 1];
-
-                                double h1 = (l1 == -1) ? z_base : get_z(l1);
-                                double h2 = (l2 == -1) ? z_base : get_z(l2);
-
-                                if (std::abs(h1 - h2) < 1e-9) continue;
-
-                                double hz1 = std::min(h1, h2);
-                                double hz2 = std::max(h1, h2);
-
-                                int b1 = add_vertex(px1, py1, hz1);
-                                int b2 = add_vertex(px2, py2, hz1);
-                                int a1 = add_vertex(px1, py1, hz2);
-                                int a2 = add_vertex(px2, py2, hz2);
-
-                                // Correct orientation: 
-                                // normal_right assumes the component 'c' is on the 'right' of the segment (p1->p2)
-                                // If the component level is HIGHER than the current wall level segment (idx), 
-                                // the wall is an exterior face of component 'c'.
-                                bool point_right = (comp_levels[c] > l1) ? normal_right : !normal_right;
-
-                                if (point_right) {
-                                    triangles.push_back({b1, b2, a1});
-                                    triangles.push_back({a1, b2, a2});
-                                } else {
-                                    triangles.push_back({b1, a1, b2});
-                                    triangles.push_back({a1, a2, b2});
-                                }
-                            }
-                        };
-
-                        // Triangle 1: v0_lbl, v1_lbl, v3_lbl
-                        bool v0 = (v0_lbl == c);
-                        bool v1 = (v1_lbl == c);
-                        bool v3 = (v3_lbl == c);
-                        if (v0) {
-                            if (!v1 && !v3) {
-                                if (v1_lbl == v3_lbl) {
-                                    add_wall(e0, e3, v1_lbl, true);
-                                } else {
-                                    add_wall(e0, d0, v1_lbl, true);
-                                    add_wall(d0, e3, v3_lbl, true);
-                                }
-                            } else if (v1 && !v3) {
-                                add_wall(d0, e3, v3_lbl, true);
-                            } else if (v3 && !v1) {
-                                add_wall(e0, d0, v1_lbl, true);
-                            }
-                        } else {
-                            if (v1 && v3) {
-                                add_wall(e0, e3, v0_lbl, true);
-                            } else if (v1 && !v3) {
-                                add_wall(e0, d0, v0_lbl, true);
-                            } else if (v3 && !v1) {
-                                add_wall(d0, e3, v0_lbl, true);
-                            }
-                        }
-
-                        // Triangle 2: v1_lbl, v2_lbl, v3_lbl
-                        bool tv1 = (v1_lbl == c);
-                        bool tv2 = (v2_lbl == c);
-                        bool tv3 = (v3_lbl == c);
-                        if (tv1) {
-                            if (!tv2 && !tv3) {
-                                if (v2_lbl == v3_lbl) {
-                                    add_wall(e1, d0, v2_lbl, true);
-                                } else {
-                                    add_wall(e1, e2, v2_lbl, true);
-                                    add_wall(e2, d0, v3_lbl, true);
-                                }
-                            } else if (tv2 && !tv3) {
-                                add_wall(e2, d0, v3_lbl, true);
-                            } else if (tv3 && !tv2) {
-                                add_wall(e1, e2, v2_lbl, true);
-                            }
-                        } else {
-                            if (tv2 && tv3) {
-                                add_wall(e1, d0, v1_lbl, true);
-                            } else if (tv2 && !tv3) {
-                                add_wall(e1, e2, v1_lbl, true);
-                            } else if (tv3 && !tv2) {
-                                add_wall(e2, d0, v1_lbl, true);
-                            }
-                        }
-                    }
-                }
+            if (close) {
+                std::vector<int> inside(grid.size());
+                for (size_t i = 0; i < grid.size(); ++i) inside[i] = grid[i] >= 0 ? 0 : -1;
+                std::vector<std::vector<LatticeSegment>> bottom = ContourUtils::marching_triangles(inside, g_w, g_h, H, {0}, x0, y0);
+                close_outline(inside, bottom, {0});
+                std::vector<std::vector<Polygon>> bottom_loops = weld(bottom);
+                if (!bottom_loops[0].empty()) mesh.add_cap(bottom_loops[0], mesh.z_base, true);
             }
 
-            Geometry geo;
-            geo.vertices = std::move(unique_vertices);
-            geo.triangles = std::move(triangles);
+            // Split at every level, whether or not this tile holds it, so
+            // walls meeting at the tile edge are cut at the same heights.
+            std::set<int> all_levels;
+            for (int l = -1; l < levels; ++l) all_levels.insert(l);
+            mesh.set_levels(all_levels);
+            mesh.add_walls(grid, g_w, g_h, x0, y0, -1, [](int level) { return level; });
 
-            vfs->write(fulfilling.with_output("$out"), P::make_shape(vfs, geo, {}));
+            vfs->write(fulfilling.with_output("$out"), P::make_shape(vfs, mesh.geometry(), {}));
         } catch (const std::exception& e) {
-            std::cerr << "[ReliefOp] Error: " << e.what() << std::endl;
+            std::cerr << "[ReliefTileOp] Error: " << e.what() << std::endl;
             throw;
         }
     }
 
-    static std::vector<std::string> argument_keys() { return {"$in", "width", "breadth", "height", "base", "levels", "minArea", "smooth", "close"}; }
+    static std::vector<std::string> argument_keys() { return {"$in", "width", "breadth", "height", "base", "levels", "minArea", "smooth", "close", "tile", "x", "y"}; }
 
     static typename P::json schema() {
         return {
-            {"path", "jot/relief"},
+            {"path", "jot/reliefTile"},
+            {"description", "One tile of a tiled jot/relief; see its tile argument."},
             {"inputs", {
                 {"$in", {{"type", "jot:image"}}}
             }},
@@ -563,7 +811,10 @@ struct ReliefOp : P {
                 {{"name", "levels"}, {"type", "jot:number"}, {"default", 16}},
                 {{"name", "minArea"}, {"type", "jot:number"}, {"default", 25.0}},
                 {{"name", "smooth"}, {"type", "jot:number"}, {"default", 0.0}},
-                {{"name", "close"}, {"type", "jot:boolean"}, {"default", true}}
+                {{"name", "close"}, {"type", "jot:boolean"}, {"default", true}},
+                {{"name", "tile"}, {"type", "jot:number"}, {"default", 256}},
+                {{"name", "x"}, {"type", "jot:number"}, {"default", 0}},
+                {{"name", "y"}, {"type", "jot:number"}, {"default", 0}}
             })},
             {"outputs", {{"$out", {{"type", "jot:shape"}}}}}
         };
@@ -571,7 +822,8 @@ struct ReliefOp : P {
 };
 
 inline void relief_init(fs::VFSNode* vfs) {
-    Processor::register_op<ReliefOp<>, nlohmann::json, double, double, double, double, int, double, double, bool>(vfs, "jot/relief");
+    Processor::register_op<ReliefOp<>, nlohmann::json, double, double, double, double, int, double, double, bool, int, double>(vfs, "jot/relief");
+    Processor::register_op<ReliefTileOp<>, nlohmann::json, double, double, double, double, int, double, double, bool, int, int, int>(vfs, "jot/reliefTile");
 }
 
 } // namespace geo
@@ -2,6 +2,7 @@
 #include "protocols.h"
 #include "processor.h"
 #include "boolean/engine.h"
+#include "../render/contour_utils.h"
 #include <CGAL/Polygon_mesh_slicer.h>
 #include <CGAL/Polygon_2.h>
 #include <CGAL/General_polygon_set_2.h>
@@ -61,43 +62,27 @@ struct SectionOp : P {
             }
 
             size_t n = ccw_polygons.size();
-            std::vector<std::vector<size_t>> contained_by(n);
+            std::vector<int> depth;
+            std::vector<int> parent = ContourUtils::nest_polygons(ccw_polygons, &depth);
+            std::vector<boolean::Polygon_with_holes_2> pwhs(n);
             for (size_t i = 0; i < n; ++i) {
-                for (size_t j = 0; j < n; ++j) {
-                    if (i == j) continue;
-                    if (ccw_polygons[j].bounded_side(ccw_polygons[i].vertex(0)) == CGAL::ON_BOUNDED_SIDE) {
-                        contained_by[i].push_back(j);
-                    }
-                }
+                // Loops nested an even number of times are Islands (outer boundaries)
+                if (depth[i] % 2 == 0) pwhs[i] = boolean::Polygon_with_holes_2(ccw_polygons[i]);
+            }
+            for (size_t h = 0; h < n; ++h) {
+                // Holes sit directly inside their island
+                if (depth[h] % 2 == 0) continue;
+                boolean::Polygon_2 hole = ccw_polygons[h];
+                hole.reverse_orientation(); // Holes in CGAL PWH must be clockwise
+                pwhs[parent[h]].add_hole(hole);
             }
 
-            boolean::General_polygon_set_2 gps;
+            boolean::PolygonBatch islands;
             for (size_t i = 0; i < n; ++i) {
-                // Loops contained by an even number of other loops are Islands (outer boundaries)
-                if (contained_by[i].size() % 2 == 0) {
-                    boolean::Polygon_with_holes_2 pwh(ccw_polygons[i]);
-                    // Find direct holes nested inside this island
-                    for (size_t h = 0; h < n; ++h) {
-                        if (contained_by[h].size() == contained_by[i].size() + 1) {
-                            bool is_contained = false;
-                            for (size_t parent : contained_by[h]) {
-                                if (parent == i) {
-                                    is_contained = true;
-                                    break;
-                                }
-                            }
-                            if (is_contained) {
-                                boolean::Polygon_2 hole = ccw_polygons[h];
-                                hole.reverse_orientation(); // Holes in CGAL PWH must be clockwise
-                                pwh.add_hole(hole);
-                            }
-                        }
-                    }
-                    gps.join(pwh);
-                }
+                if (depth[i] % 2 == 0) islands.add(pwhs[i]);
             }
             
-            Geometry res = boolean::Engine::gps_to_geometry(gps);
+            Geometry res = boolean::Engine::gps_to_geometry(islands.to_set());
             res.apply_tf(section_tf); // Move result back to world space
             
             // Merge into res_combined
@@ -157,41 +142,25 @@ struct SectionOp : P {
                     }
 
                     size_t n = ccw_polygons.size();
-                    std::vector<std::vector<size_t>> contained_by(n);
+                    std::vector<int> depth;
+                    std::vector<int> parent = ContourUtils::nest_polygons(ccw_polygons, &depth);
+                    std::vector<boolean::Polygon_with_holes_2> pwhs(n);
                     for (size_t i = 0; i < n; ++i) {
-                        for (size_t j = 0; j < n; ++j) {
-                            if (i == j) continue;
-                            if (ccw_polygons[j].bounded_side(ccw_polygons[i].vertex(0)) == CGAL::ON_BOUNDED_SIDE) {
-                                contained_by[i].push_back(j);
-                            }
-                        }
+                        if (depth[i] % 2 == 0) pwhs[i] = boolean::Polygon_with_holes_2(ccw_polygons[i]);
+                    }
+                    for (size_t h = 0; h < n; ++h) {
+                        if (depth[h] % 2 == 0) continue;
+                        boolean::Polygon_2 hole = ccw_polygons[h];
+                        hole.reverse_orientation();
+                        pwhs[parent[h]].add_hole(hole);
                     }
 
-                    boolean::General_polygon_set_2 gps;
+                    boolean::PolygonBatch islands;
                     for (size_t i = 0; i < n; ++i) {
-                        if (contained_by[i].size() % 2 == 0) {
-                            boolean::Polygon_with_holes_2 pwh(ccw_polygons[i]);
-                            for (size_t h = 0; h < n; ++h) {
-                                if (contained_by[h].size() == contained_by[i].size() + 1) {
-                                    bool is_contained = false;
-                                    for (size_t parent : contained_by[h]) {
-                                        if (parent == i) {
-                                            is_contained = true;
-                                            break;
-                                        }
-                                    }
-                                    if (is_contained) {
-                                        boolean::Polygon_2 hole = ccw_polygons[h];
-                                        hole.reverse_orientation();
-                                        pwh.add_hole(hole);
-                                    }
-                                }
-                            }
-                            gps.join(pwh);
-                        }
+                        if (depth[i] % 2 == 0) islands.add(pwhs[i]);
                     }
                     
-                    Geometry sliced_plane_local = boolean::Engine::gps_to_geometry(gps);
+                    Geometry sliced_plane_local = boolean::Engine::gps_to_geometry(islands.to_set());
                     
                     // Map back to world-space first, then to in.tf local space
                     Matrix to_s_local = in.tf.inverse() * section_tf;
@@ -24,8 +24,17 @@ struct SimplifyOp : P {
             return;
         }
 
-        Geometry geo = vfs->read<Geometry>(in.geometry.value());
-        
+        Geometry res = simplify_geometry(vfs->read<Geometry>(in.geometry.value()), ratio, count, threshold_tau);
+        Shape out = in;
+        out.geometry = vfs->materialize<Geometry>(res);
+        vfs->write(fulfilling.with_output("$out"), out);
+    }
+
+    /**
+     * simplify_geometry: Garland-Heckbert edge collapse down to count edges,
+     * or to ratio of them, keeping borders and sharp edges fixed.
+     */
+    static Geometry simplify_geometry(const Geometry& geo, double ratio, int count = 0, double threshold_tau = 60.0/360.0) {
         typedef CGAL::Surface_mesh<IK::Point_3> InexactMesh;
         typedef boost::graph_traits<InexactMesh>::edge_descriptor edge_descriptor;
         typedef boost::graph_traits<InexactMesh>::vertex_descriptor vertex_descriptor;
@@ -104,11 +113,9 @@ struct SimplifyOp : P {
                 res.faces.push_back(face);
             }
         }
-        
-        Shape out = in;
+
         res.triangulate();
-        out.geometry = vfs->materialize<Geometry>(res);
-        vfs->write(fulfilling.with_output("$out"), out);
+        return res;
     }
 
     static std::vector<std::string> argument_keys() { return {"$in", "ratio", "count", "threshold"}; }
@@ -3,6 +3,8 @@
 #include "processor.h"
 #include "stl.h"
 #include "matrix.h"
+#include <exception>
+#include <thread>
 
 namespace jotcad {
 namespace geo {
@@ -11,31 +13,78 @@ template <typename P = JotVfsProtocol>
 struct StlOp : P {
     static constexpr const char* path = "jot/stl";
 
-    static void walk(fs::VFSNode* vfs, const Shape& shape, STLWriter& writer) {
-        Matrix current_tf = shape.tf;
-        
-        if (shape.geometry.has_value() && !shape.is_gap()) {
+    // Batches hold about this many triangles, bounding the buffers in flight.
+    static constexpr std::size_t kBatchTriangles = 1u << 18;
+
+    static void collect(const Shape& shape, std::vector<const Shape*>& out) {
+        if (shape.geometry.has_value() && !shape.is_gap()) out.push_back(&shape);
+        for (const auto& child : shape.components) {
+            collect(child, out);
+        }
+    }
+
+    /**
+     * write: Streams the shape tree into writer in walk order. Exact-precision
+     * buffers, whose faces went through the exact CDT, are fetched on this
+     * thread, where the VFS and exact geometry stay, and each batch is
+     * encoded by workers while the next is fetched.
+     */
+    static void write(fs::VFSNode* vfs, const Shape& in, STLWriter& writer) {
+        std::vector<const Shape*> shapes;
+        collect(in, shapes);
+
+        std::vector<RenderBuffer> fetching, encoding;
+        std::vector<STLWriter::Placement> placements;
+        std::size_t triangles = 0;
+        // The encoder hands its exception back through failed, and joiner
+        // joins it on every exit so that a throw here never destroys a
+        // joinable thread while it still reads encoding.
+        std::exception_ptr failed;
+        std::thread encoder;
+        struct Joiner {
+            std::thread& thread;
+            ~Joiner() { if (thread.joinable()) thread.join(); }
+        } joiner{encoder};
+        auto join = [&]() {
+            if (encoder.joinable()) encoder.join();
+            if (failed) std::rethrow_exception(failed);
+        };
+        auto dispatch = [&]() {
+            join();
+            encoding = std::move(fetching);
+            fetching.clear();
+            for (std::size_t i = 0; i < encoding.size(); ++i) placements[i].buffer = &encoding[i];
+            triangles = 0;
+            encoder = std::thread([&writer, &failed, batch = std::move(placements)]() {
+                try {
+                    writer.add_buffers(batch);
+                } catch (...) {
+                    failed = std::current_exception();
+                }
+            });
+            placements.clear();
+        };
+        for (const Shape* shape : shapes) {
             try {
-                Geometry geo = vfs->read<Geometry>(shape.geometry.value());
-                geo.apply_tf(current_tf);
-                writer.add_geometry(geo);
+                fetching.push_back(RenderBuffer::get(vfs, shape->geometry.value(), RenderBuffer::Precision::Exact));
             } catch (const std::exception& e) {
-                std::cerr << "[StlOp::walk] Error reading geometry: " << e.what() << std::endl;
+                std::cerr << "[StlOp::write] Error reading geometry: " << e.what() << std::endl;
+                continue;
             }
+            placements.push_back(STLWriter::Placement::at(shape->tf));
+            triangles += fetching.back().triangle_count();
+            if (triangles >= kBatchTriangles) dispatch();
         }
-        
-        for (const auto& child : shape.components) {
-            walk(vfs, child, writer);
-        }
+        if (!fetching.empty()) dispatch();
+        join();
     }
 
     static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const std::string& stl_path) {
         STLWriter writer;
-        walk(vfs, in, writer);
-        auto stl_bytes = writer.write_binary();
+        write(vfs, in, writer);
         
         // Output: STL bytes in the primary '$out' port
-        vfs->write(fulfilling.with_output("$out"), stl_bytes);
+        vfs->write(fulfilling.with_output("$out"), writer.finish());
     }
 
     static std::vector<std::string> argument_keys() { return {"$in", "path"}; }
@@ -62,20 +111,21 @@ struct StlImportOp : P {
     static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const fs::Selector& file) {
         fs::VFSResult file_res = vfs->read<fs::VFSResult>(file);
         
-        Geometry geo;
+        ImportMesh mesh;
         bool success = false;
         if (file_res.data.size() >= 84) {
-            success = STLReader::read_binary(file_res.data, geo);
+            success = STLReader::read_binary(file_res.data.data(), file_res.data.size(), mesh);
         }
         if (!success) {
-            std::string stl_text(file_res.data.begin(), file_res.data.end());
-            success = STLReader::read_ascii(stl_text, geo);
+            success = STLReader::read_ascii((const char*)file_res.data.data(), file_res.data.size(), mesh);
         }
 
         if (!success) {
             throw std::runtime_error("Failed to parse STL file");
         }
 
+        Geometry geo;
+        mesh.to_geometry(geo);
         Shape out = P::make_shape(vfs, geo, {{"type", "closed"}});
         vfs->write(fulfilling.with_output("$out"), out);
     }
@@ -4,9 +4,7 @@
 #include "geometry.h"
 #include "triangulation.h"
 #include "boolean/engine.h"
-#include <CGAL/AABB_tree.h>
-#include <CGAL/AABB_traits.h>
-#include <CGAL/AABB_face_graph_triangle_primitive.h>
+#include "boolean/classifier.h"
 #include <CGAL/Cartesian_converter.h>
 #include <CGAL/Polygon_mesh_processing/compute_normal.h>
 #include <CGAL/Polygon_mesh_processing/orientation.h>
@@ -25,9 +23,6 @@ struct UndercutOp : P {
     static constexpr const char* path = "jot/undercut";
 
     typedef CGAL::Surface_mesh<IK::Point_3> Mesh;
-    typedef CGAL::AABB_face_graph_triangle_primitive<Mesh> Primitive;
-    typedef CGAL::AABB_traits<IK, Primitive> Traits;
-    typedef CGAL::AABB_tree<Traits> Tree;
 
     static void collect_world_geometry_recursive(fs::VFSNode* vfs, const Shape& s, const Matrix& current_tf, Geometry& world_geo) {
         if (s.geometry.has_value()) {
@@ -59,7 +54,7 @@ struct UndercutOp : P {
         }
     }
 
-    static Shape analyze_shape_recursive(fs::VFSNode* vfs, const Shape& in, const Matrix& current_tf, double dx, double dy, double dz, double sin_alpha, double L, const Tree* tree, const Mesh* world_mesh) {
+    static Shape analyze_shape_recursive(fs::VFSNode* vfs, const Shape& in, const Matrix& current_tf, double dx, double dy, double dz, double sin_alpha, double L, const boolean::TriangleBVH* bvh) {
         Shape out = in;
         out.components.clear();
         
@@ -84,9 +79,6 @@ struct UndercutOp : P {
                 target_geo.triangles.push_back({n0, n1, n2});
             };
 
-            CGAL::Cartesian_converter<EK, IK> ek_to_ik;
-            IK::Vector_3 dir_ik(dx, dy, dz);
-
             auto process_triangle = [&](int i0, int i1, int i2, 
                                         double p0_x, double p0_y, double p0_z,
                                         double p1_x, double p1_y, double p1_z,
@@ -99,8 +91,6 @@ struct UndercutOp : P {
                 double centroid_y = CGAL::to_double(w0.y() + w1.y() + w2.y()) / 3.0;
                 double centroid_z = CGAL::to_double(w0.z() + w1.z() + w2.z()) / 3.0;
 
-                IK::Point_3 c_world_ik(centroid_x, centroid_y, centroid_z);
-
                 double ux = CGAL::to_double(w1.x() - w0.x());
                 double uy = CGAL::to_double(w1.y() - w0.y());
                 double uz = CGAL::to_double(w1.z() - w0.z());
@@ -123,30 +113,14 @@ struct UndercutOp : P {
                 double dot = nx * dx + ny * dy + nz * dz;
                 
                 bool trapped = false;
-                if (tree) {
+                if (bvh) {
                     if (std::abs(dot) > sin_alpha) {
-                        IK::Vector_3 ray_dir = (dot > 0.0) ? dir_ik : -dir_ik;
-                        IK::Ray_3 ray(c_world_ik, ray_dir);
-
-                        std::vector<typename Tree::Intersection_and_primitive_id<IK::Ray_3>::Type> intersections;
-                        tree->all_intersections(ray, std::back_inserter(intersections));
-
-                        for (const auto& inter : intersections) {
-                            IK::Point_3 pt;
-                            if (const IK::Point_3* pi = std::get_if<IK::Point_3>(&inter.first)) {
-                                pt = *pi;
-                            } else if (const IK::Segment_3* ps = std::get_if<IK::Segment_3>(&inter.first)) {
-                                pt = ps->source();
-                            } else {
-                                continue;
-                            }
-
-                            // Ignore intersections at the starting point (source triangle)
-                            if (CGAL::to_double(CGAL::squared_distance(pt, c_world_ik)) > 1e-6) {
-                                trapped = true;
-                                break;
-                            }
-                        }
+                        double sign = (dot > 0.0) ? 1.0 : -1.0;
+                        double origin[3] = {centroid_x, centroid_y, centroid_z};
+                        double ray_dir[3] = {sign * dx, sign * dy, sign * dz};
+                        // Ignore intersections at the starting point (source triangle);
+                        // the pull direction is unit length, so t is a distance.
+                        trapped = bvh->any_hit(origin, ray_dir, 1e-3);
                     }
                 }
 
@@ -223,7 +197,7 @@ struct UndercutOp : P {
 
         // Process children recursively
         for (const auto& child : in.components) {
-            out.components.push_back(analyze_shape_recursive(vfs, child, current_tf * child.tf, dx, dy, dz, sin_alpha, L, tree, world_mesh));
+            out.components.push_back(analyze_shape_recursive(vfs, child, current_tf * child.tf, dx, dy, dz, sin_alpha, L, bvh));
         }
         
         return out;
@@ -247,8 +221,7 @@ struct UndercutOp : P {
         collect_world_geometry_recursive(vfs, in, Matrix::identity(), world_geo);
         
         double L = 100.0;
-        std::unique_ptr<Tree> tree = nullptr;
-        std::unique_ptr<Mesh> world_mesh = nullptr;
+        std::unique_ptr<boolean::TriangleBVH> bvh = nullptr;
         if (!world_geo.triangles.empty()) {
             // Calculate a safe starting distance outside the bounding box
             double min_x = 0, max_x = 0, min_y = 0, max_y = 0, min_z = 0, max_z = 0;
@@ -275,15 +248,11 @@ struct UndercutOp : P {
             L = diag * 2.0;
             if (L < 100.0) L = 100.0;
 
-            world_mesh = std::make_unique<Mesh>(boolean::Engine::geometry_to_mesh_ik(world_geo));
-            if (CGAL::is_closed(*world_mesh)) {
-                CGAL::Polygon_mesh_processing::orient_to_bound_a_volume(*world_mesh);
-            }
-            tree = std::make_unique<Tree>(CGAL::faces(*world_mesh).first, CGAL::faces(*world_mesh).second, *world_mesh);
-            tree->build();
+            Mesh world_mesh = boolean::Engine::geometry_to_mesh_ik(world_geo);
+            bvh = std::make_unique<boolean::TriangleBVH>(boolean::TriangleBVH::from_mesh(world_mesh));
         }
 
-        Shape out = analyze_shape_recursive(vfs, in, Matrix::identity(), dx, dy, dz, sin_alpha, L, tree.get(), world_mesh.get());
+        Shape out = analyze_shape_recursive(vfs, in, Matrix::identity(), dx, dy, dz, sin_alpha, L, bvh.get());
         vfs->write(fulfilling.with_output("$out"), out);
     }
 
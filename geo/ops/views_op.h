@@ -0,0 +1,102 @@
+#pragma once
+#include "protocols.h"
+#include "processor.h"
+#include "render/rasterizer.h"
+#include <cmath>
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * ViewsOp: Renders many views of one shape from a single scene collection.
+ *
+ * Views are listed as [ax, ay] pairs or {"ax", "ay"} objects; with no list,
+ * `frames` views orbit the shape at the `tilt` elevation. The output is a
+ * JSON frame index, either pointing at one PNG per view or at a single
+ * sprite atlas with each frame's pixel offset. lod draws dense meshes from
+ * decimated levels sized to the frame.
+ */
+template <typename P = JotVfsProtocol>
+struct ViewsOp : P {
+    static constexpr const char* path = "jot/views";
+
+    static std::vector<Camera> cameras_for(const nlohmann::json& views, int frames, double tilt) {
+        std::vector<Camera> cameras;
+        if (views.is_array() && !views.empty()) {
+            for (const auto& v : views) {
+                if (v.is_array() && v.size() >= 2) cameras.emplace_back(v[0].get<double>(), v[1].get<double>());
+                else if (v.is_object()) cameras.emplace_back(v.value("ax", 0.0), v.value("ay", 0.0));
+            }
+            return cameras;
+        }
+        for (int i = 0; i < frames; ++i) cameras.emplace_back(tilt, 2.0 * M_PI * i / frames);
+        return cameras;
+    }
+
+    static void execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in, const nlohmann::json& views,
+                        int frames = 36, double tilt = 0.61547, int width = 256, int height = 256, bool atlas = false, int columns = 0, bool lod = false) {
+        std::vector<Camera> cameras = cameras_for(views, std::max(frames, 1), tilt);
+        std::vector<std::vector<unsigned char>> images = Rasterizer::render_views(vfs, in, cameras, width, height, lod);
+
+        nlohmann::json index = {{"width", width}, {"height", height}, {"frames", nlohmann::json::array()}};
+        if (!atlas) {
+            for (std::size_t i = 0; i < images.size(); ++i) {
+                nlohmann::json frame = {{"ax", cameras[i].ax}, {"ay", cameras[i].ay}, {"png", nullptr}};
+                if (!images[i].empty()) {
+                    frame["png"] = vfs->materialize<std::vector<uint8_t>>(Rasterizer::encode_png(images[i], width, height)).value;
+                }
+                index["frames"].push_back(frame);
+            }
+        } else {
+            int count = (int)images.size();
+            int cols = columns > 0 ? columns : std::max(1, (int)std::ceil(std::sqrt((double)count)));
+            int rows = std::max(1, (count + cols - 1) / cols);
+            int atlas_w = cols * width, atlas_h = rows * height;
+            std::vector<unsigned char> pixels((std::size_t)atlas_w * atlas_h * 4, 30);
+            for (std::size_t i = 3; i < pixels.size(); i += 4) pixels[i] = 255;
+            for (int i = 0; i < count; ++i) {
+                int x = (i % cols) * width, y = (i / cols) * height;
+                if (!images[i].empty()) {
+                    for (int row = 0; row < height; ++row) {
+                        std::copy_n(images[i].begin() + (std::size_t)row * width * 4, width * 4,
+                                    pixels.begin() + ((std::size_t)(y + row) * atlas_w + x) * 4);
+                    }
+                }
+                index["frames"].push_back({{"ax", cameras[i].ax}, {"ay", cameras[i].ay}, {"x", x}, {"y", y}});
+            }
+            index["columns"] = cols;
+            index["atlas"] = vfs->materialize<std::vector<uint8_t>>(Rasterizer::encode_png(pixels, atlas_w, atlas_h)).value;
+        }
+        vfs->write(fulfilling.with_output("$out"), index);
+    }
+
+    static std::vector<std::string> argument_keys() { return {"$in", "views", "frames", "tilt", "width", "height", "atlas", "columns", "lod"}; }
+
+    static typename P::json schema() {
+        return {
+            {"path", "jot/views"},
+            {"description", "Renders several camera views of the input shape in one pass, as separate PNGs or a sprite atlas."},
+            {"inputs", {{"$in", {{"type", "jot:shape"}}}}},
+            {"arguments", nlohmann::json::array({
+                {{"name", "views"}, {"type", "jot:any"}, {"default", nlohmann::json::array()}},
+                {{"name", "frames"}, {"type", "jot:number"}, {"default", 36}},
+                {{"name", "tilt"}, {"type", "jot:number"}, {"default", 0.61547}},
+                {{"name", "width"}, {"type", "jot:number"}, {"default", 256}},
+                {{"name", "height"}, {"type", "jot:number"}, {"default", 256}},
+                {{"name", "atlas"}, {"type", "jot:boolean"}, {"default", false}},
+                {{"name", "columns"}, {"type", "jot:number"}, {"default", 0}},
+                {{"name", "lod"}, {"type", "jot:boolean"}, {"default", false}}
+            })},
+            {"outputs", {
+                {"$out", {{"type", "any"}, {"description", "Frame index: per-view PNG CIDs, or the atlas CID and frame offsets."}}}
+            }}
+        };
+    }
+};
+
+static void views_init(fs::VFSNode* vfs) {
+    Processor::register_op<ViewsOp<>, Shape, nlohmann::json, int, double, int, int, bool, int, bool>(vfs, "jot/views");
+}
+
+} // namespace geo
+} // namespace jotcad
@@ -1,7 +1,9 @@
 #pragma once
 #include <cmath>
 #include <algorithm>
+#include <vector>
 #include "geometry.h"
+#include "matrix.h"
 
 namespace jotcad {
 namespace geo {
@@ -26,20 +28,58 @@ struct Vec3 {
     }
 };
 
+/**
+ * ViewTransform: A shape placement converted once to a double 3x4 matrix.
+ */
+struct ViewTransform {
+    double m[12];
+
+    static ViewTransform from(const Matrix& tf) {
+        ViewTransform v;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 4; ++j) v.m[i * 4 + j] = CGAL::to_double(tf.t.cartesian(i, j));
+        return v;
+    }
+};
+
 struct Camera {
     double ax, ay; // Rotation angles
+    double cos_ax, sin_ax, cos_ay, sin_ay;
 
-    Camera(double ax = 0.0, double ay = 0.0) : ax(ax), ay(ay) {}
+    Camera(double ax = 0.0, double ay = 0.0)
+        : ax(ax), ay(ay), cos_ax(std::cos(ax)), sin_ax(std::sin(ax)), cos_ay(std::cos(ay)), sin_ay(std::sin(ay)) {}
 
-    Vec3 project(const Vertex& v) const {
-        double x = CGAL::to_double(v.x), y = CGAL::to_double(v.y), z = CGAL::to_double(v.z);
+    Vec3 rotate(double x, double y, double z) const {
         // Standard rotation matrix application
-        double x1 = x * std::cos(ay) + z * std::sin(ay);
-        double z1 = -x * std::sin(ay) + z * std::cos(ay);
-        double y2 = y * std::cos(ax) - z1 * std::sin(ax);
-        double z2 = y * std::sin(ax) + z1 * std::cos(ax);
+        double x1 = x * cos_ay + z * sin_ay;
+        double z1 = -x * sin_ay + z * cos_ay;
+        double y2 = y * cos_ax - z1 * sin_ax;
+        double z2 = y * sin_ax + z1 * cos_ax;
         return Vec3{x1, y2, z2};
     }
+
+    Vec3 project(const Vertex& v) const {
+        return rotate(CGAL::to_double(v.x), CGAL::to_double(v.y), CGAL::to_double(v.z));
+    }
+
+    /**
+     * project_batch: Places and projects packed xyz coordinates in one pass.
+     * The placement is applied before the rotation rather than folded into it,
+     * so identity placements reproduce project() bit for bit.
+     */
+    template <typename T>
+    void project_batch(const ViewTransform& view, const std::vector<T>& xyz, std::vector<Vec3>& out) const {
+        const double* m = view.m;
+        std::size_t n = xyz.size() / 3;
+        out.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            double x = (double)xyz[i * 3], y = (double)xyz[i * 3 + 1], z = (double)xyz[i * 3 + 2];
+            double wx = m[0] * x + m[1] * y + m[2] * z + m[3];
+            double wy = m[4] * x + m[5] * y + m[6] * z + m[7];
+            double wz = m[8] * x + m[9] * y + m[10] * z + m[11];
+            out[i] = rotate(wx, wy, wz);
+        }
+    }
 };
 
 } // namespace geo
@@ -1,13 +1,17 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <cmath>
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <list>
 #include <chrono>
 #include <iostream>
 #include <CGAL/Polygon_2.h>
 #include "geometry.h"
+#include "../algorithms/raster.h"
 
 namespace jotcad {
 namespace geo {
@@ -21,73 +25,154 @@ struct FaceGroup {
 
 class ContourUtils {
 public:
+    /**
+     * group_polygons: Pairs each outer loop with the holes directly inside
+     * it. Loops enclosed by an even number of others are outers; the rest
+     * are holes of the loop that immediately encloses them.
+     */
     static std::vector<FaceGroup> group_polygons(const std::vector<Polygon>& polygons) {
         if (polygons.empty()) return {};
         auto t_start = std::chrono::steady_clock::now();
-        
-        auto get_inside_point = [](const Polygon& poly) {
-            if (poly.size() < 3) return poly[0];
-            size_t min_idx = 0;
-            auto min_x = poly[0].x();
-            for (size_t v = 1; v < poly.size(); ++v) {
-                if (poly[v].x() < min_x) {
-                    min_x = poly[v].x();
-                    min_idx = v;
-                }
-            }
-            size_t prev_idx = (min_idx + poly.size() - 1) % poly.size();
-            size_t next_idx = (min_idx + 1) % poly.size();
-            return EK::Point_2(
-                (poly[min_idx].x() * 2 + poly[prev_idx].x() + poly[next_idx].x()) / 4,
-                (poly[min_idx].y() * 2 + poly[prev_idx].y() + poly[next_idx].y()) / 4
-            );
-        };
 
-        std::vector<bool> is_hole(polygons.size(), false);
-        std::vector<CGAL::Bbox_2> bboxes;
-        for (const auto& p : polygons) bboxes.push_back(p.bbox());
+        std::vector<int> depth;
+        std::vector<int> parent = nest_polygons(polygons, &depth);
 
+        std::vector<FaceGroup> groups;
+        std::vector<int> group_of(polygons.size(), -1);
         for (size_t i = 0; i < polygons.size(); ++i) {
-            int parent_count = 0;
-            auto test_p = get_inside_point(polygons[i]);
-            for (size_t j = 0; j < polygons.size(); ++j) {
-                if (i == j) continue;
-                // BBox Pruning: skip expensive check if point is outside the bounding box
-                if (test_p.x() < bboxes[j].xmin() || test_p.x() > bboxes[j].xmax() ||
-                    test_p.y() < bboxes[j].ymin() || test_p.y() > bboxes[j].ymax()) continue;
-
-                if (polygons[j].bounded_side(test_p) == CGAL::ON_BOUNDED_SIDE) parent_count++;
+            if (depth[i] % 2 == 0) {
+                group_of[i] = (int)groups.size();
+                groups.push_back({i, {}});
             }
-            if (parent_count % 2 != 0) is_hole[i] = true;
-            if (i > 0 && i % 1000 == 0) std::cout << "      - group progress: " << (i * 100 / polygons.size()) << "%" << std::endl;
         }
-
-        std::vector<FaceGroup> groups;
         for (size_t i = 0; i < polygons.size(); ++i) {
-            if (!is_hole[i]) groups.push_back({i, {}});
+            if (depth[i] % 2 != 0) groups[group_of[parent[i]]].holes.push_back(i);
         }
+        auto t_end = std::chrono::steady_clock::now();
+        std::cout << "    [Group] Polys=" << polygons.size() << ", Time=" << std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count() << "ms" << std::endl;
+        return groups;
+    }
 
-        for (size_t i = 0; i < polygons.size(); ++i) {
-            if (is_hole[i]) {
-                int best_parent = -1;
-                auto test_p = get_inside_point(polygons[i]);
-                for (size_t g = 0; g < groups.size(); ++g) {
-                    size_t outer_idx = groups[g].outer;
-                    if (test_p.x() < bboxes[outer_idx].xmin() || test_p.x() > bboxes[outer_idx].xmax() ||
-                        test_p.y() < bboxes[outer_idx].ymin() || test_p.y() > bboxes[outer_idx].ymax()) continue;
-
-                    if (polygons[outer_idx].bounded_side(test_p) == CGAL::ON_BOUNDED_SIDE) {
-                        if (best_parent == -1 || polygons[groups[best_parent].outer].bounded_side(get_inside_point(polygons[groups[g].outer])) == CGAL::ON_BOUNDED_SIDE) {
-                            best_parent = (int)g;
-                        }
+    /**
+     * nest_polygons: Containment tree of non-crossing loops. Returns the
+     * innermost loop enclosing each loop, or -1; depth, when given, receives
+     * how many loops enclose each.
+     *
+     * Each loop's first vertex is located in a bounding-box tree, and the
+     * larger loops whose boxes hold it are tried smallest first, so the
+     * first hit is the parent. Candidates are tested in parallel with
+     * doubles; a test too close to call, such as a vertex on another loop,
+     * is settled afterwards by exact bounded_side on the other vertices.
+     */
+    static std::vector<int> nest_polygons(const std::vector<Polygon>& polygons, std::vector<int>* depth = nullptr) {
+        const int n = (int)polygons.size();
+        std::vector<NestLoop> loops(n);
+        std::vector<BoxTree::Box> boxes(n);
+        for (int i = 0; i < n; ++i) {
+            NestLoop& loop = loops[i];
+            const Polygon& poly = polygons[i];
+            loop.xy.reserve(poly.size() * 2);
+            for (auto it = poly.vertices_begin(); it != poly.vertices_end(); ++it) {
+                loop.xy.push_back(approximate(it->x(), loop.tol));
+                loop.xy.push_back(approximate(it->y(), loop.tol));
+            }
+            CGAL::Bbox_2 bb = poly.bbox();
+            boxes[i] = {bb.xmin(), bb.ymin(), bb.xmax(), bb.ymax()};
+            double area = 0;
+            for (size_t k = 0, m = poly.size() - 1; k < poly.size(); m = k++) {
+                area += loop.xy[2 * m] * loop.xy[2 * k + 1] - loop.xy[2 * k] * loop.xy[2 * m + 1];
+            }
+            loop.area = std::abs(area) / 2;
+        }
+        BoxTree tree(boxes);
+
+        // A container is larger, with index breaking ties, which also keeps
+        // crossing input from forming cycles.
+        auto larger = [&](int a, int b) {
+            return loops[a].area > loops[b].area || (loops[a].area == loops[b].area && a > b);
+        };
+        auto candidates = [&](int i, std::vector<int>& out) {
+            out.clear();
+            tree.query(loops[i].xy[0], loops[i].xy[1], loops[i].tol, out);
+            out.erase(std::remove_if(out.begin(), out.end(), [&](int j) { return !larger(j, i); }), out.end());
+            std::sort(out.begin(), out.end(), [&](int a, int b) { return larger(b, a); });
+        };
+
+        // parent[i] stays -2 when a double test could not decide.
+        std::vector<int> parent(n, -1);
+        Raster::parallel_bands(n, [&](int begin, int end) {
+            std::vector<int> found;
+            for (int i = begin; i < end; ++i) {
+                candidates(i, found);
+                for (int j : found) {
+                    int side = approx_inside(loops[j], loops[i].xy[0], loops[i].xy[1], loops[i].tol);
+                    if (side == 0) continue;
+                    parent[i] = side > 0 ? j : -2;
+                    break;
+                }
+            }
+        }, 256);
+
+        std::vector<int> found;
+        for (int i = 0; i < n; ++i) {
+            if (parent[i] != -2) continue;
+            parent[i] = -1;
+            candidates(i, found);
+            for (int j : found) {
+                int side = -1;
+                for (size_t k = 0; k < polygons[i].size() && side < 0; ++k) {
+                    side = approx_inside(loops[j], loops[i].xy[2 * k], loops[i].xy[2 * k + 1], loops[i].tol);
+                    if (side < 0) {
+                        CGAL::Bounded_side exact = polygons[j].bounded_side(polygons[i][k]);
+                        if (exact != CGAL::ON_BOUNDARY) side = exact == CGAL::ON_BOUNDED_SIDE ? 1 : 0;
                     }
                 }
-                if (best_parent != -1) groups[best_parent].holes.push_back(i);
+                if (side > 0) {
+                    parent[i] = j;
+                    break;
+                }
             }
         }
-        auto t_end = std::chrono::steady_clock::now();
-        std::cout << "    [Group] Polys=" << polygons.size() << ", Time=" << std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count() << "ms" << std::endl;
-        return groups;
+
+        if (depth) {
+            depth->assign(n, -1);
+            std::vector<int> chain;
+            for (int i = 0; i < n; ++i) {
+                int k = i;
+                while (k >= 0 && (*depth)[k] < 0) {
+                    chain.push_back(k);
+                    k = parent[k];
+                }
+                int d = k >= 0 ? (*depth)[k] : -1;
+                while (!chain.empty()) {
+                    (*depth)[chain.back()] = ++d;
+                    chain.pop_back();
+                }
+            }
+        }
+        return parent;
+    }
+
+    /**
+     * outer_loop: Index of the loop enclosing the most area, which among the
+     * loops bounding one connected region is its outer boundary.
+     */
+    static size_t outer_loop(const std::vector<Polygon>& polys) {
+        size_t best = 0;
+        double best_area = -1;
+        for (size_t j = 0; j < polys.size(); ++j) {
+            double area = 0;
+            const Polygon& poly = polys[j];
+            for (size_t k = 0, m = poly.size() - 1; k < poly.size(); m = k++) {
+                area += CGAL::to_double(poly[m].x()) * CGAL::to_double(poly[k].y()) -
+                        CGAL::to_double(poly[k].x()) * CGAL::to_double(poly[m].y());
+            }
+            if (std::abs(area) > best_area) {
+                best_area = std::abs(area);
+                best = j;
+            }
+        }
+        return best;
     }
 
     struct ColorRGB { uint8_t r, g, b; };
@@ -113,245 +198,336 @@ public:
         return {0,0,0};
     }
     
-    struct PointKey { 
-        long long x, y; 
-        bool operator<(const PointKey& o) const { if (x != o.x) return x < o.x; return y < o.y; }
-        bool operator==(const PointKey& o) const { return x == o.x && y == o.y; }
-        bool operator!=(const PointKey& o) const { return !(*this == o); }
+    /**
+     * Lattice contours: marching triangles put every contour vertex on a
+     * half-pixel grid, so contours are traced and welded in integer lattice
+     * units (kLatticeScale per pixel) and only become exact FT points in the
+     * finished polygons.
+     */
+    static constexpr double kLatticeScale = 2.0;
+
+    struct LatticePoint {
+        int64_t x, y;
+        bool operator==(const LatticePoint& o) const { return x == o.x && y == o.y; }
+        bool operator!=(const LatticePoint& o) const { return !(*this == o); }
     };
+    struct LatticeSegment { LatticePoint a, b; };
+    typedef std::vector<LatticePoint> LatticeLoop;
+
+    /**
+     * trace_components: Boundary loops of each target label of a padded
+     * label image (see marching_triangles), welded and simplified by
+     * weld_lattice. Labels are traced and welded in parallel.
+     */
+    static std::vector<std::vector<Polygon>> trace_components(const std::vector<int>& padded, int p_w, int p_h, int H,
+                                                              const std::vector<int>& targets, double tolerance,
+                                                              double min_area, bool prune_collinear = true) {
+        auto t_start = std::chrono::steady_clock::now();
+        std::vector<std::vector<LatticeSegment>> segments = marching_triangles(padded, p_w, p_h, H, targets);
+        std::vector<std::vector<LatticeLoop>> loops(targets.size());
+        Raster::parallel_bands((int)targets.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                loops[i] = weld_lattice(segments[i], kLatticeScale, tolerance, min_area, prune_collinear);
+                std::vector<LatticeSegment>().swap(segments[i]);
+            }
+        }, 16);
+        std::vector<std::vector<Polygon>> result(targets.size());
+        size_t count = 0;
+        for (size_t i = 0; i < targets.size(); ++i) {
+            result[i] = lattice_polygons(loops[i], kLatticeScale);
+            count += result[i].size();
+        }
+        auto t_end = std::chrono::steady_clock::now();
+        std::cout << "    [Weld] Labels=" << targets.size() << ", Polys=" << count << ", Total=" << std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count() << "ms" << std::endl;
+        return result;
+    }
 
+    /**
+     * weld_segments: Joins loose segments into closed loops, matching
+     * endpoints to 1e-6, then simplifies them as weld_lattice does. The
+     * polygons keep the input's exact points: each lattice point maps back
+     * to the first endpoint that landed on it.
+     */
     static std::vector<Polygon> weld_segments(const std::vector<std::pair<EK::Point_2, EK::Point_2>>& segments, double tolerance = 0.5, double min_area = 16.0, bool prune_collinear = true) {
         if (segments.empty()) return {};
-        auto t_start = std::chrono::steady_clock::now();
-
-        auto to_key = [](const EK::Point_2& v) { 
-            return PointKey{ (long long)std::round(CGAL::to_double(v.x()) * 1000000), 
-                             (long long)std::round(CGAL::to_double(v.y()) * 1000000) }; 
-        };
-
-        struct TrackedSegment {
-            EK::Point_2 p1;
-            EK::Point_2 p2;
-            bool used = false;
+        const double scale = 1000000;
+        std::map<std::pair<int64_t, int64_t>, EK::Point_2> exact;
+        auto to_lattice = [&](const EK::Point_2& v) {
+            LatticePoint p{ (int64_t)std::round(CGAL::to_double(v.x()) * scale),
+                            (int64_t)std::round(CGAL::to_double(v.y()) * scale) };
+            exact.emplace(std::make_pair(p.x, p.y), v);
+            return p;
         };
+        std::vector<LatticeSegment> lattice;
+        lattice.reserve(segments.size());
+        for (const auto& seg : segments) lattice.push_back({to_lattice(seg.first), to_lattice(seg.second)});
 
-        std::vector<TrackedSegment> track_segs;
-        track_segs.reserve(segments.size());
-        for (const auto& seg : segments) {
-            track_segs.push_back({seg.first, seg.second, false});
-        }
-
-        std::map<PointKey, std::vector<size_t>> adj;
-        for (size_t i = 0; i < track_segs.size(); ++i) {
-            adj[to_key(track_segs[i].p1)].push_back(i);
-            adj[to_key(track_segs[i].p2)].push_back(i);
-        }
-
-        auto t_adj = std::chrono::steady_clock::now();
         std::vector<Polygon> polygons;
+        for (const LatticeLoop& loop : weld_lattice(lattice, scale, tolerance, min_area, prune_collinear)) {
+            Polygon poly;
+            for (const LatticePoint& p : loop) poly.push_back(exact.at(std::make_pair(p.x, p.y)));
+            if (poly.is_simple()) polygons.push_back(std::move(poly));
+        }
+        return polygons;
+    }
 
-        for (size_t i = 0; i < track_segs.size(); ++i) {
-            if (track_segs[i].used) continue;
-
-            std::vector<EK::Point_2> loop;
-            std::map<PointKey, size_t> loop_indices;
-
-            track_segs[i].used = true;
-            EK::Point_2 start_pt = track_segs[i].p1;
-            EK::Point_2 curr_pt = track_segs[i].p2;
-            
-            loop.push_back(start_pt);
-            loop_indices[to_key(start_pt)] = 0;
-
-            loop.push_back(curr_pt);
-            loop_indices[to_key(curr_pt)] = 1;
-
-            PointKey start_key = to_key(start_pt);
-
-            while (true) {
-                PointKey curr_key = to_key(curr_pt);
-                if (curr_key == start_key) {
-                    break;
-                }
+    /**
+     * marching_triangles: Boundary segments of each target label, in
+     * lattice units. Each 2x2 cell of the padded image is split into two
+     * triangles and every label crossing a triangle gets the edges between
+     * its corners and the others (see cell_segments), with y flipped so image
+     * row H is y = 0. A window cut from a larger padded image passes its
+     * offset (ox, oy) there. Segments come out in row order whatever the
+     * thread count.
+     */
+    static std::vector<std::vector<LatticeSegment>> marching_triangles(
+        const std::vector<int>& padded, int p_w, int p_h, int H, const std::vector<int>& targets, int ox = 0, int oy = 0) {
+        std::vector<std::vector<LatticeSegment>> result(targets.size());
+        if (targets.empty() || p_w < 2 || p_h < 2) return result;
+
+        // Dense target lookup over the label range.
+        auto [lo, hi] = std::minmax_element(targets.begin(), targets.end());
+        const int min_label = *lo;
+        std::vector<int> label_to_idx((size_t)(*hi - min_label) + 1, -1);
+        for (size_t i = 0; i < targets.size(); ++i) label_to_idx[targets[i] - min_label] = (int)i;
+        auto target_of = [&](int lbl) {
+            return (lbl < min_label || lbl - min_label >= (int)label_to_idx.size()) ? -1 : label_to_idx[lbl - min_label];
+        };
 
-                bool found = false;
-                const auto& neighbors = adj[curr_key];
-                for (size_t seg_idx : neighbors) {
-                    if (!track_segs[seg_idx].used) {
-                        track_segs[seg_idx].used = true;
-                        EK::Point_2 next_pt = (to_key(track_segs[seg_idx].p1) == curr_key) ? track_segs[seg_idx].p2 : track_segs[seg_idx].p1;
-                        PointKey next_key = to_key(next_pt);
-                        
-                        if (next_key != start_key) {
-                            auto it = loop_indices.find(next_key);
-                            if (it != loop_indices.end()) {
-                                size_t cycle_start_idx = it->second;
-                                std::vector<EK::Point_2> sub_cycle;
-                                sub_cycle.reserve(loop.size() - cycle_start_idx);
-                                for (size_t k = cycle_start_idx; k < loop.size(); ++k) {
-                                    sub_cycle.push_back(loop[k]);
-                                    loop_indices.erase(to_key(loop[k]));
-                                }
-                                
-                                if (sub_cycle.size() >= 3) {
-                                    std::vector<EK::Point_2> simplified = simplify_douglas_peucker(sub_cycle, tolerance);
-                                    if (prune_collinear) {
-                                        simplified = remove_collinear(simplified);
-                                    }
-                                    if (simplified.size() >= 3) {
-                                        Polygon poly;
-                                        for (const auto& p : simplified) poly.push_back(p);
-                                        if (poly.is_simple() && std::abs(CGAL::to_double(poly.area())) > min_area) {
-                                            polygons.push_back(poly);
-                                        }
-                                    }
-                                }
-                                loop.resize(cycle_start_idx);
-                            }
+        // Workers split the targets and each scans the whole image, so every
+        // target's segments are appended by one thread in row order.
+        Raster::parallel_bands((int)targets.size(), [&](int t0, int t1) {
+            for (int y = 0; y < p_h - 1; ++y) {
+                for (int x = 0; x < p_w - 1; ++x) {
+                    int v0_lbl = padded[y*p_w+x];
+                    int v1_lbl = padded[y*p_w+(x+1)];
+                    int v2_lbl = padded[(y+1)*p_w+(x+1)];
+                    int v3_lbl = padded[(y+1)*p_w+x];
+
+                    if (v0_lbl == v1_lbl && v1_lbl == v2_lbl && v2_lbl == v3_lbl) continue;
+
+                    int active_colors[4];
+                    int active_count = 0;
+                    auto add_target = [&](int lbl) {
+                        int t = target_of(lbl);
+                        if (t < t0 || t >= t1) return;
+                        for (int i = 0; i < active_count; ++i) {
+                            if (active_colors[i] == lbl) return;
                         }
-
-                        curr_pt = next_pt;
-                        loop.push_back(curr_pt);
-                        loop_indices[to_key(curr_pt)] = loop.size() - 1;
-                        found = true;
-                        break;
+                        active_colors[active_count++] = lbl;
+                    };
+                    add_target(v0_lbl);
+                    add_target(v1_lbl);
+                    add_target(v2_lbl);
+                    add_target(v3_lbl);
+
+                    if (active_count == 0) continue;
+
+                    int64_t fx = 2 * (int64_t)(x + ox - 1), fy = 2 * (int64_t)(H - (y + oy - 1));
+                    for (int idx = 0; idx < active_count; ++idx) {
+                        auto& segments = result[target_of(active_colors[idx])];
+                        cell_segments(fx, fy, v0_lbl, v1_lbl, v2_lbl, v3_lbl, active_colors[idx],
+                                      [&](LatticePoint a, LatticePoint b, int) { segments.push_back({a, b}); });
                     }
                 }
-                if (!found) break;
             }
+        }, 1);
+        return result;
+    }
 
-            if (loop.size() >= 3) {
-                if (to_key(loop.back()) == start_key) {
-                    loop.pop_back();
-                }
-                if (loop.size() >= 3) {
-                    std::vector<EK::Point_2> simplified = simplify_douglas_peucker(loop, tolerance);
-                    if (prune_collinear) {
-                        simplified = remove_collinear(simplified);
-                    }
-                    if (simplified.size() >= 3) {
-                        Polygon poly;
-                        for (const auto& p : simplified) poly.push_back(p);
-                        if (poly.is_simple() && std::abs(CGAL::to_double(poly.area())) > min_area) {
-                            polygons.push_back(poly);
-                        }
-                    }
-                }
-            }
+    /**
+     * cell_segments: The boundary of label c inside one cell, whose corner
+     * labels run v0 (top left, at lattice point (fx, fy)), v1, v2, v3
+     * clockwise. Each segment is passed to emit(a, b, neighbor) along with
+     * the label on its far side.
+     */
+    template <typename Emit>
+    static void cell_segments(int64_t fx, int64_t fy, int v0_lbl, int v1_lbl, int v2_lbl, int v3_lbl, int c, Emit&& emit) {
+        // Edge midpoints and the cell center, in half pixels.
+        LatticePoint e0{fx + 1, fy};
+        LatticePoint e1{fx + 2, fy - 1};
+        LatticePoint e2{fx + 1, fy - 2};
+        LatticePoint e3{fx, fy - 1};
+        LatticePoint d0{fx + 1, fy - 1};
+
+        // Triangle 1: v0_lbl, v1_lbl, v3_lbl
+        bool v0 = (v0_lbl == c);
+        bool v1 = (v1_lbl == c);
+        bool v3 = (v3_lbl == c);
+        if (v0) {
+            if (!v1 && !v3) {
+                if (v1_lbl == v3_lbl) emit(e0, e3, v1_lbl);
+                else { emit(e0, d0, v1_lbl); emit(d0, e3, v3_lbl); }
+            } else if (v1 && !v3) emit(d0, e3, v3_lbl);
+            else if (v3 && !v1) emit(e0, d0, v1_lbl);
+        } else {
+            if (v1 && v3) emit(e0, e3, v0_lbl);
+            else if (v1 && !v3) emit(e0, d0, v0_lbl);
+            else if (v3 && !v1) emit(d0, e3, v0_lbl);
         }
 
-        auto t_end = std::chrono::steady_clock::now();
-        std::cout << "    [Weld] Segs=" << segments.size() << ", Polys=" << polygons.size() << ", Total=" << std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count() << "ms" << std::endl;
-        
-        return polygons;
+        // Triangle 2: v1_lbl, v2_lbl, v3_lbl
+        bool tv1 = (v1_lbl == c);
+        bool tv2 = (v2_lbl == c);
+        bool tv3 = (v3_lbl == c);
+        if (tv1) {
+            if (!tv2 && !tv3) {
+                if (v2_lbl == v3_lbl) emit(e1, d0, v2_lbl);
+                else { emit(e1, e2, v2_lbl); emit(e2, d0, v3_lbl); }
+            } else if (tv2 && !tv3) emit(e2, d0, v3_lbl);
+            else if (tv3 && !tv2) emit(e1, e2, v2_lbl);
+        } else {
+            if (tv2 && tv3) emit(e1, d0, v1_lbl);
+            else if (tv2 && !tv3) emit(e1, e2, v1_lbl);
+            else if (tv3 && !tv2) emit(e2, d0, v1_lbl);
+        }
     }
 
-    static std::vector<std::vector<std::pair<EK::Point_2, EK::Point_2>>> generate_marching_triangles_segments(
-        const std::vector<int>& padded, int p_w, int p_h, int H, const std::vector<int>& targets) {
-        // Build active target lookup
-        std::map<int, int> label_to_idx;
-        for (size_t i = 0; i < targets.size(); ++i) {
-            label_to_idx[targets[i]] = i;
+    /**
+     * weld_lattice: Chains segments into closed loops by shared endpoints,
+     * taking each point's unused segments in input order. A walk that
+     * revisits a point splits off the sub-cycle as its own loop. Loops are
+     * simplified with Douglas-Peucker to tolerance, optionally stripped of
+     * collinear points, and dropped at or under min_area; both are in the
+     * units of scale lattice steps. Points for which pinned holds are kept
+     * through both, so loops cut at a tile edge still meet the next tile's.
+     * Uses no CGAL types, so it is safe to run on worker threads.
+     */
+    static std::vector<LatticeLoop> weld_lattice(const std::vector<LatticeSegment>& segments, double scale,
+                                                 double tolerance, double min_area, bool prune_collinear = true,
+                                                 const std::function<bool(const LatticePoint&)>& pinned = nullptr) {
+        std::vector<LatticeLoop> loops;
+        if (segments.empty()) return loops;
+
+        // Endpoint ids from an open-addressing table, then the segments at
+        // each point in input order (CSR).
+        const size_t m = segments.size();
+        size_t capacity = 16;
+        while (capacity < m * 4) capacity <<= 1;
+        std::vector<int> slots(capacity, -1);
+        std::vector<LatticePoint> points;
+        points.reserve(m + 1);
+        auto point_id = [&](const LatticePoint& p) {
+            uint64_t h = (uint64_t)p.x * 0x9E3779B97F4A7C15ull ^ (uint64_t)p.y * 0xC2B2AE3D27D4EB4Full;
+            size_t slot = (size_t)(h ^ (h >> 29)) & (capacity - 1);
+            while (slots[slot] >= 0 && points[slots[slot]] != p) slot = (slot + 1) & (capacity - 1);
+            if (slots[slot] < 0) {
+                slots[slot] = (int)points.size();
+                points.push_back(p);
+            }
+            return slots[slot];
+        };
+        std::vector<int> ends(m * 2);
+        for (size_t i = 0; i < m; ++i) {
+            ends[2 * i] = point_id(segments[i].a);
+            ends[2 * i + 1] = point_id(segments[i].b);
+        }
+        const size_t n = points.size();
+        std::vector<int> offsets(n + 1, 0), incident(m * 2);
+        for (int e : ends) offsets[e + 1]++;
+        for (size_t k = 0; k < n; ++k) offsets[k + 1] += offsets[k];
+        {
+            std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < m * 2; ++i) incident[cursor[ends[i]]++] = (int)(i / 2);
         }
 
-        std::vector<std::vector<std::pair<EK::Point_2, EK::Point_2>>> result(targets.size());
-
-        for (int y = 0; y < p_h - 1; ++y) {
-            for (int x = 0; x < p_w - 1; ++x) {
-                int v0_lbl = padded[y*p_w+x];
-                int v1_lbl = padded[y*p_w+(x+1)];
-                int v2_lbl = padded[(y+1)*p_w+(x+1)];
-                int v3_lbl = padded[(y+1)*p_w+x];
-
-                if (v0_lbl == v1_lbl && v1_lbl == v2_lbl && v2_lbl == v3_lbl) continue;
-
-                int active_colors[4];
-                int active_count = 0;
-                auto add_target = [&](int lbl) {
-                    auto it = label_to_idx.find(lbl);
-                    if (it == label_to_idx.end()) return;
-                    for (int i = 0; i < active_count; ++i) {
-                        if (active_colors[i] == lbl) return;
-                    }
-                    active_colors[active_count++] = lbl;
-                };
-                add_target(v0_lbl);
-                add_target(v1_lbl);
-                add_target(v2_lbl);
-                add_target(v3_lbl);
-
-                if (active_count == 0) continue;
-
-                FT fx(x-1), fy(H - (y-1)), h = FT(1)/2;
-                EK::Point_2 e0(fx+h, fy);
-                EK::Point_2 e1(fx+1, fy-h);
-                EK::Point_2 e2(fx+h, fy-1);
-                EK::Point_2 e3(fx, fy-h);
-                EK::Point_2 d0(fx+h, fy-h);
-
-                for (int idx = 0; idx < active_count; ++idx) {
-                    int c = active_colors[idx];
-                    int target_idx = label_to_idx[c];
-                    auto& segments = result[target_idx];
-
-                    // Triangle 1: v0_lbl, v1_lbl, v3_lbl
-                    bool v0 = (v0_lbl == c);
-                    bool v1 = (v1_lbl == c);
-                    bool v3 = (v3_lbl == c);
-                    if (v0) {
-                        if (!v1 && !v3) {
-                            if (v1_lbl == v3_lbl) segments.push_back({e0, e3});
-                            else { segments.push_back({e0, d0}); segments.push_back({d0, e3}); }
-                        } else if (v1 && !v3) segments.push_back({d0, e3});
-                        else if (v3 && !v1) segments.push_back({e0, d0});
-                    } else {
-                        if (v1 && v3) segments.push_back({e0, e3});
-                        else if (v1 && !v3) segments.push_back({e0, d0});
-                        else if (v3 && !v1) segments.push_back({d0, e3});
-                    }
+        auto finish = [&](const std::vector<int>& ids) {
+            if (ids.size() < 3) return;
+            LatticeLoop pts;
+            pts.reserve(ids.size());
+            for (int id : ids) pts.push_back(points[id]);
+            LatticeLoop simplified = simplify_douglas_peucker(pts, tolerance * scale, pinned);
+            if (prune_collinear) simplified = remove_collinear(simplified, pinned);
+            if (simplified.size() < 3) return;
+            __int128 twice_area = 0;
+            for (size_t k = 0, j = simplified.size() - 1; k < simplified.size(); j = k++) {
+                twice_area += (__int128)simplified[j].x * simplified[k].y - (__int128)simplified[k].x * simplified[j].y;
+            }
+            double area = std::abs((double)twice_area) / (2 * scale * scale);
+            if (area > min_area) loops.push_back(std::move(simplified));
+        };
 
-                    // Triangle 2: v1_lbl, v2_lbl, v3_lbl
-                    bool tv1 = (v1_lbl == c);
-                    bool tv2 = (v2_lbl == c);
-                    bool tv3 = (v3_lbl == c);
-                    if (tv1) {
-                        if (!tv2 && !tv3) {
-                            if (v2_lbl == v3_lbl) segments.push_back({e1, d0});
-                            else { segments.push_back({e1, e2}); segments.push_back({e2, d0}); }
-                        } else if (tv2 && !tv3) segments.push_back({e2, d0});
-                        else if (tv3 && !tv2) segments.push_back({e1, e2});
-                    } else {
-                        if (tv2 && tv3) segments.push_back({e1, d0});
-                        else if (tv2 && !tv3) segments.push_back({e1, e2});
-                        else if (tv3 && !tv2) segments.push_back({e2, d0});
-                    }
+        std::vector<char> used(m, 0);
+        std::vector<int> position(n, -1);  // Index of each point in the current walk
+        std::vector<int> walk;
+        for (size_t i = 0; i < m; ++i) {
+            if (used[i]) continue;
+            used[i] = 1;
+            const int start = ends[2 * i];
+            int curr = ends[2 * i + 1];
+            walk.assign({start, curr});
+            position[start] = 0;
+            position[curr] = 1;
+
+            while (curr != start) {
+                int next = -1;
+                for (int k = offsets[curr]; k < offsets[curr + 1]; ++k) {
+                    int seg = incident[k];
+                    if (used[seg]) continue;
+                    used[seg] = 1;
+                    next = ends[2 * seg] == curr ? ends[2 * seg + 1] : ends[2 * seg];
+                    break;
+                }
+                if (next < 0) break;
+
+                if (next != start && position[next] >= 0) {
+                    size_t cycle_start = (size_t)position[next];
+                    std::vector<int> cycle(walk.begin() + cycle_start, walk.end());
+                    for (int id : cycle) position[id] = -1;
+                    finish(cycle);
+                    walk.resize(cycle_start);
                 }
+                curr = next;
+                walk.push_back(curr);
+                position[curr] = (int)walk.size() - 1;
             }
+
+            for (int id : walk) position[id] = -1;
+            if (walk.size() >= 3 && walk.back() == start) walk.pop_back();
+            finish(walk);
         }
-        return result;
+        return loops;
+    }
+
+    /**
+     * lattice_polygons: Exact polygons of lattice loops, keeping only the
+     * simple ones.
+     */
+    static std::vector<Polygon> lattice_polygons(const std::vector<LatticeLoop>& loops, double scale) {
+        std::vector<Polygon> polygons;
+        for (const LatticeLoop& loop : loops) {
+            Polygon poly;
+            for (const LatticePoint& p : loop) poly.push_back(EK::Point_2(FT((double)p.x) / scale, FT((double)p.y) / scale));
+            if (poly.is_simple()) polygons.push_back(std::move(poly));
+        }
+        return polygons;
     }
 
 private:
-    static std::vector<EK::Point_2> remove_collinear(const std::vector<EK::Point_2>& pts) {
+    static __int128 cross(const LatticePoint& o, const LatticePoint& a, const LatticePoint& b) {
+        return (__int128)(a.x - o.x) * (b.y - o.y) - (__int128)(a.y - o.y) * (b.x - o.x);
+    }
+
+    static LatticeLoop remove_collinear(const LatticeLoop& pts, const std::function<bool(const LatticePoint&)>& pinned = nullptr) {
         if (pts.size() < 3) return pts;
-        std::vector<EK::Point_2> result;
+        LatticeLoop result;
         result.reserve(pts.size());
         for (size_t i = 0; i < pts.size(); ++i) {
             const auto& p = pts[(i == 0) ? pts.size() - 1 : i - 1];
             const auto& q = pts[i];
             const auto& r = pts[(i == pts.size() - 1) ? 0 : i + 1];
-            if (!CGAL::collinear(p, q, r)) {
+            if (cross(p, q, r) != 0 || (pinned && pinned(q))) {
                 result.push_back(q);
             }
         }
         if (result.size() < pts.size() && result.size() >= 3) {
-            std::vector<EK::Point_2> final_result;
+            LatticeLoop final_result;
             final_result.reserve(result.size());
             for (size_t i = 0; i < result.size(); ++i) {
                 const auto& p = result[(i == 0) ? result.size() - 1 : i - 1];
                 const auto& q = result[i];
                 const auto& r = result[(i == result.size() - 1) ? 0 : i + 1];
-                if (!CGAL::collinear(p, q, r)) {
+                if (cross(p, q, r) != 0 || (pinned && pinned(q))) {
                     final_result.push_back(q);
                 }
             }
@@ -360,24 +536,45 @@ private:
         return result;
     }
 
-    static std::vector<EK::Point_2> simplify_douglas_peucker(const std::vector<EK::Point_2>& pts, double tolerance) {
+    // tolerance is in lattice units. Pinned points split the loop into
+    // spans that are simplified separately.
+    static LatticeLoop simplify_douglas_peucker(const LatticeLoop& pts, double tolerance,
+                                                const std::function<bool(const LatticePoint&)>& pinned = nullptr) {
         if (pts.size() < 3 || tolerance <= 1e-9) return pts;
         std::vector<bool> keep(pts.size(), false);
         keep[0] = true;
         keep[pts.size()-1] = true;
-        simplify_recursive(pts, 0, (int)pts.size()-1, tolerance * tolerance, keep);
-        std::vector<EK::Point_2> result;
+        if (pinned) {
+            for (size_t i = 0; i < pts.size(); ++i) if (pinned(pts[i])) keep[i] = true;
+        }
+        int start = 0;
+        for (int i = 1; i < (int)pts.size(); ++i) {
+            if (!keep[i]) continue;
+            simplify_recursive(pts, start, i, tolerance * tolerance, keep);
+            start = i;
+        }
+        LatticeLoop result;
         for (size_t i = 0; i < pts.size(); ++i) if (keep[i]) result.push_back(pts[i]);
         return result;
     }
 
-    static void simplify_recursive(const std::vector<EK::Point_2>& pts, int start, int end, double tolSq, std::vector<bool>& keep) {
+    static void simplify_recursive(const LatticeLoop& pts, int start, int end, double tolSq, std::vector<bool>& keep) {
         if (end <= start + 1) return;
         double maxDistSq = 0;
         int index = start;
-        EK::Line_2 line(pts[start], pts[end]);
+        const LatticePoint& a = pts[start];
+        const LatticePoint& b = pts[end];
+        double dx = (double)(b.x - a.x), dy = (double)(b.y - a.y);
+        double len2 = dx * dx + dy * dy;
         for (int i = start + 1; i < end; ++i) {
-            double dSq = CGAL::to_double(CGAL::squared_distance(line, pts[i]));
+            double dSq;
+            if (len2 > 0) {
+                double c = (double)cross(a, b, pts[i]);
+                dSq = c * c / len2;
+            } else {
+                double px = (double)(pts[i].x - a.x), py = (double)(pts[i].y - a.y);
+                dSq = px * px + py * py;
+            }
             if (dSq > maxDistSq) { maxDistSq = dSq; index = i; }
         }
         if (maxDistSq > tolSq) {
@@ -386,6 +583,107 @@ private:
             simplify_recursive(pts, index, end, tolSq, keep);
         }
     }
+
+    // Double-precision copy of a loop for nest_polygons; tol bounds how far
+    // the copied coordinates may be from the exact ones.
+    struct NestLoop {
+        std::vector<double> xy;
+        double area = 0, tol = 0;
+    };
+
+    // Static bounding-box hierarchy answering point-in-box queries.
+    struct BoxTree {
+        struct Box { double xmin, ymin, xmax, ymax; };
+        struct Node { Box box; int left, right, begin, end; };
+        std::vector<Box> boxes;
+        std::vector<int> items;
+        std::vector<Node> nodes;
+
+        explicit BoxTree(const std::vector<Box>& in) : boxes(in), items(in.size()) {
+            for (size_t i = 0; i < items.size(); ++i) items[i] = (int)i;
+            if (!items.empty()) build(0, (int)items.size());
+        }
+
+        int build(int begin, int end) {
+            Box box = boxes[items[begin]];
+            for (int k = begin + 1; k < end; ++k) {
+                const Box& b = boxes[items[k]];
+                box = {std::min(box.xmin, b.xmin), std::min(box.ymin, b.ymin), std::max(box.xmax, b.xmax), std::max(box.ymax, b.ymax)};
+            }
+            int id = (int)nodes.size();
+            nodes.push_back({box, -1, -1, begin, end});
+            if (end - begin <= 8) return id;
+            // Median split by box center along the longer side.
+            bool by_x = box.xmax - box.xmin >= box.ymax - box.ymin;
+            int mid = begin + (end - begin) / 2;
+            std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [&](int a, int b) {
+                const Box& p = boxes[a];
+                const Box& q = boxes[b];
+                return by_x ? p.xmin + p.xmax < q.xmin + q.xmax : p.ymin + p.ymax < q.ymin + q.ymax;
+            });
+            int left = build(begin, mid);
+            int right = build(mid, end);
+            nodes[id].left = left;
+            nodes[id].right = right;
+            return id;
+        }
+
+        // Appends every box within slack of (x, y).
+        void query(double x, double y, double slack, std::vector<int>& out) const {
+            if (nodes.empty()) return;
+            auto near = [&](const Box& b) {
+                return x >= b.xmin - slack && x <= b.xmax + slack && y >= b.ymin - slack && y <= b.ymax + slack;
+            };
+            int stack[64];
+            int top = 0;
+            stack[top++] = 0;
+            while (top > 0) {
+                const Node& node = nodes[stack[--top]];
+                if (!near(node.box)) continue;
+                if (node.left < 0) {
+                    for (int k = node.begin; k < node.end; ++k) {
+                        if (near(boxes[items[k]])) out.push_back(items[k]);
+                    }
+                } else {
+                    stack[top++] = node.left;
+                    stack[top++] = node.right;
+                }
+            }
+        }
+    };
+
+    static double approximate(const FT& value, double& tol) {
+        std::pair<double, double> range = CGAL::to_interval(value);
+        tol = std::max(tol, range.second - range.first);
+        return (range.first + range.second) / 2;
+    }
+
+    /**
+     * approx_inside: Crossing-number test of (px, py) against a loop.
+     * Returns 1 inside, 0 outside, or -1 when rounding or the error bounds
+     * leave the answer in doubt.
+     */
+    static int approx_inside(const NestLoop& loop, double px, double py, double probe_tol) {
+        const std::vector<double>& xy = loop.xy;
+        const size_t n = xy.size() / 2;
+        if (n < 3) return 0;
+        const double tol = loop.tol + probe_tol;
+        bool inside = false;
+        for (size_t k = 0, m = n - 1; k < n; m = k++) {
+            double ax = xy[2 * m], ay = xy[2 * m + 1], bx = xy[2 * k], by = xy[2 * k + 1];
+            // With inexact coordinates a vertex near the ray may be on either side.
+            if (tol > 0 && std::abs(by - py) <= tol) return -1;
+            if ((ay > py) == (by > py)) continue;
+            double u = (bx - ax) * (py - ay), v = (px - ax) * (by - ay);
+            double det = u - v;
+            double bound = 1e-15 * (std::abs(u) + std::abs(v)) +
+                           2 * tol * (std::abs(bx - ax) + std::abs(by - ay) + std::abs(px - ax) + std::abs(py - ay) + 2 * tol);
+            if (std::abs(det) <= bound) return -1;
+            // The edge crosses the ray to the right of the point.
+            if ((det > 0) == (by > ay)) inside = !inside;
+        }
+        return inside ? 1 : 0;
+    }
 };
 
 } // namespace geo
@@ -0,0 +1,212 @@
+#include "font.h"
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include "../../fs/cpp/cid.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+namespace jotcad {
+namespace geo {
+
+namespace {
+
+// Creating and destroying faces touches the shared library, so both are
+// serialized here; per-face work only needs the face's own lock.
+struct Library {
+    std::mutex mutex;
+    FT_Library library = nullptr;
+
+    Library() {
+        if (FT_Init_FreeType(&library)) library = nullptr;
+    }
+    ~Library() {
+        if (library) FT_Done_FreeType(library);
+    }
+};
+
+Library& shared_library() {
+    static Library state;
+    return state;
+}
+
+// Segments needed to keep a Bezier within tolerance of its chords (Wang's
+// formula): sqrt(d(d-1)/8 * M / tolerance), with M the largest second
+// difference of the control points.
+int segments_for(double second_difference, double factor, double tolerance) {
+    if (!(tolerance > 0)) return 64;
+    double n = std::ceil(std::sqrt(factor * second_difference / tolerance));
+    return std::min(64, std::max(1, (int)n));
+}
+
+struct Flattener {
+    GlyphOutline* out;
+    double scale;
+    double tolerance;  // In 26.6 units
+    double x = 0, y = 0;
+
+    void add(double px, double py) {
+        x = px;
+        y = py;
+        out->paths.back().push_back({px * scale, py * scale});
+    }
+
+    static int move_to(const FT_Vector* to, void* user) {
+        auto f = static_cast<Flattener*>(user);
+        f->out->paths.emplace_back();
+        f->add(to->x, to->y);
+        return 0;
+    }
+
+    static int line_to(const FT_Vector* to, void* user) {
+        static_cast<Flattener*>(user)->add(to->x, to->y);
+        return 0;
+    }
+
+    static int conic_to(const FT_Vector* control, const FT_Vector* to, void* user) {
+        auto f = static_cast<Flattener*>(user);
+        double x0 = f->x, y0 = f->y;
+        double x1 = control->x, y1 = control->y, x2 = to->x, y2 = to->y;
+        int n = segments_for(std::hypot(x0 - 2 * x1 + x2, y0 - 2 * y1 + y2), 0.25, f->tolerance);
+        for (int i = 1; i <= n; ++i) {
+            double t = double(i) / n, u = 1 - t;
+            f->add(u * u * x0 + 2 * u * t * x1 + t * t * x2,
+                   u * u * y0 + 2 * u * t * y1 + t * t * y2);
+        }
+        return 0;
+    }
+
+    static int cubic_to(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to, void* user) {
+        auto f = static_cast<Flattener*>(user);
+        double x0 = f->x, y0 = f->y;
+        double x1 = control1->x, y1 = control1->y, x2 = control2->x, y2 = control2->y, x3 = to->x, y3 = to->y;
+        double m = std::max(std::hypot(x0 - 2 * x1 + x2, y0 - 2 * y1 + y2),
+                            std::hypot(x1 - 2 * x2 + x3, y1 - 2 * y2 + y3));
+        int n = segments_for(m, 0.75, f->tolerance);
+        for (int i = 1; i <= n; ++i) {
+            double t = double(i) / n, u = 1 - t;
+            f->add(u * u * u * x0 + 3 * u * u * t * x1 + 3 * u * t * t * x2 + t * t * t * x3,
+                   u * u * u * y0 + 3 * u * u * t * y1 + 3 * u * t * t * y2 + t * t * t * y3);
+        }
+        return 0;
+    }
+};
+
+} // namespace
+
+FontFace::FontFace(std::vector<uint8_t> bytes) : bytes_(std::move(bytes)), cid_(fs::vfs_hash256(bytes_)) {
+    if (bytes_.empty()) return;
+    Library& lib = shared_library();
+    std::lock_guard<std::mutex> lock(lib.mutex);
+    if (!lib.library) return;
+    FT_Face face;
+    if (FT_New_Memory_Face(lib.library, bytes_.data(), (FT_Long)bytes_.size(), 0, &face)) return;
+    FT_Set_Pixel_Sizes(face, 0, 64);
+    face_ = face;
+}
+
+FontFace::~FontFace() {
+    if (!face_) return;
+    Library& lib = shared_library();
+    std::lock_guard<std::mutex> lock(lib.mutex);
+    FT_Done_Face(face_);
+}
+
+unsigned FontFace::glyph_index(unsigned long code) const {
+    if (!face_) return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return FT_Get_Char_Index(face_, code);
+}
+
+bool FontFace::outline(unsigned glyph, double scale, double tolerance, GlyphOutline& out) const {
+    out = GlyphOutline();
+    if (!face_) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (FT_Load_Glyph(face_, glyph, FT_LOAD_NO_BITMAP)) return false;
+    out.advance = face_->glyph->advance.x;
+
+    FT_Outline_Funcs funcs;
+    funcs.move_to = Flattener::move_to;
+    funcs.line_to = Flattener::line_to;
+    funcs.conic_to = Flattener::conic_to;
+    funcs.cubic_to = Flattener::cubic_to;
+    funcs.shift = 0;
+    funcs.delta = 0;
+    Flattener flattener{&out, scale, scale > 0 ? tolerance / scale : 0.0};
+    return FT_Outline_Decompose(&face_->glyph->outline, &funcs, &flattener) == 0;
+}
+
+namespace {
+
+struct CacheState {
+    std::mutex mutex;
+    std::size_t capacity = 16;
+    // Most recently used first.
+    std::list<std::pair<std::string, std::shared_ptr<const FontFace>>> entries;
+    std::map<std::string, decltype(entries)::iterator> index;
+
+    void evict() {
+        while (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+};
+
+CacheState& cache_state() {
+    // The library must outlive the cached faces, so it is built first.
+    shared_library();
+    static CacheState state;
+    return state;
+}
+
+} // namespace
+
+std::shared_ptr<const FontFace> FontCache::get(const std::vector<uint8_t>& bytes) {
+    std::string cid = fs::vfs_hash256(bytes);
+    CacheState& state = cache_state();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto it = state.index.find(cid);
+        if (it != state.index.end()) {
+            state.entries.splice(state.entries.begin(), state.entries, it->second);
+            return it->second->second;
+        }
+    }
+
+    // Open outside the lock; a concurrent miss on the same font keeps
+    // whichever face is inserted first.
+    auto face = std::make_shared<const FontFace>(bytes);
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.index.find(cid);
+    if (it != state.index.end()) return it->second->second;
+    state.entries.emplace_front(cid, face);
+    state.index[cid] = state.entries.begin();
+    state.evict();
+    return face;
+}
+
+void FontCache::set_capacity(std::size_t faces) {
+    CacheState& state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.capacity = faces;
+    state.evict();
+}
+
+std::size_t FontCache::size() {
+    CacheState& state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.entries.size();
+}
+
+void FontCache::clear() {
+    CacheState& state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.entries.clear();
+    state.index.clear();
+}
+
+} // namespace geo
+} // namespace jotcad
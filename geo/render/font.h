@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct FT_FaceRec_;
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * GlyphOutline: A glyph's contours flattened to polylines, in output units
+ * with the origin on the baseline, plus its advance in 26.6 font units.
+ */
+struct GlyphOutline {
+    std::vector<std::vector<std::array<double, 2>>> paths;
+    long advance = 0;
+};
+
+/**
+ * FontFace: A FreeType face over font bytes it owns, set to the 64 pixel em
+ * that jot/text lays out at. FreeType faces are not thread-safe, so every
+ * call holds the face's lock.
+ */
+class FontFace {
+public:
+    explicit FontFace(std::vector<uint8_t> bytes);
+    ~FontFace();
+    FontFace(const FontFace&) = delete;
+    FontFace& operator=(const FontFace&) = delete;
+
+    bool valid() const { return face_ != nullptr; }
+    const std::string& cid() const { return cid_; }
+
+    // Glyph index for a character code; 0 is the missing glyph.
+    unsigned glyph_index(unsigned long code) const;
+
+    /**
+     * outline: Decomposes a glyph, scaling 26.6 units by scale, and flattens
+     * each conic and cubic into as few segments as keep it within tolerance
+     * (in output units) of the curve.
+     */
+    bool outline(unsigned glyph, double scale, double tolerance, GlyphOutline& out) const;
+
+private:
+    std::vector<uint8_t> bytes_;
+    std::string cid_;
+    FT_FaceRec_* face_ = nullptr;
+    mutable std::mutex mutex_;
+};
+
+/**
+ * FontCache: Process-wide faces keyed by the content CID of their font
+ * bytes, so repeated jot/text calls skip FreeType setup. Least recently used
+ * faces are evicted beyond the face capacity.
+ */
+class FontCache {
+public:
+    static std::shared_ptr<const FontFace> get(const std::vector<uint8_t>& bytes);
+
+    static void set_capacity(std::size_t faces);
+    static std::size_t size();
+    static void clear();
+};
+
+} // namespace geo
+} // namespace jotcad
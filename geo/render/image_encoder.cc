@@ -0,0 +1,221 @@
+#include "image_encoder.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <zlib.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../../fs/cpp/vendor/stb_image_write.h"
+
+namespace jotcad {
+namespace geo {
+
+namespace {
+
+void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back((uint8_t)(v >> 24)); out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8)); out.push_back((uint8_t)v);
+}
+
+void put_chunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, std::size_t len) {
+    put_u32(out, (uint32_t)len);
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (len) out.insert(out.end(), data, data + len);
+    put_u32(out, (uint32_t)crc32(0, out.data() + start, (uInt)(len + 4)));
+}
+
+uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// Writes the filter byte and filtered row, choosing the filter with the
+// smallest sum of absolute residuals.
+void filter_row(const unsigned char* row, const unsigned char* prev, int stride, uint8_t* out) {
+    std::vector<uint8_t> trial(stride);
+    long best_cost = -1;
+    for (int type = 0; type < 5; ++type) {
+        long cost = 0;
+        for (int i = 0; i < stride; ++i) {
+            int a = i >= 4 ? row[i - 4] : 0;
+            int b = prev ? prev[i] : 0;
+            int c = (prev && i >= 4) ? prev[i - 4] : 0;
+            uint8_t pred = 0;
+            switch (type) {
+                case 1: pred = (uint8_t)a; break;
+                case 2: pred = (uint8_t)b; break;
+                case 3: pred = (uint8_t)((a + b) / 2); break;
+                case 4: pred = paeth(a, b, c); break;
+            }
+            trial[i] = (uint8_t)(row[i] - pred);
+            cost += std::abs((int)(int8_t)trial[i]);
+        }
+        if (best_cost < 0 || cost < best_cost) {
+            best_cost = cost;
+            out[0] = (uint8_t)type;
+            std::memcpy(out + 1, trial.data(), stride);
+        }
+    }
+}
+
+} // namespace
+
+ImageEncoder::Options ImageEncoder::options_from(const std::string& format, int level) {
+    Options options;
+    if (format == "qoi") {
+        options.format = Format::Qoi;
+    } else if (format != "png") {
+        throw std::invalid_argument("Unknown image format: " + format);
+    }
+    options.level = std::min(level, 9);
+    return options;
+}
+
+std::vector<uint8_t> ImageEncoder::encode(const std::vector<unsigned char>& rgba, int width, int height, const Options& options) {
+    if (options.format == Format::Qoi) return encode_qoi(rgba, width, height);
+    if (options.level < 0) return encode_png_stb(rgba, width, height);
+    return encode_png_zlib(rgba, width, height, options.level, options.threads);
+}
+
+std::vector<uint8_t> ImageEncoder::encode_png_stb(const std::vector<unsigned char>& rgba, int width, int height) {
+    int len;
+    unsigned char* png_data = stbi_write_png_to_mem(rgba.data(), width * 4, width, height, 4, &len);
+    if (!png_data) return {};
+    std::vector<uint8_t> result(png_data, png_data + len);
+    free(png_data);
+    return result;
+}
+
+std::vector<uint8_t> ImageEncoder::encode_png_zlib(const std::vector<unsigned char>& rgba, int width, int height, int level, int threads) {
+    const int stride = width * 4;
+    const std::size_t row_bytes = (std::size_t)stride + 1;
+    const int blocks = std::max(1, (height + kRowsPerBlock - 1) / kRowsPerBlock);
+
+    // Each block is filtered and raw-deflated independently, primed with the
+    // previous block's trailing 32K so compression barely suffers. Blocks end
+    // on a byte boundary (Z_SYNC_FLUSH) and the last one closes the stream.
+    std::vector<std::vector<uint8_t>> filtered(blocks), deflated(blocks);
+    std::vector<uLong> adlers(blocks);
+    std::atomic<int> next_block{0};
+    std::atomic<bool> failed{false};
+
+    auto filter_block = [&](int b) {
+        int y0 = b * kRowsPerBlock, y1 = std::min(height, y0 + kRowsPerBlock);
+        filtered[b].resize((std::size_t)(y1 - y0) * row_bytes);
+        for (int y = y0; y < y1; ++y) {
+            const unsigned char* row = rgba.data() + (std::size_t)y * stride;
+            const unsigned char* prev = y > 0 ? row - stride : nullptr;
+            filter_row(row, prev, stride, filtered[b].data() + (std::size_t)(y - y0) * row_bytes);
+        }
+        adlers[b] = adler32(adler32(0L, Z_NULL, 0), filtered[b].data(), (uInt)filtered[b].size());
+    };
+    auto deflate_block = [&](int b) {
+        z_stream zs{};
+        if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) { failed = true; return; }
+        if (b > 0) {
+            const std::vector<uint8_t>& prior = filtered[b - 1];
+            std::size_t dict = std::min<std::size_t>(prior.size(), 32768);
+            deflateSetDictionary(&zs, prior.data() + prior.size() - dict, (uInt)dict);
+        }
+        std::vector<uint8_t>& out = deflated[b];
+        out.resize(deflateBound(&zs, (uLong)filtered[b].size()) + 16);
+        zs.next_in = filtered[b].data();
+        zs.avail_in = (uInt)filtered[b].size();
+        zs.next_out = out.data();
+        zs.avail_out = (uInt)out.size();
+        int rc = deflate(&zs, b == blocks - 1 ? Z_FINISH : Z_SYNC_FLUSH);
+        if ((b == blocks - 1 && rc != Z_STREAM_END) || (b != blocks - 1 && rc != Z_OK)) failed = true;
+        out.resize(out.size() - zs.avail_out);
+        deflateEnd(&zs);
+    };
+
+    int worker_count = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    worker_count = std::min(worker_count, blocks);
+    auto run = [&](auto&& task) {
+        next_block = 0;
+        auto worker = [&]() {
+            for (int b = next_block++; b < blocks; b = next_block++) task(b);
+        };
+        std::vector<std::thread> workers;
+        for (int i = 1; i < worker_count; ++i) workers.emplace_back(worker);
+        worker();
+        for (auto& w : workers) w.join();
+    };
+    // Dictionaries read the neighbouring block's filtered rows, so filtering
+    // completes before any deflate starts.
+    run(filter_block);
+    run(deflate_block);
+    if (failed) return {};
+
+    std::vector<uint8_t> idat = {0x78, 0x9c};
+    uLong adler = adlers[0];
+    for (int b = 0; b < blocks; ++b) {
+        idat.insert(idat.end(), deflated[b].begin(), deflated[b].end());
+        if (b > 0) adler = adler32_combine(adler, adlers[b], (z_off_t)filtered[b].size());
+    }
+    put_u32(idat, (uint32_t)adler);
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> png(signature, signature + 8);
+    std::vector<uint8_t> ihdr;
+    put_u32(ihdr, (uint32_t)width);
+    put_u32(ihdr, (uint32_t)height);
+    ihdr.insert(ihdr.end(), {8, 6, 0, 0, 0}); // 8-bit RGBA, deflate, adaptive filtering, no interlace
+    put_chunk(png, "IHDR", ihdr.data(), ihdr.size());
+    put_chunk(png, "IDAT", idat.data(), idat.size());
+    put_chunk(png, "IEND", nullptr, 0);
+    return png;
+}
+
+std::vector<uint8_t> ImageEncoder::encode_qoi(const std::vector<unsigned char>& rgba, int width, int height) {
+    std::vector<uint8_t> out = {'q', 'o', 'i', 'f'};
+    put_u32(out, (uint32_t)width);
+    put_u32(out, (uint32_t)height);
+    out.push_back(4); // RGBA
+    out.push_back(0); // sRGB with linear alpha
+    out.reserve(out.size() + (std::size_t)width * height * 5 + 8);
+
+    unsigned char index[64][4] = {};
+    unsigned char px[4] = {0, 0, 0, 255}, prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    std::size_t count = (std::size_t)width * height;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::memcpy(px, rgba.data() + i * 4, 4);
+        if (std::memcmp(px, prev, 4) == 0) {
+            if (++run == 62 || i == count - 1) { out.push_back((uint8_t)(0xc0 | (run - 1))); run = 0; }
+            continue;
+        }
+        if (run > 0) { out.push_back((uint8_t)(0xc0 | (run - 1))); run = 0; }
+
+        int slot = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (std::memcmp(index[slot], px, 4) == 0) {
+            out.push_back((uint8_t)slot);
+        } else {
+            std::memcpy(index[slot], px, 4);
+            if (px[3] == prev[3]) {
+                int dr = (int8_t)(px[0] - prev[0]), dg = (int8_t)(px[1] - prev[1]), db = (int8_t)(px[2] - prev[2]);
+                int dr_dg = dr - dg, db_dg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out.push_back((uint8_t)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                    out.push_back((uint8_t)(0x80 | (dg + 32)));
+                    out.push_back((uint8_t)((dr_dg + 8) << 4 | (db_dg + 8)));
+                } else {
+                    out.insert(out.end(), {0xfe, px[0], px[1], px[2]});
+                }
+            } else {
+                out.insert(out.end(), {0xff, px[0], px[1], px[2], px[3]});
+            }
+        }
+        std::memcpy(prev, px, 4);
+    }
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
+}
+
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * ImageEncoder: Turns RGBA8 pixel buffers into image files.
+ *
+ * - Png with level < 0: the built-in stb writer (the historical output).
+ * - Png with level 0-9: zlib deflate at that level, compressed in row blocks
+ *   on parallel workers and stitched into a single zlib stream.
+ * - Qoi: lossless and much faster to encode, for internal previews.
+ */
+struct ImageEncoder {
+    enum class Format { Png, Qoi };
+
+    struct Options {
+        Format format = Format::Png;
+        int level = -1;
+        int threads = 0; // 0 selects the hardware concurrency.
+    };
+
+    // Throws std::invalid_argument for a format other than "png" or "qoi".
+    static Options options_from(const std::string& format, int level);
+
+    static const char* mime_type(Format format) {
+        return format == Format::Qoi ? "image/qoi" : "image/png";
+    }
+
+    static std::vector<uint8_t> encode(const std::vector<unsigned char>& rgba, int width, int height, const Options& options);
+
+    static std::vector<uint8_t> encode_png_stb(const std::vector<unsigned char>& rgba, int width, int height);
+    static std::vector<uint8_t> encode_png_zlib(const std::vector<unsigned char>& rgba, int width, int height, int level, int threads);
+    static std::vector<uint8_t> encode_qoi(const std::vector<unsigned char>& rgba, int width, int height);
+
+    static constexpr int kRowsPerBlock = 64;
+};
+
+} // namespace geo
+} // namespace jotcad
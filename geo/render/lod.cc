@@ -0,0 +1,81 @@
+#include "lod.h"
+#include "render_buffer.h"
+#include "simplify_op.h"
+#include <algorithm>
+#include <cmath>
+
+namespace jotcad {
+namespace geo {
+
+Lod::Info Lod::info(fs::VFSNode* vfs, const fs::CID& geometry) {
+    fs::Selector key = Derived::key("lod_info", {{"geometry", geometry.value}, {"version", RenderBuffer::kVersion}});
+    Info info;
+    if (auto cached = Derived::lookup_json(vfs, key)) {
+        if (cached->contains("triangles") && cached->contains("bounds") && cached->at("bounds").size() == 6) {
+            info.triangles = cached->at("triangles").get<std::size_t>();
+            for (int i = 0; i < 3; ++i) {
+                info.min[i] = cached->at("bounds")[i].get<double>();
+                info.max[i] = cached->at("bounds")[i + 3].get<double>();
+            }
+            return info;
+        }
+    }
+
+    RenderBuffer buffer = RenderBuffer::get(vfs, geometry);
+    info.triangles = buffer.triangle_count();
+    if (buffer.vertex_count() > 0) {
+        for (int i = 0; i < 3; ++i) info.min[i] = info.max[i] = buffer.positions[i];
+        for (std::size_t v = 0; v < buffer.vertex_count(); ++v) {
+            for (int i = 0; i < 3; ++i) {
+                info.min[i] = std::min(info.min[i], (double)buffer.positions[v * 3 + i]);
+                info.max[i] = std::max(info.max[i], (double)buffer.positions[v * 3 + i]);
+            }
+        }
+    }
+    Derived::store_json(vfs, key, {{"triangles", info.triangles},
+                                   {"bounds", {info.min[0], info.min[1], info.min[2], info.max[0], info.max[1], info.max[2]}}});
+    return info;
+}
+
+int Lod::select(std::size_t triangles, double extent) {
+    if (triangles <= kMinTriangles) return 0;
+    double budget = std::max((double)kMinTriangles, extent * extent / kPixelsPerTriangle);
+    int level = 0;
+    double estimate = (double)triangles;
+    while (level < kMaxLevel && estimate > budget) {
+        estimate *= kLevelRatio;
+        ++level;
+    }
+    return level;
+}
+
+fs::CID Lod::geometry(fs::VFSNode* vfs, const fs::CID& geometry, int level) {
+    if (level <= 0) return geometry;
+    level = std::min(level, kMaxLevel);
+    fs::Selector key = Derived::key("lod", {{"geometry", geometry.value}, {"level", level}, {"version", kVersion}});
+    if (auto cached = Derived::lookup(vfs, key)) return *cached;
+
+    // Only the requested level is built, by one collapse of the source
+    // straight to its target, so a cold render pays for a single level.
+    fs::CID result = geometry;
+    auto face_count = [](const Geometry& g) { return std::max(g.faces.size(), g.triangles.size()); };
+    try {
+        Geometry geo = vfs->read<Geometry>(geometry);
+        std::size_t faces = face_count(geo);
+        if (faces > kMinTriangles / 2) {
+            double ratio = std::max(std::pow(kLevelRatio, level), (double)(kMinTriangles / 2) / faces);
+            Geometry simplified = SimplifyOp<>::simplify_geometry(geo, ratio);
+            // Keep the source when the collapse stalls on constrained edges.
+            if (face_count(simplified) > 0 && face_count(simplified) < faces) {
+                result = vfs->materialize<Geometry>(simplified);
+            }
+        }
+    } catch (...) {
+        // Not a simplifiable mesh (e.g. open or non-manifold): keep the source.
+    }
+    Derived::store(vfs, key, result);
+    return result;
+}
+
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include "geometry.h"
+#include "../core/derived.h"
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * Lod: Decimated levels of one geometry for preview rendering.
+ *
+ * Level 0 is the geometry itself; level n is an edge collapse of it to
+ * kLevelRatio^n of its edges. Levels are derived artifacts of the source
+ * CID, each built on its own the first time a renderer asks for it.
+ */
+struct Lod {
+    static constexpr int kVersion = 2;
+    static constexpr int kMaxLevel = 6;
+    static constexpr double kLevelRatio = 0.25;
+    // Meshes at or below this many triangles are always drawn at level 0.
+    static constexpr std::size_t kMinTriangles = 2048;
+    // Screen area, in pixels, granted to each triangle when choosing a level.
+    static constexpr double kPixelsPerTriangle = 2.0;
+
+    struct Info {
+        std::size_t triangles = 0;
+        double min[3] = {0, 0, 0};
+        double max[3] = {0, 0, 0};
+    };
+
+    /**
+     * info: Triangle count and local bounds of the level 0 render buffer,
+     * cached so that choosing a level does not decode the full buffer.
+     */
+    static Info info(fs::VFSNode* vfs, const fs::CID& geometry);
+
+    /**
+     * select: The coarsest level whose estimated triangle count still
+     * covers a footprint of extent x extent pixels.
+     */
+    static int select(std::size_t triangles, double extent);
+
+    /**
+     * geometry: The CID of the given level, without building the levels
+     * between. A mesh that cannot be simplified resolves to the source.
+     */
+    static fs::CID geometry(fs::VFSNode* vfs, const fs::CID& geometry, int level);
+};
+
+} // namespace geo
+} // namespace jotcad
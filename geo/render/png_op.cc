@@ -6,14 +6,22 @@ namespace jotcad {
 namespace geo {
 
 void PngOpImpl::execute(fs::VFSNode* vfs, const fs::Selector& fulfilling, const Shape& in_shape) {
+    // format: "png" (default) or "qoi"; level: zlib level 0-9, or -1 for the built-in PNG writer.
+    // An unknown format is a caller error and propagates.
+    ImageEncoder::Options encoding = ImageEncoder::options_from(
+        fulfilling.parameters.value("format", std::string("png")), fulfilling.parameters.value("level", -1));
     try {
         double ax = fulfilling.parameters.value("ax", 0.0);
         double ay = fulfilling.parameters.value("ay", 0.0);
         int width = fulfilling.parameters.value("width", 256);
         int height = fulfilling.parameters.value("height", 256);
+        // layers: composite multi-component scenes from cached per-component layers.
+        bool layered = fulfilling.parameters.value("layers", false);
+        // lod: draw dense meshes from decimated levels sized to the frame.
+        bool lod = fulfilling.parameters.value("lod", false);
 
         // Directly delegate to Rasterizer with the root shape
-        std::vector<uint8_t> bytes = Rasterizer::render_png(vfs, in_shape, width, height, ax, ay);
+        std::vector<uint8_t> bytes = Rasterizer::render_png(vfs, in_shape, width, height, ax, ay, encoding, layered, lod);
         
         if (!bytes.empty()) {
             vfs->write(fulfilling.with_output("$out"), bytes);
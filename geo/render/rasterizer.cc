@@ -1,28 +1,36 @@
 #include "rasterizer.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
 #include "contour_utils.h"
+#include "render_buffer.h"
+#include "image_encoder.h"
+#include "lod.h"
 #include "matrix.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "../../fs/cpp/vendor/stb_image_write.h"
-#include "../../fs/cpp/vendor/stb_image.h"
 
 namespace jotcad {
 namespace geo {
 
+int Rasterizer::threads = 0;
+
 void Rasterizer::rasterize_triangle(
     const RenderTriangle& tri,
     std::vector<unsigned char>& pixels, std::vector<double>& z_buffer,
-    int width, int height, double scale, double offset_x, double offset_y) {
+    int width, int height, double scale, double offset_x, double offset_y,
+    int clip_x0, int clip_y0, int clip_x1, int clip_y1, std::vector<double>* order) {
 
     double x0 = tri.p[0].x * scale + offset_x, y0 = (height - 1) - (tri.p[0].y * scale + offset_y);
     double x1 = tri.p[1].x * scale + offset_x, y1 = (height - 1) - (tri.p[1].y * scale + offset_y);
     double x2 = tri.p[2].x * scale + offset_x, y2 = (height - 1) - (tri.p[2].y * scale + offset_y);
 
-    int minX = (int)std::max(0.0, std::floor(std::min({x0, x1, x2})));
-    int maxX = (int)std::min((double)width - 1, std::ceil(std::max({x0, x1, x2})));
-    int minY = (int)std::max(0.0, std::floor(std::min({y0, y1, y2})));
-    int maxY = (int)std::min((double)height - 1, std::ceil(std::max({y0, y1, y2})));
+    int minX = std::max(clip_x0, (int)std::max(0.0, std::floor(std::min({x0, x1, x2}))));
+    int maxX = std::min(clip_x1, (int)std::min((double)width - 1, std::ceil(std::max({x0, x1, x2}))));
+    int minY = std::max(clip_y0, (int)std::max(0.0, std::floor(std::min({y0, y1, y2}))));
+    int maxY = std::min(clip_y1, (int)std::min((double)height - 1, std::ceil(std::max({y0, y1, y2}))));
 
     auto edge_func = [](double ax, double ay, double bx, double by, double cx, double cy) {
         return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
@@ -31,21 +39,46 @@ void Rasterizer::rasterize_triangle(
     double area = edge_func(x0, y0, x1, y1, x2, y2);
     if (std::abs(area) < 1e-6) return;
 
+    // Edge values are stepped per row with the same operations as edge_func,
+    // so they round identically. Pixels clearly outside (with margin for the
+    // division's rounding) are rejected before dividing; candidates divide
+    // exactly as before, keeping the image bit-for-bit unchanged.
+    double sign = area > 0 ? 1.0 : -1.0;
+    double reject = -1.000001e-6 * std::abs(area);
+    double k0 = y2 - y1, k1 = y0 - y2, k2 = y1 - y0;
+
+    // Minified textures sample a coarser mip level, chosen per triangle.
+    bool textured = tri.texture && !tri.texture->empty();
+    int mip = 0;
+    if (textured) {
+        double uv_area = (tri.uv[1].x - tri.uv[0].x) * (tri.uv[2].y - tri.uv[0].y) -
+                         (tri.uv[1].y - tri.uv[0].y) * (tri.uv[2].x - tri.uv[0].x);
+        mip = tri.texture->level_for(uv_area, std::abs(area));
+    }
+
     for (int y = minY; y <= maxY; ++y) {
+        double r0 = (x2 - x1) * ((double)y - y1);
+        double r1 = (x0 - x2) * ((double)y - y2);
+        double r2 = (x1 - x0) * ((double)y - y0);
         for (int x = minX; x <= maxX; ++x) {
-            double w0 = edge_func(x1, y1, x2, y2, (double)x, (double)y) / area;
-            double w1 = edge_func(x2, y2, x0, y0, (double)x, (double)y) / area;
-            double w2 = edge_func(x0, y0, x1, y1, (double)x, (double)y) / area;
+            double e0 = r0 - k0 * ((double)x - x1);
+            double e1 = r1 - k1 * ((double)x - x2);
+            double e2 = r2 - k2 * ((double)x - x0);
+            if (e0 * sign < reject || e1 * sign < reject || e2 * sign < reject) continue;
+
+            double w0 = e0 / area;
+            double w1 = e1 / area;
+            double w2 = e2 / area;
 
             if (w0 >= -1e-6 && w1 >= -1e-6 && w2 >= -1e-6) {
                 double depth = w0 * tri.p[0].z + w1 * tri.p[1].z + w2 * tri.p[2].z;
                 int idx = y * width + x;
                 if (depth >= z_buffer[idx]) {
                     ColorRGBA frag_color = tri.color;
-                    if (tri.texture && !tri.texture->pixels.empty()) {
+                    if (textured) {
                         double u = w0 * tri.uv[0].x + w1 * tri.uv[1].x + w2 * tri.uv[2].x;
                         double v = w0 * tri.uv[0].y + w1 * tri.uv[1].y + w2 * tri.uv[2].y;
-                        ColorRGBA tex_color = tri.texture->sample(u, v);
+                        ColorRGBA tex_color = tri.texture->sample(u, v, mip);
                         // Multiply base lit color by texture color
                         frag_color.r = (unsigned char)((frag_color.r * tex_color.r) / 255.0);
                         frag_color.g = (unsigned char)((frag_color.g * tex_color.g) / 255.0);
@@ -55,6 +88,7 @@ void Rasterizer::rasterize_triangle(
                     
                     if (frag_color.a == 255) {
                         z_buffer[idx] = depth;
+                        if (order) (*order)[idx] = tri.avg_z;
                         pixels[idx * 4] = frag_color.r;
                         pixels[idx * 4 + 1] = frag_color.g;
                         pixels[idx * 4 + 2] = frag_color.b;
@@ -95,18 +129,13 @@ void Rasterizer::rasterize_line(int x0, int y0, int x1, int y1, ColorRGBA col, s
     }
 }
 
-std::vector<uint8_t> Rasterizer::render_png(fs::VFSNode* vfs, const Shape& shape, int width, int height, double ax, double ay) {
-    std::vector<unsigned char> pixels(width * height * 4, 30);
-    for (int i = 3; i < (int)pixels.size(); i += 4) pixels[i] = 255;
-    std::vector<double> z_buffer(width * height, -1e18);
-
-    Camera cam(ax, ay);
-    std::vector<RenderTriangle> triangles;
-    std::vector<RenderLine> wireframe;
-    
-    std::map<std::string, Texture> texture_cache;
+Rasterizer::Scene Rasterizer::collect_scene(fs::VFSNode* vfs, const Shape& shape, bool load_textures, int lod_extent) {
+    Scene scene;
+    auto& texture_cache = scene.textures;
+    // Items are resolved to geometry CIDs first; render buffers are loaded
+    // once the level of detail of every item is known.
+    std::vector<fs::CID> sources;
 
-    // 1. Scene Collection
     auto collect = [&](auto self, const Shape& s, const std::string& current_color) -> void {
         Matrix current_tf = s.tf;
         std::string next_color = s.tags.value("color", current_color);
@@ -119,119 +148,456 @@ std::vector<uint8_t> Rasterizer::render_png(fs::VFSNode* vfs, const Shape& shape
 
         std::string material = s.tags.value("material", "");
         const Texture* active_texture = nullptr;
-        if (!material.empty() && vfs) {
+        if (!material.empty() && vfs && load_textures) {
             if (texture_cache.find(material) == texture_cache.end()) {
                 try {
                     fs::Selector req("jot/texture", {{"material", material}});
                     req.output = "$out";
-                    // Attempt to resolve texture data. We might get raw bytes or a link to a CID.
-                    // The vfs->read<std::vector<uint8_t>> should handle link resolution.
-                    auto img_data = vfs->read<std::vector<uint8_t>>(req);
-                    if (!img_data.empty()) {
-                        int w, h, channels;
-                        unsigned char* data = stbi_load_from_memory(img_data.data(), img_data.size(), &w, &h, &channels, 0);
-                        if (data) {
-                            Texture tex{w, h, channels, std::vector<unsigned char>(data, data + w * h * channels)};
-                            stbi_image_free(data);
-                            texture_cache[material] = std::move(tex);
-                        } else {
-                            texture_cache[material] = Texture{};
-                        }
-                    } else {
-                        texture_cache[material] = Texture{};
-                    }
+                    // vfs->read resolves links to the current image, and the cache is
+                    // keyed by its content hash, so a remapped material is decoded anew.
+                    texture_cache[material] = TextureCache::get(vfs->read<std::vector<uint8_t>>(req));
                 } catch (...) {
-                    texture_cache[material] = Texture{}; // Cache failure to avoid refetching
+                    texture_cache[material] = nullptr; // Cache failure to avoid refetching
                 }
             }
             auto it = texture_cache.find(material);
-            if (it != texture_cache.end() && !it->second.pixels.empty()) {
-                active_texture = &it->second;
+            if (it != texture_cache.end() && it->second && !it->second->empty()) {
+                active_texture = it->second.get();
             }
         }
 
         if (s.geometry.has_value() && vfs) {
-            Geometry geo = vfs->read<Geometry>(s.geometry.value());
             ColorRGBA base_color = {200, 200, 200, alpha};
             if (!next_color.empty()) {
                 auto rgb = ContourUtils::parse_color(next_color);
                 base_color = {rgb.r, rgb.g, rgb.b, alpha};
             }
-
-            std::vector<Vec3> pts;
-            for (const auto& v : geo.vertices) {
-                Point_3 p_world = current_tf.t.transform(Point_3(v.x, v.y, v.z));
-                pts.push_back(cam.project(Vertex{p_world.x(), p_world.y(), p_world.z()}));
-            }
-
-            auto add_tri = [&](int i0, int i1, int i2) {
-                Vec3 p0 = pts[i0], p1 = pts[i1], p2 = pts[i2];
-                Vec2 uv0 = { CGAL::to_double(geo.vertices[i0].x) / 100.0, CGAL::to_double(geo.vertices[i0].y) / 100.0 };
-                Vec2 uv1 = { CGAL::to_double(geo.vertices[i1].x) / 100.0, CGAL::to_double(geo.vertices[i1].y) / 100.0 };
-                Vec2 uv2 = { CGAL::to_double(geo.vertices[i2].x) / 100.0, CGAL::to_double(geo.vertices[i2].y) / 100.0 };
-                
-                Vec3 normal = (p1 - p0).cross(p2 - p0).normalized();
-                double brightness = (normal.x + normal.y + normal.z + 1.5) / 4.5 + 0.3;
-                ColorRGBA lit_color = {
-                    (unsigned char)std::min(255.0, base_color.r * brightness),
-                    (unsigned char)std::min(255.0, base_color.g * brightness),
-                    (unsigned char)std::min(255.0, base_color.b * brightness),
-                    base_color.a
-                };
-                triangles.push_back({{p0, p1, p2}, {uv0, uv1, uv2}, normal, lit_color, active_texture, (p0.z + p1.z + p2.z) / 3.0});
-            };
-
-            for (const auto& f : geo.faces) Triangulation::triangulate_face(f, pts, add_tri);
-            for (const auto& t : geo.triangles) add_tri(t[0], t[1], t[2]);
-            for (const auto& s_wire : geo.segments) {
-                wireframe.push_back({pts[s_wire[0]], pts[s_wire[1]], base_color});
-            }
+            sources.push_back(s.geometry.value());
+            scene.items.push_back({nullptr, s.geometry.value(), ViewTransform::from(current_tf), base_color, active_texture, material});
         }
         for (const auto& child : s.components) self(self, child, next_color);
     };
 
     collect(collect, shape, "");
-    if (triangles.empty() && wireframe.empty()) return {};
 
-    // 2. Global View Setup
-    double min_x = 1e9, max_x = -1e9, min_y = 1e9, max_y = -1e9;
-    for (const auto& tri : triangles) {
-        for (int i = 0; i < 3; ++i) {
-            min_x = std::min(min_x, tri.p[i].x); max_x = std::max(max_x, tri.p[i].x);
-            min_y = std::min(min_y, tri.p[i].y); max_y = std::max(max_y, tri.p[i].y);
+    if (lod_extent > 0 && !sources.empty()) {
+        // The renderer fits the scene bounds to the frame, so an item spans
+        // roughly its share of the scene diagonal times the frame extent.
+        std::map<fs::CID, Lod::Info> infos;
+        std::vector<double> diagonals(sources.size());
+        double lo[3] = {1e18, 1e18, 1e18}, hi[3] = {-1e18, -1e18, -1e18};
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            auto info = infos.find(sources[i]);
+            if (info == infos.end()) info = infos.emplace(sources[i], Lod::info(vfs, sources[i])).first;
+            const double* m = scene.items[i].placement.m;
+            double item_lo[3] = {1e18, 1e18, 1e18}, item_hi[3] = {-1e18, -1e18, -1e18};
+            for (int corner = 0; corner < 8; ++corner) {
+                double x = (corner & 1) ? info->second.max[0] : info->second.min[0];
+                double y = (corner & 2) ? info->second.max[1] : info->second.min[1];
+                double z = (corner & 4) ? info->second.max[2] : info->second.min[2];
+                for (int a = 0; a < 3; ++a) {
+                    double w = m[a * 4] * x + m[a * 4 + 1] * y + m[a * 4 + 2] * z + m[a * 4 + 3];
+                    item_lo[a] = std::min(item_lo[a], w); item_hi[a] = std::max(item_hi[a], w);
+                }
+            }
+            double d2 = 0;
+            for (int a = 0; a < 3; ++a) {
+                d2 += (item_hi[a] - item_lo[a]) * (item_hi[a] - item_lo[a]);
+                lo[a] = std::min(lo[a], item_lo[a]); hi[a] = std::max(hi[a], item_hi[a]);
+            }
+            diagonals[i] = std::sqrt(d2);
+        }
+        double scene_diagonal = std::sqrt((hi[0] - lo[0]) * (hi[0] - lo[0]) + (hi[1] - lo[1]) * (hi[1] - lo[1]) +
+                                          (hi[2] - lo[2]) * (hi[2] - lo[2]));
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            double extent = scene_diagonal > 0 ? 0.9 * lod_extent * diagonals[i] / scene_diagonal : lod_extent;
+            int level = Lod::select(infos[sources[i]].triangles, extent);
+            if (level > 0) sources[i] = Lod::geometry(vfs, sources[i], level);
         }
     }
-    for (const auto& wf : wireframe) {
-        min_x = std::min({min_x, wf.p0.x, wf.p1.x});
-        max_x = std::max({max_x, wf.p0.x, wf.p1.x});
-        min_y = std::min({min_y, wf.p0.y, wf.p1.y});
-        max_y = std::max({max_y, wf.p0.y, wf.p1.y});
+
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        // Geometry shared between components resolves its render buffer once.
+        auto cached = scene.buffers.find(sources[i]);
+        if (cached == scene.buffers.end()) {
+            cached = scene.buffers.emplace(sources[i], RenderBuffer::get(vfs, sources[i])).first;
+        }
+        scene.items[i].buffer = &cached->second;
+        scene.items[i].geometry = sources[i];
     }
+    return scene;
+}
 
-    double scale = 0.9 * std::min(width / (max_x - min_x + 1e-6), height / (max_y - min_y + 1e-6));
-    double offset_x = width / 2.0 - (min_x + max_x) / 2.0 * scale;
-    double offset_y = height / 2.0 - (min_y + max_y) / 2.0 * scale;
+void Rasterizer::project_item(const SceneItem& item, const Camera& cam, std::vector<Vec3>& pts,
+                              std::vector<RenderTriangle>& triangles, std::vector<RenderLine>& wireframe) {
+    const RenderBuffer& buffer = *item.buffer;
+    const ColorRGBA& base_color = item.color;
+    cam.project_batch(item.placement, buffer.positions, pts);
 
-    // 3. Rasterization
+    const std::vector<float>& uvs = buffer.uvs;
+    auto add_tri = [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+        Vec3 p0 = pts[i0], p1 = pts[i1], p2 = pts[i2];
+        Vec2 uv0 = { uvs[i0 * 2], uvs[i0 * 2 + 1] };
+        Vec2 uv1 = { uvs[i1 * 2], uvs[i1 * 2 + 1] };
+        Vec2 uv2 = { uvs[i2 * 2], uvs[i2 * 2 + 1] };
+
+        Vec3 normal = (p1 - p0).cross(p2 - p0).normalized();
+        double brightness = (normal.x + normal.y + normal.z + 1.5) / 4.5 + 0.3;
+        ColorRGBA lit_color = {
+            (unsigned char)std::min(255.0, base_color.r * brightness),
+            (unsigned char)std::min(255.0, base_color.g * brightness),
+            (unsigned char)std::min(255.0, base_color.b * brightness),
+            base_color.a
+        };
+        triangles.push_back({{p0, p1, p2}, {uv0, uv1, uv2}, normal, lit_color, item.texture, (p0.z + p1.z + p2.z) / 3.0});
+    };
+
+    const std::vector<uint32_t>& tris = buffer.triangles;
+    for (std::size_t t = 0; t + 2 < tris.size(); t += 3) add_tri(tris[t], tris[t + 1], tris[t + 2]);
+    const std::vector<uint32_t>& segs = buffer.segments;
+    for (std::size_t w = 0; w + 1 < segs.size(); w += 2) {
+        wireframe.push_back({pts[segs[w]], pts[segs[w + 1]], base_color});
+    }
+}
+
+void Rasterizer::draw_triangles(
+    std::vector<RenderTriangle>& triangles,
+    std::vector<unsigned char>& pixels, std::vector<double>& z_buffer, std::vector<double>* order,
+    int width, int height, const Frame& frame, int tile_threads) {
     std::sort(triangles.begin(), triangles.end(), [](const RenderTriangle& a, const RenderTriangle& b) {
         return a.avg_z < b.avg_z;
     });
+    // Bin triangles into screen tiles, keeping the depth order within each
+    // tile, then rasterize tiles concurrently. Every pixel sees the same
+    // sequence of fragments as a single in-order pass.
+    int tiles_x = (width + kTileSize - 1) / kTileSize;
+    int tiles_y = (height + kTileSize - 1) / kTileSize;
+    std::vector<std::vector<uint32_t>> bins(tiles_x * tiles_y);
+    for (uint32_t t = 0; t < triangles.size(); ++t) {
+        int minX, minY, maxX, maxY;
+        if (!screen_bounds(triangles[t], width, height, frame, minX, minY, maxX, maxY)) continue;
+        for (int ty = minY / kTileSize; ty <= maxY / kTileSize; ++ty) {
+            for (int tx = minX / kTileSize; tx <= maxX / kTileSize; ++tx) bins[ty * tiles_x + tx].push_back(t);
+        }
+    }
+
+    std::atomic<int> next_tile{0};
+    auto worker = [&]() {
+        for (int tile = next_tile++; tile < (int)bins.size(); tile = next_tile++) {
+            int tx = tile % tiles_x, ty = tile / tiles_x;
+            int cx0 = tx * kTileSize, cy0 = ty * kTileSize;
+            int cx1 = std::min(width, cx0 + kTileSize) - 1, cy1 = std::min(height, cy0 + kTileSize) - 1;
+            for (uint32_t t : bins[tile]) {
+                rasterize_triangle(triangles[t], pixels, z_buffer, width, height, frame.scale, frame.offset_x, frame.offset_y,
+                                   cx0, cy0, cx1, cy1, order);
+            }
+        }
+    };
+    int worker_count = tile_threads > 0 ? tile_threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    worker_count = std::min(worker_count, (int)bins.size());
+    std::vector<std::thread> workers;
+    for (int i = 1; i < worker_count; ++i) workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers) w.join();
+}
 
+bool Rasterizer::screen_bounds(const RenderTriangle& tri, int width, int height, const Frame& frame,
+                               int& minX, int& minY, int& maxX, int& maxY) {
+    double xs[3], ys[3];
+    for (int i = 0; i < 3; ++i) {
+        xs[i] = tri.p[i].x * frame.scale + frame.offset_x;
+        ys[i] = (height - 1) - (tri.p[i].y * frame.scale + frame.offset_y);
+    }
+    minX = (int)std::max(0.0, std::floor(std::min({xs[0], xs[1], xs[2]})));
+    maxX = (int)std::min((double)width - 1, std::ceil(std::max({xs[0], xs[1], xs[2]})));
+    minY = (int)std::max(0.0, std::floor(std::min({ys[0], ys[1], ys[2]})));
+    maxY = (int)std::min((double)height - 1, std::ceil(std::max({ys[0], ys[1], ys[2]})));
+    return minX <= maxX && minY <= maxY;
+}
+
+void Rasterizer::extend_bounds(const std::vector<RenderTriangle>& triangles, const std::vector<RenderLine>& wireframe,
+                               Bounds& b) {
     for (const auto& tri : triangles) {
-        rasterize_triangle(tri, pixels, z_buffer, width, height, scale, offset_x, offset_y);
+        for (int i = 0; i < 3; ++i) {
+            b.min_x = std::min(b.min_x, tri.p[i].x); b.max_x = std::max(b.max_x, tri.p[i].x);
+            b.min_y = std::min(b.min_y, tri.p[i].y); b.max_y = std::max(b.max_y, tri.p[i].y);
+        }
+    }
+    for (const auto& wf : wireframe) {
+        b.min_x = std::min({b.min_x, wf.p0.x, wf.p1.x});
+        b.max_x = std::max({b.max_x, wf.p0.x, wf.p1.x});
+        b.min_y = std::min({b.min_y, wf.p0.y, wf.p1.y});
+        b.max_y = std::max({b.max_y, wf.p0.y, wf.p1.y});
+    }
+}
+
+Rasterizer::Frame Rasterizer::fit_frame(const Bounds& b, int width, int height, bool snapped) {
+    Frame frame;
+    frame.scale = 0.9 * std::min(width / (b.max_x - b.min_x + 1e-6), height / (b.max_y - b.min_y + 1e-6));
+    if (snapped) frame.scale = std::exp2(std::floor(std::log2(frame.scale) * kScaleSteps) / kScaleSteps);
+    frame.offset_x = width / 2.0 - (b.min_x + b.max_x) / 2.0 * frame.scale;
+    frame.offset_y = height / 2.0 - (b.min_y + b.max_y) / 2.0 * frame.scale;
+    if (snapped) {
+        frame.offset_x = std::round(frame.offset_x);
+        frame.offset_y = std::round(frame.offset_y);
     }
+    return frame;
+}
+
+void Rasterizer::draw_wireframe(const std::vector<RenderLine>& wireframe, std::vector<unsigned char>& pixels,
+                                int width, int height, const Frame& frame) {
     for (const auto& wf : wireframe) {
-        rasterize_line((int)(wf.p0.x * scale + offset_x), (int)((height - 1) - (wf.p0.y * scale + offset_y)),
-                       (int)(wf.p1.x * scale + offset_x), (int)((height - 1) - (wf.p1.y * scale + offset_y)),
+        rasterize_line((int)(wf.p0.x * frame.scale + frame.offset_x), (int)((height - 1) - (wf.p0.y * frame.scale + frame.offset_y)),
+                       (int)(wf.p1.x * frame.scale + frame.offset_x), (int)((height - 1) - (wf.p1.y * frame.scale + frame.offset_y)),
                        wf.color, pixels, width, height);
     }
+}
+
+std::vector<unsigned char> Rasterizer::rasterize(const Scene& scene, const Camera& cam, int width, int height, int tile_threads,
+                                                bool snapped) {
+    std::vector<RenderTriangle> triangles;
+    std::vector<RenderLine> wireframe;
+    std::vector<Vec3> pts;
+
+    // 1. Projection
+    for (const SceneItem& item : scene.items) project_item(item, cam, pts, triangles, wireframe);
+    if (triangles.empty() && wireframe.empty()) return {};
+
+    std::vector<unsigned char> pixels(width * height * 4, 30);
+    for (int i = 3; i < (int)pixels.size(); i += 4) pixels[i] = 255;
+    std::vector<double> z_buffer(width * height, -1e18);
+
+    // 2. Global View Setup
+    Bounds bounds;
+    extend_bounds(triangles, wireframe, bounds);
+    Frame frame = fit_frame(bounds, width, height, snapped);
+
+    // 3. Rasterization
+    draw_triangles(triangles, pixels, z_buffer, nullptr, width, height, frame, tile_threads);
+    draw_wireframe(wireframe, pixels, width, height, frame);
+
+    return pixels;
+}
+
+namespace {
+
+// A component's opaque fragments inside its screen rectangle: color, depth,
+// and the depth key of the triangle that won each pixel. The rectangle is in
+// pixels relative to the view origin, x right and y down. Uncovered pixels
+// hold a depth of -1e18.
+struct Layer {
+    int x0 = 0, y0 = 0, w = 0, h = 0;
+    std::vector<unsigned char> rgba;
+    std::vector<double> depth;
+    std::vector<double> order;
+
+    std::size_t byte_size() const {
+        return rgba.size() + (depth.size() + order.size()) * sizeof(double);
+    }
+};
+
+struct LayerCacheState {
+    std::mutex mutex;
+    std::size_t capacity = 64u << 20;
+    std::size_t bytes = 0;
+    // Most recently used first.
+    std::list<std::pair<std::string, std::shared_ptr<const Layer>>> entries;
+    std::map<std::string, decltype(entries)::iterator> index;
+
+    void evict() {
+        while (bytes > capacity && !entries.empty()) {
+            bytes -= entries.back().second->byte_size();
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    std::shared_ptr<const Layer> find(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    void insert(const std::string& key, std::shared_ptr<const Layer> layer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index.count(key)) return;
+        entries.emplace_front(key, layer);
+        index[key] = entries.begin();
+        bytes += layer->byte_size();
+        evict();
+    }
+};
+
+LayerCacheState& layer_cache_state() {
+    static LayerCacheState state;
+    return state;
+}
+
+} // namespace
+
+void LayerCache::set_capacity(std::size_t bytes) {
+    LayerCacheState& state = layer_cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.capacity = bytes;
+    state.evict();
+}
+
+std::size_t LayerCache::capacity() {
+    LayerCacheState& state = layer_cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.capacity;
+}
+
+std::size_t LayerCache::size() {
+    LayerCacheState& state = layer_cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.entries.size();
+}
+
+void LayerCache::clear() {
+    LayerCacheState& state = layer_cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.entries.clear();
+    state.index.clear();
+    state.bytes = 0;
+}
+
+std::vector<unsigned char> Rasterizer::rasterize_layered(
+    const Scene& scene, const Camera& cam, int width, int height, int tile_threads) {
+    std::vector<std::vector<RenderTriangle>> item_triangles(scene.items.size());
+    std::vector<RenderTriangle> blended;
+    std::vector<RenderLine> wireframe;
+    std::vector<Vec3> pts;
+
+    // 1. Projection, keeping each component's triangles apart.
+    Bounds bounds;
+    bool empty = true;
+    for (std::size_t i = 0; i < scene.items.size(); ++i) {
+        project_item(scene.items[i], cam, pts, item_triangles[i], wireframe);
+        extend_bounds(item_triangles[i], {}, bounds);
+        empty = empty && item_triangles[i].empty();
+    }
+    if (empty && wireframe.empty()) return {};
+    extend_bounds({}, wireframe, bounds);
+    Frame frame = fit_frame(bounds, width, height, true);
+    // Whole-pixel offsets from the view origin to this frame's canvas.
+    int shift_x = (int)frame.offset_x, shift_y = (height - 1) - (int)frame.offset_y;
+
+    std::vector<unsigned char> pixels(width * height * 4, 30);
+    for (int i = 3; i < (int)pixels.size(); i += 4) pixels[i] = 255;
+    std::vector<double> z_buffer(width * height, -1e18);
+    std::vector<double> order(width * height, -1e18);
+
+    // 2. Opaque components resolve to cached layers, composited by depth.
+    // Ties fall to the later triangle, as in a single depth-sorted pass.
+    LayerCacheState& cache = layer_cache_state();
+    for (std::size_t i = 0; i < scene.items.size(); ++i) {
+        const SceneItem& item = scene.items[i];
+        if (item_triangles[i].empty()) continue;
+        bool opaque = item.color.a == 255 && (!item.texture || item.texture->channels != 4);
+        if (!opaque) {
+            blended.insert(blended.end(), item_triangles[i].begin(), item_triangles[i].end());
+            continue;
+        }
+
+        const double* m = item.placement.m;
+        std::string key = nlohmann::json{
+            {"geometry", item.geometry.value},
+            {"placement", std::vector<double>(m, m + 12)},
+            {"color", {item.color.r, item.color.g, item.color.b, item.color.a}},
+            {"material", item.texture ? item.material : ""},
+            {"camera", {cam.ax, cam.ay}},
+            {"scale", frame.scale}}.dump();
+
+        std::shared_ptr<const Layer> layer = cache.find(key);
+        if (!layer) {
+            // The layer's own canvas covers its triangles at the frame scale,
+            // with the view origin at a whole-pixel offset.
+            double lo_x = 1e18, hi_x = -1e18, lo_y = 1e18, hi_y = -1e18;
+            for (const RenderTriangle& tri : item_triangles[i]) {
+                for (int k = 0; k < 3; ++k) {
+                    lo_x = std::min(lo_x, tri.p[k].x * frame.scale); hi_x = std::max(hi_x, tri.p[k].x * frame.scale);
+                    lo_y = std::min(lo_y, -tri.p[k].y * frame.scale); hi_y = std::max(hi_y, -tri.p[k].y * frame.scale);
+                }
+            }
+            auto built = std::make_shared<Layer>();
+            built->x0 = (int)std::floor(lo_x) - 1;
+            built->y0 = (int)std::floor(lo_y) - 1;
+            built->w = (int)std::ceil(hi_x) + 2 - built->x0;
+            built->h = (int)std::ceil(hi_y) + 2 - built->y0;
+            std::size_t n = (std::size_t)built->w * built->h;
+            built->rgba.assign(n * 4, 0);
+            built->depth.assign(n, -1e18);
+            built->order.assign(n, -1e18);
+            Frame local{frame.scale, -(double)built->x0, (double)(built->h - 1 + built->y0)};
+            std::vector<RenderTriangle> triangles = item_triangles[i];
+            draw_triangles(triangles, built->rgba, built->depth, &built->order, built->w, built->h, local, tile_threads);
+            cache.insert(key, built);
+            layer = built;
+        }
 
-    int len;
-    unsigned char* png_data = stbi_write_png_to_mem(pixels.data(), width * 4, width, height, 4, &len);
-    if (!png_data) return {};
-    std::vector<uint8_t> result(png_data, png_data + len);
-    free(png_data);
-    return result;
+        for (int y = 0; y < layer->h; ++y) {
+            int py = y + layer->y0 + shift_y;
+            if (py < 0 || py >= height) continue;
+            for (int x = 0; x < layer->w; ++x) {
+                int px = x + layer->x0 + shift_x;
+                if (px < 0 || px >= width) continue;
+                std::size_t src = (std::size_t)y * layer->w + x;
+                std::size_t dst = (std::size_t)py * width + px;
+                double depth = layer->depth[src];
+                if (depth == -1e18) continue;
+                if (depth > z_buffer[dst] || (depth == z_buffer[dst] && layer->order[src] >= order[dst])) {
+                    z_buffer[dst] = depth;
+                    order[dst] = layer->order[src];
+                    std::memcpy(&pixels[dst * 4], &layer->rgba[src * 4], 4);
+                }
+            }
+        }
+    }
+
+    // 3. Translucent components blend over the composite, back to front.
+    draw_triangles(blended, pixels, z_buffer, nullptr, width, height, frame, tile_threads);
+    draw_wireframe(wireframe, pixels, width, height, frame);
+
+    return pixels;
+}
+
+std::vector<uint8_t> Rasterizer::encode_png(const std::vector<unsigned char>& pixels, int width, int height) {
+    return ImageEncoder::encode_png_stb(pixels, width, height);
+}
+
+std::vector<uint8_t> Rasterizer::render_png(fs::VFSNode* vfs, const Shape& shape, int width, int height, double ax, double ay,
+                                            const ImageEncoder::Options& encoding, bool layered, bool lod) {
+    Scene scene = collect_scene(vfs, shape, true, lod ? std::min(width, height) : 0);
+    std::vector<unsigned char> pixels = layered && scene.items.size() > 1 && LayerCache::capacity() > 0
+        ? rasterize_layered(scene, Camera(ax, ay), width, height, threads)
+        : rasterize(scene, Camera(ax, ay), width, height, threads, layered);
+    if (pixels.empty()) return {};
+    return ImageEncoder::encode(pixels, width, height, encoding);
+}
+
+std::vector<std::vector<unsigned char>> Rasterizer::render_views(
+    fs::VFSNode* vfs, const Shape& shape, const std::vector<Camera>& cameras, int width, int height, bool lod) {
+    Scene scene = collect_scene(vfs, shape, true, lod ? std::min(width, height) : 0);
+    std::vector<std::vector<unsigned char>> views(cameras.size());
+
+    // Views are independent, so each worker rasterizes whole views serially
+    // rather than splitting every view into tiles.
+    std::atomic<int> next_view{0};
+    auto worker = [&]() {
+        for (int v = next_view++; v < (int)cameras.size(); v = next_view++) {
+            views[v] = rasterize(scene, cameras[v], width, height, 1);
+        }
+    };
+    int worker_count = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    worker_count = std::min(worker_count, (int)cameras.size());
+    std::vector<std::thread> workers;
+    for (int i = 1; i < worker_count; ++i) workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers) w.join();
+    return views;
 }
 
 } // namespace geo
@@ -1,49 +1,101 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <map>
+#include <memory>
 #include "geometry.h"
 #include "camera.h"
 #include "triangulation.h"
+#include "render_buffer.h"
+#include "image_encoder.h"
+#include "texture.h"
 #include "../core/protocols.h"
 
 namespace jotcad {
 namespace geo {
 
-struct ColorRGBA {
-    unsigned char r, g, b, a;
-};
-
-struct Texture {
-    int width, height, channels;
-    std::vector<unsigned char> pixels;
-    
-    ColorRGBA sample(double u, double v) const {
-        if (pixels.empty()) return {255, 255, 255, 255};
-        // Repeat wrapping
-        int x = (int)(std::floor(u * width)) % width;
-        int y = (int)(std::floor(v * height)) % height;
-        if (x < 0) x += width;
-        if (y < 0) y += height;
-        int idx = (y * width + x) * channels;
-        if (channels == 3) return {pixels[idx], pixels[idx+1], pixels[idx+2], 255};
-        if (channels == 4) return {pixels[idx], pixels[idx+1], pixels[idx+2], pixels[idx+3]};
-        return {255, 255, 255, 255};
-    }
-};
-
 class Rasterizer {
 public:
     /**
      * render_png: Standard JotCAD rasterizer.
      * Traverses a Shape hierarchy, resolving geometry via VFS and applying
-     * color tags to produce a depth-buffered PNG.
+     * color tags to produce a depth-buffered PNG (or QOI, per encoding).
+     * layered opts into compositing multi-component scenes from LayerCache,
+     * with the framing snapped so that small bounds changes keep it.
+     * lod opts into drawing dense meshes from decimated levels sized to the
+     * frame; a cold level is built on the first such render.
      */
     static std::vector<uint8_t> render_png(
         fs::VFSNode* vfs,
         const Shape& shape,
-        int width = 256, int height = 256, double ax = 0.0, double ay = 0.0);
+        int width = 256, int height = 256, double ax = 0.0, double ay = 0.0,
+        const ImageEncoder::Options& encoding = ImageEncoder::Options(),
+        bool layered = false, bool lod = false);
+
+    /**
+     * render_views: Rasterizes one collected scene from each camera, in
+     * parallel, returning raw RGBA pixels per view (empty if nothing drew).
+     * lod is as for render_png.
+     */
+    static std::vector<std::vector<unsigned char>> render_views(
+        fs::VFSNode* vfs,
+        const Shape& shape,
+        const std::vector<Camera>& cameras,
+        int width = 256, int height = 256, bool lod = false);
+
+    // A placed geometry with its resolved color, opacity and material.
+    struct SceneItem {
+        const RenderBuffer* buffer;
+        fs::CID geometry;  // The geometry (or level of detail) the buffer draws
+        ViewTransform placement;
+        ColorRGBA color;
+        const Texture* texture;
+        std::string material;
+    };
+
+    struct Scene {
+        std::map<fs::CID, RenderBuffer> buffers;
+        std::map<std::string, std::shared_ptr<const Texture>> textures;  // By material, from TextureCache
+        std::vector<SceneItem> items;
+    };
+
+    /**
+     * collect_scene: Resolves the shape tree into placed render buffers,
+     * applying the color, opacity and material tags as the renderer sees them.
+     * Exporters that do not sample textures can skip loading them.
+     * A positive lod_extent (the frame size in pixels) draws dense meshes
+     * from a decimated level sized to their footprint; 0 keeps full detail.
+     */
+    static Scene collect_scene(fs::VFSNode* vfs, const Shape& shape, bool load_textures = true, int lod_extent = 0);
+
+    static std::vector<uint8_t> encode_png(const std::vector<unsigned char>& pixels, int width, int height);
+
+    /**
+     * threads: Worker threads used to rasterize screen tiles.
+     * 0 selects the hardware concurrency. The image does not depend on it.
+     */
+    static int threads;
 
 private:
+    static constexpr int kTileSize = 64;
+    // Layered frames snap their scale to steps of 2^(1/kScaleSteps).
+    static constexpr int kScaleSteps = 8;
+
+    static std::vector<unsigned char> rasterize(
+        const Scene& scene, const Camera& cam, int width, int height, int tile_threads, bool snapped = false);
+
+    /**
+     * rasterize_layered: As rasterize with a snapped frame, but each opaque
+     * component is drawn into a color and depth layer held in LayerCache
+     * under its geometry, placement, color, material, camera and frame
+     * scale. Layers sit in pixel coordinates relative to the view origin, so
+     * re-framing by whole pixels reuses them; an edit rasterizes only the
+     * components whose key changed, then composites by depth. Translucent
+     * components are drawn over the result.
+     */
+    static std::vector<unsigned char> rasterize_layered(
+        const Scene& scene, const Camera& cam, int width, int height, int tile_threads);
+
     struct RenderTriangle {
         Vec3 p[3];
         Vec2 uv[3];
@@ -58,15 +110,62 @@ private:
         ColorRGBA color;
     };
 
+    struct Bounds {
+        double min_x = 1e9, max_x = -1e9, min_y = 1e9, max_y = -1e9;
+    };
+
+    // Maps projected x, y to pixels.
+    struct Frame {
+        double scale, offset_x, offset_y;
+    };
+
+    static void project_item(const SceneItem& item, const Camera& cam, std::vector<Vec3>& pts,
+                             std::vector<RenderTriangle>& triangles, std::vector<RenderLine>& wireframe);
+    static void extend_bounds(const std::vector<RenderTriangle>& triangles, const std::vector<RenderLine>& wireframe,
+                              Bounds& bounds);
+    // snapped rounds the scale down to a kScaleSteps step and the offsets to whole pixels.
+    static Frame fit_frame(const Bounds& bounds, int width, int height, bool snapped = false);
+    static bool screen_bounds(const RenderTriangle& tri, int width, int height, const Frame& frame,
+                              int& minX, int& minY, int& maxX, int& maxY);
+
+    /**
+     * draw_triangles: Depth-sorts triangles and rasterizes them tile by tile.
+     * When order is given, opaque fragments record their triangle's depth key.
+     */
+    static void draw_triangles(
+        std::vector<RenderTriangle>& triangles,
+        std::vector<unsigned char>& pixels, std::vector<double>& z_buffer, std::vector<double>* order,
+        int width, int height, const Frame& frame, int tile_threads);
+    static void draw_wireframe(const std::vector<RenderLine>& wireframe, std::vector<unsigned char>& pixels,
+                               int width, int height, const Frame& frame);
+
+    /**
+     * rasterize_triangle: Shades the pixels of tri inside the clip rectangle
+     * [clip_x0, clip_x1] x [clip_y0, clip_y1].
+     */
     static void rasterize_triangle(
         const RenderTriangle& tri,
         std::vector<unsigned char>& pixels, std::vector<double>& z_buffer,
-        int width, int height, double scale, double offset_x, double offset_y);
+        int width, int height, double scale, double offset_x, double offset_y,
+        int clip_x0, int clip_y0, int clip_x1, int clip_y1, std::vector<double>* order = nullptr);
 
     static void rasterize_line(
         int x0, int y0, int x1, int y1, ColorRGBA col,
         std::vector<unsigned char>& pixels, int width, int height);
 };
 
+/**
+ * LayerCache: Process-wide opaque component layers for layered renders,
+ * least recently used evicted beyond a byte capacity (64 MiB by default).
+ * A capacity of 0 turns layered renders into snapped direct renders.
+ */
+class LayerCache {
+public:
+    static void set_capacity(std::size_t bytes);
+    static std::size_t capacity();
+    static std::size_t size();
+    static void clear();
+};
+
 } // namespace geo
 } // namespace jotcad
@@ -0,0 +1,115 @@
+#include "render_buffer.h"
+#include <cmath>
+#include <cstring>
+#include "camera.h"
+#include "triangulation.h"
+
+namespace jotcad {
+namespace geo {
+
+namespace {
+
+const char kMagic[4] = {'J', 'R', 'B', '1'};
+
+template <typename T>
+void append(std::vector<uint8_t>& out, const std::vector<T>& values) {
+    std::size_t offset = out.size();
+    out.resize(offset + values.size() * sizeof(T));
+    if (!values.empty()) std::memcpy(out.data() + offset, values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool extract(const std::vector<uint8_t>& in, std::size_t& offset, std::size_t count, std::vector<T>& values) {
+    if (in.size() - offset < count * sizeof(T)) return false;
+    values.resize(count);
+    if (count) std::memcpy(values.data(), in.data() + offset, count * sizeof(T));
+    offset += count * sizeof(T);
+    return true;
+}
+
+} // namespace
+
+RenderBuffer RenderBuffer::build(const Geometry& geo, Precision precision) {
+    RenderBuffer buffer;
+    std::vector<Vec3> pts;
+    pts.reserve(geo.vertices.size());
+    buffer.positions.reserve(geo.vertices.size() * 3);
+    buffer.uvs.reserve(geo.vertices.size() * 2);
+    for (const auto& v : geo.vertices) {
+        Vec3 p{CGAL::to_double(v.x), CGAL::to_double(v.y), CGAL::to_double(v.z)};
+        pts.push_back(p);
+        buffer.positions.insert(buffer.positions.end(), {(float)p.x, (float)p.y, (float)p.z});
+        buffer.uvs.insert(buffer.uvs.end(), {(float)(p.x / 100.0), (float)(p.y / 100.0)});
+    }
+
+    auto add_tri = [&](int i0, int i1, int i2) {
+        const Vertex& a = geo.vertices[i0];
+        const Vertex& b = geo.vertices[i1];
+        const Vertex& c = geo.vertices[i2];
+        if (CGAL::collinear(EK::Point_3(a.x, a.y, a.z), EK::Point_3(b.x, b.y, b.z), EK::Point_3(c.x, c.y, c.z))) return;
+        Vec3 n = (pts[i1] - pts[i0]).cross(pts[i2] - pts[i0]).normalized();
+        buffer.triangles.insert(buffer.triangles.end(), {(uint32_t)i0, (uint32_t)i1, (uint32_t)i2});
+        buffer.normals.insert(buffer.normals.end(), {(float)n.x, (float)n.y, (float)n.z});
+    };
+
+    for (const auto& f : geo.faces) {
+        if (precision == Precision::Exact) {
+            Triangulation::triangulate_face(f, pts, add_tri);
+        } else {
+            Triangulation::triangulate_face_display(f, pts, add_tri);
+        }
+    }
+    for (const auto& t : geo.triangles) add_tri(t[0], t[1], t[2]);
+    for (const auto& s : geo.segments) {
+        buffer.segments.insert(buffer.segments.end(), {(uint32_t)s[0], (uint32_t)s[1]});
+    }
+    return buffer;
+}
+
+std::vector<uint8_t> RenderBuffer::encode() const {
+    std::vector<uint8_t> out(kMagic, kMagic + 4);
+    append(out, std::vector<uint32_t>{(uint32_t)vertex_count(), (uint32_t)triangle_count(), (uint32_t)(segments.size() / 2)});
+    append(out, positions);
+    append(out, uvs);
+    append(out, normals);
+    append(out, triangles);
+    append(out, segments);
+    return out;
+}
+
+bool RenderBuffer::decode(const std::vector<uint8_t>& bytes, RenderBuffer& out) {
+    if (bytes.size() < 16 || std::memcmp(bytes.data(), kMagic, 4) != 0) return false;
+    std::size_t offset = 4;
+    std::vector<uint32_t> counts;
+    if (!extract(bytes, offset, 3, counts)) return false;
+    std::size_t vertices = counts[0], tris = counts[1], segs = counts[2];
+    return extract(bytes, offset, vertices * 3, out.positions) &&
+           extract(bytes, offset, vertices * 2, out.uvs) &&
+           extract(bytes, offset, tris * 3, out.normals) &&
+           extract(bytes, offset, tris * 3, out.triangles) &&
+           extract(bytes, offset, segs * 2, out.segments) &&
+           offset == bytes.size();
+}
+
+fs::Selector RenderBuffer::key(const fs::CID& geometry, Precision precision) {
+    const char* kind = precision == Precision::Exact ? "export_buffer" : "render_buffer";
+    return Derived::key(kind, {{"geometry", geometry.value}, {"version", kVersion}});
+}
+
+RenderBuffer RenderBuffer::get(fs::VFSNode* vfs, const fs::CID& geometry, Precision precision) {
+    RenderBuffer buffer;
+    if (auto cached = Derived::lookup(vfs, key(geometry, precision))) {
+        try {
+            if (decode(vfs->read<std::vector<uint8_t>>(*cached), buffer)) return buffer;
+        } catch (...) {
+            // Missing or unreadable artifact: rebuild below.
+        }
+        buffer = RenderBuffer{};
+    }
+    buffer = build(vfs->read<Geometry>(geometry), precision);
+    Derived::store(vfs, key(geometry, precision), vfs->materialize<std::vector<uint8_t>>(buffer.encode()));
+    return buffer;
+}
+
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "geometry.h"
+#include "../core/derived.h"
+
+namespace jotcad {
+namespace geo {
+
+/**
+ * RenderBuffer: Render-ready triangles for one geometry, in its local frame.
+ *
+ * Faces are triangulated once and stored as float32 positions and UVs per
+ * vertex, a unit normal per triangle, and triangle and segment indices.
+ * The encoded buffer is a derived artifact of the geometry CID. Display
+ * buffers use the inexact display triangulation; exact buffers run every
+ * face through the exact CDT and serve exporters such as jot/stl.
+ */
+struct RenderBuffer {
+    static constexpr uint32_t kVersion = 2;
+
+    enum class Precision { Display, Exact };
+
+    std::vector<float> positions;     // x, y, z per vertex
+    std::vector<float> uvs;           // u, v per vertex
+    std::vector<float> normals;       // x, y, z per triangle
+    std::vector<uint32_t> triangles;  // 3 vertex indices per triangle
+    std::vector<uint32_t> segments;   // 2 vertex indices per segment
+
+    std::size_t vertex_count() const { return positions.size() / 3; }
+    std::size_t triangle_count() const { return triangles.size() / 3; }
+
+    // Triangulates faces and copies explicit triangles, dropping collinear ones.
+    static RenderBuffer build(const Geometry& geo, Precision precision = Precision::Display);
+
+    std::vector<uint8_t> encode() const;
+    static bool decode(const std::vector<uint8_t>& bytes, RenderBuffer& out);
+
+    static fs::Selector key(const fs::CID& geometry, Precision precision = Precision::Display);
+
+    /**
+     * get: The buffer for a geometry CID, built and stored on first use.
+     */
+    static RenderBuffer get(fs::VFSNode* vfs, const fs::CID& geometry, Precision precision = Precision::Display);
+};
+
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,165 @@
+#include "texture.h"
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include "../../fs/cpp/cid.h"
+#include "../../fs/cpp/vendor/stb_image.h"
+
+namespace jotcad {
+namespace geo {
+
+Texture Texture::decode(const std::vector<uint8_t>& bytes) {
+    Texture tex;
+    if (bytes.empty()) return tex;
+    int w, h, channels;
+    unsigned char* data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &w, &h, &channels, 4);
+    if (!data) return tex;
+    tex.width = w;
+    tex.height = h;
+    tex.channels = channels;
+
+    Level base;
+    base.width = w;
+    base.height = h;
+    base.rgba.assign(data, data + (std::size_t)w * h * 4);
+    stbi_image_free(data);
+    tex.levels.push_back(std::move(base));
+
+    while (tex.levels.back().width > 1 || tex.levels.back().height > 1) {
+        const Level& src = tex.levels.back();
+        Level dst;
+        dst.width = std::max(1, src.width / 2);
+        dst.height = std::max(1, src.height / 2);
+        dst.rgba.resize((std::size_t)dst.width * dst.height * 4);
+        for (int y = 0; y < dst.height; ++y) {
+            int y0 = std::min(2 * y, src.height - 1), y1 = std::min(2 * y + 1, src.height - 1);
+            for (int x = 0; x < dst.width; ++x) {
+                int x0 = std::min(2 * x, src.width - 1), x1 = std::min(2 * x + 1, src.width - 1);
+                for (int c = 0; c < 4; ++c) {
+                    int sum = src.rgba[((std::size_t)y0 * src.width + x0) * 4 + c] + src.rgba[((std::size_t)y0 * src.width + x1) * 4 + c] +
+                              src.rgba[((std::size_t)y1 * src.width + x0) * 4 + c] + src.rgba[((std::size_t)y1 * src.width + x1) * 4 + c];
+                    dst.rgba[((std::size_t)y * dst.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        tex.levels.push_back(std::move(dst));
+    }
+    for (Level& level : tex.levels) {
+        level.pow2 = (level.width & (level.width - 1)) == 0 && (level.height & (level.height - 1)) == 0;
+    }
+    return tex;
+}
+
+int Texture::level_for(double uv_area, double pixel_area) const {
+    if (levels.size() < 2 || pixel_area <= 0) return 0;
+    double ratio = std::abs(uv_area) * width * height / pixel_area;
+    if (!(ratio >= 4.0)) return 0;
+    return std::min((int)levels.size() - 1, (int)std::floor(0.5 * std::log2(ratio)));
+}
+
+ColorRGBA Texture::sample(double u, double v, int level) const {
+    if (levels.empty()) return {255, 255, 255, 255};
+    const Level& l = levels[std::min(std::max(level, 0), (int)levels.size() - 1)];
+    // Repeat wrapping
+    int x = (int)std::floor(u * l.width);
+    int y = (int)std::floor(v * l.height);
+    if (l.pow2) {
+        x &= l.width - 1;
+        y &= l.height - 1;
+    } else {
+        x %= l.width;
+        y %= l.height;
+        if (x < 0) x += l.width;
+        if (y < 0) y += l.height;
+    }
+    const unsigned char* p = &l.rgba[((std::size_t)y * l.width + x) * 4];
+    return {p[0], p[1], p[2], p[3]};
+}
+
+std::size_t Texture::byte_size() const {
+    std::size_t total = 0;
+    for (const Level& level : levels) total += level.rgba.size();
+    return total;
+}
+
+namespace {
+
+struct CacheState {
+    std::mutex mutex;
+    std::size_t capacity = 256u << 20;
+    std::size_t bytes = 0;
+    // Most recently used first.
+    std::list<std::pair<std::string, std::shared_ptr<const Texture>>> entries;
+    std::map<std::string, decltype(entries)::iterator> index;
+
+    void evict() {
+        while (bytes > capacity && !entries.empty()) {
+            bytes -= entries.back().second->byte_size();
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+};
+
+CacheState& cache_state() {
+    static CacheState state;
+    return state;
+}
+
+} // namespace
+
+std::shared_ptr<const Texture> TextureCache::get(const std::string& key, const std::function<std::vector<uint8_t>()>& load) {
+    CacheState& state = cache_state();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto it = state.index.find(key);
+        if (it != state.index.end()) {
+            state.entries.splice(state.entries.begin(), state.entries, it->second);
+            return it->second->second;
+        }
+    }
+
+    // Load and decode outside the lock; a concurrent miss on the same key
+    // keeps whichever copy is inserted first.
+    auto texture = std::make_shared<const Texture>(Texture::decode(load()));
+    if (texture->empty()) return texture;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.index.find(key);
+    if (it != state.index.end()) return it->second->second;
+    state.entries.emplace_front(key, texture);
+    state.index[key] = state.entries.begin();
+    state.bytes += texture->byte_size();
+    state.evict();
+    return texture;
+}
+
+std::shared_ptr<const Texture> TextureCache::get(const std::vector<uint8_t>& bytes) {
+    return get(fs::vfs_hash256(bytes), [&]() { return bytes; });
+}
+
+void TextureCache::set_capacity(std::size_t bytes) {
+    CacheState& state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.capacity = bytes;
+    state.evict();
+}
+
+std::size_t TextureCache::size() {
+    CacheState& state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.entries.size();
+}
+
+void TextureCache::clear() {
+    CacheState& state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.entries.clear();
+    state.index.clear();
+    state.bytes = 0;
+}
+
+} // namespace geo
+} // namespace jotcad
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jotcad {
+namespace geo {
+
+struct ColorRGBA {
+    unsigned char r, g, b, a;
+};
+
+/**
+ * Texture: A decoded image as an RGBA8 mip chain.
+ *
+ * Level 0 is the source image; each further level box-filters the previous
+ * one down to a single texel. Sampling wraps (repeats) and is nearest within
+ * the chosen level; power-of-two levels wrap with a mask instead of a modulo.
+ */
+struct Texture {
+    struct Level {
+        int width = 0, height = 0;
+        bool pow2 = false;
+        std::vector<unsigned char> rgba;
+    };
+
+    int width = 0, height = 0;
+    int channels = 0;  // Channels in the source image; 4 means it carries alpha
+    std::vector<Level> levels;
+
+    bool empty() const { return levels.empty(); }
+
+    // Decodes an encoded image (PNG, JPEG, ...) and builds its mip chain.
+    static Texture decode(const std::vector<uint8_t>& bytes);
+
+    /**
+     * level_for: The mip level for a triangle covering uv_area of texture
+     * space over pixel_area screen pixels (both as doubled areas).
+     */
+    int level_for(double uv_area, double pixel_area) const;
+
+    ColorRGBA sample(double u, double v, int level = 0) const;
+
+    std::size_t byte_size() const;
+};
+
+/**
+ * TextureCache: Process-wide decoded textures, so repeated renders skip
+ * decoding and mip building. The renderer keys textures by the content hash
+ * of the image its jot/texture selector resolves to, so remapping a material
+ * picks up the new image. Images that fail to decode are not kept. Least
+ * recently used textures are evicted beyond the byte capacity.
+ */
+class TextureCache {
+public:
+    // The texture cached under key, or the decoded result of load, which is
+    // only cached if it decoded.
+    static std::shared_ptr<const Texture> get(const std::string& key, const std::function<std::vector<uint8_t>()>& load);
+
+    // Keys the bytes by their content hash, for callers that already hold them.
+    static std::shared_ptr<const Texture> get(const std::vector<uint8_t>& bytes);
+
+    static void set_capacity(std::size_t bytes);
+    static std::size_t size();
+    static void clear();
+};
+
+} // namespace geo
+} // namespace jotcad
@@ -1,6 +1,9 @@
 #include "triangulation.h"
 #include <CGAL/mark_domain_in_triangulation.h>
 #include <CGAL/normal_vector_newell_3.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 namespace jotcad {
 namespace geo {
@@ -51,5 +54,156 @@ void Triangulation::triangulate_face(
     }
 }
 
+bool Triangulation::ear_clip(
+    const std::vector<int>& loop,
+    const std::vector<Vec3>& pts,
+    const std::function<void(int, int, int)>& on_triangle) {
+
+    std::size_t n = loop.size();
+    if (n < 3) return false;
+
+    // Newell normal picks the projection plane; dropping its dominant axis
+    // keeps the loop's winding as the sign of the projected area.
+    Vec3 normal{0, 0, 0};
+    for (std::size_t i = 0; i < n; ++i) {
+        const Vec3& a = pts[loop[i]];
+        const Vec3& b = pts[loop[(i + 1) % n]];
+        normal.x += (a.y - b.y) * (a.z + b.z);
+        normal.y += (a.z - b.z) * (a.x + b.x);
+        normal.z += (a.x - b.x) * (a.y + b.y);
+    }
+    double nx = std::abs(normal.x), ny = std::abs(normal.y), nz = std::abs(normal.z);
+    if (nx + ny + nz == 0) return false;
+    int drop = (nx >= ny && nx >= nz) ? 0 : (ny >= nz ? 1 : 2);
+    int u_axis = drop == 0 ? 1 : 0;
+    int v_axis = drop == 2 ? 1 : 2;
+    // The Newell component is twice the area projected onto (y,z), (z,x) or (x,y).
+    double area = drop == 0 ? normal.x : (drop == 1 ? -normal.y : normal.z);
+    double sign = area > 0 ? 1.0 : -1.0;
+
+    std::vector<double> u(n), v(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const Vec3& p = pts[loop[i]];
+        double c[3] = {p.x, p.y, p.z};
+        u[i] = c[u_axis];
+        v[i] = c[v_axis];
+    }
+    auto cross = [&](std::size_t a, std::size_t b, std::size_t c) {
+        return sign * ((u[b] - u[a]) * (v[c] - v[a]) - (v[b] - v[a]) * (u[c] - u[a]));
+    };
+
+    // Ear clipping assumes a simple loop; a crossing loop would come out as
+    // overlapping triangles. Any touching edges, repeated vertices or folds
+    // back along an edge are left to the CDT paths.
+    auto on_segment = [&](std::size_t a, std::size_t b, std::size_t p) {
+        return std::min(u[a], u[b]) <= u[p] && u[p] <= std::max(u[a], u[b]) &&
+               std::min(v[a], v[b]) <= v[p] && v[p] <= std::max(v[a], v[b]);
+    };
+    auto touches = [&](std::size_t a, std::size_t b, std::size_t c, std::size_t d) {
+        double d1 = cross(a, b, c), d2 = cross(a, b, d), d3 = cross(c, d, a), d4 = cross(c, d, b);
+        if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) return true;
+        return (d1 == 0 && on_segment(a, b, c)) || (d2 == 0 && on_segment(a, b, d)) ||
+               (d3 == 0 && on_segment(c, d, a)) || (d4 == 0 && on_segment(c, d, b));
+    };
+    for (std::size_t e = 0; e < n; ++e) {
+        std::size_t a = e, b = (e + 1) % n, c = (e + 2) % n;
+        if (u[a] == u[b] && v[a] == v[b]) return false;
+        // Adjacent edges may only share their common vertex.
+        if (n > 3 && cross(a, b, c) == 0 && (u[a] - u[b]) * (u[c] - u[b]) + (v[a] - v[b]) * (v[c] - v[b]) > 0) return false;
+        for (std::size_t f = e + 2; f < n; ++f) {
+            if (e == 0 && f == n - 1) continue;
+            if (touches(a, b, f, (f + 1) % n)) return false;
+        }
+    }
+
+    std::vector<std::size_t> ring(n);
+    for (std::size_t i = 0; i < n; ++i) ring[i] = i;
+    std::vector<std::array<int, 3>> out;
+    out.reserve(n - 2);
+
+    std::size_t i = 0, stalled = 0;
+    while (ring.size() > 3) {
+        std::size_t m = ring.size();
+        std::size_t a = ring[(i + m - 1) % m], b = ring[i % m], c = ring[(i + 1) % m];
+        bool ear = cross(a, b, c) > 0;
+        for (std::size_t k = 0; ear && k < m; ++k) {
+            std::size_t p = ring[k];
+            if (p == a || p == b || p == c) continue;
+            if (cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0) ear = false;
+        }
+        if (ear) {
+            out.push_back({loop[a], loop[b], loop[c]});
+            ring.erase(ring.begin() + (i % m));
+            stalled = 0;
+        } else {
+            ++i;
+            if (++stalled > m) return false;
+        }
+        i %= ring.size();
+    }
+    if (cross(ring[0], ring[1], ring[2]) <= 0) return false;
+    out.push_back({loop[ring[0]], loop[ring[1]], loop[ring[2]]});
+
+    for (const auto& t : out) on_triangle(t[0], t[1], t[2]);
+    return true;
+}
+
+bool Triangulation::inexact_cdt(
+    const Geometry::Face& f,
+    const std::vector<Vec3>& pts,
+    const std::function<void(int, int, int)>& on_triangle) {
+
+    std::vector<IK::Point_3> loop_pts;
+    loop_pts.reserve(f.loops[0].size());
+    for (int idx : f.loops[0]) loop_pts.emplace_back(pts[idx].x, pts[idx].y, pts[idx].z);
+
+    IK::Vector_3 normal;
+    CGAL::normal_vector_newell_3(loop_pts.begin(), loop_pts.end(), normal);
+    if (normal == CGAL::NULL_VECTOR) return false;
+    IK::Plane_3 plane(loop_pts[0], normal);
+
+    IK_CDT cdt;
+    std::map<IK_CDT::Vertex_handle, int> v_map;
+    std::size_t inserted = 0;
+    try {
+        for (const auto& loop : f.loops) {
+            std::vector<IK_CDT::Vertex_handle> vh;
+            for (int idx : loop) {
+                vh.push_back(cdt.insert(plane.to_2d(IK::Point_3(pts[idx].x, pts[idx].y, pts[idx].z))));
+                v_map[vh.back()] = idx;
+                ++inserted;
+            }
+            if (vh.size() >= 2) {
+                for (size_t i = 0; i < vh.size(); ++i) {
+                    cdt.insert_constraint(vh[i], vh[(i + 1) % vh.size()]);
+                }
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    // Points that collapsed together after rounding need the exact path.
+    if (cdt.number_of_vertices() != inserted) return false;
+
+    CGAL::mark_domain_in_triangulation(cdt);
+    for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
+        if (fit->info().in_domain) {
+            on_triangle(v_map[fit->vertex(0)], v_map[fit->vertex(1)], v_map[fit->vertex(2)]);
+        }
+    }
+    return true;
+}
+
+void Triangulation::triangulate_face_display(
+    const Geometry::Face& f,
+    const std::vector<Vec3>& pts,
+    std::function<void(int, int, int)> on_triangle) {
+
+    if (f.loops.empty() || f.loops[0].size() < 3) return;
+    if (f.loops.size() == 1 && f.loops[0].size() <= kEarClipLimit && ear_clip(f.loops[0], pts, on_triangle)) return;
+    if (inexact_cdt(f, pts, on_triangle)) return;
+    triangulate_face(f, pts, on_triangle);
+}
+
 } // namespace geo
 } // namespace jotcad
@@ -4,6 +4,7 @@
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
 #include <CGAL/Triangulation_face_base_with_info_2.h>
 #include "geometry.h"
+#include "kernel.h"
 #include "camera.h"
 
 namespace jotcad {
@@ -52,6 +53,14 @@ typedef Face_with_info_2<EK, Fb> Fb_with_info;
 typedef CGAL::Triangulation_data_structure_2<Vb, Fb_with_info> TDS;
 typedef CGAL::Constrained_Delaunay_triangulation_2<EK, TDS, Itag> CDT;
 
+// Display CDT: inexact, and throws instead of constructing intersections.
+typedef CGAL::No_constraint_intersection_requiring_constructions_tag IK_Itag;
+typedef CGAL::Triangulation_vertex_base_2<IK> IK_Vb;
+typedef CGAL::Constrained_triangulation_face_base_2<IK> IK_Fb;
+typedef Face_with_info_2<IK, IK_Fb> IK_Fb_with_info;
+typedef CGAL::Triangulation_data_structure_2<IK_Vb, IK_Fb_with_info> IK_TDS;
+typedef CGAL::Constrained_Delaunay_triangulation_2<IK, IK_TDS, IK_Itag> IK_CDT;
+
 struct Triangulation {
     /**
      * triangulate_face: Robustly decomposes a complex face into triangles using CDT.
@@ -60,6 +69,31 @@ struct Triangulation {
         const Geometry::Face& f, 
         const std::vector<Vec3>& projected_pts,
         std::function<void(int, int, int)> on_triangle);
+
+    /**
+     * triangulate_face_display: Display-quality triangulation.
+     * Hole-free loops are ear clipped and other faces use an inexact CDT;
+     * anything either path cannot settle falls back to triangulate_face.
+     */
+    static void triangulate_face_display(
+        const Geometry::Face& f,
+        const std::vector<Vec3>& projected_pts,
+        std::function<void(int, int, int)> on_triangle);
+
+    // Ear clips a single loop. Returns false, emitting nothing, if the loop
+    // is not simple or the clipping gets stuck.
+    static bool ear_clip(
+        const std::vector<int>& loop,
+        const std::vector<Vec3>& pts,
+        const std::function<void(int, int, int)>& on_triangle);
+
+    // Inexact CDT. Returns false, emitting nothing, on intersecting or duplicate input.
+    static bool inexact_cdt(
+        const Geometry::Face& f,
+        const std::vector<Vec3>& pts,
+        const std::function<void(int, int, int)>& on_triangle);
+
+    static constexpr std::size_t kEarClipLimit = 64;
 };
 
 } // namespace geo
@@ -0,0 +1,410 @@
+#include "test_base.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <sys/resource.h>
+
+using namespace jotcad::geo;
+using namespace fs;
+
+/**
+ * bench: Times a fixed set of geometry fixtures and gates them against a
+ * stored baseline.
+ *
+ * Each repetition builds its inputs on a fresh MockVFS, so the VFS result
+ * cache never short-circuits the op under test; only the op's execution is
+ * measured. Process-wide caches (fonts, textures) stay warm after warmup.
+ *
+ *   bench [--reps N] [--warmup N] [--filter TEXT] [--font PATH]
+ *         [--out PATH] [--baseline PATH] [--threshold [METRIC=]RATIO]...
+ *         [--allow-ungated]
+ *
+ * Exits 1 when a metric exceeds its baseline by more than its threshold,
+ * 2 when a fixture fails, and 3 when a selected fixture was skipped or has
+ * no baseline, so the gate did not check it; --allow-ungated only reports
+ * those.
+ */
+
+// Allocation counting: every global operator new is tallied. Aligned
+// allocations bypass these and are not counted.
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocated_bytes{0};
+
+void* counted_malloc(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* counted_new(std::size_t size) {
+    if (void* p = counted_malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return counted_new(size); }
+void* operator new[](std::size_t size) { return counted_new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+double cpu_ms() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    auto ms = [](const timeval& tv) { return tv.tv_sec * 1e3 + tv.tv_usec / 1e3; };
+    return ms(usage.ru_utime) + ms(usage.ru_stime);
+}
+
+// Linux resets the resident high-water mark through clear_refs; elsewhere
+// the peak is process-wide and only ever grows.
+bool reset_peak_rss() {
+    std::ofstream refs("/proc/self/clear_refs");
+    if (!refs.is_open()) return false;
+    refs << "5";
+    refs.flush();
+    return refs.good();
+}
+
+long peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::atol(line.c_str() + 6);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+bool read_file(const std::vector<std::string>& paths, std::vector<uint8_t>& out) {
+    for (const auto& path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) continue;
+        out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !out.empty();
+    }
+    return false;
+}
+
+Shape surface(VFSNode* vfs, std::vector<Vertex> vertices) {
+    Geometry geo;
+    geo.vertices = std::move(vertices);
+    std::vector<int> loop;
+    for (int i = 0; i < (int)geo.vertices.size(); ++i) loop.push_back(i);
+    geo.faces.push_back({{loop}});
+    Shape s;
+    s.geometry = vfs->materialize(geo);
+    s.tags["type"] = "surface";
+    return s;
+}
+
+// Inputs read once and written into each repetition's VFS.
+struct Inputs {
+    std::string font_path;
+    std::vector<uint8_t> hill_png;
+    std::vector<uint8_t> font;
+};
+
+/**
+ * Fixture: prepare loads shared inputs once, returning a reason to skip when
+ * they are unavailable; setup builds a repetition's inputs and returns the
+ * selectors whose execution is timed.
+ */
+struct Fixture {
+    std::string name;
+    std::function<std::string(Inputs&)> prepare;
+    std::function<std::vector<Selector>(MockVFS&, const Inputs&)> setup;
+};
+
+const Selector kHill = Selector{"jot/Image", {{"url", "mock://Trencrom_Hill.png"}}}.with_output("$out");
+const Selector kFont = Selector{"jot/Font", {{"url", "mock://bench_font.ttf"}}}.with_output("$out");
+
+std::vector<Fixture> fixtures() {
+    auto none = [](Inputs&) { return std::string(); };
+    return {
+        // A plate cut by a grid of 48 square through-holes in a single jot/cut.
+        {"perforated_plate", none, [](MockVFS& vfs, const Inputs&) {
+            Selector plate = Selector{"jot/Box", {{"width", 120.0}, {"height", 80.0}, {"depth", 4.0}}}.with_output("$out");
+            Selector hole = Selector{"jot/Box", {{"width", 6.0}, {"height", 6.0}, {"depth", 10.0}}}.with_output("$out");
+            Processor::execute(&vfs, plate);
+            Shape tool = vfs.read<Shape>(hole);
+            nlohmann::json tools = nlohmann::json::array();
+            for (int i = 0; i < 8; ++i) {
+                for (int j = 0; j < 6; ++j) {
+                    tool.tf = Matrix::translate(FT(-49 + 14 * i), FT(-35 + 14 * j), FT(0));
+                    tools.push_back(vfs.materialize(tool));
+                }
+            }
+            return std::vector<Selector>{Selector{"jot/cut", {{"$in", plate}, {"tools", tools}}}.with_output("$out")};
+        }},
+        // jot/relief over the Trencrom Hill heightmap.
+        {"trencrom_relief", [](Inputs& in) {
+            std::vector<std::string> paths;
+            for (std::string dir : {"test/data/", "data/", "geo/test/data/"}) paths.push_back(dir + "Trencrom_Hill.png");
+            return read_file(paths, in.hill_png) ? std::string() : std::string("Trencrom_Hill.png not found");
+        }, [](MockVFS& vfs, const Inputs& in) {
+            vfs.write(kHill, in.hill_png);
+            return std::vector<Selector>{Selector{"jot/relief", {
+                {"$in", kHill.to_json()}, {"width", 200.0}, {"breadth", 200.0}, {"height", 10.0}
+            }}.with_output("$out")};
+        }},
+        // Six lines of running text in one face.
+        {"text_block", [](Inputs& in) {
+            if (!in.font_path.empty()) {
+                return read_file({in.font_path}, in.font) ? std::string() : "font not readable: " + in.font_path;
+            }
+            std::vector<std::string> paths;
+            for (std::string dir : {"test/data/", "data/", "geo/test/data/"}) paths.push_back(dir + "Lato-Regular.ttf");
+            return read_file(paths, in.font) ? std::string() : std::string("Lato-Regular.ttf not found");
+        }, [](MockVFS& vfs, const Inputs& in) {
+            vfs.write(kFont, in.font);
+            std::vector<Selector> lines;
+            for (std::string line : {"Sphinx of black quartz, judge my vow.",
+                                     "The quick brown fox jumps over the lazy dog.",
+                                     "Pack my box with five dozen liquor jugs!",
+                                     "How vexingly quick daft zebras jump.",
+                                     "Jackdaws love my big sphinx of quartz.",
+                                     "0123456789 (){}[] +-*/=<>"}) {
+                lines.push_back(Selector{"jot/text", {{"text", line}, {"font", kFont.to_json()}, {"size", 10.0}}}.with_output("$out"));
+            }
+            return lines;
+        }},
+        // jot/unfold of a faceted orb.
+        {"unfold_orb", none, [](MockVFS& vfs, const Inputs&) {
+            Selector orb = Selector{"jot/Orb", {{"diameter", 40.0}, {"zag", 1.0}}}.with_output("$out");
+            Processor::execute(&vfs, orb);
+            return std::vector<Selector>{Selector{"jot/unfold", {{"$in", orb.to_json()}}}.with_output("$out")};
+        }},
+        // jot/pack of 200 mixed rectangles and triangles onto 400mm sheets.
+        {"pack_200", none, [](MockVFS& vfs, const Inputs&) {
+            Shape parts;
+            parts.tags["type"] = "group";
+            for (int i = 0; i < 200; ++i) {
+                FT w(8 + (i * 37) % 41), h(6 + (i * 53) % 29);
+                if (i % 3 == 2) {
+                    parts.components.push_back(surface(&vfs, {{FT(0), FT(0), FT(0)}, {w, FT(0), FT(0)}, {FT(0), h, FT(0)}}));
+                } else {
+                    parts.components.push_back(surface(&vfs, {{FT(0), FT(0), FT(0)}, {w, FT(0), FT(0)}, {w, h, FT(0)}, {FT(0), h, FT(0)}}));
+                }
+            }
+            Shape sheets;
+            sheets.tags["type"] = "group";
+            for (int i = 0; i < 3; ++i) {
+                FT s(400);
+                sheets.components.push_back(surface(&vfs, {{FT(0), FT(0), FT(0)}, {s, FT(0), FT(0)}, {s, s, FT(0)}, {FT(0), s, FT(0)}}));
+            }
+            Selector pack("jot/pack");
+            pack.parameters["$in"] = parts;
+            pack.parameters["sheet"] = sheets;
+            pack.parameters["spacing"] = 2.0;
+            pack.output = "$out";
+            return std::vector<Selector>{pack};
+        }},
+    };
+}
+
+struct Sample {
+    double wall_ms = 0;
+    double cpu_ms = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+};
+
+Sample run_once(const Fixture& fixture, const Inputs& inputs) {
+    auto vfs = std::make_unique<MockVFS>("bench_" + fixture.name);
+    register_all_ops(vfs.get());
+    std::vector<Selector> selectors = fixture.setup(*vfs, inputs);
+
+    uint64_t allocations = g_allocations.load();
+    uint64_t bytes = g_allocated_bytes.load();
+    double cpu = cpu_ms();
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& sel : selectors) Processor::execute(vfs.get(), sel);
+    auto end = std::chrono::steady_clock::now();
+
+    Sample sample;
+    sample.wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    sample.cpu_ms = cpu_ms() - cpu;
+    sample.allocations = g_allocations.load() - allocations;
+    sample.allocated_bytes = g_allocated_bytes.load() - bytes;
+    return sample;
+}
+
+template <typename T>
+T median(std::vector<T> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// Metrics compared against the baseline, with the default allowed growth.
+std::map<std::string, double> default_thresholds() {
+    return {{"wall_ms", 0.15}, {"cpu_ms", 0.20}, {"peak_rss_kb", 0.10}, {"allocations", 0.05}};
+}
+
+int usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--reps N] [--warmup N] [--filter TEXT] [--font PATH]"
+              << " [--out PATH] [--baseline PATH] [--threshold [METRIC=]RATIO]... [--allow-ungated]" << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int reps = 5, warmup = 1;
+    std::string filter, out_path, baseline_path;
+    Inputs inputs;
+    auto thresholds = default_thresholds();
+    bool allow_ungated = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--allow-ungated") {
+            allow_ungated = true;
+            continue;
+        }
+        if (i + 1 >= argc) return usage(argv[0]);
+        std::string value = argv[++i];
+        if (arg == "--reps") reps = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--warmup") warmup = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--filter") filter = value;
+        else if (arg == "--font") inputs.font_path = value;
+        else if (arg == "--out") out_path = value;
+        else if (arg == "--baseline") baseline_path = value;
+        else if (arg == "--threshold") {
+            size_t eq = value.find('=');
+            if (eq == std::string::npos) {
+                for (auto& [metric, ratio] : thresholds) ratio = std::atof(value.c_str());
+            } else if (thresholds.count(value.substr(0, eq))) {
+                thresholds[value.substr(0, eq)] = std::atof(value.c_str() + eq + 1);
+            } else {
+                std::cerr << "Unknown metric: " << value.substr(0, eq) << std::endl;
+                return usage(argv[0]);
+            }
+        } else return usage(argv[0]);
+    }
+
+    std::cout << "Running Geometry Benchmarks (" << warmup << " warmup, " << reps << " reps)..." << std::endl;
+
+    bool scoped_rss = reset_peak_rss();
+    nlohmann::json results = {
+        {"version", 1},
+        {"reps", reps},
+        {"warmup", warmup},
+        {"hardware_threads", std::thread::hardware_concurrency()},
+        {"peak_rss_scope", scoped_rss ? "fixture" : "process"},
+        {"fixtures", nlohmann::json::object()}
+    };
+    bool failed = false;
+
+    for (const auto& fixture : fixtures()) {
+        if (!filter.empty() && fixture.name.find(filter) == std::string::npos) continue;
+        std::string skip = fixture.prepare(inputs);
+        if (!skip.empty()) {
+            std::cout << "  - " << fixture.name << ": skipped (" << skip << ")" << std::endl;
+            results["fixtures"][fixture.name] = {{"skipped", skip}};
+            continue;
+        }
+        try {
+            for (int i = 0; i < warmup; ++i) run_once(fixture, inputs);
+            if (scoped_rss) reset_peak_rss();
+            std::vector<Sample> samples;
+            for (int i = 0; i < reps; ++i) samples.push_back(run_once(fixture, inputs));
+
+            std::vector<double> wall, cpu, samples_ms;
+            std::vector<uint64_t> allocations, bytes;
+            for (const auto& s : samples) {
+                wall.push_back(s.wall_ms);
+                cpu.push_back(s.cpu_ms);
+                allocations.push_back(s.allocations);
+                bytes.push_back(s.allocated_bytes);
+            }
+            nlohmann::json entry = {
+                {"wall_ms", median(wall)},
+                {"wall_ms_min", *std::min_element(wall.begin(), wall.end())},
+                {"cpu_ms", median(cpu)},
+                {"peak_rss_kb", peak_rss_kb()},
+                {"allocations", median(allocations)},
+                {"allocated_bytes", median(bytes)},
+                {"wall_samples_ms", wall}
+            };
+            results["fixtures"][fixture.name] = entry;
+            std::cout << "  - " << fixture.name << ": " << entry["wall_ms"].get<double>() << " ms wall, "
+                      << entry["cpu_ms"].get<double>() << " ms cpu, " << entry["peak_rss_kb"].get<long>() << " KiB peak, "
+                      << entry["allocations"].get<uint64_t>() << " allocations" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "❌ " << fixture.name << " failed: " << e.what() << std::endl;
+            results["fixtures"][fixture.name] = {{"error", e.what()}};
+            failed = true;
+        }
+    }
+
+    // Compare medians against the baseline. Selected fixtures that were
+    // skipped or that it lacks are ungated; metrics it lacks pass.
+    bool regressed = false, ungated_fail = false;
+    if (!baseline_path.empty()) {
+        std::ifstream file(baseline_path);
+        if (!file.is_open()) {
+            std::cerr << "❌ Baseline not found: " << baseline_path << std::endl;
+            return 2;
+        }
+        nlohmann::json baseline = nlohmann::json::parse(file);
+        nlohmann::json regressions = nlohmann::json::array();
+        nlohmann::json ungated = nlohmann::json::array();
+        const char* mark = allow_ungated ? "⚠️ " : "❌ ";
+        for (auto& [name, entry] : results["fixtures"].items()) {
+            if (entry.contains("skipped")) {
+                std::cout << mark << name << ": skipped, not gated (" << entry["skipped"].get<std::string>() << ")" << std::endl;
+                ungated.push_back(name);
+                continue;
+            }
+            if (!entry.contains("wall_ms")) continue;
+            if (!baseline["fixtures"].contains(name) || !baseline["fixtures"][name].contains("wall_ms")) {
+                std::cout << mark << name << ": no baseline, not gated; run make bench-baseline" << std::endl;
+                ungated.push_back(name);
+                continue;
+            }
+            const auto& base = baseline["fixtures"][name];
+            for (const auto& [metric, threshold] : thresholds) {
+                if (metric == "peak_rss_kb" && baseline.value("peak_rss_scope", "fixture") != results["peak_rss_scope"]) continue;
+                double was = base.value(metric, 0.0);
+                double now = entry[metric].get<double>();
+                if (!(was > 0) || now <= was * (1 + threshold)) continue;
+                std::cout << "❌ " << name << " " << metric << ": " << now << " vs baseline " << was
+                          << " (+" << 100 * (now / was - 1) << "%, limit " << 100 * threshold << "%)" << std::endl;
+                regressions.push_back({{"fixture", name}, {"metric", metric}, {"value", now}, {"baseline", was}});
+            }
+        }
+        results["regressions"] = regressions;
+        results["ungated"] = ungated;
+        regressed = !regressions.empty();
+        ungated_fail = !ungated.empty() && !allow_ungated;
+    }
+
+    if (!out_path.empty()) {
+        std::ofstream out(out_path);
+        out << results.dump(2) << std::endl;
+        std::cout << "  - Results written to " << out_path << std::endl;
+    }
+
+    if (failed) return 2;
+    if (regressed) return 1;
+    if (ungated_fail) return 3;
+    std::cout << "✅ Geometry Benchmarks PASS" << std::endl;
+    return 0;
+}
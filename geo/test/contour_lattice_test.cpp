@@ -0,0 +1,61 @@
+#include "test_base.h"
+#include "render/contour_utils.h"
+
+using namespace jotcad::geo;
+
+int main() {
+    std::cout << "Testing Lattice Contour Tracing..." << std::endl;
+
+    // 1. A 4x4 block of label 1 with a one-pixel hole, padded by label 2.
+    const int W = 8, H = 8, p_w = W + 2, p_h = H + 2;
+    std::vector<int> padded(p_w * p_h, 2);
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            bool block = x >= 2 && x < 6 && y >= 2 && y < 6;
+            padded[(y + 1) * p_w + (x + 1)] = (block && !(x == 3 && y == 3)) ? 1 : 0;
+        }
+    }
+    std::vector<int> targets = {0, 1};
+    std::vector<std::vector<ContourUtils::LatticeSegment>> segments = ContourUtils::marching_triangles(padded, p_w, p_h, H, targets);
+    for (const auto& seg : segments[1]) assert(seg.a != seg.b);
+    std::vector<ContourUtils::LatticeLoop> loops = ContourUtils::weld_lattice(segments[1], ContourUtils::kLatticeScale, 0.0, 0.1);
+    assert(loops.size() == 2);
+    std::cout << "  ✅ Block and hole traced as two loops." << std::endl;
+
+    // 2. Tracing does not depend on the thread count.
+    std::vector<int> noisy(34 * 27);
+    for (int i = 0; i < (int)noisy.size(); ++i) noisy[i] = ((i * 7919) >> 4) % 5;
+    std::vector<int> all = {0, 1, 2, 3, 4};
+    int previous = Raster::threads;
+    Raster::threads = 1;
+    auto serial = ContourUtils::marching_triangles(noisy, 34, 27, 25, all);
+    Raster::threads = 3;
+    auto threaded = ContourUtils::marching_triangles(noisy, 34, 27, 25, all);
+    Raster::threads = previous;
+    for (size_t t = 0; t < all.size(); ++t) {
+        assert(serial[t].size() == threaded[t].size());
+        for (size_t k = 0; k < serial[t].size(); ++k) {
+            assert(serial[t][k].a == threaded[t][k].a && serial[t][k].b == threaded[t][k].b);
+        }
+    }
+    std::cout << "  ✅ Threads agree." << std::endl;
+
+    // 3. Exact polygons are made only from the finished loops.
+    std::vector<std::vector<Polygon>> polys = ContourUtils::trace_components(padded, p_w, p_h, H, targets, 0.0, 0.1, false);
+    assert(polys[1].size() == 2);
+    // Marching triangles cut each outer corner and round the hole.
+    assert(CGAL::abs(polys[1][0].area()) == FT(63) / 4);
+    assert(CGAL::abs(polys[1][1].area()) == FT(3) / 4);
+    std::cout << "  ✅ Component polygons." << std::endl;
+
+    // 4. Welded loose segments keep their exact endpoints, not the 1e-6 grid.
+    EK::Point_2 a(FT(0), FT(0)), b(FT(10), FT(1) / 3), c(FT(2) / 7, FT(10));
+    std::vector<std::pair<EK::Point_2, EK::Point_2>> loose = {{a, b}, {c, a}, {b, c}};
+    std::vector<Polygon> welded = ContourUtils::weld_segments(loose, 0.0, 0.5);
+    assert(welded.size() == 1 && welded[0].size() == 3);
+    for (size_t k = 0; k < welded[0].size(); ++k) assert(welded[0][k] == a || welded[0][k] == b || welded[0][k] == c);
+    std::cout << "  ✅ Welded segments keep exact points." << std::endl;
+
+    std::cout << "✅ Lattice Contour Tracing PASS" << std::endl;
+    return 0;
+}
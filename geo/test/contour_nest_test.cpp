@@ -0,0 +1,73 @@
+#include "test_base.h"
+#include "render/contour_utils.h"
+#include <algorithm>
+#include <random>
+
+using namespace jotcad::geo;
+
+static Polygon square(double x0, double y0, double x1, double y1) {
+    Polygon p;
+    p.push_back(EK::Point_2(x0, y0));
+    p.push_back(EK::Point_2(x1, y0));
+    p.push_back(EK::Point_2(x1, y1));
+    p.push_back(EK::Point_2(x0, y1));
+    return p;
+}
+
+int main() {
+    std::cout << "Testing Contour Nesting..." << std::endl;
+
+    // 1. Concentric rings in a grid of cells, shuffled, against a brute force scan.
+    std::vector<Polygon> polygons;
+    std::mt19937 rng(3);
+    for (int cx = 0; cx < 12; ++cx) {
+        for (int cy = 0; cy < 12; ++cy) {
+            int rings = rng() % 5;
+            for (int k = 0; k < rings; ++k) {
+                polygons.push_back(square(cx * 20 + 2 * k, cy * 20 + 2 * k, cx * 20 + 18 - 2 * k, cy * 20 + 18 - 2 * k));
+            }
+        }
+    }
+    polygons.push_back(square(-5, -5, 245, 245));
+    std::shuffle(polygons.begin(), polygons.end(), rng);
+
+    std::vector<int> depth;
+    std::vector<int> parent = ContourUtils::nest_polygons(polygons, &depth);
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        int count = 0, innermost = -1;
+        for (size_t j = 0; j < polygons.size(); ++j) {
+            if (i == j || polygons[j].bounded_side(polygons[i][0]) != CGAL::ON_BOUNDED_SIDE) continue;
+            ++count;
+            if (innermost == -1 || polygons[innermost].bounded_side(polygons[j][0]) == CGAL::ON_BOUNDED_SIDE) innermost = (int)j;
+        }
+        assert(depth[i] == count);
+        assert(parent[i] == innermost);
+    }
+    std::cout << "  ✅ Nesting of " << polygons.size() << " loops matches a brute force scan." << std::endl;
+
+    // 2. A hole touching its outer at a vertex is settled exactly.
+    Polygon touching;
+    touching.push_back(EK::Point_2(0, 5));
+    touching.push_back(EK::Point_2(5, 2));
+    touching.push_back(EK::Point_2(5, 8));
+    Polygon island;
+    island.push_back(EK::Point_2(4, 4));
+    island.push_back(EK::Point_2(5, 4));
+    island.push_back(EK::Point_2(5, 5));
+    std::vector<Polygon> glyph = {touching, island, square(0, 0, 10, 10)};
+    std::vector<int> glyph_depth;
+    std::vector<int> glyph_parent = ContourUtils::nest_polygons(glyph, &glyph_depth);
+    assert((glyph_parent == std::vector<int>{2, 0, -1}));
+    assert((glyph_depth == std::vector<int>{1, 2, 0}));
+    std::cout << "  ✅ Touching loops." << std::endl;
+
+    // 3. Groups pair each outer with its direct holes.
+    std::vector<FaceGroup> groups = ContourUtils::group_polygons(glyph);
+    assert(groups.size() == 2);
+    assert(groups[0].outer == 1 && groups[0].holes.empty());
+    assert(groups[1].outer == 2 && (groups[1].holes == std::vector<size_t>{0}));
+    std::cout << "  ✅ Face groups." << std::endl;
+
+    std::cout << "✅ Contour Nesting PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "test_base.h"
+#include "render/triangulation.h"
+#include <cmath>
+
+using namespace jotcad::geo;
+
+static double triangles_area(const std::vector<std::array<int, 3>>& tris, const std::vector<Vec3>& pts, Vec3 normal) {
+    double area = 0;
+    for (const auto& t : tris) area += (pts[t[1]] - pts[t[0]]).cross(pts[t[2]] - pts[t[0]]).dot(normal) / 2;
+    return area;
+}
+
+int main() {
+    std::cout << "Testing Display Triangulation..." << std::endl;
+
+    // 1. A concave L in the xz plane is ear clipped with the loop's winding.
+    std::vector<Vec3> l_pts = {{0, 0, 0}, {0, 0, 2}, {1, 0, 2}, {1, 0, 1}, {2, 0, 1}, {2, 0, 0}};
+    std::vector<std::array<int, 3>> tris;
+    auto collect = [&](int a, int b, int c) { tris.push_back({a, b, c}); };
+    assert(Triangulation::ear_clip({0, 1, 2, 3, 4, 5}, l_pts, collect));
+    assert(tris.size() == 4);
+    assert(std::abs(triangles_area(tris, l_pts, Vec3{0, 1, 0}) - 3.0) < 1e-12);
+    std::cout << "  ✅ Concave loop ear clipped." << std::endl;
+
+    // 2. A bow-tie cannot be ear clipped and emits nothing.
+    tris.clear();
+    std::vector<Vec3> bow_pts = {{0, 0, 0}, {2, 2, 0}, {2, 0, 0}, {0, 2, 0}};
+    assert(!Triangulation::ear_clip({0, 1, 2, 3}, bow_pts, collect));
+    assert(tris.empty());
+    std::cout << "  ✅ Self-intersecting loop rejected." << std::endl;
+
+    // 3. A crossing loop with unequal lobes has nonzero area but is still
+    // rejected, and the display path falls back to the exact CDT.
+    std::vector<Vec3> cross_pts = {{0, 0, 0}, {10, 10, 0}, {10, 0, 0}, {0, 6, 0}};
+    assert(!Triangulation::ear_clip({0, 1, 2, 3}, cross_pts, collect));
+    assert(tris.empty());
+    Geometry::Face crossing;
+    crossing.loops = {{0, 1, 2, 3}};
+    std::vector<std::array<int, 3>> crossing_exact;
+    Triangulation::triangulate_face(crossing, cross_pts, [&](int a, int b, int c) { crossing_exact.push_back({a, b, c}); });
+    Triangulation::triangulate_face_display(crossing, cross_pts, collect);
+    assert(tris == crossing_exact);
+    std::cout << "  ✅ Nonzero-area crossing loop falls back." << std::endl;
+
+    // 4. A face with a hole matches the exact CDT's area.
+    tris.clear();
+    std::vector<Vec3> pts = {{0, 0, 0}, {4, 0, 0}, {4, 4, 0}, {0, 4, 0},
+                             {1, 1, 0}, {1, 3, 0}, {3, 3, 0}, {3, 1, 0}};
+    Geometry::Face face;
+    face.loops = {{0, 1, 2, 3}, {4, 5, 6, 7}};
+    std::vector<std::array<int, 3>> exact;
+    Triangulation::triangulate_face(face, pts, [&](int a, int b, int c) { exact.push_back({a, b, c}); });
+    tris.clear();
+    Triangulation::triangulate_face_display(face, pts, collect);
+    assert(tris.size() == exact.size());
+    assert(std::abs(triangles_area(tris, pts, Vec3{0, 0, 1}) - 12.0) < 1e-12);
+    assert(std::abs(triangles_area(exact, pts, Vec3{0, 0, 1}) - 12.0) < 1e-12);
+    std::cout << "  ✅ Holed face matches exact CDT." << std::endl;
+
+    std::cout << "✅ Display Triangulation PASS" << std::endl;
+    return 0;
+}
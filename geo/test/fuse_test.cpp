@@ -44,6 +44,20 @@ int main() {
     // Two non-overlapping 8-vertex boxes fused should have exactly 16 vertices.
     assert(geo_disjoint.vertices.size() == 16);
 
+    // 3. Arrangement engine: three boxes in a row unioned in a single pass.
+    Shape sD = sA;
+    sD.tf = Matrix::translate(FT(10), FT(0), FT(0));
+    Selector fuse_arr = Selector{"jot/fuse", {{"$in", boxA_sel}, {"tools", {boxB_cid, vfs.materialize(sD)}}, {"engine", "arrangement"}}}.with_output("$out");
+    FuseOp<>::execute(&vfs, fuse_arr, sA, {sB, sD}, "arrangement");
+    Shape res_arr = vfs.read<Shape>(fuse_arr);
+    assert(res_arr.geometry.has_value());
+    Geometry geo_arr = vfs.read<Geometry>(res_arr.geometry.value());
+    vfs.verify_well_formed_solid(geo_arr, "Arrangement Fuse");
+    // A and D share a face; B overlaps both: 1000 + 1000 + 1000 - 125 - 125.
+    FT vol_arr = CGAL::Polygon_mesh_processing::volume(boolean::Engine::geometry_to_mesh(geo_arr));
+    std::cout << "  - Arrangement Fused volume: " << CGAL::to_double(vol_arr) << std::endl;
+    assert(vol_arr == FT(2750));
+
     std::cout << "✅ Fuse PASS" << std::endl;
     return 0;
 }
@@ -0,0 +1,56 @@
+#include "test_base.h"
+#include "../box_op.h"
+#include "../glb_op.h"
+#include <cstring>
+
+using namespace jotcad::geo;
+
+static nlohmann::json glb_json(const std::vector<uint8_t>& glb) {
+    uint32_t magic = 0, json_len = 0;
+    std::memcpy(&magic, glb.data(), 4);
+    assert(magic == 0x46546C67);
+    std::memcpy(&json_len, glb.data() + 12, 4);
+    return nlohmann::json::parse(glb.begin() + 20, glb.begin() + 20 + json_len);
+}
+
+int main() {
+    MockVFS vfs("glb_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing GLB Export..." << std::endl;
+
+    fs::Selector box_sel = {"jot/Box/glb", {{"width", 10.0}, {"height", 10.0}, {"depth", 10.0}}};
+    BoxOp<>::execute(&vfs, box_sel, Interval{-5.0, 5.0}, Interval{-5.0, 5.0}, Interval{-5.0, 5.0});
+    Shape box = vfs.read<Shape>(box_sel);
+
+    // 1. Two placements of one box share a mesh; a recolored one gets its own.
+    Shape scene;
+    for (int i = 0; i < 3; ++i) {
+        Shape s = box;
+        s.tf = Matrix::translate(FT(i * 20), FT(0), FT(0));
+        if (i == 2) s.tags["color"] = "#ff0000";
+        scene.components.push_back(s);
+    }
+
+    fs::Selector glb_sel = {"jot/glb/scene", {}};
+    GlbOp<>::execute(&vfs, glb_sel, scene, "scene.glb", false);
+    nlohmann::json doc = glb_json(vfs.read<std::vector<uint8_t>>(glb_sel.with_output("$out")));
+    assert(doc["nodes"].size() == 4);
+    assert(doc["meshes"].size() == 2);
+    assert(doc["materials"].size() == 2);
+    assert(doc["nodes"][2]["mesh"] == doc["nodes"][1]["mesh"]);
+    assert(doc["nodes"][2]["matrix"][12] == 20.0);
+    assert(doc["accessors"][0]["count"] >= 8);
+    std::cout << "  ✅ Instanced meshes and materials." << std::endl;
+
+    // 2. Quantized positions declare the extension.
+    fs::Selector quant_sel = {"jot/glb/quantized", {}};
+    GlbOp<>::execute(&vfs, quant_sel, scene, "scene.glb", true);
+    doc = glb_json(vfs.read<std::vector<uint8_t>>(quant_sel.with_output("$out")));
+    assert(doc["extensionsRequired"][0] == "KHR_mesh_quantization");
+    assert(doc["accessors"][0]["componentType"] == 5122);
+    std::cout << "  ✅ Quantized export." << std::endl;
+
+    std::cout << "✅ GLB Export PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "test_base.h"
+
+using namespace jotcad::geo;
+using namespace fs;
+
+int main() {
+    MockVFS vfs("glyph_cache");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Glyph Cache..." << std::endl;
+
+    std::string font_url = "https://raw.githubusercontent.com/google/fonts/main/ofl/greatvibes/GreatVibes-Regular.ttf";
+    Selector font_addr = Selector{"jot/Font", {{"url", font_url}}}.with_output("$out");
+    Processor::execute(&vfs, font_addr);
+    std::vector<uint8_t> font_bytes = vfs.read<std::vector<uint8_t>>(font_addr);
+    std::shared_ptr<const FontFace> face = FontCache::get(font_bytes);
+    assert(face->valid());
+
+    auto text_geometry = [&](const std::string& text, double tolerance) {
+        Selector addr = Selector{"jot/text", {
+            {"text", text}, {"font", font_addr.to_json()}, {"size", 50.0}, {"tolerance", tolerance}
+        }}.with_output("$out");
+        Processor::execute(&vfs, addr);
+        Shape shape = vfs.read<Shape>(addr);
+        assert(shape.geometry.has_value());
+        return vfs.read<Geometry>(shape.geometry.value());
+    };
+
+    // 1. Each glyph is built once per font, size and tolerance, and kept as
+    // a Derived geometry CID that later strings reuse.
+    Geometry once = text_geometry("o", 0.01);
+    Geometry thrice = text_geometry("ooo", 0.01);
+    assert(FontCache::get(font_bytes) == face);
+    auto entry = Derived::lookup_json(&vfs, TextOp<>::glyph_key(face->cid(), face->glyph_index('o'), 50.0, 0.01));
+    assert(entry && entry->at("cid").is_string());
+    Geometry cached = vfs.read<Geometry>(CID::from_json(entry->at("cid")));
+    assert(once.triangles.size() == cached.triangles.size());
+    assert(thrice.triangles.size() == 3 * cached.triangles.size());
+    std::cout << "  ✅ Glyph geometry reused (" << cached.triangles.size() << " triangles)." << std::endl;
+
+    // 2. Repeats are translated copies, offset by the glyph advance.
+    FT advance = FT(entry->at("advance").get<long>()) * FT(50.0) / (64 * 64);
+    size_t n = cached.vertices.size();
+    for (size_t i = 0; i < n; ++i) {
+        assert(thrice.vertices[n + i].x == cached.vertices[i].x + advance);
+        assert(thrice.vertices[2 * n + i].y == cached.vertices[i].y);
+    }
+    std::cout << "  ✅ Layout by translation." << std::endl;
+
+    // 3. A finer tolerance flattens curves into more segments.
+    Geometry coarse = text_geometry("o", 0.5);
+    Geometry fine = text_geometry("o", 0.001);
+    std::cout << "  - Vertices: " << coarse.vertices.size() << " coarse, " << fine.vertices.size() << " fine" << std::endl;
+    assert(coarse.vertices.size() < once.vertices.size() && once.vertices.size() < fine.vertices.size());
+    std::cout << "  ✅ Adaptive flattening." << std::endl;
+
+    std::cout << "✅ Glyph Cache PASS" << std::endl;
+    return 0;
+}
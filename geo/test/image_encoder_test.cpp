@@ -0,0 +1,103 @@
+#include "test_base.h"
+#include "render/image_encoder.h"
+#include "../../fs/cpp/vendor/stb_image.h"
+#include <cstring>
+
+using namespace jotcad::geo;
+using namespace fs;
+
+// Reference QOI decoder (qoiformat.org), independent of the encoder under test.
+static bool decode_qoi(const std::vector<uint8_t>& in, int& width, int& height, std::vector<unsigned char>& rgba) {
+    if (in.size() < 22 || std::memcmp(in.data(), "qoif", 4) != 0) return false;
+    auto u32 = [&](std::size_t at) { return (uint32_t)in[at] << 24 | (uint32_t)in[at + 1] << 16 | (uint32_t)in[at + 2] << 8 | in[at + 3]; };
+    width = (int)u32(4);
+    height = (int)u32(8);
+    std::size_t count = (std::size_t)width * height, end = in.size() - 8, at = 14;
+    rgba.assign(count * 4, 0);
+    unsigned char index[64][4] = {};
+    unsigned char px[4] = {0, 0, 0, 255};
+    int run = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (run > 0) {
+            --run;
+        } else {
+            if (at >= end) return false;
+            uint8_t b = in[at++];
+            if (b == 0xfe) {
+                px[0] = in[at]; px[1] = in[at + 1]; px[2] = in[at + 2]; at += 3;
+            } else if (b == 0xff) {
+                std::memcpy(px, &in[at], 4); at += 4;
+            } else if ((b & 0xc0) == 0x00) {
+                std::memcpy(px, index[b], 4);
+            } else if ((b & 0xc0) == 0x40) {
+                px[0] += ((b >> 4) & 3) - 2; px[1] += ((b >> 2) & 3) - 2; px[2] += (b & 3) - 2;
+            } else if ((b & 0xc0) == 0x80) {
+                int dg = (b & 0x3f) - 32, next = in[at++];
+                px[0] += dg - 8 + ((next >> 4) & 15); px[1] += dg; px[2] += dg - 8 + (next & 15);
+            } else {
+                run = b & 0x3f;
+            }
+            std::memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        }
+        std::memcpy(&rgba[i * 4], px, 4);
+    }
+    return at == end && std::memcmp(&in[end], "\0\0\0\0\0\0\0\1", 8) == 0;
+}
+
+int main() {
+    MockVFS vfs("image_encoder_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Image Encoders..." << std::endl;
+
+    // 1. A gradient spanning several row blocks, with translucent columns.
+    int W = 300, H = 200;
+    std::vector<unsigned char> pixels(W * H * 4);
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            unsigned char* p = &pixels[(y * W + x) * 4];
+            p[0] = (unsigned char)(x * 255 / W); p[1] = (unsigned char)((y / 16) % 2 ? 200 : 30);
+            p[2] = (unsigned char)(x ^ y); p[3] = x < 20 ? 128 : 255;
+        }
+    }
+
+    // 2. Parallel deflate is lossless and independent of the thread count.
+    std::vector<uint8_t> serial = ImageEncoder::encode(pixels, W, H, {ImageEncoder::Format::Png, 6, 1});
+    std::vector<uint8_t> parallel = ImageEncoder::encode(pixels, W, H, {ImageEncoder::Format::Png, 6, 4});
+    assert(serial == parallel);
+    int w, h, c;
+    unsigned char* decoded = stbi_load_from_memory(parallel.data(), (int)parallel.size(), &w, &h, &c, 4);
+    assert(decoded && w == W && h == H);
+    assert(std::memcmp(decoded, pixels.data(), pixels.size()) == 0);
+    stbi_image_free(decoded);
+    std::cout << "  ✅ zlib PNG round-trips (" << parallel.size() << " bytes)." << std::endl;
+
+    // 3. QOI output for internal previews.
+    std::vector<uint8_t> qoi = ImageEncoder::encode(pixels, W, H, {ImageEncoder::Format::Qoi, -1, 0});
+    assert(std::memcmp(qoi.data(), "qoif", 4) == 0);
+    assert(qoi[12] == 4);
+    std::vector<unsigned char> unpacked;
+    assert(decode_qoi(qoi, w, h, unpacked));
+    assert(w == W && h == H && unpacked == pixels);
+    std::cout << "  ✅ QOI round-trips (" << qoi.size() << " bytes)." << std::endl;
+
+    // 4. jot/png selects the encoder from its parameters.
+    Selector box_addr = Selector{"jot/Box", {{"width", 10.0}, {"height", 10.0}, {"depth", 10.0}}}.with_output("$out");
+    Processor::execute(&vfs, box_addr);
+    Selector qoi_addr = Selector{"jot/png", {{"$in", box_addr}, {"format", "qoi"}}}.with_output("$out");
+    Processor::execute(&vfs, qoi_addr);
+    std::vector<uint8_t> preview = vfs.read<std::vector<uint8_t>>(qoi_addr);
+    assert(preview.size() > 14 && std::memcmp(preview.data(), "qoif", 4) == 0);
+    assert(decode_qoi(preview, w, h, unpacked) && w == 256 && h == 256);
+    bool rejected = false;
+    try {
+        ImageEncoder::options_from("webp", -1);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::cout << "  ✅ jot/png honours format." << std::endl;
+
+    std::cout << "✅ Image Encoders PASS" << std::endl;
+    return 0;
+}
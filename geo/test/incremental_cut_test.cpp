@@ -0,0 +1,85 @@
+#include "test_base.h"
+#include "../box_op.h"
+#include "../cut_op.h"
+
+using namespace jotcad::geo;
+
+static FT cut_volume(MockVFS& vfs, const fs::Selector& sel) {
+    Shape out = vfs.read<Shape>(sel);
+    Geometry res = vfs.read<Geometry>(out.geometry.value());
+    return CGAL::Polygon_mesh_processing::volume(boolean::Engine::geometry_to_mesh(res));
+}
+
+int main() {
+    MockVFS vfs("incremental_cut_test");
+
+    std::cout << "Testing Incremental Cut..." << std::endl;
+
+    // 1. A 40x40x4 plate with six 4x4 through-holes.
+    fs::Selector plate_sel = {"jot/Box/plate", {{"width", 40.0}, {"height", 40.0}, {"depth", 4.0}}};
+    BoxOp<>::execute(&vfs, plate_sel, Interval{-20.0, 20.0}, Interval{-20.0, 20.0}, Interval{-2.0, 2.0});
+    Shape plate = vfs.read<Shape>(plate_sel);
+
+    fs::Selector hole_sel = {"jot/Box/hole", {{"width", 4.0}, {"height", 4.0}, {"depth", 10.0}}};
+    BoxOp<>::execute(&vfs, hole_sel, Interval{-2.0, 2.0}, Interval{-2.0, 2.0}, Interval{-5.0, 5.0});
+    Shape hole = vfs.read<Shape>(hole_sel);
+
+    std::vector<Shape> holes;
+    for (int i = 0; i < 6; ++i) {
+        Shape h = hole;
+        h.tf = Matrix::translate(FT(-15 + i * 6), FT(0), FT(0));
+        holes.push_back(h);
+    }
+
+    fs::Selector first_sel = {"jot/cut/incremental/first", {}};
+    CutOp<>::execute(&vfs, first_sel, plate, holes, false, "incremental");
+    assert(cut_volume(vfs, first_sel) == FT(6400 - 6 * 64));
+    std::cout << "  ✅ Initial cut volume correct." << std::endl;
+
+    // 2. Nudge one hole; the result must match a full pairwise cut.
+    holes[1].tf = Matrix::translate(FT(-9), FT(7), FT(0));
+
+    fs::Selector nudged_sel = {"jot/cut/incremental/nudged", {}};
+    CutOp<>::execute(&vfs, nudged_sel, plate, holes, false, "incremental");
+    fs::Selector pairwise_sel = {"jot/cut/pairwise/nudged", {}};
+    CutOp<>::execute(&vfs, pairwise_sel, plate, holes, false, "pairwise");
+
+    FT nudged_volume = cut_volume(vfs, nudged_sel);
+    assert(nudged_volume == cut_volume(vfs, pairwise_sel));
+    assert(nudged_volume == FT(6400 - 6 * 64));
+    assert(fix::is_geometry_unambiguous(boolean::Engine::geometry_to_mesh(vfs.read<Geometry>(vfs.read<Shape>(nudged_sel).geometry.value()))));
+    std::cout << "  ✅ Nudged cut matches pairwise." << std::endl;
+
+    // 3. Results do not depend on what was cached: a cold cut of the nudged
+    // holes on an empty store yields the same geometry CID.
+    {
+        MockVFS cold("incremental_cut_cold");
+        fs::Selector cold_plate_sel = plate_sel, cold_hole_sel = hole_sel;
+        BoxOp<>::execute(&cold, cold_plate_sel, Interval{-20.0, 20.0}, Interval{-20.0, 20.0}, Interval{-2.0, 2.0});
+        BoxOp<>::execute(&cold, cold_hole_sel, Interval{-2.0, 2.0}, Interval{-2.0, 2.0}, Interval{-5.0, 5.0});
+        CutOp<>::execute(&cold, nudged_sel, cold.read<Shape>(cold_plate_sel), holes, false, "incremental");
+        assert(cold.read<Shape>(nudged_sel).geometry.value() == vfs.read<Shape>(nudged_sel).geometry.value());
+    }
+    std::cout << "  ✅ Warm and cold cuts are identical." << std::endl;
+
+    // 4. Overlapping holes are joined once, cached by their keys alone, and
+    // the cut still matches pairwise.
+    Shape overlap = hole;
+    overlap.tf = Matrix::translate(FT(-13), FT(2), FT(0));
+    holes.push_back(overlap);
+    fs::Selector overlap_sel = {"jot/cut/incremental/overlap", {}};
+    CutOp<>::execute(&vfs, overlap_sel, plate, holes, false, "incremental");
+    fs::Selector overlap_pairwise_sel = {"jot/cut/pairwise/overlap", {}};
+    CutOp<>::execute(&vfs, overlap_pairwise_sel, plate, holes, false, "pairwise");
+    assert(cut_volume(vfs, overlap_sel) == cut_volume(vfs, overlap_pairwise_sel));
+    assert(cut_volume(vfs, overlap_sel) == FT(6400 - 7 * 64 + 2 * 2 * 4));
+
+    Geometry hole_geo = vfs.read<Geometry>(hole.geometry.value());
+    auto key_of = [&](const Shape& h) { return boolean::Engine::make_incremental_tool(hole_geo, hole.geometry.value(), h.tf).key; };
+    assert(Derived::lookup(&vfs, boolean::Engine::incremental_union_key({key_of(holes[0]), key_of(overlap)})).has_value());
+    assert(!Derived::lookup(&vfs, boolean::Engine::incremental_union_key({key_of(holes[1]), key_of(holes[2])})).has_value());
+    std::cout << "  ✅ Overlapping tools are joined and cached as one cluster." << std::endl;
+
+    std::cout << "✅ Incremental Cut PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "test_base.h"
+#include "render/rasterizer.h"
+#include "../box_op.h"
+
+using namespace jotcad::geo;
+
+int main() {
+    MockVFS vfs("incremental_render");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Incremental Re-render..." << std::endl;
+
+    // 1. Three overlapping boxes as separate components.
+    fs::Selector big_sel = {"jot/Box/incremental_big", {{"width", 10.0}}};
+    BoxOp<>::execute(&vfs, big_sel, Interval{-5.0, 5.0}, Interval{-5.0, 5.0}, Interval{-5.0, 5.0});
+    fs::Selector small_sel = {"jot/Box/incremental_small", {{"width", 4.0}}};
+    BoxOp<>::execute(&vfs, small_sel, Interval{-2.0, 2.0}, Interval{-2.0, 2.0}, Interval{-2.0, 2.0});
+    Shape big = vfs.read<Shape>(big_sel);
+    Shape small = vfs.read<Shape>(small_sel);
+
+    Shape assembly;
+    assembly.components.push_back(big);
+    Shape a = small; a.tf = Matrix::translate(FT(4), FT(4), FT(4));
+    Shape b = small; b.tf = Matrix::translate(FT(-4), FT(3), FT(2));
+    assembly.components.push_back(a);
+    assembly.components.push_back(b);
+
+    // Capacity 0 renders a layered request directly, with the same snapped frame.
+    auto direct = [&](const Shape& shape, double ax, double ay) {
+        std::size_t capacity = LayerCache::capacity();
+        LayerCache::set_capacity(0);
+        std::vector<uint8_t> png = Rasterizer::render_png(&vfs, shape, 128, 96, ax, ay, ImageEncoder::Options(), true);
+        LayerCache::set_capacity(capacity);
+        return png;
+    };
+    auto layered = [&](const Shape& shape, double ax, double ay) {
+        return Rasterizer::render_png(&vfs, shape, 128, 96, ax, ay, ImageEncoder::Options(), true);
+    };
+
+    // 2. Layers are opt-in: a default render leaves the cache alone.
+    LayerCache::clear();
+    assert(!Rasterizer::render_png(&vfs, assembly, 128, 96, 0.0, 0.0).empty());
+    assert(LayerCache::size() == 0);
+    std::cout << "  ✅ Default renders do not cache layers." << std::endl;
+
+    // 3. The composited layers match a single depth-sorted pass.
+    for (double angle : {0.0, 0.4}) {
+        std::vector<uint8_t> png = layered(assembly, angle, angle * 1.5);
+        assert(!png.empty() && png == direct(assembly, angle, angle * 1.5));
+    }
+    assert(LayerCache::size() == 6);
+    std::cout << "  ✅ Layered render matches the direct render." << std::endl;
+
+    // 4. An unchanged scene is composited from cached layers alone.
+    layered(assembly, 0.0, 0.0);
+    assert(LayerCache::size() == 6);
+    std::cout << "  ✅ Unchanged components are not re-rasterized." << std::endl;
+
+    // 5. Moving one component in depth rasterizes only its layer.
+    Shape edited = assembly;
+    edited.components[1].tf = Matrix::translate(FT(4), FT(4), FT(3));
+    assert(layered(edited, 0.0, 0.0) == direct(edited, 0.0, 0.0));
+    assert(LayerCache::size() == 7);
+    std::cout << "  ✅ Only the edited component is re-rasterized." << std::endl;
+
+    // 6. A sideways move shifts the scene bounds without crossing a scale
+    // step, so the other components keep their layers.
+    Shape shifted = assembly;
+    shifted.components[2].tf = Matrix::translate(FT(-4.2), FT(3), FT(2));
+    assert(layered(shifted, 0.0, 0.0) == direct(shifted, 0.0, 0.0));
+    assert(LayerCache::size() == 8);
+    std::cout << "  ✅ Bounds changes reuse the other layers." << std::endl;
+
+    // 7. Layers are evicted beyond the byte capacity.
+    LayerCache::set_capacity(1);
+    assert(LayerCache::size() == 0);
+    layered(assembly, 0.0, 0.0);
+    assert(LayerCache::size() == 0);
+    LayerCache::set_capacity(64u << 20);
+    std::cout << "  ✅ Layers are evicted beyond the capacity." << std::endl;
+
+    std::cout << "✅ Incremental Re-render PASS" << std::endl;
+    return 0;
+}
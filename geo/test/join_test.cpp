@@ -30,6 +30,19 @@ int main() {
     // Actually, with corefinement and triangulation it will be quite a few.
     assert(geo3d.vertices.size() > 8);
 
+    // 1b. Arrangement engine must agree with the pairwise union on volume.
+    Selector join3d_arr = Selector{"jot/join", {{"$in", boxA}, {"tools", {boxB_cid}}, {"engine", "arrangement"}}}.with_output("$out");
+    JoinOp<>::execute(&vfs, join3d_arr, vfs.read<Shape>(boxA), {sB}, "arrangement");
+    Shape res3d_arr = vfs.read<Shape>(join3d_arr);
+    assert(res3d_arr.geometry.has_value());
+    Geometry geo3d_arr = vfs.read<Geometry>(res3d_arr.geometry.value());
+    vfs.verify_well_formed_solid(geo3d_arr, "Arrangement Union");
+    FT vol_pairwise = CGAL::Polygon_mesh_processing::volume(boolean::Engine::geometry_to_mesh(geo3d));
+    FT vol_arrangement = CGAL::Polygon_mesh_processing::volume(boolean::Engine::geometry_to_mesh(geo3d_arr));
+    std::cout << "  - Arrangement Union volume: " << CGAL::to_double(vol_arrangement) << std::endl;
+    assert(vol_pairwise == FT(1875));
+    assert(vol_arrangement == vol_pairwise);
+
     // 2. 2D Union: Two overlapping 10x10 rectangles
     Selector rectA = Selector{"jot/Box", {{"width", 10.0}, {"height", 10.0}, {"depth", 0.0}}}.with_output("$out");
     
@@ -0,0 +1,86 @@
+#include "test_base.h"
+#include "render/lod.h"
+#include "render/rasterizer.h"
+#include <cmath>
+
+using namespace jotcad::geo;
+
+int main() {
+    MockVFS vfs("lod_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Level of Detail..." << std::endl;
+
+    // 1. A closed UV sphere of 64 x 128 quads, about 16k triangles.
+    const int rings = 64, sectors = 128;
+    Geometry geo;
+    geo.vertices.push_back({FT(0), FT(0), FT(10)});
+    for (int r = 1; r < rings; ++r) {
+        double phi = M_PI * r / rings;
+        for (int s = 0; s < sectors; ++s) {
+            double theta = 2 * M_PI * s / sectors;
+            geo.vertices.push_back({FT(10 * std::sin(phi) * std::cos(theta)), FT(10 * std::sin(phi) * std::sin(theta)),
+                                    FT(10 * std::cos(phi))});
+        }
+    }
+    geo.vertices.push_back({FT(0), FT(0), FT(-10)});
+    int south = (int)geo.vertices.size() - 1;
+    auto at = [&](int r, int s) { return 1 + (r - 1) * sectors + (s % sectors); };
+    for (int s = 0; s < sectors; ++s) {
+        geo.triangles.push_back({0, at(1, s), at(1, s + 1)});
+        geo.triangles.push_back({south, at(rings - 1, s + 1), at(rings - 1, s)});
+        for (int r = 1; r < rings - 1; ++r) {
+            geo.triangles.push_back({at(r, s), at(r + 1, s), at(r + 1, s + 1)});
+            geo.triangles.push_back({at(r, s), at(r + 1, s + 1), at(r, s + 1)});
+        }
+    }
+    fs::CID cid = vfs.materialize<Geometry>(geo);
+    Shape sphere;
+    sphere.geometry = cid;
+
+    // 2. Level selection follows the footprint.
+    assert(Lod::select(100, 16) == 0);
+    assert(Lod::select(geo.triangles.size(), 4096) == 0);
+    assert(Lod::select(geo.triangles.size(), 64) > 0);
+    assert(Lod::select(1000000, 256) > Lod::select(1000000, 1024));
+    std::cout << "  ✅ Levels follow screen size." << std::endl;
+
+    // 3. Coarser levels are smaller and cached under the source CID.
+    Lod::Info info = Lod::info(&vfs, cid);
+    assert(info.triangles == geo.triangles.size());
+    assert(std::abs(info.max[2] - 10.0) < 1e-6 && std::abs(info.min[2] + 10.0) < 1e-6);
+    fs::Selector level1_key = Derived::key("lod", {{"geometry", cid.value}, {"level", 1}, {"version", Lod::kVersion}});
+    fs::CID level2 = Lod::geometry(&vfs, cid, 2);
+    assert(level2 != cid);
+    // The intermediate level is not built on the way.
+    assert(!Derived::lookup(&vfs, level1_key).has_value());
+    std::size_t coarse = RenderBuffer::get(&vfs, level2).triangle_count();
+    std::cout << "  - level 2: " << coarse << " of " << info.triangles << " triangles" << std::endl;
+    assert(coarse < info.triangles / 4);
+    assert(Lod::geometry(&vfs, cid, 2) == level2);
+    std::cout << "  ✅ Levels decimate and are cached." << std::endl;
+
+    // 4. Thumbnails draw the decimated level; exports keep full detail.
+    Rasterizer::Scene full = Rasterizer::collect_scene(&vfs, sphere);
+    Rasterizer::Scene thumb = Rasterizer::collect_scene(&vfs, sphere, true, 64);
+    assert(full.items.size() == 1 && thumb.items.size() == 1);
+    assert(full.items[0].buffer->triangle_count() == info.triangles);
+    assert(thumb.items[0].buffer->triangle_count() < info.triangles);
+    assert(!Rasterizer::render_png(&vfs, sphere, 64, 64, 0.3, 0.3, ImageEncoder::Options(), false, true).empty());
+    std::cout << "  ✅ Thumbnails use the decimated level." << std::endl;
+
+    // 5. Renders draw full detail unless asked for levels, so a plain render
+    // of a new mesh builds none.
+    Geometry moved = geo;
+    moved.vertices[0] = {FT(0), FT(0), FT(11)};
+    Shape fresh;
+    fresh.geometry = vfs.materialize<Geometry>(moved);
+    assert(!Rasterizer::render_png(&vfs, fresh, 64, 64, 0.3, 0.3).empty());
+    for (int level = 1; level <= Lod::kMaxLevel; ++level) {
+        assert(!Derived::lookup(&vfs, Derived::key("lod", {{"geometry", fresh.geometry->value}, {"level", level}, {"version", Lod::kVersion}})).has_value());
+    }
+    std::cout << "  ✅ Plain renders keep full detail." << std::endl;
+
+    std::cout << "✅ Level of Detail PASS" << std::endl;
+    return 0;
+}
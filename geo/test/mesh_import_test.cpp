@@ -0,0 +1,116 @@
+#include "test_base.h"
+#include "infra/stl.h"
+#include "infra/obj.h"
+#include <cstring>
+#include <sstream>
+
+using namespace jotcad::geo;
+
+int main() {
+    std::cout << "Testing Mesh Import..." << std::endl;
+
+    // 1. An 80x80 grid of quads as binary and ASCII STL, enough facets that
+    // the banded stages below run on several workers.
+    const int N = 80;
+    auto corner = [&](int x, int y) { return std::array<float, 3>{x * 0.5f, y * 0.25f, (float)((x * y) % 5)}; };
+    std::vector<std::array<float, 3>> corners;
+    for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+            for (auto c : {corner(x, y), corner(x + 1, y), corner(x + 1, y + 1), corner(x, y), corner(x + 1, y + 1), corner(x, y + 1)}) {
+                corners.push_back(c);
+            }
+        }
+    }
+    uint32_t count = (uint32_t)(corners.size() / 3);
+    std::vector<uint8_t> binary(84 + count * 50, 0);
+    std::memcpy(binary.data() + 80, &count, 4);
+    std::ostringstream ascii;
+    ascii << "solid grid\n";
+    for (uint32_t i = 0; i < count; ++i) {
+        ascii << " facet normal 0 0 1\n  outer loop\n";
+        for (int k = 0; k < 3; ++k) {
+            std::memcpy(binary.data() + 84 + i * 50 + 12 + k * 12, corners[i * 3 + k].data(), 12);
+            const auto& c = corners[i * 3 + k];
+            ascii << "   Vertex " << c[0] << " " << c[1] << " " << c[2] << "\r\n";
+        }
+        ascii << "  endloop\n endfacet\n";
+    }
+    ascii << "endsolid grid\n";
+    std::string text = ascii.str();
+
+    ImportMesh from_binary, from_ascii;
+    assert(STLReader::read(binary.data(), binary.size(), from_binary));
+    assert(STLReader::read((const uint8_t*)text.data(), text.size(), from_ascii));
+    assert(from_binary.vertex_count() == (N + 1) * (N + 1));
+    assert(from_binary.triangles.size() == count);
+    assert(from_ascii.xyz == from_binary.xyz && from_ascii.triangles == from_binary.triangles);
+    std::cout << "  ✅ STL welded to " << from_binary.vertex_count() << " vertices." << std::endl;
+
+    // 2. Threads agree, also with chunks far smaller than a facet so that
+    // facets straddle chunk boundaries, and Geometry holds the same exact
+    // vertices.
+    int previous = Raster::threads;
+    Raster::threads = 3;
+    ImportMesh threaded, small_chunks;
+    assert(STLReader::read_binary(binary.data(), binary.size(), threaded));
+    assert(MeshImport::word_chunks(text.data(), text.size(), "vertex", 64).size() > count);
+    assert(STLReader::read_ascii(text.data(), text.size(), small_chunks, 64));
+    Raster::threads = previous;
+    assert(threaded.xyz == from_binary.xyz && threaded.triangles == from_binary.triangles);
+    assert(small_chunks.xyz == from_binary.xyz && small_chunks.triangles == from_binary.triangles);
+    Geometry geo;
+    assert(STLReader::read_binary(binary, geo));
+    assert(geo.vertices.size() == from_binary.vertex_count() && geo.vertices[1].x == FT(0.5));
+    std::cout << "  ✅ Threads and chunk sizes agree." << std::endl;
+
+    // 3. ASCII STL reflowed onto one line, and with words split by tabs and
+    // blank lines, parses the same.
+    std::string one_line = text, reflowed;
+    for (char& c : one_line) if (c == '\n' || c == '\r') c = ' ';
+    for (char c : text) reflowed += c == ' ' ? std::string("\t\n") : std::string(1, c);
+    for (const std::string& variant : {one_line, reflowed}) {
+        ImportMesh mesh;
+        assert(STLReader::read_ascii(variant.data(), variant.size(), mesh, 4096));
+        assert(mesh.xyz == from_binary.xyz && mesh.triangles == from_binary.triangles);
+    }
+    std::cout << "  ✅ Single-line and reflowed ASCII STL." << std::endl;
+
+    // 4. OBJ with texture indices, a relative quad and a degenerate face.
+    std::string obj =
+        "# square\n"
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "vn 0 0 1\n"
+        "v 1 1 0\n"
+        "  v 0 1 0\n"
+        "f 1/1 2/2/1 3//1\n"
+        "f -4 -3 -2 -1\n"
+        "f 1 2\n";
+    ImportMesh square;
+    assert(OBJReader::read_text(obj.data(), obj.size(), square));
+    assert(square.vertex_count() == 4 && square.triangles.size() == 3);
+    assert((square.triangles[1] == std::array<int, 3>{0, 1, 2}) && (square.triangles[2] == std::array<int, 3>{0, 2, 3}));
+    std::cout << "  ✅ OBJ faces." << std::endl;
+
+    // 5. Relative faces reaching back across chunk boundaries resolve the
+    // same as in one chunk.
+    std::ostringstream strip;
+    for (int i = 0; i < 200; ++i) {
+        strip << "v " << i << " " << (i % 2) << " 0\n";
+        if (i >= 2) strip << (i % 3 ? "f -3 -2 -1\n" : "f " + std::to_string(i - 1) + " -2 -1\n");
+    }
+    std::string strip_text = strip.str();
+    ImportMesh whole, chunked;
+    assert(OBJReader::read_text(strip_text.data(), strip_text.size(), whole));
+    Raster::threads = 3;
+    assert(MeshImport::line_chunks(strip_text.data(), strip_text.size(), 8).size() > 300);
+    assert(OBJReader::read_text(strip_text.data(), strip_text.size(), chunked, 8));
+    Raster::threads = previous;
+    assert(whole.triangles.size() == 198);
+    for (int i = 2; i < 200; ++i) assert((whole.triangles[i - 2] == std::array<int, 3>{i - 2, i - 1, i}));
+    assert(chunked.xyz == whole.xyz && chunked.triangles == whole.triangles);
+    std::cout << "  ✅ OBJ relative faces across chunks." << std::endl;
+
+    std::cout << "✅ Mesh Import PASS" << std::endl;
+    return 0;
+}
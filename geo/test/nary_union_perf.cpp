@@ -0,0 +1,61 @@
+#include "test_base.h"
+#include "fuse_op.h"
+#include <chrono>
+
+using namespace jotcad::geo;
+using namespace fs;
+
+// Compares the pairwise corefinement loop with the single-pass arrangement
+// engine on a chain of overlapping orbs.
+int main(int argc, char** argv) {
+    MockVFS vfs("nary_union_perf");
+    register_all_ops(&vfs);
+
+    int count = argc > 1 ? std::atoi(argv[1]) : 16;
+    std::cout << "Starting N-ary Union Performance Test (" << count << " orbs)..." << std::endl;
+
+    Selector orb_sel = Selector{"jot/Orb", {{"diameter", 10.0}, {"zag", 1.0}}}.with_output("$out");
+    Shape orb = vfs.read<Shape>(orb_sel);
+
+    std::vector<Shape> shapes;
+    for (int i = 0; i < count; ++i) {
+        Shape s = orb;
+        s.tf = Matrix::translate(FT(i * 6), FT((i % 2) * 3), FT(0));
+        shapes.push_back(s);
+    }
+
+    FT volumes[2];
+    const char* engines[2] = {"pairwise", "arrangement"};
+    for (int e = 0; e < 2; ++e) {
+        Selector fuse_sel = Selector{"jot/Fuse", {{"engine", engines[e]}}}.with_output("$out");
+        fix::RepairTimings repair;
+        auto t_start = std::chrono::high_resolution_clock::now();
+        {
+            fix::RepairTimingScope scope(repair);
+            FusePrimitiveOp<>::execute(&vfs, fuse_sel, shapes, engines[e]);
+        }
+        auto t_end = std::chrono::high_resolution_clock::now();
+
+        Shape res = vfs.read<Shape>(fuse_sel);
+        if (!res.geometry.has_value()) {
+            std::cerr << "❌ " << engines[e] << " produced no geometry." << std::endl;
+            return 1;
+        }
+        Geometry geo = vfs.read<Geometry>(res.geometry.value());
+        volumes[e] = CGAL::Polygon_mesh_processing::volume(boolean::Engine::geometry_to_mesh(geo));
+        std::cout << "  - " << engines[e] << ": " << std::chrono::duration<double>(t_end - t_start).count() << "s"
+                  << ", triangles=" << geo.triangles.size()
+                  << ", volume=" << CGAL::to_double(volumes[e]) << std::endl;
+        std::cout << "    [Repair] " << repair.calls << " calls (" << repair.clean << " clean)"
+                  << ": precheck=" << repair.precheck << "s, manifold=" << repair.manifold
+                  << "s, collisions=" << repair.collisions << "s, triangulate=" << repair.triangulate << "s" << std::endl;
+    }
+
+    if (volumes[0] != volumes[1]) {
+        std::cerr << "❌ Engines disagree on union volume." << std::endl;
+        return 1;
+    }
+
+    std::cout << "✅ N-ary Union Performance Test PASS" << std::endl;
+    return 0;
+}
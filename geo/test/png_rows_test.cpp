@@ -0,0 +1,108 @@
+#include "test_base.h"
+#include "algorithms/png_rows.h"
+#include "../../fs/cpp/vendor/stb_image.h"
+
+extern "C" unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len);
+
+using namespace jotcad::geo;
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int s = 24; s >= 0; s -= 8) out.push_back((uint8_t)(v >> s));
+}
+
+static void put_chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    put_u32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_u32(out, (uint32_t)crc32(0, out.data() + start, (uInt)(data.size() + 4)));
+}
+
+// A PNG of raw filtered rows, with IDAT split into small chunks so that rows
+// straddle them.
+static std::vector<uint8_t> make_png(int w, int h, int depth, int color, const std::vector<uint8_t>& rows,
+                                     const std::vector<uint8_t>& palette = {}) {
+    std::vector<uint8_t> out = {137, 80, 78, 71, 13, 10, 26, 10};
+    std::vector<uint8_t> ihdr;
+    put_u32(ihdr, w);
+    put_u32(ihdr, h);
+    ihdr.insert(ihdr.end(), {(uint8_t)depth, (uint8_t)color, 0, 0, 0});
+    put_chunk(out, "IHDR", ihdr);
+    if (!palette.empty()) put_chunk(out, "PLTE", palette);
+    uLongf len = compressBound(rows.size());
+    std::vector<uint8_t> z(len);
+    compress(z.data(), &len, rows.data(), rows.size());
+    for (size_t at = 0; at < len; at += 7) {
+        put_chunk(out, "IDAT", std::vector<uint8_t>(z.begin() + at, z.begin() + std::min<size_t>(len, at + 7)));
+    }
+    put_chunk(out, "IEND", {});
+    return out;
+}
+
+static void expect_stb(const std::vector<uint8_t>& png, const char* label) {
+    int W, H, channels;
+    unsigned char* ref = stbi_load_from_memory(png.data(), (int)png.size(), &W, &H, &channels, 3);
+    assert(ref);
+    PngRows rows(png.data(), png.size());
+    assert(rows.ok() && rows.width == W && rows.height == H);
+    std::vector<unsigned char> row((size_t)W * 3);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int y = 0; y < H; ++y) {
+            assert(rows.row() == y);
+            rows.read(row.data());
+            assert(std::memcmp(row.data(), ref + (size_t)y * W * 3, row.size()) == 0);
+        }
+        rows.rewind();
+    }
+    stbi_image_free(ref);
+    std::cout << "  ✅ " << label << " matches stb_image." << std::endl;
+}
+
+int main() {
+    std::cout << "Testing Streamed PNG Rows..." << std::endl;
+
+    // 1. stb-written 8-bit images of 1 to 4 channels, which use every filter.
+    const int W = 37, H = 23;
+    for (int n = 1; n <= 4; ++n) {
+        std::vector<unsigned char> pixels((size_t)W * H * n);
+        for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = (unsigned char)((i * 7919) % 251 + (i / (W * n)) * 3);
+        int len = 0;
+        unsigned char* data = stbi_write_png_to_mem(pixels.data(), W * n, W, H, n, &len);
+        assert(data);
+        std::vector<uint8_t> png(data, data + len);
+        free(data);
+        std::string label = std::to_string(n) + "-channel";
+        expect_stb(png, label.c_str());
+    }
+
+    // 2. 16-bit RGB with Paeth rows, and a 2-bit palette with Sub rows.
+    {
+        std::vector<uint8_t> raw;
+        for (int y = 0; y < 5; ++y) {
+            raw.push_back(4);
+            for (int i = 0; i < 9 * 6; ++i) raw.push_back((uint8_t)(y * 31 + i * 17));
+        }
+        expect_stb(make_png(9, 5, 16, 2, raw), "16-bit RGB");
+    }
+    {
+        std::vector<uint8_t> raw;
+        for (int y = 0; y < 6; ++y) {
+            raw.push_back(1);
+            for (int i = 0; i < 3; ++i) raw.push_back((uint8_t)(y * 0x1b + i * 0x55));
+        }
+        expect_stb(make_png(11, 6, 2, 3, raw, {255, 0, 0, 0, 255, 0, 0, 0, 255, 9, 9, 9}), "2-bit palette");
+    }
+
+    // 3. Interlaced and non-PNG input is left to stb_image.
+    {
+        std::vector<uint8_t> png = make_png(4, 4, 8, 0, std::vector<uint8_t>(4 * 5, 0));
+        png[28] = 1;
+        assert(!PngRows(png.data(), png.size()).ok());
+        std::vector<uint8_t> jpeg = {0xff, 0xd8, 0xff, 0xe0};
+        assert(!PngRows(jpeg.data(), jpeg.size()).ok());
+        std::cout << "  ✅ Interlaced and non-PNG input rejected." << std::endl;
+    }
+
+    std::cout << "✅ Streamed PNG Rows PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "test_base.h"
+#include "boolean/classifier.h"
+#include <chrono>
+
+using namespace jotcad::geo;
+using namespace fs;
+
+int main() {
+    MockVFS vfs("point_classifier_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Batched Point Classifier..." << std::endl;
+
+    Selector orb_sel = Selector{"jot/Orb", {{"diameter", 10.0}, {"zag", 1.0}}}.with_output("$out");
+    Shape orb = vfs.read<Shape>(orb_sel);
+    boolean::ExactMesh mesh = boolean::Engine::geometry_to_mesh(vfs.read<Geometry>(orb.geometry.value()));
+    assert(CGAL::is_closed(mesh));
+
+    // 1. A grid through the orb, plus every vertex and face centroid, which
+    //    must take the exact path.
+    std::vector<EK::Point_3> points;
+    for (int x = -12; x <= 12; ++x)
+        for (int y = -12; y <= 12; ++y)
+            for (int z = -12; z <= 12; ++z)
+                points.push_back(EK::Point_3(FT(x) / 2, FT(y) / 2, FT(z) / 2));
+    std::size_t on_surface = 0;
+    for (auto v : mesh.vertices()) { points.push_back(mesh.point(v)); ++on_surface; }
+    for (auto f : mesh.faces()) {
+        auto h = mesh.halfedge(f);
+        points.push_back(CGAL::centroid(mesh.point(mesh.source(h)), mesh.point(mesh.target(h)), mesh.point(mesh.target(mesh.next(h)))));
+        ++on_surface;
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    boolean::PointClassifier classifier(mesh);
+    std::vector<CGAL::Bounded_side> fast = classifier.classify(points);
+    auto t_fast = std::chrono::high_resolution_clock::now();
+
+    CGAL::Side_of_triangle_mesh<boolean::ExactMesh, EK> exact(mesh);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (fast[i] != exact(points[i])) {
+            std::cerr << "❌ Classification mismatch at point " << i << std::endl;
+            return 1;
+        }
+    }
+    auto t_exact = std::chrono::high_resolution_clock::now();
+
+    std::cout << "  - " << points.size() << " points, " << classifier.exact_fallbacks() << " exact fallbacks" << std::endl;
+    std::cout << "  - batched: " << std::chrono::duration<double>(t_fast - t_start).count() << "s"
+              << ", exact: " << std::chrono::duration<double>(t_exact - t_fast).count() << "s" << std::endl;
+    assert(classifier.exact_fallbacks() >= on_surface);
+    assert(classifier.exact_fallbacks() < points.size());
+    std::cout << "  ✅ Matches Side_of_triangle_mesh." << std::endl;
+
+    // The banded pass gives the same sides on any number of threads.
+    int previous = Raster::threads;
+    Raster::threads = 4;
+    assert(boolean::PointClassifier(mesh).classify(points) == fast);
+    Raster::threads = previous;
+    std::cout << "  ✅ Threaded classification matches." << std::endl;
+
+    // 2. The flattened BVH answers ray queries with the originating face.
+    boolean::TriangleBVH bvh = boolean::TriangleBVH::from_mesh(mesh);
+    double origin[3] = {0.0, 0.0, -20.0};
+    double up[3] = {0.0, 0.01, 1.0};
+    auto hit = bvh.first_hit(origin, up);
+    assert(hit.has_value());
+    assert(hit->t > 10.0 && hit->t < 20.0);
+    assert(bvh.any_hit(origin, up));
+    double down[3] = {0.0, 0.01, -1.0};
+    assert(!bvh.any_hit(origin, down));
+    std::cout << "  ✅ Ray queries hit the near side." << std::endl;
+
+    // 3. A ray running within a triangle's plane hits it where it enters;
+    //    an open mesh classifies points on it exactly as on the boundary.
+    boolean::ExactMesh sheet;
+    auto a = sheet.add_vertex(EK::Point_3(0, 0, 0));
+    auto b = sheet.add_vertex(EK::Point_3(10, 0, 0));
+    auto c = sheet.add_vertex(EK::Point_3(0, 10, 0));
+    sheet.add_face(a, b, c);
+    boolean::TriangleBVH flat = boolean::TriangleBVH::from_mesh(sheet);
+    double along[3] = {1.0, 0.0, 0.0};
+    double beside[3] = {-5.0, 1.0, 0.0}, past[3] = {-5.0, 20.0, 0.0};
+    assert(flat.any_hit(beside, along, 1e-3));
+    assert(!flat.any_hit(past, along, 1e-3));
+    boolean::PointClassifier open_classifier(sheet);
+    assert(!open_classifier.is_closed());
+    assert(open_classifier(EK::Point_3(1, 1, 0)) == CGAL::ON_BOUNDARY);
+    assert(open_classifier(EK::Point_3(1, 1, 1)) == CGAL::ON_UNBOUNDED_SIDE);
+    assert(open_classifier(EK::Point_3(8, 8, 0)) == CGAL::ON_UNBOUNDED_SIDE);
+    std::cout << "  ✅ Coplanar rays and open meshes." << std::endl;
+
+    std::cout << "✅ Batched Point Classifier PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "test_base.h"
+#include "algorithms/quantize.h"
+#include <random>
+#include <set>
+
+using namespace jotcad::geo;
+
+int main() {
+    std::cout << "Testing Color Quantization..." << std::endl;
+
+    // 1. As many centers as colors: every color gets its own.
+    unsigned char quad[4 * 3] = {255, 0, 0,  0, 255, 0,  0, 0, 255,  255, 255, 255};
+    ColorQuantizer::Result four = ColorQuantizer::kmeans(quad, 4, 4);
+    assert(four.samples == 4);
+    assert((std::set<int>(four.labels.begin(), four.labels.end()).size() == 4));
+    ColorQuantizer::Result six = ColorQuantizer::kmeans(quad, 4, 6);
+    assert(six.centers.size() == 6);
+    std::cout << "  ✅ Distinct colors keep distinct centers." << std::endl;
+
+    // 2. A noisy image of seven tinted blocks, binned past kMaxSamples.
+    int W = 512, H = 512;
+    std::vector<unsigned char> noisy(W * H * 3);
+    std::mt19937 rng(1);
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            int block = ((x / 64) + (y / 64) * 3) % 7;
+            for (int c = 0; c < 3; ++c) {
+                noisy[(y * W + x) * 3 + c] = (unsigned char)std::clamp(block * 36 + c * 20 + (int)(rng() % 40) - 20, 0, 255);
+            }
+        }
+    }
+    ColorQuantizer::Result binned = ColorQuantizer::kmeans(noisy.data(), W * H, 7);
+    assert(binned.samples <= ColorQuantizer::kMaxSamples);
+    assert((int)binned.labels.size() == W * H);
+    std::cout << "  ✅ Binned " << binned.samples << " samples in " << binned.iterations << " iterations." << std::endl;
+
+    // 3. Binned reds either side of the hue wrap stay red: cells average
+    // their RGB, not their hue. The dark ramp forces binning.
+    std::vector<unsigned char> wrap;
+    for (int i = 0; i < 70000; ++i) wrap.insert(wrap.end(), {(unsigned char)(i & 63), (unsigned char)((i >> 6) & 63), (unsigned char)(i >> 12)});
+    for (int i = 0; i < 20000; ++i) {
+        unsigned char t = (unsigned char)(i % 8);
+        if (i % 2) wrap.insert(wrap.end(), {255, 0, t});
+        else wrap.insert(wrap.end(), {255, t, 0});
+    }
+    int wrap_count = (int)wrap.size() / 3;
+    ColorQuantizer::Result red = ColorQuantizer::kmeans(wrap.data(), wrap_count, 2);
+    assert(red.samples < (std::size_t)wrap_count);
+    const Raster::HSV& red_center = red.centers[red.labels[wrap_count - 1]];
+    assert(std::min(red_center.h, 1.0 - red_center.h) < 0.02);
+    assert(red_center.v > 0.95 && red_center.s > 0.9);
+    std::cout << "  ✅ Binned hues average across the wrap." << std::endl;
+
+    // 4. The result depends on the seed alone, not the thread count.
+    std::vector<unsigned char> ramp(256 * 256 * 3);
+    for (int i = 0; i < 256 * 256; ++i) {
+        ramp[i * 3] = (unsigned char)(i & 255);
+        ramp[i * 3 + 1] = (unsigned char)(i >> 8);
+        ramp[i * 3 + 2] = (unsigned char)((i * 37) & 255);
+    }
+    int previous = Raster::threads;
+    Raster::threads = 1;
+    ColorQuantizer::Result serial = ColorQuantizer::kmeans(ramp.data(), 256 * 256, 7, 9);
+    Raster::threads = 5;
+    ColorQuantizer::Result threaded = ColorQuantizer::kmeans(ramp.data(), 256 * 256, 7, 9);
+    Raster::threads = previous;
+    assert(serial.samples == 256 * 256);
+    assert(serial.labels == threaded.labels);
+    for (int j = 0; j < 7; ++j) {
+        assert(serial.centers[j].h == threaded.centers[j].h);
+        assert(serial.centers[j].s == threaded.centers[j].s);
+        assert(serial.centers[j].v == threaded.centers[j].v);
+    }
+    std::cout << "  ✅ Threads agree." << std::endl;
+
+    std::cout << "✅ Color Quantization PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "test_base.h"
+#include "algorithms/raster.h"
+#include "../../fs/cpp/vendor/stb_image.h"
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <set>
+
+using namespace jotcad::geo;
+using namespace fs;
+
+// Serial reference stages, as relief and trace ran them before algorithms/raster.h.
+namespace reference {
+
+inline std::vector<int> despeckle(const std::vector<int>& labels, int W, int H) {
+    std::vector<int> clean_labels = labels;
+    for (int y = 1; y < H - 1; ++y) {
+        for (int x = 1; x < W - 1; ++x) {
+            std::map<int, int> neighbors;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) neighbors[labels[(y+dy)*W + (x+dx)]]++;
+            }
+            int best = labels[y*W+x], max_c = 0;
+            for (auto const& [id, count] : neighbors) if (count > max_c) { max_c = count; best = id; }
+            if (max_c >= 5) clean_labels[y*W + x] = best;
+        }
+    }
+    return clean_labels;
+}
+
+inline void merge(std::vector<int>& clean_labels, int W, int H, double minArea) {
+    bool changed = true;
+    int passes = 0;
+    while (changed && passes < 5) {
+        changed = false;
+        passes++;
+        std::vector<bool> visited(W * H, false);
+        for (int start_idx = 0; start_idx < W * H; ++start_idx) {
+            if (visited[start_idx]) continue;
+            int target_label = clean_labels[start_idx];
+            std::vector<int> component, queue{start_idx};
+            visited[start_idx] = true;
+            size_t q_head = 0;
+            while (q_head < queue.size()) {
+                int idx = queue[q_head++];
+                component.push_back(idx);
+                int cx = idx % W, cy = idx / W;
+                int dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+                for (int dir = 0; dir < 4; ++dir) {
+                    int nx = cx + dx[dir], ny = cy + dy[dir];
+                    if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
+                        int nidx = ny * W + nx;
+                        if (clean_labels[nidx] == target_label && !visited[nidx]) { visited[nidx] = true; queue.push_back(nidx); }
+                    }
+                }
+            }
+            if (component.size() < (size_t)minArea) {
+                std::set<int> neighbor_labels;
+                for (int idx : component) {
+                    int cx = idx % W, cy = idx / W;
+                    int dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+                    for (int dir = 0; dir < 4; ++dir) {
+                        int nx = cx + dx[dir], ny = cy + dy[dir];
+                        if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
+                            int nidx = ny * W + nx;
+                            if (clean_labels[nidx] != target_label) neighbor_labels.insert(clean_labels[nidx]);
+                        }
+                    }
+                }
+                int best_neighbor = -1, min_dist = 999999;
+                for (int n_lbl : neighbor_labels) {
+                    int d = std::abs(target_label - n_lbl);
+                    if (d < min_dist) { min_dist = d; best_neighbor = n_lbl; }
+                }
+                if (best_neighbor != -1) {
+                    for (int idx : component) clean_labels[idx] = best_neighbor;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+inline int components(const std::vector<int>& clean_labels, int W, int H, std::vector<int>& comp_ids) {
+    comp_ids.assign(W * H, -1);
+    int comp_count = 0;
+    for (int idx = 0; idx < W * H; ++idx) {
+        if (comp_ids[idx] != -1) continue;
+        int lvl = clean_labels[idx];
+        int comp_id = comp_count++;
+        std::vector<int> queue{idx};
+        comp_ids[idx] = comp_id;
+        size_t q_head = 0;
+        while (q_head < queue.size()) {
+            int curr = queue[q_head++];
+            int cx = curr % W, cy = curr / W;
+            int dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+            for (int dir = 0; dir < 4; ++dir) {
+                int nx = cx + dx[dir], ny = cy + dy[dir];
+                if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
+                    int nidx = ny * W + nx;
+                    if (clean_labels[nidx] == lvl && comp_ids[nidx] == -1) { comp_ids[nidx] = comp_id; queue.push_back(nidx); }
+                }
+            }
+        }
+    }
+    return comp_count;
+}
+
+} // namespace reference
+
+static double seconds_since(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Times the shared raster stages against the serial reference on the
+// Trencrom Hill heightmap, checking the labels match, then times jot/relief
+// and jot/trace end to end on the same image.
+int main(int argc, char** argv) {
+    MockVFS vfs("raster_perf");
+    register_all_ops(&vfs);
+
+    std::string path = argc > 1 ? argv[1] : "Heightmap_of_Trencrom_Hill.png";
+    std::ifstream file(path, std::ios::binary);
+    if (!file) file.open("test/" + path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    int W, H, channels;
+    unsigned char* data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &W, &H, &channels, 3);
+    assert(data);
+    std::cout << "Starting Raster Performance Test (" << W << "x" << H << ")..." << std::endl;
+
+    const int levels = 16;
+    std::vector<double> intensity = Raster::intensity(data, W * H);
+    std::vector<int> labels(W * H);
+    for (int i = 0; i < W * H; ++i) labels[i] = std::clamp((int)(intensity[i] * (levels - 1) + 0.5), 0, levels - 1);
+    stbi_image_free(data);
+
+    auto t = std::chrono::high_resolution_clock::now();
+    std::vector<int> ref_clean = reference::despeckle(labels, W, H);
+    double ref_time = seconds_since(t);
+    t = std::chrono::high_resolution_clock::now();
+    std::vector<int> clean = Raster::mode_filter(labels, W, H);
+    std::cout << "[Despeckle] reference " << ref_time << "s, raster " << seconds_since(t) << "s" << std::endl;
+    assert(clean == ref_clean);
+
+    t = std::chrono::high_resolution_clock::now();
+    reference::merge(ref_clean, W, H, 25.0);
+    ref_time = seconds_since(t);
+    t = std::chrono::high_resolution_clock::now();
+    Raster::merge_small_regions(clean, W, H, 25.0, [](int a, int b) { return (double)std::abs(a - b); });
+    std::cout << "[Merge] reference " << ref_time << "s, raster " << seconds_since(t) << "s" << std::endl;
+    assert(clean == ref_clean);
+
+    std::vector<int> ref_ids, ids;
+    t = std::chrono::high_resolution_clock::now();
+    int ref_count = reference::components(ref_clean, W, H, ref_ids);
+    ref_time = seconds_since(t);
+    t = std::chrono::high_resolution_clock::now();
+    int count = Raster::label_components(clean, W, H, ids);
+    std::cout << "[Components] " << count << ": reference " << ref_time << "s, raster " << seconds_since(t) << "s" << std::endl;
+    assert(count == ref_count && ids == ref_ids);
+
+    Selector image_sel = Selector{"jot/Image", {{"url", "mock://raster_perf.png"}}}.with_output("$out");
+    vfs.write(image_sel, bytes);
+
+    t = std::chrono::high_resolution_clock::now();
+    Selector relief_sel = Selector{"jot/relief", {{"$in", image_sel.to_json()}}}.with_output("$out");
+    Processor::execute(&vfs, relief_sel);
+    std::cout << "[Relief] " << seconds_since(t) << "s" << std::endl;
+
+    t = std::chrono::high_resolution_clock::now();
+    Selector trace_sel = Selector{"jot/trace", {{"$in", image_sel.to_json()}, {"colors", 8}}}.with_output("$out");
+    Processor::execute(&vfs, trace_sel);
+    std::cout << "[Trace] " << seconds_since(t) << "s" << std::endl;
+
+    std::cout << "✅ Raster Performance PASS" << std::endl;
+    return 0;
+}
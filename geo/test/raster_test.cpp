@@ -0,0 +1,63 @@
+#include "test_base.h"
+#include "algorithms/raster.h"
+
+using namespace jotcad::geo;
+
+int main() {
+    std::cout << "Testing Raster Label Processing..." << std::endl;
+
+    // 1. A 6x4 grid: 0s wrapping a block of 1s, plus a lone 1 speck.
+    int W = 6, H = 4;
+    std::vector<int> labels = {
+        0, 1, 1, 1, 1, 0,
+        0, 1, 1, 1, 1, 0,
+        0, 0, 0, 1, 0, 0,
+        0, 1, 0, 0, 0, 0,
+    };
+    std::vector<int> ids, comp_labels;
+    int count = Raster::label_components(labels, W, H, ids, &comp_labels);
+    assert(count == 3);
+    assert(ids[0] == 0 && ids[1] == 1 && ids[19] == 2);
+    assert(ids[5] == 0 && ids[21] == 0 && ids[15] == 1);
+    assert((comp_labels == std::vector<int>{0, 1, 1}));
+    std::cout << "  ✅ Components numbered in raster order." << std::endl;
+
+    // 2. Banded labeling matches a single band.
+    std::vector<int> big(97 * 131);
+    for (int i = 0; i < (int)big.size(); ++i) big[i] = ((i * 7919) >> 5) % 3;
+    std::vector<int> serial, banded;
+    int previous = Raster::threads;
+    Raster::threads = 1;
+    int serial_count = Raster::label_components(big, 97, 131, serial);
+    std::vector<int> serial_mode = Raster::mode_filter(big, 97, 131);
+    Raster::threads = 4;
+    assert(Raster::label_components(big, 97, 131, banded) == serial_count);
+    assert(banded == serial);
+    assert(Raster::mode_filter(big, 97, 131) == serial_mode);
+    Raster::threads = previous;
+    std::cout << "  ✅ Bands agree with a serial pass." << std::endl;
+
+    // 3. The mode filter needs a five-of-nine majority.
+    std::vector<int> speck = {
+        2, 2, 2,
+        2, 7, 2,
+        3, 3, 3,
+    };
+    assert(Raster::mode_filter(speck, 3, 3)[4] == 2);
+    speck[1] = 3; speck[0] = 3;
+    assert(Raster::mode_filter(speck, 3, 3)[4] == 3);
+    std::cout << "  ✅ Mode filter." << std::endl;
+
+    // 4. Components under the minimum area join the nearest label.
+    std::vector<int> levels = {
+        5, 5, 5, 5,
+        5, 9, 5, 5,
+        5, 5, 5, 6,
+    };
+    Raster::merge_small_regions(levels, 4, 3, 2.0, [](int a, int b) { return (double)std::abs(a - b); });
+    assert((levels == std::vector<int>(12, 5)));
+    std::cout << "  ✅ Small regions merged." << std::endl;
+
+    std::cout << "✅ Raster Label Processing PASS" << std::endl;
+    return 0;
+}
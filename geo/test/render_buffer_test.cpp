@@ -0,0 +1,52 @@
+#include "test_base.h"
+#include "render/render_buffer.h"
+#include <cstring>
+#include "../box_op.h"
+#include "../stl_op.h"
+
+using namespace jotcad::geo;
+
+int main() {
+    MockVFS vfs("render_buffer_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Render Buffer Cache..." << std::endl;
+
+    fs::Selector box_sel = {"jot/Box/render_buffer", {{"width", 10.0}, {"height", 10.0}, {"depth", 10.0}}};
+    BoxOp<>::execute(&vfs, box_sel, Interval{-5.0, 5.0}, Interval{-5.0, 5.0}, Interval{-5.0, 5.0});
+    Shape box = vfs.read<Shape>(box_sel);
+    fs::CID cid = box.geometry.value();
+
+    // 1. The first request triangulates and stores the buffer.
+    assert(!Derived::lookup(&vfs, RenderBuffer::key(cid)).has_value());
+    RenderBuffer built = RenderBuffer::get(&vfs, cid);
+    assert(built.triangle_count() == 12);
+    assert(built.normals.size() == built.triangles.size());
+    assert(Derived::lookup(&vfs, RenderBuffer::key(cid)).has_value());
+    std::cout << "  ✅ Buffer built and stored." << std::endl;
+
+    // 2. Later requests decode the stored artifact.
+    RenderBuffer cached = RenderBuffer::get(&vfs, cid);
+    assert(cached.positions == built.positions);
+    assert(cached.triangles == built.triangles);
+    assert(cached.normals == built.normals);
+    RenderBuffer truncated;
+    std::vector<uint8_t> bytes = built.encode();
+    bytes.pop_back();
+    assert(!RenderBuffer::decode(bytes, truncated));
+    std::cout << "  ✅ Buffer round-trips through the VFS." << std::endl;
+
+    // 3. STL export consumes the buffer.
+    fs::Selector stl_sel = {"jot/stl/render_buffer", {}};
+    StlOp<>::execute(&vfs, stl_sel, box, "box.stl");
+    std::vector<uint8_t> stl = vfs.read<std::vector<uint8_t>>(stl_sel.with_output("$out"));
+    uint32_t count = 0;
+    std::memcpy(&count, stl.data() + 80, 4);
+    assert(count == 12);
+    assert(Derived::lookup(&vfs, RenderBuffer::key(cid, RenderBuffer::Precision::Exact)).has_value());
+    assert(RenderBuffer::key(cid, RenderBuffer::Precision::Exact) != RenderBuffer::key(cid));
+    std::cout << "  ✅ STL export uses the exact buffer." << std::endl;
+
+    std::cout << "✅ Render Buffer Cache PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "test_base.h"
+#include "render/rasterizer.h"
+#include <chrono>
+
+using namespace jotcad::geo;
+using namespace fs;
+
+// Compares single-threaded and tiled multi-threaded rasterization of a dense
+// orb cluster, then times each image encoder on the frame. The images must
+// be byte-identical.
+int main(int argc, char** argv) {
+    MockVFS vfs("render_perf");
+    register_all_ops(&vfs);
+
+    int size = argc > 1 ? std::atoi(argv[1]) : 2048;
+    std::cout << "Starting Render Performance Test (" << size << "x" << size << ")..." << std::endl;
+
+    Selector orb_sel = Selector{"jot/Orb", {{"diameter", 10.0}, {"zag", 0.1}}}.with_output("$out");
+    Shape orb = vfs.read<Shape>(orb_sel);
+
+    Shape scene;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            Shape s = orb;
+            s.tf = Matrix::translate(FT(i * 8), FT(j * 8), FT((i + j) % 3));
+            scene.components.push_back(s);
+        }
+    }
+
+    int previous = Rasterizer::threads;
+    std::vector<uint8_t> images[2];
+    int thread_counts[2] = {1, 0};
+    for (int r = 0; r < 2; ++r) {
+        Rasterizer::threads = thread_counts[r];
+        auto t_start = std::chrono::high_resolution_clock::now();
+        images[r] = Rasterizer::render_png(&vfs, scene, size, size, 0.5, 0.5);
+        auto t_end = std::chrono::high_resolution_clock::now();
+        std::cout << "[Render] threads=" << (thread_counts[r] ? std::to_string(thread_counts[r]) : "auto")
+                  << ": " << std::chrono::duration<double>(t_end - t_start).count() << "s, "
+                  << images[r].size() << " bytes" << std::endl;
+    }
+    Rasterizer::threads = previous;
+
+    if (images[0].empty() || images[0] != images[1]) {
+        std::cerr << "❌ Tiled render differs from the single-threaded render." << std::endl;
+        return 1;
+    }
+
+    // Encoder stage on the same frame.
+    std::vector<unsigned char> pixels = Rasterizer::render_views(&vfs, scene, {Camera(0.5, 0.5)}, size, size)[0];
+    struct { const char* name; ImageEncoder::Options options; } encoders[] = {
+        {"stb", {ImageEncoder::Format::Png, -1, 0}},
+        {"zlib-1", {ImageEncoder::Format::Png, 1, 0}},
+        {"zlib-6", {ImageEncoder::Format::Png, 6, 0}},
+        {"qoi", {ImageEncoder::Format::Qoi, -1, 0}},
+    };
+    for (const auto& encoder : encoders) {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        std::vector<uint8_t> bytes = ImageEncoder::encode(pixels, size, size, encoder.options);
+        auto t_end = std::chrono::high_resolution_clock::now();
+        std::cout << "[Encode] " << encoder.name << ": " << std::chrono::duration<double>(t_end - t_start).count()
+                  << "s, " << bytes.size() << " bytes" << std::endl;
+    }
+
+    std::cout << "✅ Render Performance PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "test_base.h"
+#include "algorithms/rtin.h"
+#include <cmath>
+
+extern "C" unsigned char *stbi_write_png_to_mem(const unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len);
+
+using namespace jotcad::geo;
+using namespace fs;
+
+int main() {
+    std::cout << "Testing Heightfield Relief..." << std::endl;
+
+    // 1. A tilted plane needs only the two root triangles; a negative
+    // error refines to every grid point.
+    assert(Rtin::grid_size(1, 1) == 3 && Rtin::grid_size(65, 40) == 65 && Rtin::grid_size(66, 2) == 129);
+    const int n = 33;
+    std::vector<float> plane(n * n), bump(n * n);
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            plane[y * n + x] = 0.25f * x + 0.5f * y;
+            bump[y * n + x] = 4.0f * std::exp(-((x - 12) * (x - 12) + (y - 20) * (y - 20)) / 30.0f);
+        }
+    }
+    assert(Rtin(plane, n).mesh(1e-3).triangles.size() == 2);
+    Rtin hill(bump, n);
+    assert(hill.mesh(-1).triangles.size() == 2 * (n - 1) * (n - 1));
+    std::cout << "  ✅ Plane and full refinement." << std::endl;
+
+    // 2. Triangle counts fall as the error bound grows.
+    size_t previous = hill.mesh(-1).triangles.size();
+    for (double max_error : {0.01, 0.1, 0.5, 2.0}) {
+        size_t count = hill.mesh(max_error).triangles.size();
+        assert(count <= previous);
+        previous = count;
+    }
+    assert(previous < 64);
+    std::cout << "  ✅ Error bound scales the triangle count." << std::endl;
+
+    // 3. jot/relief with maxError builds a closed continuous surface.
+    MockVFS vfs("rtin");
+    register_all_ops(&vfs);
+    const int W = 40, H = 27;
+    std::vector<unsigned char> pixels(W * H * 3);
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            double v = 255.0 * std::exp(-((x - 25) * (x - 25) + (y - 10) * (y - 10)) / 80.0);
+            for (int c = 0; c < 3; ++c) pixels[(y * W + x) * 3 + c] = (unsigned char)v;
+        }
+    }
+    int len = 0;
+    unsigned char* png_data = stbi_write_png_to_mem(pixels.data(), W * 3, W, H, 3, &len);
+    assert(png_data);
+    std::vector<uint8_t> png_bytes(png_data, png_data + len);
+    free(png_data);
+    Selector image_sel = Selector{"jot/Image", {{"url", "mock://bump.png"}}}.with_output("$out");
+    vfs.write(image_sel, png_bytes);
+
+    Selector relief_sel = Selector{"jot/relief", {
+        {"$in", image_sel.to_json()},
+        {"maxError", 0.05}
+    }}.with_output("$out");
+    Processor::execute(&vfs, relief_sel);
+    Shape result = vfs.read<Shape>(relief_sel);
+    Geometry geo = vfs.read<Geometry>(result.geometry.value());
+    std::cout << "  - Heightfield triangles: " << geo.triangles.size() << std::endl;
+    assert(geo.triangles.size() < (size_t)W * H);
+    vfs.verify_well_formed_solid(geo, "Heightfield Relief");
+    std::cout << "  ✅ Heightfield relief." << std::endl;
+
+    std::cout << "✅ Heightfield Relief PASS" << std::endl;
+    return 0;
+}
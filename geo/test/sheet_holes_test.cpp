@@ -0,0 +1,59 @@
+#include "test_base.h"
+#include "../box_op.h"
+#include "../cut_op.h"
+#include <chrono>
+
+using namespace jotcad::geo;
+
+int main() {
+    MockVFS vfs("sheet_holes");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Batched 2D Cut (sheet with many holes)..." << std::endl;
+
+    // 1. A flat 100x100 sheet and a 2x2 square hole.
+    fs::Selector sheet_sel = {"jot/Box/sheet", {{"width", 100.0}, {"height", 100.0}}};
+    BoxOp<>::execute(&vfs, sheet_sel, Interval{-50.0, 50.0}, Interval{-50.0, 50.0}, Interval{0.0, 0.0});
+    Shape sheet = vfs.read<Shape>(sheet_sel);
+
+    fs::Selector hole_sel = {"jot/Box/hole", {{"width", 2.0}, {"height", 2.0}}};
+    BoxOp<>::execute(&vfs, hole_sel, Interval{-1.0, 1.0}, Interval{-1.0, 1.0}, Interval{0.0, 0.0});
+    Shape hole = vfs.read<Shape>(hole_sel);
+
+    // 2. A 10x10 grid of coplanar holes, cut in one batch.
+    std::vector<Shape> holes;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            Shape h = hole;
+            h.tf = Matrix::translate(FT(-45 + i * 10), FT(-45 + j * 10), FT(0));
+            holes.push_back(h);
+        }
+    }
+
+    fs::Selector cut_sel = {"jot/cut/sheet", {}};
+    auto t_start = std::chrono::high_resolution_clock::now();
+    CutOp<>::execute(&vfs, cut_sel, sheet, holes, false);
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "  - " << holes.size() << " holes cut in " << std::chrono::duration<double>(t_end - t_start).count() << "s" << std::endl;
+
+    Shape out = vfs.read<Shape>(cut_sel);
+    Geometry res = vfs.read<Geometry>(out.geometry.value());
+    assert(res.faces.size() == 1);
+    assert(res.faces[0].loops.size() == 101);
+
+    // 3. Area is the sheet less every hole.
+    boolean::General_polygon_set_2 gps;
+    boolean::Engine::add_geometry_to_gps(res, Matrix::identity(), gps);
+    std::vector<boolean::Polygon_with_holes_2> pwhs;
+    gps.polygons_with_holes(std::back_inserter(pwhs));
+    FT area = 0;
+    for (const auto& pwh : pwhs) {
+        area += pwh.outer_boundary().area();
+        for (auto it = pwh.holes_begin(); it != pwh.holes_end(); ++it) area += it->area();
+    }
+    assert(area == FT(10000 - 100 * 4));
+    std::cout << "  ✅ Area matches." << std::endl;
+
+    std::cout << "✅ Batched 2D Cut PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "test_base.h"
+#include "render/rasterizer.h"
+#include "render/texture.h"
+#include "../box_op.h"
+
+using namespace jotcad::geo;
+
+int main() {
+    MockVFS vfs("texture_cache_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Texture Cache..." << std::endl;
+
+    // 1. A 64x64 checkerboard with 8 texel squares.
+    int W = 64, H = 64;
+    std::vector<unsigned char> pixels(W * H * 4);
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            unsigned char c = ((x / 8 + y / 8) % 2) ? 255 : 0;
+            unsigned char* p = &pixels[(y * W + x) * 4];
+            p[0] = c; p[1] = c; p[2] = c; p[3] = 255;
+        }
+    }
+    std::vector<uint8_t> png = ImageEncoder::encode_png_stb(pixels, W, H);
+
+    // 2. Decoding builds the mip chain down to one texel.
+    TextureCache::clear();
+    std::shared_ptr<const Texture> tex = TextureCache::get(png);
+    assert(tex->width == W && tex->height == H);
+    assert(tex->levels.size() == 7);
+    assert(tex->levels.back().width == 1 && tex->levels.back().height == 1);
+    ColorRGBA average = tex->sample(0.5, 0.5, 6);
+    assert(average.r > 120 && average.r < 135);
+    std::cout << "  ✅ Mip chain built." << std::endl;
+
+    // 3. Power-of-two wrapping repeats in both directions.
+    for (double u : {-1.3, 0.2, 5.7}) {
+        ColorRGBA a = tex->sample(u, 0.3);
+        ColorRGBA b = tex->sample(u - std::floor(u), 0.3);
+        assert(a.r == b.r && a.a == 255);
+    }
+    assert(tex->level_for(1.0, W * H) == 0);
+    assert(tex->level_for(1.0, (W / 4) * (H / 4)) == 2);
+    std::cout << "  ✅ Wrapping and level selection." << std::endl;
+
+    // 4. Renders share one decoded texture per image, keyed by the content
+    // the material resolves to.
+    assert(TextureCache::get(png) == tex);
+    fs::Selector tex_sel("jot/texture", {{"material", "checker"}});
+    tex_sel.output = "$out";
+    vfs.write(tex_sel, png);
+    fs::Selector box_sel = {"jot/Box/texture_cache", {{"width", 10.0}}};
+    BoxOp<>::execute(&vfs, box_sel, Interval{-5.0, 5.0}, Interval{-5.0, 5.0}, Interval{-5.0, 5.0});
+    Shape box = vfs.read<Shape>(box_sel);
+    box.tags["material"] = "checker";
+    Rasterizer::Scene scene = Rasterizer::collect_scene(&vfs, box);
+    assert(scene.items.size() == 1 && scene.items[0].texture);
+    assert(scene.items[0].texture->width == W);
+    assert(scene.items[0].texture == tex.get());
+    assert(Rasterizer::collect_scene(&vfs, box).items[0].texture == tex.get());
+    assert(!Rasterizer::render_png(&vfs, box, 64, 64, 0.3, 0.3).empty());
+    assert(TextureCache::size() == 1);
+    std::cout << "  ✅ Renders reuse the cached texture." << std::endl;
+
+    // 5. Remapping the material serves the new image, and images that fail
+    // to decode are not cached.
+    std::vector<unsigned char> small((std::size_t)16 * 16 * 4, 255);
+    vfs.write(tex_sel, ImageEncoder::encode_png_stb(small, 16, 16));
+    Rasterizer::Scene remapped = Rasterizer::collect_scene(&vfs, box);
+    assert(remapped.items[0].texture && remapped.items[0].texture->width == 16);
+    assert(TextureCache::size() == 2);
+    int loads = 0;
+    auto bad = [&]() { ++loads; return std::vector<uint8_t>{1, 2, 3}; };
+    assert(TextureCache::get("bad", bad)->empty());
+    assert(TextureCache::get("bad", bad)->empty());
+    assert(loads == 2 && TextureCache::size() == 2);
+    std::cout << "  ✅ Remapped and undecodable images." << std::endl;
+
+    // 6. Capacity evicts, but live scenes keep their textures.
+    TextureCache::set_capacity(0);
+    assert(TextureCache::size() == 0);
+    assert(!scene.items[0].texture->empty());
+    TextureCache::set_capacity(256u << 20);
+    assert(TextureCache::get(png) != tex);
+    std::cout << "  ✅ Eviction." << std::endl;
+
+    std::cout << "✅ Texture Cache PASS" << std::endl;
+    return 0;
+}
@@ -7,6 +7,8 @@
 // Global backend engine and utility headers included by tests
 #include "boolean/engine.h"
 #include "render/rasterizer.h"
+#include "render/lod.h"
+#include "infra/obj.h"
 #include "../math/interval.h"
 #include "packaide_engine.h"
 #include "../../fs/cpp/cid.h"
@@ -42,6 +44,8 @@
 #include "pdf_op.h"
 #include "stl_op.h"
 #include "png_op.h"
+#include "views_op.h"
+#include "glb_op.h"
 #include "relief_op.h"
 #include "rule_op.h"
 #include "move_op.h"
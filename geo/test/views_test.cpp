@@ -0,0 +1,47 @@
+#include "test_base.h"
+#include "render/rasterizer.h"
+#include "../box_op.h"
+#include "../views_op.h"
+
+using namespace jotcad::geo;
+
+static uint32_t png_dimension(const std::vector<uint8_t>& png, int offset) {
+    return (uint32_t(png[offset]) << 24) | (uint32_t(png[offset + 1]) << 16) | (uint32_t(png[offset + 2]) << 8) | png[offset + 3];
+}
+
+int main() {
+    MockVFS vfs("views_test");
+    register_all_ops(&vfs);
+
+    std::cout << "Testing Multi-View Rendering..." << std::endl;
+
+    fs::Selector box_sel = {"jot/Box/views", {{"width", 10.0}, {"height", 6.0}, {"depth", 4.0}}};
+    BoxOp<>::execute(&vfs, box_sel, Interval{-5.0, 5.0}, Interval{-3.0, 3.0}, Interval{-2.0, 2.0});
+    Shape box = vfs.read<Shape>(box_sel);
+
+    // 1. A 4-frame turntable matches individual renders.
+    fs::Selector frames_sel = {"jot/views/frames", {}};
+    ViewsOp<>::execute(&vfs, frames_sel, box, nlohmann::json::array(), 4, 0.5, 64, 64, false, 0);
+    nlohmann::json index = vfs.read<nlohmann::json>(frames_sel.with_output("$out"));
+    assert(index["frames"].size() == 4);
+    for (const auto& frame : index["frames"]) {
+        std::vector<uint8_t> single = Rasterizer::render_png(&vfs, box, 64, 64, frame["ax"].get<double>(), frame["ay"].get<double>());
+        assert(vfs.read<std::vector<uint8_t>>(fs::CID::from_json(frame["png"])) == single);
+    }
+    std::cout << "  ✅ Turntable frames match single renders." << std::endl;
+
+    // 2. Explicit views packed into a 2-column atlas.
+    fs::Selector atlas_sel = {"jot/views/atlas", {}};
+    nlohmann::json views = nlohmann::json::array({{0.0, 0.0}, {0.5, 0.5}, {{"ax", 1.0}, {"ay", 0.0}}});
+    ViewsOp<>::execute(&vfs, atlas_sel, box, views, 36, 0.0, 64, 48, true, 2);
+    index = vfs.read<nlohmann::json>(atlas_sel.with_output("$out"));
+    assert(index["columns"] == 2);
+    assert(index["frames"].size() == 3);
+    assert(index["frames"][2]["x"] == 0 && index["frames"][2]["y"] == 48);
+    std::vector<uint8_t> atlas = vfs.read<std::vector<uint8_t>>(fs::CID::from_json(index["atlas"]));
+    assert(png_dimension(atlas, 16) == 128 && png_dimension(atlas, 20) == 96);
+    std::cout << "  ✅ Atlas layout and index correct." << std::endl;
+
+    std::cout << "✅ Multi-View Rendering PASS" << std::endl;
+    return 0;
+}